@@ -0,0 +1,1289 @@
+/*
+  Simple DirectMedia Layer Shader Cross Compiler
+  Copyright (C) 2024 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <SDL3_shadercross/SDL_shadercross.h>
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_iostream.h>
+
+#ifndef SDL_PLATFORM_WINDOWS
+#include <sys/resource.h>
+#else
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+// Set by CMake to the bundled corpus in the source tree
+#ifndef SHADERCROSS_BENCH_CORPUS
+#define SHADERCROSS_BENCH_CORPUS "shaders"
+#endif
+
+// Set by CMake to the SPIR-V it compiles from the bundled corpus at build time
+#ifndef SHADERCROSS_BENCH_SPIRV_CORPUS
+#define SHADERCROSS_BENCH_SPIRV_CORPUS SHADERCROSS_BENCH_CORPUS
+#endif
+
+#define STAGE_VERTEX_BIT (1u << SDL_SHADERCROSS_SHADERSTAGE_VERTEX)
+#define STAGE_FRAGMENT_BIT (1u << SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT)
+#define STAGE_COMPUTE_BIT (1u << SDL_SHADERCROSS_SHADERSTAGE_COMPUTE)
+#define STAGE_GRAPHICS_BITS (STAGE_VERTEX_BIT | STAGE_FRAGMENT_BIT)
+#define STAGE_ALL_BITS (STAGE_GRAPHICS_BITS | STAGE_COMPUTE_BIT)
+
+// The uber shaders mask features out with BENCH_PERMUTATION
+#define NUM_PERMUTATIONS 4
+
+void print_help(void)
+{
+    int column_width = 32;
+    SDL_Log("Usage: shadercross-bench [options]");
+    SDL_Log("Options:\n");
+    SDL_Log("  %-*s %s", column_width, "--corpus <dir>", "Directory of *.hlsl and *.spv shaders. Default: the bundled corpus.");
+    SDL_Log("  %-*s %s", column_width, "", "The stage is inferred from .vert, .frag or .comp in the filename.");
+    SDL_Log("  %-*s %s", column_width, "--spirv-corpus <dir>", "Directory of the SPIR-V compiled from the HLSL shaders, as <name>.spv for");
+    SDL_Log("  %-*s %s", column_width, "", "<name>.hlsl. Default: the SPIR-V built with the bundled corpus, or --corpus.");
+    SDL_Log("  %-*s %s", column_width, "-n | --iterations <count>", "Timed compiles per shader and entry point, or passes over the");
+    SDL_Log("  %-*s %s", column_width, "", "corpus per thread with --scaling. Default: 20, or 4 with --scaling.");
+    SDL_Log("  %-*s %s", column_width, "--warmup <count>", "Untimed compiles before timing. Default: 2.");
+    SDL_Log("  %-*s %s", column_width, "-f | --filter <text>", "Only run cases whose shader, entry point or format contains the text.");
+    SDL_Log("  %-*s %s", column_width, "--scaling", "Compile concurrently on 1, 2, 4... threads up to --threads and");
+    SDL_Log("  %-*s %s", column_width, "", "report how throughput scales, instead of single-threaded latency.");
+    SDL_Log("  %-*s %s", column_width, "--threads <count>", "The most threads --scaling runs. Default: the number of CPU cores.");
+    SDL_Log("  %-*s %s", column_width, "--json <file>", "Write the results as JSON.");
+    SDL_Log("  %-*s %s", column_width, "-l | --list", "List the cases that would run, without running them.");
+    SDL_Log("  %-*s %s", column_width, "-h | --help", "Display this message.");
+    SDL_Log("\n");
+    SDL_Log("The SPIR-V entry points run on the SPIR-V the build compiles from every HLSL");
+    SDL_Log("shader with the shadercross CLI. Targets the compilers that were found cannot");
+    SDL_Log("produce, such as DXBC without FXC or vkd3d, are skipped. Creating GPU shader");
+    SDL_Log("objects needs a device and is not measured.");
+    SDL_Log("\n");
+    SDL_Log("--scaling only runs the entry points that compile on the calling thread. An");
+    SDL_Log("efficiency well below 100%% means the threads get in each other's way: with low");
+    SDL_Log("CPU utilization they are waiting on a lock, with high CPU utilization they are");
+    SDL_Log("contending for the allocator, caches or memory bandwidth.");
+}
+
+typedef struct BenchOptions
+{
+    const char *corpusDir;
+    const char *spirvCorpusDir;
+    const char *filter;
+    const char *jsonPath;
+    int iterations;
+    int warmup;
+    int maxThreads;
+    bool scaling;
+    bool list;
+    bool showHelp;
+} BenchOptions;
+
+typedef struct BenchShader
+{
+    char *name;
+    const char *includeDir;
+    SDL_ShaderCross_ShaderStage stage;
+    char *hlsl;        // NULL for shaders only available as SPIR-V
+    size_t hlslSize;
+    Uint8 *spirv;      // NULL if the build did not compile it
+    size_t spirvSize;
+} BenchShader;
+
+typedef struct BenchCase BenchCase;
+typedef bool (*BenchFunction)(const BenchShader *shader, const BenchCase *benchCase, size_t *outputSize);
+
+struct BenchCase
+{
+    const char *entryPoint;
+    const char *formatName;
+    bool fromHLSL;
+    SDL_GPUShaderFormat format;  // 0 for HLSL source output
+    Uint32 stages;
+    BenchFunction run;
+};
+
+typedef struct BenchResult
+{
+    const BenchShader *shader;
+    const BenchCase *benchCase;
+    int iterations;
+    Uint64 minNS;
+    Uint64 p50NS;
+    Uint64 p90NS;
+    Uint64 p99NS;
+    Uint64 maxNS;
+    Uint64 totalNS;
+    size_t outputSize;
+    Uint64 peakMemory;
+    bool failed;
+} BenchResult;
+
+/* Set if the high-water mark can be reset, so that every case reports its own
+ * peak. Elsewhere, results report the cumulative maximum RSS of the process.
+ */
+static bool perCasePeakMemory = false;
+static Uint64 processPeakMemory = 0;
+
+Uint64 get_peak_memory(void)
+{
+    Uint64 peak = 0;
+#ifdef SDL_PLATFORM_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        peak = counters.PeakWorkingSetSize;
+    }
+#else
+#ifdef SDL_PLATFORM_LINUX
+    // VmHWM is the high-water mark that /proc/self/clear_refs resets
+    char *status = (char *)SDL_LoadFile("/proc/self/status", NULL);
+    const char *hwm = status != NULL ? SDL_strstr(status, "VmHWM:") : NULL;
+    if (hwm != NULL) {
+        peak = SDL_strtoull(hwm + SDL_strlen("VmHWM:"), NULL, 10) * 1024;
+    }
+    SDL_free(status);
+#endif
+    struct rusage usage;
+    if (peak == 0 && getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef SDL_PLATFORM_APPLE
+        peak = (Uint64)usage.ru_maxrss;
+#else
+        peak = (Uint64)usage.ru_maxrss * 1024;
+#endif
+    }
+#endif
+    processPeakMemory = SDL_max(processPeakMemory, peak);
+    return peak;
+}
+
+// The peak of the whole run, which resetting for every case would otherwise lose
+Uint64 get_process_peak_memory(void)
+{
+    get_peak_memory();
+    return processPeakMemory;
+}
+
+// Starts measuring a new peak, returning false if the platform can't
+bool reset_peak_memory(void)
+{
+#ifdef SDL_PLATFORM_LINUX
+    get_peak_memory();
+    SDL_IOStream *io = SDL_IOFromFile("/proc/self/clear_refs", "w");
+    if (io == NULL) {
+        return false;
+    }
+    bool written = SDL_IOprintf(io, "5") == 1;
+    return SDL_CloseIO(io) && written;
+#else
+    return false;
+#endif
+}
+
+const char *get_peak_memory_column(void)
+{
+    return perCasePeakMemory ? "peak MiB" : "cum. RSS";
+}
+
+const char *get_peak_memory_key(void)
+{
+    return perCasePeakMemory ? "peak_memory_bytes" : "cumulative_max_rss_bytes";
+}
+
+// User and system time of the whole process, in nanoseconds
+Uint64 get_cpu_time(void)
+{
+#ifdef SDL_PLATFORM_WINDOWS
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+    Uint64 kernel = ((Uint64)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+    Uint64 user = ((Uint64)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+    return (kernel + user) * 100;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return SDL_SECONDS_TO_NS(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           SDL_US_TO_NS(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+}
+
+double to_ms(Uint64 ns)
+{
+    return (double)ns / SDL_NS_PER_MS;
+}
+
+double to_mib(Uint64 bytes)
+{
+    return (double)bytes / (1024.0 * 1024.0);
+}
+
+void init_hlsl_info(const BenchShader *shader, SDL_ShaderCross_HLSL_Info *info)
+{
+    SDL_zerop(info);
+    info->source = shader->hlsl;
+    info->entrypoint = "main";
+    info->include_dir = shader->includeDir;
+    info->shader_stage = shader->stage;
+    info->name = shader->name;
+}
+
+void init_spirv_info(const BenchShader *shader, SDL_ShaderCross_SPIRV_Info *info)
+{
+    SDL_zerop(info);
+    info->bytecode = shader->spirv;
+    info->bytecode_size = shader->spirvSize;
+    info->entrypoint = "main";
+    info->shader_stage = shader->stage;
+    info->name = shader->name;
+}
+
+bool take_blob(SDL_ShaderCross_Blob *blob, size_t *outputSize)
+{
+    if (blob == NULL) {
+        return false;
+    }
+    *outputSize = SDL_ShaderCross_GetBlobSize(blob);
+    SDL_ShaderCross_ReleaseBlob(blob);
+    return true;
+}
+
+bool take_buffer(void *buffer, size_t size, size_t *outputSize)
+{
+    if (buffer == NULL) {
+        return false;
+    }
+    *outputSize = size;
+    SDL_free(buffer);
+    return true;
+}
+
+bool take_job(SDL_ShaderCross_Job *job, size_t *outputSize)
+{
+    if (job == NULL) {
+        return false;
+    }
+    SDL_ShaderCross_Blob *blob = SDL_ShaderCross_GetJobResult(job);
+    if (blob == NULL) {
+        SDL_SetError("%s", SDL_ShaderCross_GetJobError(job));
+    }
+    SDL_ShaderCross_ReleaseJob(job);
+    return take_blob(blob, outputSize);
+}
+
+bool bench_buffer(const BenchShader *shader, const BenchCase *benchCase, size_t *outputSize)
+{
+    size_t size = 0;
+    void *buffer = NULL;
+
+    if (benchCase->fromHLSL) {
+        SDL_ShaderCross_HLSL_Info info;
+        init_hlsl_info(shader, &info);
+        switch (benchCase->format) {
+            case SDL_GPU_SHADERFORMAT_SPIRV:
+                buffer = SDL_ShaderCross_CompileSPIRVFromHLSL(&info, &size);
+                break;
+            case SDL_GPU_SHADERFORMAT_DXIL:
+                buffer = SDL_ShaderCross_CompileDXILFromHLSL(&info, &size);
+                break;
+            case SDL_GPU_SHADERFORMAT_DXBC:
+                buffer = SDL_ShaderCross_CompileDXBCFromHLSL(&info, &size);
+                break;
+            default:
+                return SDL_SetError("Unsupported format");
+        }
+    } else {
+        SDL_ShaderCross_SPIRV_Info info;
+        init_spirv_info(shader, &info);
+        switch (benchCase->format) {
+            case SDL_GPU_SHADERFORMAT_MSL:
+                buffer = SDL_ShaderCross_TranspileMSLFromSPIRV(&info);
+                size = buffer != NULL ? SDL_strlen((const char *)buffer) : 0;
+                break;
+            case 0:
+                buffer = SDL_ShaderCross_TranspileHLSLFromSPIRV(&info);
+                size = buffer != NULL ? SDL_strlen((const char *)buffer) : 0;
+                break;
+            case SDL_GPU_SHADERFORMAT_DXIL:
+                buffer = SDL_ShaderCross_CompileDXILFromSPIRV(&info, &size);
+                break;
+            case SDL_GPU_SHADERFORMAT_DXBC:
+                buffer = SDL_ShaderCross_CompileDXBCFromSPIRV(&info, &size);
+                break;
+            default:
+                return SDL_SetError("Unsupported format");
+        }
+    }
+
+    return take_buffer(buffer, size, outputSize);
+}
+
+bool bench_blob(const BenchShader *shader, const BenchCase *benchCase, size_t *outputSize)
+{
+    SDL_ShaderCross_Blob *blob = NULL;
+
+    if (benchCase->fromHLSL) {
+        SDL_ShaderCross_HLSL_Info info;
+        init_hlsl_info(shader, &info);
+        switch (benchCase->format) {
+            case SDL_GPU_SHADERFORMAT_SPIRV:
+                blob = SDL_ShaderCross_CompileSPIRVFromHLSLToBlob(&info);
+                break;
+            case SDL_GPU_SHADERFORMAT_DXIL:
+                blob = SDL_ShaderCross_CompileDXILFromHLSLToBlob(&info);
+                break;
+            case SDL_GPU_SHADERFORMAT_DXBC:
+                blob = SDL_ShaderCross_CompileDXBCFromHLSLToBlob(&info);
+                break;
+            default:
+                return SDL_SetError("Unsupported format");
+        }
+    } else {
+        SDL_ShaderCross_SPIRV_Info info;
+        init_spirv_info(shader, &info);
+        switch (benchCase->format) {
+            case SDL_GPU_SHADERFORMAT_MSL:
+                blob = SDL_ShaderCross_TranspileMSLFromSPIRVToBlob(&info);
+                break;
+            case 0:
+                blob = SDL_ShaderCross_TranspileHLSLFromSPIRVToBlob(&info);
+                break;
+            case SDL_GPU_SHADERFORMAT_DXIL:
+                blob = SDL_ShaderCross_CompileDXILFromSPIRVToBlob(&info);
+                break;
+            case SDL_GPU_SHADERFORMAT_DXBC:
+                blob = SDL_ShaderCross_CompileDXBCFromSPIRVToBlob(&info);
+                break;
+            default:
+                return SDL_SetError("Unsupported format");
+        }
+    }
+
+    return take_blob(blob, outputSize);
+}
+
+// Measures the latency of a single job, including the handoff to a worker thread
+bool bench_async(const BenchShader *shader, const BenchCase *benchCase, size_t *outputSize)
+{
+    SDL_ShaderCross_Job *job = NULL;
+
+    if (benchCase->fromHLSL) {
+        SDL_ShaderCross_HLSL_Info info;
+        init_hlsl_info(shader, &info);
+        switch (benchCase->format) {
+            case SDL_GPU_SHADERFORMAT_SPIRV:
+                job = SDL_ShaderCross_CompileSPIRVFromHLSLAsync(&info, NULL, NULL);
+                break;
+            case SDL_GPU_SHADERFORMAT_DXIL:
+                job = SDL_ShaderCross_CompileDXILFromHLSLAsync(&info, NULL, NULL);
+                break;
+            case SDL_GPU_SHADERFORMAT_DXBC:
+                job = SDL_ShaderCross_CompileDXBCFromHLSLAsync(&info, NULL, NULL);
+                break;
+            default:
+                return SDL_SetError("Unsupported format");
+        }
+    } else {
+        SDL_ShaderCross_SPIRV_Info info;
+        init_spirv_info(shader, &info);
+        switch (benchCase->format) {
+            case SDL_GPU_SHADERFORMAT_MSL:
+                job = SDL_ShaderCross_TranspileMSLFromSPIRVAsync(&info, NULL, NULL);
+                break;
+            case 0:
+                job = SDL_ShaderCross_TranspileHLSLFromSPIRVAsync(&info, NULL, NULL);
+                break;
+            case SDL_GPU_SHADERFORMAT_DXIL:
+                job = SDL_ShaderCross_CompileDXILFromSPIRVAsync(&info, NULL, NULL);
+                break;
+            case SDL_GPU_SHADERFORMAT_DXBC:
+                job = SDL_ShaderCross_CompileDXBCFromSPIRVAsync(&info, NULL, NULL);
+                break;
+            default:
+                return SDL_SetError("Unsupported format");
+        }
+    }
+
+    return take_job(job, outputSize);
+}
+
+bool bench_permutations(const BenchShader *shader, const BenchCase *benchCase, size_t *outputSize)
+{
+    static char *values[NUM_PERMUTATIONS] = { "0", "3", "5", "15" };
+    SDL_ShaderCross_HLSL_Define defines[NUM_PERMUTATIONS][2];
+    const SDL_ShaderCross_HLSL_Define *defineSets[NUM_PERMUTATIONS];
+    for (int i = 0; i < NUM_PERMUTATIONS; i += 1) {
+        defines[i][0].name = "BENCH_PERMUTATION";
+        defines[i][0].value = values[i];
+        defines[i][1].name = NULL;
+        defines[i][1].value = NULL;
+        defineSets[i] = defines[i];
+    }
+
+    SDL_ShaderCross_HLSL_Info info;
+    init_hlsl_info(shader, &info);
+    SDL_ShaderCross_PermutationResult *results = SDL_ShaderCross_CompilePermutationsFromHLSL(&info, defineSets, NUM_PERMUTATIONS, benchCase->format);
+    if (results == NULL) {
+        return false;
+    }
+
+    bool result = true;
+    *outputSize = 0;
+    for (int i = 0; i < NUM_PERMUTATIONS; i += 1) {
+        if (results[i].blob == NULL) {
+            SDL_SetError("%s", results[i].error);
+            result = false;
+            break;
+        }
+        *outputSize += SDL_ShaderCross_GetBlobSize(results[i].blob);
+    }
+    SDL_ShaderCross_ReleasePermutationResults(results, NUM_PERMUTATIONS);
+    return result;
+}
+
+bool bench_multi_target(const BenchShader *shader, const BenchCase *benchCase, size_t *outputSize)
+{
+    SDL_ShaderCross_SPIRV_Info info;
+    SDL_ShaderCross_MultiTargetResult results;
+    init_spirv_info(shader, &info);
+    SDL_zero(results);
+
+    bool result = SDL_ShaderCross_CompileMultiTargetFromSPIRV(&info, benchCase->format, &results);
+    if (result) {
+        SDL_ShaderCross_Blob *blobs[] = { results.msl, results.dxbc, results.dxil };
+        *outputSize = 0;
+        for (int i = 0; i < (int)SDL_arraysize(blobs); i += 1) {
+            if (blobs[i] != NULL) {
+                *outputSize += SDL_ShaderCross_GetBlobSize(blobs[i]);
+            }
+        }
+    }
+    SDL_ShaderCross_ReleaseMultiTargetResult(&results);
+    return result;
+}
+
+bool bench_reflect(const BenchShader *shader, const BenchCase *benchCase, size_t *outputSize)
+{
+    *outputSize = 0;
+    if (shader->stage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+        SDL_ShaderCross_ComputePipelineMetadata metadata;
+        return SDL_ShaderCross_ReflectComputeSPIRV(shader->spirv, shader->spirvSize, &metadata);
+    } else {
+        SDL_ShaderCross_GraphicsShaderMetadata metadata;
+        return SDL_ShaderCross_ReflectGraphicsSPIRV(shader->spirv, shader->spirvSize, &metadata);
+    }
+}
+
+static const BenchCase cases[] = {
+    { "SDL_ShaderCross_CompileSPIRVFromHLSL", "SPIRV", true, SDL_GPU_SHADERFORMAT_SPIRV, STAGE_ALL_BITS, bench_buffer },
+    { "SDL_ShaderCross_CompileSPIRVFromHLSLToBlob", "SPIRV", true, SDL_GPU_SHADERFORMAT_SPIRV, STAGE_ALL_BITS, bench_blob },
+    { "SDL_ShaderCross_CompileSPIRVFromHLSLAsync", "SPIRV", true, SDL_GPU_SHADERFORMAT_SPIRV, STAGE_ALL_BITS, bench_async },
+    { "SDL_ShaderCross_CompilePermutationsFromHLSL", "SPIRV", true, SDL_GPU_SHADERFORMAT_SPIRV, STAGE_ALL_BITS, bench_permutations },
+    { "SDL_ShaderCross_CompileDXILFromHLSL", "DXIL", true, SDL_GPU_SHADERFORMAT_DXIL, STAGE_ALL_BITS, bench_buffer },
+    { "SDL_ShaderCross_CompileDXILFromHLSLToBlob", "DXIL", true, SDL_GPU_SHADERFORMAT_DXIL, STAGE_ALL_BITS, bench_blob },
+    { "SDL_ShaderCross_CompileDXILFromHLSLAsync", "DXIL", true, SDL_GPU_SHADERFORMAT_DXIL, STAGE_ALL_BITS, bench_async },
+    { "SDL_ShaderCross_CompilePermutationsFromHLSL", "DXIL", true, SDL_GPU_SHADERFORMAT_DXIL, STAGE_ALL_BITS, bench_permutations },
+    { "SDL_ShaderCross_CompileDXBCFromHLSL", "DXBC", true, SDL_GPU_SHADERFORMAT_DXBC, STAGE_ALL_BITS, bench_buffer },
+    { "SDL_ShaderCross_CompileDXBCFromHLSLToBlob", "DXBC", true, SDL_GPU_SHADERFORMAT_DXBC, STAGE_ALL_BITS, bench_blob },
+    { "SDL_ShaderCross_CompileDXBCFromHLSLAsync", "DXBC", true, SDL_GPU_SHADERFORMAT_DXBC, STAGE_ALL_BITS, bench_async },
+    { "SDL_ShaderCross_CompilePermutationsFromHLSL", "DXBC", true, SDL_GPU_SHADERFORMAT_DXBC, STAGE_ALL_BITS, bench_permutations },
+    { "SDL_ShaderCross_TranspileMSLFromSPIRV", "MSL", false, SDL_GPU_SHADERFORMAT_MSL, STAGE_ALL_BITS, bench_buffer },
+    { "SDL_ShaderCross_TranspileMSLFromSPIRVToBlob", "MSL", false, SDL_GPU_SHADERFORMAT_MSL, STAGE_ALL_BITS, bench_blob },
+    { "SDL_ShaderCross_TranspileMSLFromSPIRVAsync", "MSL", false, SDL_GPU_SHADERFORMAT_MSL, STAGE_ALL_BITS, bench_async },
+    { "SDL_ShaderCross_TranspileHLSLFromSPIRV", "HLSL", false, 0, STAGE_ALL_BITS, bench_buffer },
+    { "SDL_ShaderCross_TranspileHLSLFromSPIRVToBlob", "HLSL", false, 0, STAGE_ALL_BITS, bench_blob },
+    { "SDL_ShaderCross_TranspileHLSLFromSPIRVAsync", "HLSL", false, 0, STAGE_ALL_BITS, bench_async },
+    { "SDL_ShaderCross_CompileDXILFromSPIRV", "DXIL", false, SDL_GPU_SHADERFORMAT_DXIL, STAGE_ALL_BITS, bench_buffer },
+    { "SDL_ShaderCross_CompileDXILFromSPIRVToBlob", "DXIL", false, SDL_GPU_SHADERFORMAT_DXIL, STAGE_ALL_BITS, bench_blob },
+    { "SDL_ShaderCross_CompileDXILFromSPIRVAsync", "DXIL", false, SDL_GPU_SHADERFORMAT_DXIL, STAGE_ALL_BITS, bench_async },
+    { "SDL_ShaderCross_CompileDXBCFromSPIRV", "DXBC", false, SDL_GPU_SHADERFORMAT_DXBC, STAGE_ALL_BITS, bench_buffer },
+    { "SDL_ShaderCross_CompileDXBCFromSPIRVToBlob", "DXBC", false, SDL_GPU_SHADERFORMAT_DXBC, STAGE_ALL_BITS, bench_blob },
+    { "SDL_ShaderCross_CompileDXBCFromSPIRVAsync", "DXBC", false, SDL_GPU_SHADERFORMAT_DXBC, STAGE_ALL_BITS, bench_async },
+    { "SDL_ShaderCross_CompileMultiTargetFromSPIRV", "MSL+DXIL", false, SDL_GPU_SHADERFORMAT_MSL | SDL_GPU_SHADERFORMAT_DXIL, STAGE_ALL_BITS, bench_multi_target },
+    { "SDL_ShaderCross_CompileMultiTargetFromSPIRV", "MSL+DXIL+DXBC", false, SDL_GPU_SHADERFORMAT_MSL | SDL_GPU_SHADERFORMAT_DXIL | SDL_GPU_SHADERFORMAT_DXBC, STAGE_ALL_BITS, bench_multi_target },
+    { "SDL_ShaderCross_ReflectGraphicsSPIRV", "reflection", false, 0, STAGE_GRAPHICS_BITS, bench_reflect },
+    { "SDL_ShaderCross_ReflectComputeSPIRV", "reflection", false, 0, STAGE_COMPUTE_BIT, bench_reflect },
+};
+
+bool parse_args(int argc, char *argv[], BenchOptions *options)
+{
+    SDL_zerop(options);
+    options->corpusDir = SHADERCROSS_BENCH_CORPUS;
+    options->warmup = 2;
+
+    for (int i = 1; i < argc; i += 1) {
+        const char *arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (SDL_strcmp(arg, "--corpus") == 0 && hasValue) {
+            options->corpusDir = argv[++i];
+        } else if (SDL_strcmp(arg, "--spirv-corpus") == 0 && hasValue) {
+            options->spirvCorpusDir = argv[++i];
+        } else if ((SDL_strcmp(arg, "-n") == 0 || SDL_strcmp(arg, "--iterations") == 0) && hasValue) {
+            options->iterations = SDL_atoi(argv[++i]);
+            if (options->iterations <= 0) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: iterations must be positive", argv[0]);
+                return false;
+            }
+        } else if (SDL_strcmp(arg, "--warmup") == 0 && hasValue) {
+            options->warmup = SDL_atoi(argv[++i]);
+            if (options->warmup < 0) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: warmup cannot be negative", argv[0]);
+                return false;
+            }
+        } else if (SDL_strcmp(arg, "--scaling") == 0) {
+            options->scaling = true;
+        } else if (SDL_strcmp(arg, "--threads") == 0 && hasValue) {
+            options->maxThreads = SDL_atoi(argv[++i]);
+            if (options->maxThreads <= 0) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: threads must be positive", argv[0]);
+                return false;
+            }
+        } else if ((SDL_strcmp(arg, "-f") == 0 || SDL_strcmp(arg, "--filter") == 0) && hasValue) {
+            options->filter = argv[++i];
+        } else if (SDL_strcmp(arg, "--json") == 0 && hasValue) {
+            options->jsonPath = argv[++i];
+        } else if (SDL_strcmp(arg, "-l") == 0 || SDL_strcmp(arg, "--list") == 0) {
+            options->list = true;
+        } else if (SDL_strcmp(arg, "-h") == 0 || SDL_strcmp(arg, "--help") == 0) {
+            options->showHelp = true;
+        } else {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: Unknown argument: %s", argv[0], arg);
+            return false;
+        }
+    }
+
+    // The SPIR-V built with the bundled corpus does not match another one
+    if (options->spirvCorpusDir == NULL) {
+        bool bundled = SDL_strcmp(options->corpusDir, SHADERCROSS_BENCH_CORPUS) == 0;
+        options->spirvCorpusDir = bundled ? SHADERCROSS_BENCH_SPIRV_CORPUS : options->corpusDir;
+    }
+    if (options->iterations == 0) {
+        options->iterations = options->scaling ? 4 : 20;
+    }
+    if (options->maxThreads == 0) {
+        options->maxThreads = SDL_max(SDL_GetNumLogicalCPUCores(), 1);
+    }
+    return true;
+}
+
+bool infer_stage(const char *name, SDL_ShaderCross_ShaderStage *stage)
+{
+    if (SDL_strcasestr(name, ".vert")) {
+        *stage = SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
+    } else if (SDL_strcasestr(name, ".frag")) {
+        *stage = SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+    } else if (SDL_strcasestr(name, ".comp")) {
+        *stage = SDL_SHADERCROSS_SHADERSTAGE_COMPUTE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void free_corpus(BenchShader *shaders, int numShaders)
+{
+    for (int i = 0; i < numShaders; i += 1) {
+        SDL_free(shaders[i].name);
+        SDL_free(shaders[i].hlsl);
+        SDL_free(shaders[i].spirv);
+    }
+    SDL_free(shaders);
+}
+
+int SDLCALL compare_names(const void *a, const void *b)
+{
+    return SDL_strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+// Loads the SPIR-V compiled from an HLSL shader, or returns NULL if there is none
+Uint8 *load_compiled_spirv(const BenchOptions *options, const char *hlslName, size_t *size)
+{
+    char *path = NULL;
+    if (SDL_asprintf(&path, "%s/%.*s.spv", options->spirvCorpusDir, (int)SDL_strlen(hlslName) - 5, hlslName) < 0) {
+        return NULL;
+    }
+    Uint8 *spirv = (Uint8 *)SDL_LoadFile(path, size);
+    SDL_free(path);
+    return spirv;
+}
+
+// True if a SPIR-V file in the corpus is the one compiled from an HLSL shader next to it
+bool is_compiled_spirv(const BenchOptions *options, char **files, int numFiles, const char *spirvName)
+{
+    if (SDL_strcmp(options->spirvCorpusDir, options->corpusDir) != 0) {
+        return false;
+    }
+    size_t stemLength = SDL_strlen(spirvName) - 4;
+    for (int i = 0; i < numFiles; i += 1) {
+        if (SDL_strlen(files[i]) == stemLength + 5 &&
+            SDL_strncmp(files[i], spirvName, stemLength) == 0 &&
+            SDL_strcasecmp(files[i] + stemLength, ".hlsl") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Loads every shader in the corpus, pairing the HLSL ones with the SPIR-V the build compiled from them
+BenchShader *load_corpus(const BenchOptions *options, int *numShaders)
+{
+    int numFiles = 0;
+    char **files = SDL_GlobDirectory(options->corpusDir, "*.*", 0, &numFiles);
+    if (files == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to read the corpus (%s)", SDL_GetError());
+        return NULL;
+    }
+    SDL_qsort(files, numFiles, sizeof(char *), compare_names);
+
+    BenchShader *shaders = SDL_calloc(numFiles > 0 ? numFiles : 1, sizeof(BenchShader));
+    if (shaders == NULL) {
+        SDL_free(files);
+        return NULL;
+    }
+
+    int count = 0;
+    for (int i = 0; i < numFiles; i += 1) {
+        const char *name = files[i];
+        bool isHLSL = SDL_strlen(name) > 5 && SDL_strcasecmp(name + SDL_strlen(name) - 5, ".hlsl") == 0;
+        bool isSPIRV = SDL_strlen(name) > 4 && SDL_strcasecmp(name + SDL_strlen(name) - 4, ".spv") == 0;
+        if ((!isHLSL && !isSPIRV) || (isSPIRV && is_compiled_spirv(options, files, numFiles, name))) {
+            continue;
+        }
+
+        BenchShader *shader = &shaders[count];
+        if (!infer_stage(name, &shader->stage)) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%s: could not infer the shader stage, skipping", name);
+            continue;
+        }
+
+        char *path = NULL;
+        if (SDL_asprintf(&path, "%s/%s", options->corpusDir, name) < 0) {
+            free_corpus(shaders, count);
+            SDL_free(files);
+            return NULL;
+        }
+        size_t size = 0;
+        void *data = SDL_LoadFile(path, &size);
+        SDL_free(path);
+        if (data == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: %s", name, SDL_GetError());
+            free_corpus(shaders, count);
+            SDL_free(files);
+            return NULL;
+        }
+
+        shader->name = SDL_strdup(name);
+        shader->includeDir = options->corpusDir;
+        if (isHLSL) {
+            shader->hlsl = (char *)data;
+            shader->hlslSize = size;
+            shader->spirv = load_compiled_spirv(options, name, &shader->spirvSize);
+        } else {
+            shader->spirv = (Uint8 *)data;
+            shader->spirvSize = size;
+        }
+        count += 1;
+    }
+    SDL_free(files);
+
+    *numShaders = count;
+    return shaders;
+}
+
+bool matches_filter(const BenchOptions *options, const BenchShader *shader, const BenchCase *benchCase)
+{
+    if (options->filter == NULL) {
+        return true;
+    }
+    return SDL_strcasestr(shader->name, options->filter) ||
+           SDL_strcasestr(benchCase->entryPoint, options->filter) ||
+           SDL_strcasestr(benchCase->formatName, options->filter);
+}
+
+// Returns NULL if the case can run, otherwise why it was skipped
+const char *get_skip_reason(const BenchShader *shader, const BenchCase *benchCase)
+{
+    if ((benchCase->stages & (1u << shader->stage)) == 0) {
+        return "stage";
+    }
+    if (benchCase->fromHLSL) {
+        if (shader->hlsl == NULL) {
+            return "no HLSL source";
+        }
+        if ((SDL_ShaderCross_GetHLSLShaderFormats() & benchCase->format) != benchCase->format) {
+            return "compiler not found";
+        }
+    } else {
+        if (shader->spirv == NULL) {
+            return "no SPIR-V";
+        }
+        if ((SDL_ShaderCross_GetSPIRVShaderFormats() & benchCase->format) != benchCase->format) {
+            return "compiler not found";
+        }
+    }
+    return NULL;
+}
+
+int SDLCALL compare_times(const void *a, const void *b)
+{
+    Uint64 timeA = *(const Uint64 *)a;
+    Uint64 timeB = *(const Uint64 *)b;
+    return timeA < timeB ? -1 : timeA > timeB ? 1 : 0;
+}
+
+// Nearest-rank percentile of sorted samples
+Uint64 percentile(const Uint64 *sorted, int count, int percent)
+{
+    int rank = (percent * count + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+bool run_case(const BenchOptions *options, const BenchShader *shader, const BenchCase *benchCase, Uint64 *samples, BenchResult *result)
+{
+    SDL_zerop(result);
+    result->shader = shader;
+    result->benchCase = benchCase;
+    if (perCasePeakMemory) {
+        reset_peak_memory();
+    }
+
+    for (int i = 0; i < options->warmup + options->iterations; i += 1) {
+        size_t outputSize = 0;
+        Uint64 start = SDL_GetTicksNS();
+        bool succeeded = benchCase->run(shader, benchCase, &outputSize);
+        Uint64 elapsed = SDL_GetTicksNS() - start;
+        if (!succeeded) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s %s (%s): %s", shader->name, benchCase->entryPoint, benchCase->formatName, SDL_GetError());
+            result->failed = true;
+            return false;
+        }
+        if (i >= options->warmup) {
+            samples[i - options->warmup] = elapsed;
+            result->totalNS += elapsed;
+        }
+        result->outputSize = outputSize;
+    }
+
+    SDL_qsort(samples, options->iterations, sizeof(Uint64), compare_times);
+    result->iterations = options->iterations;
+    result->minNS = samples[0];
+    result->p50NS = percentile(samples, options->iterations, 50);
+    result->p90NS = percentile(samples, options->iterations, 90);
+    result->p99NS = percentile(samples, options->iterations, 99);
+    result->maxNS = samples[options->iterations - 1];
+    result->peakMemory = get_peak_memory();
+    return true;
+}
+
+double get_throughput(const BenchResult *result)
+{
+    return result->totalNS > 0 ? (double)result->iterations * SDL_NS_PER_SECOND / (double)result->totalNS : 0.0;
+}
+
+void log_result(const BenchResult *result)
+{
+    if (result->failed) {
+        SDL_Log("%-18s %-46s %-14s %s", result->shader->name, result->benchCase->entryPoint, result->benchCase->formatName, "FAILED");
+        return;
+    }
+    SDL_Log("%-18s %-46s %-14s %9.3f %9.3f %9.3f %9.3f %9.1f %9.1f",
+            result->shader->name,
+            result->benchCase->entryPoint,
+            result->benchCase->formatName,
+            to_ms(result->minNS),
+            to_ms(result->p50NS),
+            to_ms(result->p90NS),
+            to_ms(result->p99NS),
+            get_throughput(result),
+            to_mib(result->peakMemory));
+}
+
+void write_json_string(SDL_IOStream *io, const char *str)
+{
+    SDL_IOprintf(io, "\"");
+    for (const char *c = str; *c != '\0'; c += 1) {
+        if (*c == '"' || *c == '\\') {
+            SDL_IOprintf(io, "\\%c", *c);
+        } else if ((unsigned char)*c < 0x20) {
+            SDL_IOprintf(io, "\\u%04x", (unsigned char)*c);
+        } else {
+            SDL_IOprintf(io, "%c", *c);
+        }
+    }
+    SDL_IOprintf(io, "\"");
+}
+
+bool write_json(const BenchOptions *options, const BenchResult *results, int numResults, Uint64 wallNS)
+{
+    static const char *stageNames[] = { "vertex", "fragment", "compute" };
+
+    SDL_IOStream *io = SDL_IOFromFile(options->jsonPath, "w");
+    if (io == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return false;
+    }
+
+    SDL_IOprintf(io, "{\n");
+    SDL_IOprintf(io, "  \"iterations\": %d,\n", options->iterations);
+    SDL_IOprintf(io, "  \"warmup\": %d,\n", options->warmup);
+    SDL_IOprintf(io, "  \"wall_ms\": %.3f,\n", to_ms(wallNS));
+    SDL_IOprintf(io, "  \"peak_memory_bytes\": %" SDL_PRIu64 ",\n", get_process_peak_memory());
+    SDL_IOprintf(io, "  \"results\": [");
+    for (int i = 0; i < numResults; i += 1) {
+        const BenchResult *result = &results[i];
+        SDL_IOprintf(io, "%s\n    {\n", i > 0 ? "," : "");
+        SDL_IOprintf(io, "      \"shader\": ");
+        write_json_string(io, result->shader->name);
+        SDL_IOprintf(io, ",\n      \"stage\": \"%s\",\n", stageNames[result->shader->stage]);
+        SDL_IOprintf(io, "      \"entry_point\": \"%s\",\n", result->benchCase->entryPoint);
+        SDL_IOprintf(io, "      \"format\": \"%s\",\n", result->benchCase->formatName);
+        SDL_IOprintf(io, "      \"input_bytes\": %" SDL_PRIu64 ",\n", (Uint64)(result->benchCase->fromHLSL ? result->shader->hlslSize : result->shader->spirvSize));
+        if (result->failed) {
+            SDL_IOprintf(io, "      \"failed\": true\n");
+        } else {
+            SDL_IOprintf(io, "      \"failed\": false,\n");
+            SDL_IOprintf(io, "      \"output_bytes\": %" SDL_PRIu64 ",\n", (Uint64)result->outputSize);
+            SDL_IOprintf(io, "      \"iterations\": %d,\n", result->iterations);
+            SDL_IOprintf(io, "      \"min_ms\": %.3f,\n", to_ms(result->minNS));
+            SDL_IOprintf(io, "      \"p50_ms\": %.3f,\n", to_ms(result->p50NS));
+            SDL_IOprintf(io, "      \"p90_ms\": %.3f,\n", to_ms(result->p90NS));
+            SDL_IOprintf(io, "      \"p99_ms\": %.3f,\n", to_ms(result->p99NS));
+            SDL_IOprintf(io, "      \"max_ms\": %.3f,\n", to_ms(result->maxNS));
+            SDL_IOprintf(io, "      \"mean_ms\": %.3f,\n", to_ms(result->totalNS) / result->iterations);
+            SDL_IOprintf(io, "      \"compiles_per_second\": %.3f,\n", get_throughput(result));
+            SDL_IOprintf(io, "      \"%s\": %" SDL_PRIu64 "\n", get_peak_memory_key(), result->peakMemory);
+        }
+        SDL_IOprintf(io, "    }");
+    }
+    SDL_IOprintf(io, "\n  ]\n}\n");
+
+    if (!SDL_CloseIO(io)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+int run_latency(const BenchOptions *options, const BenchShader *shaders, int numShaders)
+{
+    int maxResults = numShaders * (int)SDL_arraysize(cases);
+    BenchResult *results = SDL_calloc(maxResults, sizeof(BenchResult));
+    Uint64 *samples = SDL_calloc(options->iterations, sizeof(Uint64));
+    if (results == NULL || samples == NULL) {
+        SDL_free(results);
+        SDL_free(samples);
+        return 1;
+    }
+
+    if (!options->list) {
+        SDL_Log("%-18s %-46s %-14s %9s %9s %9s %9s %9s %9s",
+                "shader", "entry point", "format", "min ms", "p50 ms", "p90 ms", "p99 ms", "per sec", get_peak_memory_column());
+    }
+
+    int result = 0;
+    int numResults = 0;
+    int numSkipped = 0;
+    Uint64 wallStart = SDL_GetTicksNS();
+    for (int i = 0; i < numShaders; i += 1) {
+        for (int j = 0; j < (int)SDL_arraysize(cases); j += 1) {
+            const BenchShader *shader = &shaders[i];
+            const BenchCase *benchCase = &cases[j];
+            if (!matches_filter(options, shader, benchCase)) {
+                continue;
+            }
+            const char *skipReason = get_skip_reason(shader, benchCase);
+            if (skipReason != NULL) {
+                // Stage mismatches are by design, only report what is missing from this setup
+                if (SDL_strcmp(skipReason, "stage") != 0) {
+                    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "%s %s (%s): skipped, %s", shader->name, benchCase->entryPoint, benchCase->formatName, skipReason);
+                    numSkipped += 1;
+                }
+                continue;
+            }
+            if (options->list) {
+                SDL_Log("%-18s %-46s %s", shader->name, benchCase->entryPoint, benchCase->formatName);
+                continue;
+            }
+
+            BenchResult *benchResult = &results[numResults++];
+            if (!run_case(options, shader, benchCase, samples, benchResult)) {
+                result = 1;
+            }
+            log_result(benchResult);
+        }
+    }
+    Uint64 wallNS = SDL_GetTicksNS() - wallStart;
+
+    if (numSkipped > 0) {
+        SDL_Log("%d cases skipped because their input or compiler is unavailable", numSkipped);
+    }
+    if (!options->list) {
+        SDL_Log("wall time: %.3f ms, peak memory: %.1f MiB", to_ms(wallNS), to_mib(get_process_peak_memory()));
+        if (options->jsonPath != NULL && !write_json(options, results, numResults, wallNS)) {
+            result = 1;
+        }
+    }
+
+    SDL_free(samples);
+    SDL_free(results);
+    return result;
+}
+
+typedef struct ScalingThread
+{
+    const BenchOptions *options;
+    const BenchShader *shaders;
+    int numShaders;
+    int firstShader;
+    const BenchCase *benchCase;
+    SDL_Semaphore *start;
+    Uint64 *samples;
+    int numSamples;
+    bool failed;
+} ScalingThread;
+
+typedef struct ScalingResult
+{
+    const BenchCase *benchCase;
+    int numThreads;
+    int compiles;
+    Uint64 wallNS;
+    Uint64 cpuNS;
+    Uint64 p50NS;
+    Uint64 p99NS;
+    double throughput;
+    double speedup;
+    double efficiency;
+    double cpuUtilization;
+    Uint64 peakMemory;
+    bool failed;
+} ScalingResult;
+
+// Entry points that fan out to worker threads themselves would measure the pool rather than the caller
+bool runs_on_caller(const BenchCase *benchCase)
+{
+    return benchCase->run == bench_blob || benchCase->run == bench_reflect;
+}
+
+int count_applicable_shaders(const BenchShader *shaders, int numShaders, const BenchCase *benchCase)
+{
+    int count = 0;
+    for (int i = 0; i < numShaders; i += 1) {
+        if (get_skip_reason(&shaders[i], benchCase) == NULL) {
+            count += 1;
+        }
+    }
+    return count;
+}
+
+int SDLCALL scaling_thread(void *data)
+{
+    ScalingThread *thread = (ScalingThread *)data;
+    SDL_WaitSemaphore(thread->start);
+
+    // Each thread starts at a different shader, so they don't all compile the same one in lockstep
+    for (int pass = 0; pass < thread->options->iterations; pass += 1) {
+        for (int i = 0; i < thread->numShaders; i += 1) {
+            const BenchShader *shader = &thread->shaders[(thread->firstShader + i) % thread->numShaders];
+            if (get_skip_reason(shader, thread->benchCase) != NULL) {
+                continue;
+            }
+            size_t outputSize = 0;
+            Uint64 start = SDL_GetTicksNS();
+            if (!thread->benchCase->run(shader, thread->benchCase, &outputSize)) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s %s (%s): %s", shader->name, thread->benchCase->entryPoint, thread->benchCase->formatName, SDL_GetError());
+                thread->failed = true;
+                return 1;
+            }
+            thread->samples[thread->numSamples++] = SDL_GetTicksNS() - start;
+        }
+    }
+    return 0;
+}
+
+bool run_scaling_step(const BenchOptions *options, const BenchShader *shaders, int numShaders, const BenchCase *benchCase, int numThreads, ScalingResult *result)
+{
+    int samplesPerThread = options->iterations * count_applicable_shaders(shaders, numShaders, benchCase);
+    ScalingThread *threads = SDL_calloc(numThreads, sizeof(ScalingThread));
+    SDL_Thread **handles = SDL_calloc(numThreads, sizeof(SDL_Thread *));
+    Uint64 *samples = SDL_calloc((size_t)samplesPerThread * numThreads, sizeof(Uint64));
+    SDL_Semaphore *start = SDL_CreateSemaphore(0);
+    if (threads == NULL || handles == NULL || samples == NULL || start == NULL) {
+        SDL_free(threads);
+        SDL_free(handles);
+        SDL_free(samples);
+        if (start != NULL) {
+            SDL_DestroySemaphore(start);
+        }
+        return false;
+    }
+
+    SDL_zerop(result);
+    result->benchCase = benchCase;
+    result->numThreads = numThreads;
+
+    if (perCasePeakMemory) {
+        reset_peak_memory();
+    }
+    int numStarted = 0;
+    for (int i = 0; i < numThreads; i += 1) {
+        threads[i].options = options;
+        threads[i].shaders = shaders;
+        threads[i].numShaders = numShaders;
+        threads[i].firstShader = i % numShaders;
+        threads[i].benchCase = benchCase;
+        threads[i].start = start;
+        threads[i].samples = samples + (size_t)samplesPerThread * i;
+        handles[i] = SDL_CreateThread(scaling_thread, "shadercross-bench", &threads[i]);
+        if (handles[i] == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start a thread (%s)", SDL_GetError());
+            result->failed = true;
+            break;
+        }
+        numStarted += 1;
+    }
+
+    Uint64 cpuStart = get_cpu_time();
+    Uint64 wallStart = SDL_GetTicksNS();
+    for (int i = 0; i < numStarted; i += 1) {
+        SDL_SignalSemaphore(start);
+    }
+    for (int i = 0; i < numStarted; i += 1) {
+        SDL_WaitThread(handles[i], NULL);
+    }
+    result->wallNS = SDL_GetTicksNS() - wallStart;
+    result->cpuNS = get_cpu_time() - cpuStart;
+    result->peakMemory = get_peak_memory();
+
+    // Gather every thread's samples into one sorted run
+    for (int i = 0; i < numStarted; i += 1) {
+        if (threads[i].failed) {
+            result->failed = true;
+        }
+        SDL_memmove(samples + result->compiles, threads[i].samples, threads[i].numSamples * sizeof(Uint64));
+        result->compiles += threads[i].numSamples;
+    }
+    if (!result->failed && result->compiles > 0 && result->wallNS > 0) {
+        SDL_qsort(samples, result->compiles, sizeof(Uint64), compare_times);
+        result->p50NS = percentile(samples, result->compiles, 50);
+        result->p99NS = percentile(samples, result->compiles, 99);
+        result->throughput = (double)result->compiles * SDL_NS_PER_SECOND / (double)result->wallNS;
+        result->cpuUtilization = (double)result->cpuNS / ((double)result->wallNS * numThreads);
+    }
+
+    SDL_DestroySemaphore(start);
+    SDL_free(samples);
+    SDL_free(handles);
+    SDL_free(threads);
+    return !result->failed;
+}
+
+void log_scaling_result(const ScalingResult *result)
+{
+    if (result->failed) {
+        SDL_Log("%7d %s", result->numThreads, "FAILED");
+        return;
+    }
+    SDL_Log("%7d %10.1f %10.1f %9.2fx %8.1f%% %9.3f %9.3f %8.1f%% %9.1f",
+            result->numThreads,
+            result->throughput,
+            result->throughput / result->numThreads,
+            result->speedup,
+            result->efficiency * 100.0,
+            to_ms(result->p50NS),
+            to_ms(result->p99NS),
+            result->cpuUtilization * 100.0,
+            to_mib(result->peakMemory));
+}
+
+bool write_scaling_json(const BenchOptions *options, const ScalingResult *results, int numResults)
+{
+    SDL_IOStream *io = SDL_IOFromFile(options->jsonPath, "w");
+    if (io == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return false;
+    }
+
+    SDL_IOprintf(io, "{\n");
+    SDL_IOprintf(io, "  \"mode\": \"scaling\",\n");
+    SDL_IOprintf(io, "  \"passes\": %d,\n", options->iterations);
+    SDL_IOprintf(io, "  \"cpu_cores\": %d,\n", SDL_GetNumLogicalCPUCores());
+    SDL_IOprintf(io, "  \"peak_memory_bytes\": %" SDL_PRIu64 ",\n", get_process_peak_memory());
+    SDL_IOprintf(io, "  \"results\": [");
+    for (int i = 0; i < numResults; i += 1) {
+        const ScalingResult *result = &results[i];
+        SDL_IOprintf(io, "%s\n    {\n", i > 0 ? "," : "");
+        SDL_IOprintf(io, "      \"entry_point\": \"%s\",\n", result->benchCase->entryPoint);
+        SDL_IOprintf(io, "      \"format\": \"%s\",\n", result->benchCase->formatName);
+        SDL_IOprintf(io, "      \"threads\": %d,\n", result->numThreads);
+        if (result->failed) {
+            SDL_IOprintf(io, "      \"failed\": true\n");
+        } else {
+            SDL_IOprintf(io, "      \"failed\": false,\n");
+            SDL_IOprintf(io, "      \"compiles\": %d,\n", result->compiles);
+            SDL_IOprintf(io, "      \"wall_ms\": %.3f,\n", to_ms(result->wallNS));
+            SDL_IOprintf(io, "      \"cpu_ms\": %.3f,\n", to_ms(result->cpuNS));
+            SDL_IOprintf(io, "      \"compiles_per_second\": %.3f,\n", result->throughput);
+            SDL_IOprintf(io, "      \"speedup\": %.3f,\n", result->speedup);
+            SDL_IOprintf(io, "      \"efficiency\": %.3f,\n", result->efficiency);
+            SDL_IOprintf(io, "      \"cpu_utilization\": %.3f,\n", result->cpuUtilization);
+            SDL_IOprintf(io, "      \"p50_ms\": %.3f,\n", to_ms(result->p50NS));
+            SDL_IOprintf(io, "      \"p99_ms\": %.3f,\n", to_ms(result->p99NS));
+            SDL_IOprintf(io, "      \"%s\": %" SDL_PRIu64 "\n", get_peak_memory_key(), result->peakMemory);
+        }
+        SDL_IOprintf(io, "    }");
+    }
+    SDL_IOprintf(io, "\n  ]\n}\n");
+
+    if (!SDL_CloseIO(io)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+// Runs every case on 1, 2, 4... threads up to the maximum, each thread compiling the whole corpus
+int run_scaling(const BenchOptions *options, const BenchShader *shaders, int numShaders)
+{
+    int numSteps = 1;
+    while ((1 << (numSteps - 1)) < options->maxThreads) {
+        numSteps += 1;
+    }
+
+    ScalingResult *results = SDL_calloc((size_t)numSteps * SDL_arraysize(cases), sizeof(ScalingResult));
+    if (results == NULL) {
+        return 1;
+    }
+
+    int result = 0;
+    int numResults = 0;
+    for (int i = 0; i < (int)SDL_arraysize(cases); i += 1) {
+        const BenchCase *benchCase = &cases[i];
+        if (!runs_on_caller(benchCase)) {
+            continue;
+        }
+        if (options->filter != NULL &&
+            !SDL_strcasestr(benchCase->entryPoint, options->filter) &&
+            !SDL_strcasestr(benchCase->formatName, options->filter)) {
+            continue;
+        }
+        int numApplicable = count_applicable_shaders(shaders, numShaders, benchCase);
+        if (numApplicable == 0) {
+            continue;
+        }
+        if (options->list) {
+            SDL_Log("%-46s %-14s %d shaders", benchCase->entryPoint, benchCase->formatName, numApplicable);
+            continue;
+        }
+
+        SDL_Log("%s (%s), %d shaders x %d passes per thread", benchCase->entryPoint, benchCase->formatName, numApplicable, options->iterations);
+        SDL_Log("%7s %10s %10s %10s %9s %9s %9s %9s %9s",
+                "threads", "per sec", "per thread", "speedup", "effic.", "p50 ms", "p99 ms", "cpu", get_peak_memory_column());
+
+        // Warm up on this thread, so the first step doesn't pay for loading the compilers
+        if (options->warmup > 0) {
+            for (int j = 0; j < numShaders; j += 1) {
+                size_t outputSize;
+                if (get_skip_reason(&shaders[j], benchCase) == NULL) {
+                    benchCase->run(&shaders[j], benchCase, &outputSize);
+                }
+            }
+        }
+
+        double baseline = 0.0;
+        for (int step = 0; step < numSteps; step += 1) {
+            int numThreads = SDL_min(1 << step, options->maxThreads);
+            ScalingResult *scalingResult = &results[numResults++];
+            if (!run_scaling_step(options, shaders, numShaders, benchCase, numThreads, scalingResult)) {
+                result = 1;
+                log_scaling_result(scalingResult);
+                break;
+            }
+            if (step == 0) {
+                baseline = scalingResult->throughput;
+            }
+            scalingResult->speedup = baseline > 0.0 ? scalingResult->throughput / baseline : 0.0;
+            scalingResult->efficiency = scalingResult->speedup / numThreads;
+            log_scaling_result(scalingResult);
+        }
+        SDL_Log("\n");
+    }
+
+    if (!options->list && options->jsonPath != NULL && !write_scaling_json(options, results, numResults)) {
+        result = 1;
+    }
+
+    SDL_free(results);
+    return result;
+}
+
+int run_bench(const BenchOptions *options)
+{
+    int numShaders = 0;
+    BenchShader *shaders = load_corpus(options, &numShaders);
+    if (shaders == NULL) {
+        return 1;
+    }
+    if (numShaders == 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "No shaders found in %s", options->corpusDir);
+        free_corpus(shaders, numShaders);
+        return 1;
+    }
+
+    int result;
+    if (options->scaling) {
+        result = run_scaling(options, shaders, numShaders);
+    } else {
+        result = run_latency(options, shaders, numShaders);
+    }
+
+    free_corpus(shaders, numShaders);
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+    if (!parse_args(argc, argv, &options)) {
+        print_help();
+        return 1;
+    }
+    if (options.showHelp) {
+        print_help();
+        return 0;
+    }
+
+    // No cache directory and no memory cache budget, so every iteration compiles from scratch
+    if (!SDL_ShaderCross_Init()) {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "%s", "Failed to initialize shadercross!");
+        return 1;
+    }
+
+    perCasePeakMemory = reset_peak_memory();
+    if (!perCasePeakMemory) {
+        SDL_Log("%s", "Peak memory can't be measured per case here, results show the cumulative max RSS of the process.");
+    }
+
+    int result = run_bench(&options);
+
+    SDL_ShaderCross_Quit();
+    return result;
+}
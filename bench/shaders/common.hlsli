@@ -0,0 +1,100 @@
+#ifndef BENCH_COMMON_HLSLI
+#define BENCH_COMMON_HLSLI
+
+static const float PI = 3.14159265f;
+
+float3 DecodeNormal(float2 encoded)
+{
+    float3 n = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-n.z);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+float3 SRGBToLinear(float3 color)
+{
+    return lerp(pow((color + 0.055f) / 1.055f, 2.4f), color / 12.92f, step(color, 0.04045f));
+}
+
+float3 LinearToSRGB(float3 color)
+{
+    return lerp(1.055f * pow(color, 1.0f / 2.4f) - 0.055f, color * 12.92f, step(color, 0.0031308f));
+}
+
+float Luminance(float3 color)
+{
+    return dot(color, float3(0.2126f, 0.7152f, 0.0722f));
+}
+
+float3 ACESFilm(float3 x)
+{
+    return saturate((x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f));
+}
+
+float DistributionGGX(float ndoth, float roughness)
+{
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float d = ndoth * ndoth * (a2 - 1.0f) + 1.0f;
+    return a2 / max(PI * d * d, 1e-6f);
+}
+
+float GeometrySmith(float ndotv, float ndotl, float roughness)
+{
+    float k = (roughness + 1.0f) * (roughness + 1.0f) / 8.0f;
+    float gv = ndotv / (ndotv * (1.0f - k) + k);
+    float gl = ndotl / (ndotl * (1.0f - k) + k);
+    return gv * gl;
+}
+
+float3 FresnelSchlick(float cos_theta, float3 f0)
+{
+    return f0 + (1.0f - f0) * pow(saturate(1.0f - cos_theta), 5.0f);
+}
+
+float3 EvaluateBRDF(float3 n, float3 v, float3 l, float3 albedo, float metallic, float roughness)
+{
+    float3 h = normalize(v + l);
+    float ndotl = saturate(dot(n, l));
+    float ndotv = max(dot(n, v), 1e-4f);
+    float ndoth = saturate(dot(n, h));
+    float3 f0 = lerp(float3(0.04f, 0.04f, 0.04f), albedo, metallic);
+    float3 f = FresnelSchlick(saturate(dot(h, v)), f0);
+    float3 specular = DistributionGGX(ndoth, roughness) * GeometrySmith(ndotv, ndotl, roughness) * f / (4.0f * ndotv * max(ndotl, 1e-4f));
+    float3 diffuse = (1.0f - f) * (1.0f - metallic) * albedo / PI;
+    return (diffuse + specular) * ndotl;
+}
+
+float3 EvaluateSH(float4 sh[9], float3 n)
+{
+    float3 result = sh[0].rgb * 0.282095f;
+    result += sh[1].rgb * 0.488603f * n.y;
+    result += sh[2].rgb * 0.488603f * n.z;
+    result += sh[3].rgb * 0.488603f * n.x;
+    result += sh[4].rgb * 1.092548f * n.x * n.y;
+    result += sh[5].rgb * 1.092548f * n.y * n.z;
+    result += sh[6].rgb * 0.315392f * (3.0f * n.z * n.z - 1.0f);
+    result += sh[7].rgb * 1.092548f * n.x * n.z;
+    result += sh[8].rgb * 0.546274f * (n.x * n.x - n.y * n.y);
+    return max(result, 0.0f);
+}
+
+float Hash(float2 p)
+{
+    return frac(sin(dot(p, float2(127.1f, 311.7f))) * 43758.5453f);
+}
+
+float ValueNoise(float2 p)
+{
+    float2 i = floor(p);
+    float2 f = frac(p);
+    float2 u = f * f * (3.0f - 2.0f * f);
+    float a = Hash(i);
+    float b = Hash(i + float2(1.0f, 0.0f));
+    float c = Hash(i + float2(0.0f, 1.0f));
+    float d = Hash(i + float2(1.0f, 1.0f));
+    return lerp(lerp(a, b, u.x), lerp(c, d, u.x), u.y);
+}
+
+#endif
@@ -0,0 +1,11 @@
+struct Output
+{
+    float4 position : SV_Position;
+};
+
+Output main(float3 position : TEXCOORD0)
+{
+    Output output;
+    output.position = float4(position, 1.0f);
+    return output;
+}
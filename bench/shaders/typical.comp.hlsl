@@ -0,0 +1,50 @@
+// One pass of a separable gaussian blur, the kind of post-processing kernel
+// most renderers ship a handful of.
+
+Texture2D<float4> Input : register(t0, space0);
+RWTexture2D<float4> Output : register(u0, space1);
+
+cbuffer Params : register(b0, space2)
+{
+    int2 direction;
+    int2 size;
+};
+
+#define GROUP_SIZE 128
+#define RADIUS 8
+
+static const float weights[RADIUS + 1] = {
+    0.1038f, 0.0975f, 0.0916f, 0.0783f, 0.0630f, 0.0475f, 0.0337f, 0.0225f, 0.0140f
+};
+
+groupshared float4 cache[GROUP_SIZE + 2 * RADIUS];
+
+float4 Fetch(int2 pixel)
+{
+    return Input.Load(int3(clamp(pixel, int2(0, 0), size - 1), 0));
+}
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void main(uint3 group : SV_GroupID, uint3 local : SV_GroupThreadID)
+{
+    int2 across = int2(direction.y, direction.x);
+    int2 origin = direction * int(group.x * GROUP_SIZE) + across * int(group.y);
+    int index = int(local.x);
+
+    cache[index + RADIUS] = Fetch(origin + direction * index);
+    if (index < RADIUS) {
+        cache[index] = Fetch(origin + direction * (index - RADIUS));
+        cache[index + GROUP_SIZE + RADIUS] = Fetch(origin + direction * (index + GROUP_SIZE));
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    float4 sum = cache[index + RADIUS] * weights[0];
+    [unroll] for (int i = 1; i <= RADIUS; i++) {
+        sum += (cache[index + RADIUS - i] + cache[index + RADIUS + i]) * weights[i];
+    }
+
+    int2 pixel = origin + direction * index;
+    if (all(pixel < size)) {
+        Output[uint2(pixel)] = sum;
+    }
+}
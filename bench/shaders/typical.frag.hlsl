@@ -0,0 +1,64 @@
+#include "common.hlsli"
+
+Texture2D<float4> AlbedoTexture : register(t0, space2);
+SamplerState AlbedoSampler : register(s0, space2);
+Texture2D<float4> NormalTexture : register(t1, space2);
+SamplerState NormalSampler : register(s1, space2);
+Texture2D<float> ShadowTexture : register(t2, space2);
+SamplerComparisonState ShadowSampler : register(s2, space2);
+
+cbuffer Lighting : register(b0, space3)
+{
+    float4x4 light_view_projection;
+    float3 light_direction;
+    float shadow_bias;
+    float3 light_color;
+    float ambient;
+};
+
+struct Input
+{
+    float3 world_position : TEXCOORD0;
+    float3 normal : TEXCOORD1;
+    float4 tangent : TEXCOORD2;
+    float2 uv : TEXCOORD3;
+    float4 color : TEXCOORD4;
+    float3 view_dir : TEXCOORD5;
+};
+
+float SampleShadow(float3 world_position)
+{
+    float4 clip = mul(light_view_projection, float4(world_position, 1.0f));
+    float3 ndc = clip.xyz / clip.w;
+    float2 uv = ndc.xy * float2(0.5f, -0.5f) + 0.5f;
+    float width, height;
+    ShadowTexture.GetDimensions(width, height);
+    float2 texel = 1.0f / float2(width, height);
+    float sum = 0.0f;
+    [unroll] for (int y = -1; y <= 1; y++) {
+        [unroll] for (int x = -1; x <= 1; x++) {
+            sum += ShadowTexture.SampleCmpLevelZero(ShadowSampler, uv + float2(x, y) * texel, ndc.z - shadow_bias);
+        }
+    }
+    return sum / 9.0f;
+}
+
+float4 main(Input input) : SV_Target0
+{
+    float4 albedo = AlbedoTexture.Sample(AlbedoSampler, input.uv) * input.color;
+    float3 n = normalize(input.normal);
+    float3 t = normalize(input.tangent.xyz - n * dot(n, input.tangent.xyz));
+    float3 b = cross(n, t) * input.tangent.w;
+    float3 tn = NormalTexture.Sample(NormalSampler, input.uv).xyz * 2.0f - 1.0f;
+    n = normalize(tn.x * t + tn.y * b + tn.z * n);
+
+    float3 v = normalize(input.view_dir);
+    float3 l = -light_direction;
+    float3 h = normalize(l + v);
+    float ndotl = saturate(dot(n, l));
+    float specular = pow(saturate(dot(n, h)), 64.0f) * ndotl;
+    float shadow = SampleShadow(input.world_position);
+
+    float3 color = albedo.rgb * (ambient + light_color * ndotl * shadow) + light_color * specular * shadow;
+    return float4(LinearToSRGB(ACESFilm(color)), albedo.a);
+}
@@ -0,0 +1,48 @@
+#include "common.hlsli"
+
+cbuffer Camera : register(b0, space1)
+{
+    float4x4 view_projection;
+    float3 camera_position;
+    float time;
+};
+
+cbuffer Object : register(b1, space1)
+{
+    float4x4 model;
+    float4x4 normal_matrix;
+};
+
+struct Input
+{
+    float3 position : TEXCOORD0;
+    float2 normal : TEXCOORD1;
+    float4 tangent : TEXCOORD2;
+    float2 uv : TEXCOORD3;
+    float4 color : TEXCOORD4;
+};
+
+struct Output
+{
+    float4 position : SV_Position;
+    float3 world_position : TEXCOORD0;
+    float3 normal : TEXCOORD1;
+    float4 tangent : TEXCOORD2;
+    float2 uv : TEXCOORD3;
+    float4 color : TEXCOORD4;
+    float3 view_dir : TEXCOORD5;
+};
+
+Output main(Input input)
+{
+    Output output;
+    float4 world = mul(model, float4(input.position, 1.0f));
+    output.position = mul(view_projection, world);
+    output.world_position = world.xyz;
+    output.normal = normalize(mul((float3x3)normal_matrix, DecodeNormal(input.normal)));
+    output.tangent = float4(normalize(mul((float3x3)model, input.tangent.xyz)), input.tangent.w);
+    output.uv = input.uv;
+    output.color = float4(SRGBToLinear(input.color.rgb), input.color.a);
+    output.view_dir = camera_position - world.xyz;
+    return output;
+}
@@ -0,0 +1,222 @@
+// Tiled deferred lighting: per-tile depth bounds, light culling against the
+// tile frustum, a bitonic sort of the visible lights and PBR shading with
+// cascaded shadows. The sort and shadow loops are fully unrolled, so the
+// generated code is representative of the largest compute shaders engines
+// ship. BENCH_PERMUTATION masks features out for permutation benchmarks.
+
+#include "common.hlsli"
+
+#ifndef BENCH_PERMUTATION
+#define BENCH_PERMUTATION 0
+#endif
+
+#define FEATURE_SORT    ((BENCH_PERMUTATION & 1) == 0)
+#define FEATURE_SHADOWS ((BENCH_PERMUTATION & 2) == 0)
+#define FEATURE_AMBIENT ((BENCH_PERMUTATION & 4) == 0)
+#define FEATURE_DEBUG   ((BENCH_PERMUTATION & 8) != 0)
+
+#define TILE_SIZE 16
+#define TILE_PIXELS (TILE_SIZE * TILE_SIZE)
+#define MAX_LIGHTS 256
+#define NUM_CASCADES 4
+#define PCF_RADIUS 2
+
+Texture2D<float4> AlbedoMetallic : register(t0, space0);
+Texture2D<float4> NormalRoughness : register(t1, space0);
+Texture2D<float> Depth : register(t2, space0);
+Texture2DArray<float> ShadowCascades : register(t3, space0);
+RWTexture2D<float4> Output : register(u0, space1);
+
+struct Light
+{
+    float4 position_range;    // xyz: view space position, w: range
+    float4 color_intensity;
+};
+
+cbuffer Frame : register(b0, space2)
+{
+    float4x4 inverse_projection;
+    float4x4 inverse_view;
+    float4x4 cascade_matrices[NUM_CASCADES];
+    float4 cascade_splits;
+    float4 sh[9];
+    float4 sun_direction_intensity;
+    float4 sun_color;
+    uint2 screen_size;
+    float shadow_bias;
+    float shadow_size;
+};
+
+cbuffer Lights : register(b1, space2)
+{
+    Light lights[MAX_LIGHTS];
+    uint num_lights;
+    float3 lights_padding;
+};
+
+groupshared uint tile_min_depth;
+groupshared uint tile_max_depth;
+groupshared uint tile_light_count;
+groupshared uint tile_lights[MAX_LIGHTS];
+groupshared float tile_light_keys[MAX_LIGHTS];
+
+float3 ViewPosition(float2 pixel, float depth)
+{
+    float2 ndc = (pixel + 0.5f) / float2(screen_size) * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
+    float4 view = mul(inverse_projection, float4(ndc, depth, 1.0f));
+    return view.xyz / view.w;
+}
+
+float4 FrustumPlane(float3 a, float3 b)
+{
+    float3 n = normalize(cross(a, b));
+    return float4(n, 0.0f);
+}
+
+float SampleCascade(int cascade, float3 world_position)
+{
+    float4 shadow_coord = mul(cascade_matrices[cascade], float4(world_position, 1.0f));
+    float3 coord = shadow_coord.xyz / shadow_coord.w;
+    float2 texel = (coord.xy * float2(0.5f, -0.5f) + 0.5f) * shadow_size;
+    float depth = coord.z - shadow_bias * (1.0f + cascade);
+    float sum = 0.0f;
+    [unroll] for (int y = -PCF_RADIUS; y <= PCF_RADIUS; y++) {
+        [unroll] for (int x = -PCF_RADIUS; x <= PCF_RADIUS; x++) {
+            int2 location = clamp(int2(texel) + int2(x, y), int2(0, 0), int2(shadow_size - 1.0f, shadow_size - 1.0f));
+            sum += ShadowCascades.Load(int4(location, cascade, 0)) >= depth ? 1.0f : 0.0f;
+        }
+    }
+    return sum / ((2 * PCF_RADIUS + 1) * (2 * PCF_RADIUS + 1));
+}
+
+float SampleShadows(float3 world_position, float view_depth)
+{
+    float shadow = 1.0f;
+    [unroll] for (int c = NUM_CASCADES - 1; c >= 0; c--) {
+        if (view_depth < cascade_splits[c]) {
+            shadow = SampleCascade(c, world_position);
+        }
+    }
+    return shadow;
+}
+
+[numthreads(TILE_SIZE, TILE_SIZE, 1)]
+void main(uint3 group : SV_GroupID, uint3 id : SV_DispatchThreadID, uint local_index : SV_GroupIndex)
+{
+    if (local_index == 0) {
+        tile_min_depth = 0xFFFFFFFFu;
+        tile_max_depth = 0u;
+        tile_light_count = 0u;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 pixel = min(id.xy, screen_size - 1);
+    float depth = Depth.Load(int3(pixel, 0));
+    uint depth_bits = asuint(depth);
+    InterlockedMin(tile_min_depth, depth_bits);
+    InterlockedMax(tile_max_depth, depth_bits);
+    GroupMemoryBarrierWithGroupSync();
+
+    // Tile frustum in view space, from the corners of the tile on the near plane
+    float2 tile_min = float2(group.xy * TILE_SIZE);
+    float2 tile_max = tile_min + TILE_SIZE;
+    float3 corners[4];
+    corners[0] = ViewPosition(float2(tile_min.x, tile_min.y), 1.0f);
+    corners[1] = ViewPosition(float2(tile_max.x, tile_min.y), 1.0f);
+    corners[2] = ViewPosition(float2(tile_max.x, tile_max.y), 1.0f);
+    corners[3] = ViewPosition(float2(tile_min.x, tile_max.y), 1.0f);
+    float4 planes[4];
+    [unroll] for (int p = 0; p < 4; p++) {
+        planes[p] = FrustumPlane(corners[p], corners[(p + 1) % 4]);
+    }
+    float near_z = ViewPosition(tile_min, asfloat(tile_min_depth)).z;
+    float far_z = ViewPosition(tile_min, asfloat(tile_max_depth)).z;
+    float min_z = min(near_z, far_z);
+    float max_z = max(near_z, far_z);
+
+    uint light_limit = min(num_lights, MAX_LIGHTS);
+    for (uint i = local_index; i < light_limit; i += TILE_PIXELS) {
+        float4 sphere = lights[i].position_range;
+        bool visible = sphere.z + sphere.w >= min_z && sphere.z - sphere.w <= max_z;
+        [unroll] for (int q = 0; q < 4; q++) {
+            visible = visible && dot(planes[q].xyz, sphere.xyz) + planes[q].w >= -sphere.w;
+        }
+        if (visible) {
+            uint slot;
+            InterlockedAdd(tile_light_count, 1u, slot);
+            tile_lights[slot] = i;
+            tile_light_keys[slot] = abs(sphere.z);
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint count = tile_light_count;
+
+#if FEATURE_SORT
+    // Pad to a power of two so the bitonic network sorts every slot
+    if (local_index >= count) {
+        tile_lights[local_index] = 0u;
+        tile_light_keys[local_index] = 3.402823466e+38f;
+    }
+    GroupMemoryBarrierWithGroupSync();
+    [unroll] for (uint k = 2; k <= MAX_LIGHTS; k *= 2) {
+        [unroll] for (uint j = k / 2; j > 0; j /= 2) {
+            uint partner = local_index ^ j;
+            if (partner > local_index) {
+                bool ascending = (local_index & k) == 0;
+                float key_a = tile_light_keys[local_index];
+                float key_b = tile_light_keys[partner];
+                if ((key_a > key_b) == ascending) {
+                    uint light_a = tile_lights[local_index];
+                    tile_light_keys[local_index] = key_b;
+                    tile_light_keys[partner] = key_a;
+                    tile_lights[local_index] = tile_lights[partner];
+                    tile_lights[partner] = light_a;
+                }
+            }
+            GroupMemoryBarrierWithGroupSync();
+        }
+    }
+#endif
+
+    if (any(id.xy >= screen_size)) {
+        return;
+    }
+
+    float4 albedo_metallic = AlbedoMetallic.Load(int3(pixel, 0));
+    float4 normal_roughness = NormalRoughness.Load(int3(pixel, 0));
+    float3 albedo = albedo_metallic.rgb;
+    float metallic = albedo_metallic.a;
+    float roughness = max(normal_roughness.a, 0.045f);
+    float3 n = normalize(normal_roughness.xyz * 2.0f - 1.0f);
+    float3 view_position = ViewPosition(float2(pixel), depth);
+    float3 v = normalize(-view_position);
+
+    float3 color = 0.0f;
+    for (uint l = 0; l < count; l++) {
+        Light light = lights[tile_lights[l]];
+        float3 to_light = light.position_range.xyz - view_position;
+        float distance_squared = max(dot(to_light, to_light), 1e-4f);
+        float range_factor = saturate(1.0f - pow(distance_squared / (light.position_range.w * light.position_range.w), 2.0f));
+        float attenuation = light.color_intensity.a * range_factor * range_factor / distance_squared;
+        color += EvaluateBRDF(n, v, to_light * rsqrt(distance_squared), albedo, metallic, roughness) * light.color_intensity.rgb * attenuation;
+    }
+
+    float shadow = 1.0f;
+#if FEATURE_SHADOWS
+    float3 world_position = mul(inverse_view, float4(view_position, 1.0f)).xyz;
+    shadow = SampleShadows(world_position, -view_position.z);
+#endif
+    color += EvaluateBRDF(n, v, -sun_direction_intensity.xyz, albedo, metallic, roughness) * sun_color.rgb * sun_direction_intensity.w * shadow;
+
+#if FEATURE_AMBIENT
+    float3 world_normal = mul((float3x3)inverse_view, n);
+    color += EvaluateSH(sh, world_normal) * albedo * (1.0f - metallic);
+#endif
+
+#if FEATURE_DEBUG
+    color = lerp(color, float3(count / 32.0f, 1.0f - count / 32.0f, 0.0f), 0.5f);
+#endif
+
+    Output[pixel] = float4(color, 1.0f);
+}
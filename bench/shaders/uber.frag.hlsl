@@ -0,0 +1,272 @@
+// Uber material shader: PBR with parallax occlusion, detail layers, clear
+// coat, cascaded shadows, image based lighting and fog. The light, cascade
+// and parallax loops are fully unrolled, so the generated code is
+// representative of the largest pixel shaders engines ship.
+// BENCH_PERMUTATION masks features out for permutation benchmarks.
+
+#include "common.hlsli"
+
+#ifndef BENCH_PERMUTATION
+#define BENCH_PERMUTATION 0
+#endif
+
+#define FEATURE_PARALLAX  ((BENCH_PERMUTATION & 1) == 0)
+#define FEATURE_DETAIL    ((BENCH_PERMUTATION & 2) == 0)
+#define FEATURE_CLEARCOAT ((BENCH_PERMUTATION & 4) == 0)
+#define FEATURE_FOG       ((BENCH_PERMUTATION & 8) == 0)
+
+#define NUM_LIGHTS 32
+#define NUM_CASCADES 4
+#define PCF_RADIUS 2
+#define PARALLAX_STEPS 24
+
+Texture2D<float4> BaseColorTexture : register(t0, space2);
+SamplerState BaseColorSampler : register(s0, space2);
+Texture2D<float4> NormalTexture : register(t1, space2);
+SamplerState NormalSampler : register(s1, space2);
+Texture2D<float4> ORMTexture : register(t2, space2);
+SamplerState ORMSampler : register(s2, space2);
+Texture2D<float4> EmissiveTexture : register(t3, space2);
+SamplerState EmissiveSampler : register(s3, space2);
+Texture2D<float> HeightTexture : register(t4, space2);
+SamplerState HeightSampler : register(s4, space2);
+Texture2D<float4> DetailAlbedoTexture : register(t5, space2);
+SamplerState DetailAlbedoSampler : register(s5, space2);
+Texture2D<float4> DetailNormalTexture : register(t6, space2);
+SamplerState DetailNormalSampler : register(s6, space2);
+Texture2D<float4> ClearcoatNormalTexture : register(t7, space2);
+SamplerState ClearcoatNormalSampler : register(s7, space2);
+Texture2DArray<float> ShadowCascades : register(t8, space2);
+SamplerComparisonState ShadowSampler : register(s8, space2);
+TextureCube<float4> EnvironmentTexture : register(t9, space2);
+SamplerState EnvironmentSampler : register(s9, space2);
+Texture2D<float2> BRDFTexture : register(t10, space2);
+SamplerState BRDFSampler : register(s10, space2);
+
+struct Light
+{
+    float4 position_range;    // xyz: position, w: range (0 for directional)
+    float4 color_intensity;   // rgb: color, a: intensity
+    float4 direction_cone;    // xyz: direction, w: cos outer cone angle
+    float4 shadow_params;     // x: inner cone cos, y: source radius, zw: unused
+};
+
+cbuffer Material : register(b0, space3)
+{
+    float4 base_color_factor;
+    float3 emissive_factor;
+    float metallic_factor;
+    float roughness_factor;
+    float occlusion_strength;
+    float parallax_scale;
+    float detail_scale;
+    float clearcoat_factor;
+    float clearcoat_roughness;
+    float alpha_cutoff;
+    float material_padding;
+};
+
+cbuffer Frame : register(b1, space3)
+{
+    float4 cascade_splits;
+    float4 sh[9];
+    float4 fog_color_density;
+    float4 fog_height_falloff;
+    float3 camera_position;
+    float exposure;
+    float shadow_bias;
+    float shadow_texel_size;
+    float environment_mips;
+    float frame_padding;
+};
+
+cbuffer Lights : register(b2, space3)
+{
+    Light lights[NUM_LIGHTS];
+    uint num_lights;
+    float3 lights_padding;
+};
+
+struct Input
+{
+    float3 world_position : TEXCOORD0;
+    float3 normal : TEXCOORD1;
+    float4 tangent : TEXCOORD2;
+    float4 uv : TEXCOORD3;
+    float4 color : TEXCOORD4;
+    float3 view_dir : TEXCOORD5;
+    float4 current_clip : TEXCOORD6;
+    float4 previous_clip : TEXCOORD7;
+    float4 shadow_coords[NUM_CASCADES] : TEXCOORD8;
+    float view_depth : TEXCOORD12;
+};
+
+struct Output
+{
+    float4 color : SV_Target0;
+    float4 normal_roughness : SV_Target1;
+    float2 velocity : SV_Target2;
+};
+
+float2 ParallaxOcclusion(float2 uv, float3 view_ts)
+{
+#if FEATURE_PARALLAX
+    float2 dx = ddx(uv);
+    float2 dy = ddy(uv);
+    float2 step_uv = view_ts.xy / max(view_ts.z, 0.05f) * parallax_scale / PARALLAX_STEPS;
+    float step_height = 1.0f / PARALLAX_STEPS;
+    float2 current_uv = uv;
+    float current_height = 1.0f;
+    float previous_sample = 1.0f;
+    float2 hit_uv = uv;
+    bool found = false;
+    [unroll] for (int i = 0; i < PARALLAX_STEPS; i++) {
+        float height = HeightTexture.SampleGrad(HeightSampler, current_uv, dx, dy);
+        if (!found && height >= current_height) {
+            float after = height - current_height;
+            float before = previous_sample - (current_height + step_height);
+            float weight = after / (after - before);
+            hit_uv = lerp(current_uv, current_uv + step_uv, weight);
+            found = true;
+        }
+        previous_sample = height;
+        current_uv -= step_uv;
+        current_height -= step_height;
+    }
+    return found ? hit_uv : current_uv;
+#else
+    return uv;
+#endif
+}
+
+float SampleCascade(int cascade, float4 shadow_coord)
+{
+    float3 coord = shadow_coord.xyz / shadow_coord.w;
+    float2 uv = coord.xy * float2(0.5f, -0.5f) + 0.5f;
+    float depth = coord.z - shadow_bias * (1.0f + cascade);
+    float sum = 0.0f;
+    [unroll] for (int y = -PCF_RADIUS; y <= PCF_RADIUS; y++) {
+        [unroll] for (int x = -PCF_RADIUS; x <= PCF_RADIUS; x++) {
+            float3 location = float3(uv + float2(x, y) * shadow_texel_size, cascade);
+            sum += ShadowCascades.SampleCmpLevelZero(ShadowSampler, location, depth);
+        }
+    }
+    return sum / ((2 * PCF_RADIUS + 1) * (2 * PCF_RADIUS + 1));
+}
+
+float SampleShadows(Input input)
+{
+    float shadow = 1.0f;
+    float blend = 1.0f;
+    [unroll] for (int c = NUM_CASCADES - 1; c >= 0; c--) {
+        if (input.view_depth < cascade_splits[c]) {
+            float cascade_shadow = SampleCascade(c, input.shadow_coords[c]);
+            float fade = saturate((cascade_splits[c] - input.view_depth) / (cascade_splits[c] * 0.1f));
+            shadow = lerp(shadow, cascade_shadow, c == NUM_CASCADES - 1 ? fade : blend);
+        }
+    }
+    return shadow;
+}
+
+float3 EvaluateLight(Light light, float3 world_position, float3 n, float3 v, float3 albedo, float metallic, float roughness, float shadow)
+{
+    float3 l;
+    float attenuation = light.color_intensity.a;
+    if (light.position_range.w > 0.0f) {
+        float3 to_light = light.position_range.xyz - world_position;
+        float distance_squared = max(dot(to_light, to_light), 1e-4f);
+        l = to_light * rsqrt(distance_squared);
+        float range_factor = saturate(1.0f - pow(distance_squared / (light.position_range.w * light.position_range.w), 2.0f));
+        attenuation *= range_factor * range_factor / distance_squared;
+        float cone = dot(-l, light.direction_cone.xyz);
+        attenuation *= smoothstep(light.direction_cone.w, light.shadow_params.x, cone);
+    } else {
+        l = -light.direction_cone.xyz;
+        attenuation *= shadow;
+    }
+    return EvaluateBRDF(n, v, l, albedo, metallic, roughness) * light.color_intensity.rgb * attenuation;
+}
+
+Output main(Input input, bool front_face : SV_IsFrontFace)
+{
+    float3 n = normalize(front_face ? input.normal : -input.normal);
+    float3 t = normalize(input.tangent.xyz - n * dot(n, input.tangent.xyz));
+    float3 b = cross(n, t) * input.tangent.w;
+    float3 v = normalize(input.view_dir);
+    float3 view_ts = float3(dot(v, t), dot(v, b), dot(v, n));
+
+    float2 uv = ParallaxOcclusion(input.uv.xy, view_ts);
+    float4 base_color = BaseColorTexture.Sample(BaseColorSampler, uv) * base_color_factor * input.color;
+    clip(base_color.a - alpha_cutoff);
+
+    float3 orm = ORMTexture.Sample(ORMSampler, uv).rgb;
+    float occlusion = lerp(1.0f, orm.r, occlusion_strength);
+    float roughness = clamp(orm.g * roughness_factor, 0.045f, 1.0f);
+    float metallic = saturate(orm.b * metallic_factor);
+    float3 tn = NormalTexture.Sample(NormalSampler, uv).xyz * 2.0f - 1.0f;
+
+#if FEATURE_DETAIL
+    float2 detail_uv = input.uv.zw * detail_scale;
+    float3 detail_albedo = DetailAlbedoTexture.Sample(DetailAlbedoSampler, detail_uv).rgb * 2.0f;
+    float3 detail_normal = DetailNormalTexture.Sample(DetailNormalSampler, detail_uv).xyz * 2.0f - 1.0f;
+    base_color.rgb *= detail_albedo;
+    tn = normalize(float3(tn.xy + detail_normal.xy, tn.z * detail_normal.z));
+#endif
+
+    float3 shading_normal = normalize(tn.x * t + tn.y * b + tn.z * n);
+    float shadow = SampleShadows(input);
+
+    float3 color = 0.0f;
+    [unroll] for (int i = 0; i < NUM_LIGHTS; i++) {
+        if (i < (int)num_lights) {
+            color += EvaluateLight(lights[i], input.world_position, shading_normal, v, base_color.rgb, metallic, roughness, shadow);
+        }
+    }
+
+    float ndotv = saturate(dot(shading_normal, v));
+    float3 f0 = lerp(float3(0.04f, 0.04f, 0.04f), base_color.rgb, metallic);
+    float2 brdf = BRDFTexture.SampleLevel(BRDFSampler, float2(ndotv, roughness), 0.0f);
+    float3 r = reflect(-v, shading_normal);
+    float3 prefiltered = EnvironmentTexture.SampleLevel(EnvironmentSampler, r, roughness * environment_mips).rgb;
+    float3 irradiance = EvaluateSH(sh, shading_normal);
+    float3 f = FresnelSchlick(ndotv, f0);
+    float3 ambient = (1.0f - f) * (1.0f - metallic) * base_color.rgb * irradiance + prefiltered * (f0 * brdf.x + brdf.y);
+    color += ambient * occlusion;
+
+#if FEATURE_CLEARCOAT
+    float3 cn = ClearcoatNormalTexture.Sample(ClearcoatNormalSampler, uv).xyz * 2.0f - 1.0f;
+    float3 clearcoat_normal = normalize(cn.x * t + cn.y * b + cn.z * n);
+    float clearcoat_ndotv = saturate(dot(clearcoat_normal, v));
+    float clearcoat_fresnel = FresnelSchlick(clearcoat_ndotv, float3(0.04f, 0.04f, 0.04f)).x * clearcoat_factor;
+    float3 clearcoat_r = reflect(-v, clearcoat_normal);
+    float3 clearcoat = EnvironmentTexture.SampleLevel(EnvironmentSampler, clearcoat_r, clearcoat_roughness * environment_mips).rgb;
+    [unroll] for (int j = 0; j < NUM_LIGHTS; j++) {
+        if (j < (int)num_lights && lights[j].position_range.w == 0.0f) {
+            float3 l = -lights[j].direction_cone.xyz;
+            float3 h = normalize(l + v);
+            float d = DistributionGGX(saturate(dot(clearcoat_normal, h)), clearcoat_roughness);
+            clearcoat += d * lights[j].color_intensity.rgb * lights[j].color_intensity.a * saturate(dot(clearcoat_normal, l)) * shadow;
+        }
+    }
+    color = color * (1.0f - clearcoat_fresnel) + clearcoat * clearcoat_fresnel;
+#endif
+
+    color += EmissiveTexture.Sample(EmissiveSampler, uv).rgb * emissive_factor;
+
+#if FEATURE_FOG
+    float3 to_camera = camera_position - input.world_position;
+    float fog_distance = length(to_camera);
+    float height_fog = exp(-max(input.world_position.y - fog_height_falloff.x, 0.0f) * fog_height_falloff.y);
+    float fog = 1.0f - exp(-fog_distance * fog_color_density.w * height_fog);
+    float3 fog_color = fog_color_density.rgb + EvaluateSH(sh, -v) * fog_height_falloff.z;
+    color = lerp(color, fog_color, saturate(fog));
+#endif
+
+    Output output;
+    output.color = float4(LinearToSRGB(ACESFilm(color * exposure)), base_color.a);
+    output.normal_roughness = float4(shading_normal * 0.5f + 0.5f, roughness);
+    float2 current = input.current_clip.xy / input.current_clip.w;
+    float2 previous = input.previous_clip.xy / input.previous_clip.w;
+    output.velocity = (current - previous) * float2(0.5f, -0.5f);
+    return output;
+}
@@ -0,0 +1,162 @@
+// Uber vertex shader: linear blend skinning, morph targets, procedural wind
+// and a full set of interpolants. The morph target loop is unrolled, so the
+// generated code is representative of the largest vertex shaders engines
+// ship. BENCH_PERMUTATION masks features out for permutation benchmarks.
+
+#include "common.hlsli"
+
+#ifndef BENCH_PERMUTATION
+#define BENCH_PERMUTATION 0
+#endif
+
+#define FEATURE_SKINNING ((BENCH_PERMUTATION & 1) == 0)
+#define FEATURE_MORPHING ((BENCH_PERMUTATION & 2) == 0)
+#define FEATURE_WIND     ((BENCH_PERMUTATION & 4) == 0)
+#define FEATURE_SHADOWS  ((BENCH_PERMUTATION & 8) == 0)
+
+#define NUM_BONES 128
+#define NUM_MORPH_TARGETS 16
+#define NUM_CASCADES 4
+
+Texture2D<float4> MorphPositions : register(t0, space0);
+Texture2D<float4> MorphNormals : register(t1, space0);
+
+cbuffer Camera : register(b0, space1)
+{
+    float4x4 view;
+    float4x4 projection;
+    float4x4 view_projection;
+    float4x4 previous_view_projection;
+    float4x4 cascade_matrices[NUM_CASCADES];
+    float3 camera_position;
+    float time;
+    float4 wind_direction_strength;
+    float4 wind_gust;
+};
+
+cbuffer Object : register(b1, space1)
+{
+    float4x4 model;
+    float4x4 previous_model;
+    float4x4 normal_matrix;
+    float4 morph_weights[NUM_MORPH_TARGETS / 4];
+    uint morph_row;
+    uint num_morph_targets;
+    float wind_stiffness;
+    float object_padding;
+};
+
+cbuffer Skeleton : register(b2, space1)
+{
+    float4x4 bones[NUM_BONES];
+};
+
+struct Input
+{
+    float3 position : TEXCOORD0;
+    float2 normal : TEXCOORD1;
+    float4 tangent : TEXCOORD2;
+    float2 uv0 : TEXCOORD3;
+    float2 uv1 : TEXCOORD4;
+    float4 color : TEXCOORD5;
+    uint4 bone_indices : TEXCOORD6;
+    float4 bone_weights : TEXCOORD7;
+    uint vertex_id : SV_VertexID;
+};
+
+struct Output
+{
+    float4 position : SV_Position;
+    float3 world_position : TEXCOORD0;
+    float3 normal : TEXCOORD1;
+    float4 tangent : TEXCOORD2;
+    float4 uv : TEXCOORD3;
+    float4 color : TEXCOORD4;
+    float3 view_dir : TEXCOORD5;
+    float4 current_clip : TEXCOORD6;
+    float4 previous_clip : TEXCOORD7;
+    float4 shadow_coords[NUM_CASCADES] : TEXCOORD8;
+    float view_depth : TEXCOORD12;
+};
+
+float MorphWeight(uint index)
+{
+    float4 weights = morph_weights[index / 4];
+    uint lane = index % 4;
+    return lane == 0 ? weights.x : lane == 1 ? weights.y : lane == 2 ? weights.z : weights.w;
+}
+
+float4x4 SkinMatrix(uint4 indices, float4 weights)
+{
+    return bones[indices.x] * weights.x +
+           bones[indices.y] * weights.y +
+           bones[indices.z] * weights.z +
+           bones[indices.w] * weights.w;
+}
+
+float3 Wind(float3 world_position, float height)
+{
+    float3 direction = normalize(wind_direction_strength.xyz);
+    float phase = dot(world_position.xz, direction.xz) * 0.35f + time * wind_gust.x;
+    float gust = ValueNoise(world_position.xz * wind_gust.y + time * wind_gust.z);
+    float sway = sin(phase) * 0.5f + sin(phase * 2.7f + 1.3f) * 0.25f + sin(phase * 5.1f + 2.1f) * 0.125f;
+    float bend = height * height * (1.0f - wind_stiffness);
+    return direction * (sway + gust * wind_gust.w) * wind_direction_strength.w * bend;
+}
+
+Output main(Input input)
+{
+    float3 position = input.position;
+    float3 normal = DecodeNormal(input.normal);
+    float3 tangent = input.tangent.xyz;
+
+#if FEATURE_MORPHING
+    [unroll] for (uint i = 0; i < NUM_MORPH_TARGETS; i++) {
+        float weight = i < num_morph_targets ? MorphWeight(i) : 0.0f;
+        if (weight != 0.0f) {
+            int3 texel = int3(input.vertex_id % 1024, morph_row + i * 4 + input.vertex_id / 1024, 0);
+            position += MorphPositions.Load(texel).xyz * weight;
+            normal += MorphNormals.Load(texel).xyz * weight;
+        }
+    }
+    normal = normalize(normal);
+#endif
+
+#if FEATURE_SKINNING
+    float4 bone_weights = input.bone_weights / max(dot(input.bone_weights, float4(1.0f, 1.0f, 1.0f, 1.0f)), 1e-5f);
+    float4x4 skin = SkinMatrix(input.bone_indices, bone_weights);
+    position = mul(skin, float4(position, 1.0f)).xyz;
+    normal = normalize(mul((float3x3)skin, normal));
+    tangent = normalize(mul((float3x3)skin, tangent));
+#endif
+
+    float4 world = mul(model, float4(position, 1.0f));
+    float4 previous_world = mul(previous_model, float4(position, 1.0f));
+
+#if FEATURE_WIND
+    float height = saturate(input.color.a);
+    world.xyz += Wind(world.xyz, height);
+    previous_world.xyz += Wind(previous_world.xyz, height);
+#endif
+
+    Output output;
+    output.position = mul(view_projection, world);
+    output.world_position = world.xyz;
+    output.normal = normalize(mul((float3x3)normal_matrix, normal));
+    output.tangent = float4(normalize(mul((float3x3)model, tangent)), input.tangent.w);
+    output.uv = float4(input.uv0, input.uv1);
+    output.color = float4(SRGBToLinear(input.color.rgb), input.color.a);
+    output.view_dir = camera_position - world.xyz;
+    output.current_clip = output.position;
+    output.previous_clip = mul(previous_view_projection, previous_world);
+    output.view_depth = -mul(view, world).z;
+
+    [unroll] for (int c = 0; c < NUM_CASCADES; c++) {
+#if FEATURE_SHADOWS
+        output.shadow_coords[c] = mul(cascade_matrices[c], world);
+#else
+        output.shadow_coords[c] = float4(0.0f, 0.0f, 0.0f, 1.0f);
+#endif
+    }
+    return output;
+}
@@ -0,0 +1,167 @@
+#include <SDL3/SDL.h>
+#include <SDL3_shadercross/SDL_shadercross.h>
+
+/* Checks that compile results are reused from the memory and disk caches,
+ * and that a result stops being reused once a file it included changes.
+ * Takes a scratch directory for the disk cache. Exits with 77 when HLSL
+ * compilation is not available, for ctest to report the test as skipped.
+ */
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            SDL_Log("%s:%d: check failed: %s (%s)", __FILE__, __LINE__, #cond, \
+                    SDL_GetError());                                            \
+            return false;                                                       \
+        }                                                                       \
+    } while (0)
+
+static const char *source =
+    "#include \"color.hlsli\"\n"
+    "float4 main() : SV_Target0 { return COLOR; }\n";
+
+static const char *red = "#define COLOR float4(1.0, 0.0, 0.0, 1.0)\n";
+static const char *green = "#define COLOR float4(0.0, 1.0, 0.0, 1.0)\n";
+
+typedef struct Dependencies
+{
+    int count;
+    bool sawColor;
+} Dependencies;
+
+static void SDLCALL record_dependency(void *userdata, const char *path)
+{
+    Dependencies *dependencies = (Dependencies *)userdata;
+    dependencies->count += 1;
+    if (SDL_strstr(path, "color.hlsli") != NULL) {
+        dependencies->sawColor = true;
+    }
+}
+
+static SDL_ShaderCross_Blob *compile(SDL_PropertiesID props)
+{
+    SDL_ShaderCross_HLSL_Info info;
+    SDL_zero(info);
+    info.source = source;
+    info.entrypoint = "main";
+    info.include_dir = "shaders";
+    info.shader_stage = SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+    info.props = props;
+    return SDL_ShaderCross_CompileSPIRVFromHLSLToBlob(&info);
+}
+
+static bool same_output(SDL_ShaderCross_Blob *a, SDL_ShaderCross_Blob *b)
+{
+    return SDL_ShaderCross_GetBlobSize(a) == SDL_ShaderCross_GetBlobSize(b) &&
+           SDL_memcmp(SDL_ShaderCross_GetBlobData(a), SDL_ShaderCross_GetBlobData(b), SDL_ShaderCross_GetBlobSize(a)) == 0;
+}
+
+static bool test_memory_cache(void)
+{
+    SDL_ShaderCross_MemoryCacheStats before, after;
+
+    CHECK(SDL_ShaderCross_SetMemoryCacheBudget(1024 * 1024));
+    CHECK(SDL_ShaderCross_RegisterVirtualFile("shaders/color.hlsli", red, SDL_strlen(red)));
+
+    SDL_ShaderCross_Blob *first = compile(0);
+    CHECK(first != NULL);
+    CHECK(SDL_ShaderCross_GetMemoryCacheStats(&before));
+    CHECK(before.num_entries >= 1);
+
+    SDL_ShaderCross_Blob *second = compile(0);
+    CHECK(second != NULL);
+    CHECK(SDL_ShaderCross_GetMemoryCacheStats(&after));
+    CHECK(after.hits > before.hits);
+    CHECK(same_output(first, second));
+    SDL_ShaderCross_ReleaseBlob(second);
+
+    // A changed include makes the cached result stale
+    CHECK(SDL_ShaderCross_RegisterVirtualFile("shaders/color.hlsli", green, SDL_strlen(green)));
+    SDL_ShaderCross_Blob *third = compile(0);
+    CHECK(third != NULL);
+    CHECK(SDL_ShaderCross_GetMemoryCacheStats(&before));
+    CHECK(before.hits == after.hits);
+    CHECK(before.misses > after.misses);
+    CHECK(!same_output(first, third));
+    SDL_ShaderCross_ReleaseBlob(third);
+
+    // Blobs handed out stay valid after the cache is emptied
+    CHECK(SDL_ShaderCross_SetMemoryCacheBudget(0));
+    CHECK(SDL_ShaderCross_GetMemoryCacheStats(&after));
+    CHECK(after.num_entries == 0 && after.bytes == 0);
+    CHECK(SDL_ShaderCross_GetBlobSize(first) > 0);
+    SDL_ShaderCross_ReleaseBlob(first);
+    return true;
+}
+
+static bool test_disk_cache(const char *directory)
+{
+    Dependencies dependencies;
+    SDL_ShaderCross_DependencyReporter reporter;
+    reporter.callback = record_dependency;
+    reporter.userdata = &dependencies;
+    SDL_PropertiesID props = SDL_CreateProperties();
+    CHECK(props != 0);
+    SDL_SetStringProperty(props, SDL_SHADERCROSS_PROP_CACHE_DIRECTORY_STRING, directory);
+    SDL_SetPointerProperty(props, SDL_SHADERCROSS_PROP_HLSL_DEPENDENCY_REPORTER_POINTER, &reporter);
+
+    CHECK(SDL_ShaderCross_RegisterVirtualFile("shaders/color.hlsli", red, SDL_strlen(red)));
+
+    SDL_zero(dependencies);
+    SDL_ShaderCross_Blob *first = compile(props);
+    CHECK(first != NULL);
+    CHECK(dependencies.sawColor);
+
+    int count = 0;
+    char **entries = SDL_GlobDirectory(directory, NULL, 0, &count);
+    SDL_free(entries);
+    CHECK(count > 0);
+
+    // A hit reports the includes it was compiled with
+    SDL_zero(dependencies);
+    SDL_ShaderCross_Blob *second = compile(props);
+    CHECK(second != NULL);
+    CHECK(dependencies.sawColor);
+    CHECK(same_output(first, second));
+    SDL_ShaderCross_ReleaseBlob(second);
+
+    CHECK(SDL_ShaderCross_RegisterVirtualFile("shaders/color.hlsli", green, SDL_strlen(green)));
+    SDL_ShaderCross_Blob *third = compile(props);
+    CHECK(third != NULL);
+    CHECK(!same_output(first, third));
+    SDL_ShaderCross_ReleaseBlob(third);
+
+    SDL_ShaderCross_ReleaseBlob(first);
+    SDL_DestroyProperties(props);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        SDL_Log("Usage: %s <scratch directory>", argv[0]);
+        return 1;
+    }
+    if (!SDL_Init(0)) {
+        SDL_Log("SDL_Init failed (%s)", SDL_GetError());
+        return 1;
+    }
+    if (!SDL_ShaderCross_Init()) {
+        SDL_Log("SDL_ShaderCross_Init failed (%s)", SDL_GetError());
+        return 1;
+    }
+    if (!(SDL_ShaderCross_GetHLSLShaderFormats() & SDL_GPU_SHADERFORMAT_SPIRV)) {
+        SDL_Log("HLSL compilation is not available, skipping");
+        SDL_ShaderCross_Quit();
+        SDL_Quit();
+        return 77;
+    }
+
+    SDL_CreateDirectory(argv[1]);
+    bool success = test_memory_cache() && test_disk_cache(argv[1]);
+
+    SDL_ShaderCross_UnregisterVirtualFile("shaders/color.hlsli");
+    SDL_ShaderCross_Quit();
+    SDL_Quit();
+    return success ? 0 : 1;
+}
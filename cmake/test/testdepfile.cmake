@@ -0,0 +1,36 @@
+# Checks the depfile written by the shadercross CLI: every output is a target,
+# and the input and its includes are prerequisites, escaped for Make and Ninja.
+#
+# Usage: cmake -DSHADERCROSS=<path to shadercross> -DWORKDIR=<scratch directory> -P testdepfile.cmake
+
+if(NOT SHADERCROSS OR NOT WORKDIR)
+    message(FATAL_ERROR "SHADERCROSS and WORKDIR must be set")
+endif()
+
+file(REMOVE_RECURSE "${WORKDIR}")
+file(MAKE_DIRECTORY "${WORKDIR}/include dir")
+file(WRITE "${WORKDIR}/include dir/color #1$.hlsli" "#define COLOR float4(1.0, 0.0, 0.0, 1.0)\n")
+file(WRITE "${WORKDIR}/main.frag.hlsl" "#include \"color #1$.hlsli\"\nfloat4 main() : SV_Target0 { return COLOR; }\n")
+
+execute_process(
+    COMMAND "${SHADERCROSS}" main.frag.hlsl -o main.frag.spv -I "include dir" -MD
+    WORKING_DIRECTORY "${WORKDIR}"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "shadercross failed (${result}):\n${output}")
+endif()
+
+if(NOT EXISTS "${WORKDIR}/main.frag.spv.d")
+    message(FATAL_ERROR "No depfile was written to main.frag.spv.d")
+endif()
+file(READ "${WORKDIR}/main.frag.spv.d" depfile)
+
+foreach(expected "main.frag.spv: main.frag.hlsl" "include\\ dir/color\\ \\#1$$.hlsli")
+    string(FIND "${depfile}" "${expected}" index)
+    if(index EQUAL -1)
+        message(FATAL_ERROR "The depfile does not contain \"${expected}\":\n${depfile}")
+    endif()
+endforeach()
@@ -0,0 +1,168 @@
+#include <SDL3/SDL.h>
+#include <SDL3_shadercross/SDL_shadercross.h>
+
+/* Checks the ToBuffer functions against the ToBlob ones: querying the size,
+ * a buffer that is too small, an include changing between the query and
+ * the call that fills the buffer, and the text outputs not counting a NUL
+ * terminator. Exits with 77 when HLSL compilation is not available, for
+ * ctest to report the test as skipped.
+ */
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            SDL_Log("%s:%d: check failed: %s (%s)", __FILE__, __LINE__, #cond, \
+                    SDL_GetError());                                            \
+            return false;                                                       \
+        }                                                                       \
+    } while (0)
+
+static const char *source =
+    "#include \"color.hlsli\"\n"
+    "float4 main() : SV_Target0 { return COLOR; }\n";
+
+static const char *red = "#define COLOR float4(1.0, 0.0, 0.0, 1.0)\n";
+static const char *green = "#define COLOR float4(0.0, 1.0, 0.0, 1.0)\n";
+
+static void init_info(SDL_ShaderCross_HLSL_Info *info)
+{
+    SDL_zerop(info);
+    info->source = source;
+    info->entrypoint = "main";
+    info->include_dir = "shaders";
+    info->shader_stage = SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+}
+
+static bool matches_blob(const void *data, size_t size, SDL_ShaderCross_Blob *blob)
+{
+    return blob != NULL &&
+           SDL_ShaderCross_GetBlobSize(blob) == size &&
+           SDL_memcmp(SDL_ShaderCross_GetBlobData(blob), data, size) == 0;
+}
+
+static bool test_query_and_fill(void)
+{
+    SDL_ShaderCross_HLSL_Info info;
+    size_t size = 0;
+
+    init_info(&info);
+    CHECK(SDL_ShaderCross_RegisterVirtualFile("shaders/color.hlsli", red, SDL_strlen(red)));
+
+    CHECK(SDL_ShaderCross_CompileSPIRVFromHLSLToBuffer(&info, NULL, 0, &size));
+    CHECK(size > 0);
+
+    Uint8 *buffer = SDL_malloc(size);
+    CHECK(buffer != NULL);
+
+    // Too small fails, but still reports the size
+    size_t smallSize = 0;
+    bool result = SDL_ShaderCross_CompileSPIRVFromHLSLToBuffer(&info, buffer, size - 1, &smallSize);
+    CHECK(!result);
+    CHECK(smallSize == size);
+
+    size_t filledSize = 0;
+    CHECK(SDL_ShaderCross_CompileSPIRVFromHLSLToBuffer(&info, buffer, size, &filledSize));
+    CHECK(filledSize == size);
+
+    SDL_ShaderCross_Blob *blob = SDL_ShaderCross_CompileSPIRVFromHLSLToBlob(&info);
+    result = matches_blob(buffer, size, blob);
+    SDL_ShaderCross_ReleaseBlob(blob);
+    SDL_free(buffer);
+    CHECK(result);
+    return true;
+}
+
+static bool test_include_changed(void)
+{
+    SDL_ShaderCross_HLSL_Info info;
+    size_t size = 0;
+
+    init_info(&info);
+    CHECK(SDL_ShaderCross_RegisterVirtualFile("shaders/color.hlsli", red, SDL_strlen(red)));
+    CHECK(SDL_ShaderCross_CompileSPIRVFromHLSLToBuffer(&info, NULL, 0, &size));
+
+    // The output kept by the query must not be handed out for the new include
+    CHECK(SDL_ShaderCross_RegisterVirtualFile("shaders/color.hlsli", green, SDL_strlen(green)));
+    SDL_ShaderCross_Blob *blob = SDL_ShaderCross_CompileSPIRVFromHLSLToBlob(&info);
+    CHECK(blob != NULL);
+
+    size_t bufferSize = SDL_ShaderCross_GetBlobSize(blob);
+    Uint8 *buffer = SDL_malloc(bufferSize);
+    bool result = buffer != NULL && SDL_ShaderCross_CompileSPIRVFromHLSLToBuffer(&info, buffer, bufferSize, &size);
+    result = result && matches_blob(buffer, size, blob);
+    SDL_ShaderCross_ReleaseBlob(blob);
+    SDL_free(buffer);
+    CHECK(result);
+    return true;
+}
+
+static bool test_text_output(void)
+{
+    SDL_ShaderCross_HLSL_Info hlslInfo;
+    SDL_ShaderCross_SPIRV_Info spirvInfo;
+    size_t size = 0;
+
+    init_info(&hlslInfo);
+    CHECK(SDL_ShaderCross_RegisterVirtualFile("shaders/color.hlsli", red, SDL_strlen(red)));
+    SDL_ShaderCross_Blob *spirv = SDL_ShaderCross_CompileSPIRVFromHLSLToBlob(&hlslInfo);
+    CHECK(spirv != NULL);
+
+    SDL_zero(spirvInfo);
+    spirvInfo.bytecode = (const Uint8 *)SDL_ShaderCross_GetBlobData(spirv);
+    spirvInfo.bytecode_size = SDL_ShaderCross_GetBlobSize(spirv);
+    spirvInfo.entrypoint = "main";
+    spirvInfo.shader_stage = SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+
+    char *msl = (char *)SDL_ShaderCross_TranspileMSLFromSPIRV(&spirvInfo);
+    bool result = msl != NULL && SDL_ShaderCross_TranspileMSLFromSPIRVToBuffer(&spirvInfo, NULL, 0, &size);
+    result = result && size == SDL_strlen(msl);
+
+    // A buffer of exactly the size is enough, nothing is written past it
+    char *buffer = result ? SDL_malloc(size + 1) : NULL;
+    if (buffer != NULL) {
+        buffer[size] = '#';
+        result = SDL_ShaderCross_TranspileMSLFromSPIRVToBuffer(&spirvInfo, buffer, size, &size) &&
+                 buffer[size] == '#' &&
+                 SDL_memcmp(buffer, msl, size) == 0;
+    }
+
+    SDL_free(buffer);
+    SDL_free(msl);
+    SDL_ShaderCross_ReleaseBlob(spirv);
+    CHECK(result);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (!SDL_Init(0)) {
+        SDL_Log("SDL_Init failed (%s)", SDL_GetError());
+        return 1;
+    }
+    if (!SDL_ShaderCross_Init()) {
+        SDL_Log("SDL_ShaderCross_Init failed (%s)", SDL_GetError());
+        return 1;
+    }
+    if (!(SDL_ShaderCross_GetHLSLShaderFormats() & SDL_GPU_SHADERFORMAT_SPIRV)) {
+        SDL_Log("HLSL compilation is not available, skipping");
+        SDL_ShaderCross_Quit();
+        SDL_Quit();
+        return 77;
+    }
+
+    bool success = test_query_and_fill() && test_include_changed() && test_text_output();
+
+    // The output kept by a query is released by SDL_ShaderCross_Quit
+    SDL_ShaderCross_HLSL_Info info;
+    size_t size = 0;
+    init_info(&info);
+    if (success && !SDL_ShaderCross_CompileSPIRVFromHLSLToBuffer(&info, NULL, 0, &size)) {
+        SDL_Log("Query before quitting failed (%s)", SDL_GetError());
+        success = false;
+    }
+
+    SDL_ShaderCross_UnregisterVirtualFile("shaders/color.hlsli");
+    SDL_ShaderCross_Quit();
+    SDL_Quit();
+    return success ? 0 : 1;
+}
@@ -66,6 +66,120 @@ typedef struct SDL_ShaderCross_ComputePipelineMetadata
     Uint32 threadcount_z;                   /**< The number of threads in the Z dimension. */
 } SDL_ShaderCross_ComputePipelineMetadata;
 
+/**
+ * A number for SDL_ShaderCross_SPIRV_Info.props and
+ * SDL_ShaderCross_HLSL_Info.props selecting the HLSL shader model to target,
+ * written as major * 10 + minor, e.g. 62 for Shader Model 6.2.
+ *
+ * This applies to DXC target profiles, to the HLSL emitted by SPIRV-Cross
+ * and to FXC. DXIL, SPIR-V and HLSL output default to 60, and a compile
+ * fails if the shader model is below 60 or above the newest one the loaded
+ * DXC supports, or above 69 for HLSL output. DXBC output defaults to 51 and
+ * is clamped to it, since FXC does not support Shader Model 6.
+ */
+#define SDL_SHADERCROSS_PROP_SHADER_MODEL_NUMBER "SDL.shadercross.shader_model"
+
+/**
+ * A number for SDL_ShaderCross_SPIRV_Info.props and
+ * SDL_ShaderCross_HLSL_Info.props selecting the optimization level, 0 to 3.
+ * Maps to DXC's -O0..-O3 and FXC's D3DCOMPILE_OPTIMIZATION_LEVEL0..3, where
+ * 0 also skips optimization entirely. Defaults to each compiler's own
+ * default.
+ */
+#define SDL_SHADERCROSS_PROP_OPTIMIZATION_LEVEL_NUMBER "SDL.shadercross.optimization_level"
+
+/**
+ * A boolean for SDL_ShaderCross_SPIRV_Info.props and
+ * SDL_ShaderCross_HLSL_Info.props. When true, the compiled shader is not
+ * validated (DXC -Vd, D3DCOMPILE_SKIP_VALIDATION). Defaults to false.
+ */
+#define SDL_SHADERCROSS_PROP_SKIP_VALIDATION_BOOLEAN "SDL.shadercross.skip_validation"
+
+/**
+ * A boolean for SDL_ShaderCross_SPIRV_Info.props and
+ * SDL_ShaderCross_HLSL_Info.props. When true, the compiler may assume that
+ * every resource is bound at draw time (DXC -all_resources_bound,
+ * D3DCOMPILE_ALL_RESOURCES_BOUND). Defaults to false.
+ */
+#define SDL_SHADERCROSS_PROP_ALL_RESOURCES_BOUND_BOOLEAN "SDL.shadercross.all_resources_bound"
+
+/**
+ * A boolean for SDL_ShaderCross_SPIRV_Info.props and
+ * SDL_ShaderCross_HLSL_Info.props. When true, the compiler avoids emitting
+ * flow control where it can (DXC -Gfa, D3DCOMPILE_AVOID_FLOW_CONTROL).
+ * Defaults to false.
+ */
+#define SDL_SHADERCROSS_PROP_AVOID_FLOW_CONTROL_BOOLEAN "SDL.shadercross.avoid_flow_control"
+
+/**
+ * The phases of a compile that are timed in SDL_ShaderCross_CompileStats and
+ * reported to the trace callback.
+ *
+ * \sa SDL_SHADERCROSS_PROP_COMPILE_STATS_POINTER
+ * \sa SDL_ShaderCross_SetTraceCallback
+ */
+typedef enum SDL_ShaderCross_CompilePhase
+{
+    SDL_SHADERCROSS_PHASE_DXC_FRONTEND,  /**< DXC compiling HLSL to SPIR-V. */
+    SDL_SHADERCROSS_PHASE_SPIRV_PARSE,   /**< SPIRV-Cross parsing SPIR-V. */
+    SDL_SHADERCROSS_PHASE_REFLECTION,    /**< Reflecting the resources a shader uses. */
+    SDL_SHADERCROSS_PHASE_CODEGEN,       /**< SPIRV-Cross generating HLSL or MSL. */
+    SDL_SHADERCROSS_PHASE_DXC_BACKEND,   /**< DXC compiling HLSL to DXIL. */
+    SDL_SHADERCROSS_PHASE_FXC,           /**< FXC compiling HLSL to DXBC. */
+    SDL_SHADERCROSS_PHASE_GPU_OBJECT,    /**< Creating an SDL_GPUShader or SDL_GPUComputePipeline. */
+    SDL_SHADERCROSS_PHASE_COUNT
+} SDL_ShaderCross_CompilePhase;
+
+/**
+ * Time spent in each phase of one or more compiles.
+ *
+ * Phases that ran on several threads at once, such as the targets of
+ * SDL_ShaderCross_CompileMultiTargetFromSPIRV, each add their own time, so
+ * the sum can exceed the wall time of the compile.
+ *
+ * \sa SDL_SHADERCROSS_PROP_COMPILE_STATS_POINTER
+ */
+typedef struct SDL_ShaderCross_CompileStats
+{
+    Uint64 phase_ns[SDL_SHADERCROSS_PHASE_COUNT];     /**< Wall time spent in each phase, in nanoseconds. */
+    Uint32 phase_count[SDL_SHADERCROSS_PHASE_COUNT];  /**< The number of times each phase ran. */
+    Uint32 cache_hits;                                /**< Results that were returned from the compile cache. */
+} SDL_ShaderCross_CompileStats;
+
+/**
+ * A pointer to an SDL_ShaderCross_CompileStats for
+ * SDL_ShaderCross_SPIRV_Info.props and SDL_ShaderCross_HLSL_Info.props.
+ * The time spent in each phase of the compile is added to it, so it must be
+ * zeroed before the first compile, and several compiles can add to the same
+ * stats, even from different threads. It must stay valid for the duration
+ * of the call, or until an async job is done.
+ */
+#define SDL_SHADERCROSS_PROP_COMPILE_STATS_POINTER "SDL.shadercross.compile_stats"
+
+/**
+ * A pointer to memory for SDL_ShaderCross_SPIRV_Info.props and
+ * SDL_ShaderCross_HLSL_Info.props, used for the temporary allocations of
+ * the compile, such as the converted compiler arguments, before any memory
+ * is allocated for them. Temporaries that don't fit are allocated as usual.
+ * It must stay valid for the duration of the call, or until an async job is
+ * done, and must not be used by two compiles at once.
+ *
+ * Without it, each thread keeps the memory its temporaries needed for its
+ * next compile, so this is only needed to avoid allocating altogether. Every
+ * other allocation goes through SDL_malloc, so it can be replaced with
+ * SDL_SetMemoryFunctions.
+ *
+ * \sa SDL_SHADERCROSS_PROP_SCRATCH_BUFFER_SIZE_NUMBER
+ */
+#define SDL_SHADERCROSS_PROP_SCRATCH_BUFFER_POINTER "SDL.shadercross.scratch_buffer"
+
+/**
+ * A number for SDL_ShaderCross_SPIRV_Info.props and
+ * SDL_ShaderCross_HLSL_Info.props, the size in bytes of the memory in
+ * SDL_SHADERCROSS_PROP_SCRATCH_BUFFER_POINTER.
+ */
+#define SDL_SHADERCROSS_PROP_SCRATCH_BUFFER_SIZE_NUMBER "SDL.shadercross.scratch_buffer_size"
+
 typedef struct SDL_ShaderCross_SPIRV_Info
 {
     const Uint8 *bytecode;                     /**< The SPIRV bytecode. */
@@ -84,9 +198,75 @@ typedef struct SDL_ShaderCross_HLSL_Define
     char *value;  /**< An optional value for the define. Can be NULL. */
 } SDL_ShaderCross_HLSL_Define;
 
+/**
+ * A NULL-terminated array of additional UTF-8 include directories for
+ * SDL_ShaderCross_HLSL_Info.props, searched in order after `include_dir`.
+ * The array must stay valid for the duration of the call.
+ */
+#define SDL_SHADERCROSS_PROP_HLSL_INCLUDE_DIRS_POINTER "SDL.shadercross.hlsl.include_dirs"
+
+/**
+ * A number for SDL_ShaderCross_HLSL_Info.props giving the length of
+ * `source` in bytes. When set, `source` does not need to be NUL-terminated,
+ * so it can point straight into a memory-mapped file or archive. When unset
+ * or 0, `source` must be NUL-terminated.
+ */
+#define SDL_SHADERCROSS_PROP_HLSL_SOURCE_SIZE_NUMBER "SDL.shadercross.hlsl.source_size"
+
+/**
+ * A function that is called with the path of a file an HLSL compile
+ * depended on.
+ *
+ * \param userdata the `userdata` of the SDL_ShaderCross_DependencyReporter.
+ * \param path the path of the file, as it was resolved from the include
+ *             directories.
+ *
+ * \sa SDL_ShaderCross_DependencyReporter
+ */
+typedef void (SDLCALL *SDL_ShaderCross_DependencyCallback)(void *userdata, const char *path);
+
+/**
+ * A dependency callback and the pointer that is passed to it.
+ *
+ * \sa SDL_SHADERCROSS_PROP_HLSL_DEPENDENCY_REPORTER_POINTER
+ */
+typedef struct SDL_ShaderCross_DependencyReporter
+{
+    SDL_ShaderCross_DependencyCallback callback;  /**< Called for every file the compile depended on. */
+    void *userdata;                               /**< Passed to `callback`. */
+} SDL_ShaderCross_DependencyReporter;
+
+/**
+ * A pointer to an SDL_ShaderCross_DependencyReporter for
+ * SDL_ShaderCross_HLSL_Info.props, whose callback is called for every file
+ * opened through `#include` while compiling, such as for writing a depfile.
+ * Results returned from the compile cache report the includes they were
+ * compiled with. A file can be reported more than once, and the callback is
+ * called on the thread running the compile. The reporter must stay valid
+ * for the duration of the call, or until an async job is done.
+ */
+#define SDL_SHADERCROSS_PROP_HLSL_DEPENDENCY_REPORTER_POINTER "SDL.shadercross.hlsl.dependency_reporter"
+
+/**
+ * A boolean for SDL_ShaderCross_HLSL_Info.props. When true, DXIL is compiled
+ * straight from the HLSL source with a single DXC invocation instead of
+ * roundtripping through SPIR-V, whenever the source needs no legalization.
+ * Defaults to false. Has no effect on GDK platforms, which always compile
+ * DXIL directly.
+ *
+ * The roundtrip is what remaps resources to the registers and spaces
+ * SDL_GPU expects. The bindings of the direct output are checked against
+ * the registers and spaces SDL_GPU documents for the stage, and if any
+ * resource is out of place, the roundtrip is used instead. This is
+ * automatic, so a shader that declares every resource with the expected
+ * `register(..., spaceN)` gets the speedup. If the direct compile fails,
+ * its error is returned and the roundtrip is not tried.
+ */
+#define SDL_SHADERCROSS_PROP_HLSL_DXIL_DIRECT_BOOLEAN "SDL.shadercross.hlsl.dxil_direct"
+
 typedef struct SDL_ShaderCross_HLSL_Info
 {
-    const char *source;                        /**< The HLSL source code for the shader. */
+    const char *source;                        /**< The HLSL source code for the shader. Must be NUL-terminated unless SDL_SHADERCROSS_PROP_HLSL_SOURCE_SIZE_NUMBER is set. */
     const char *entrypoint;                    /**< The entry point function name for the shader in UTF-8. */
     const char *include_dir;                   /**< The include directory for shader code. Optional, can be NULL. */
     SDL_ShaderCross_HLSL_Define *defines;      /**< An array of defines. Optional, can be NULL. If not NULL, must be terminated with a fully NULL define struct. */
@@ -97,16 +277,134 @@ typedef struct SDL_ShaderCross_HLSL_Info
     SDL_PropertiesID props;                    /**< A properties ID for extensions. Should be 0 if no extensions are needed. */
 } SDL_ShaderCross_HLSL_Info;
 
+/**
+ * An opaque handle to a compiler output.
+ *
+ * A blob wraps the buffer owned by the compiler that produced it (a DXC or
+ * FXC blob, or a SPIRV-Cross context), so the output is never copied.
+ *
+ * \sa SDL_ShaderCross_GetBlobData
+ * \sa SDL_ShaderCross_GetBlobSize
+ * \sa SDL_ShaderCross_ReleaseBlob
+ */
+typedef struct SDL_ShaderCross_Blob SDL_ShaderCross_Blob;
+
+/**
+ * A string naming a directory in which compile results are cached across
+ * runs.
+ *
+ * Pass it to SDL_ShaderCross_InitWithProperties to enable the cache for
+ * every compile, or set it in SDL_ShaderCross_SPIRV_Info.props or
+ * SDL_ShaderCross_HLSL_Info.props to override the directory for a single
+ * compile, where an empty string disables the cache. The cache is only used
+ * once SDL_ShaderCross_Init has been called.
+ *
+ * Entries are keyed on a SHA-256 of the input, every option and the
+ * versions of the compilers involved, and HLSL entries are additionally
+ * checked against the contents of every file they included. The directory
+ * can be shared by several processes, and can be deleted at any time to
+ * clear the cache.
+ */
+#define SDL_SHADERCROSS_PROP_CACHE_DIRECTORY_STRING "SDL.shadercross.cache_directory"
+
+/**
+ * A number for SDL_ShaderCross_InitWithProperties, the number of bytes that
+ * compile results cached in memory may take up. When the budget is
+ * exceeded, the least recently used results are evicted. Defaults to 0,
+ * which disables the memory cache.
+ *
+ * \sa SDL_ShaderCross_SetMemoryCacheBudget
+ * \sa SDL_ShaderCross_GetMemoryCacheStats
+ */
+#define SDL_SHADERCROSS_PROP_MEMORY_CACHE_BUDGET_NUMBER "SDL.shadercross.memory_cache_budget"
+
+/**
+ * A number for SDL_ShaderCross_InitWithProperties, the number of worker
+ * threads that run async jobs and share the work of
+ * SDL_ShaderCross_CompilePermutationsFromHLSL and
+ * SDL_ShaderCross_CompileMultiTargetFromSPIRV. Defaults to 0, which uses one
+ * fewer than the number of logical CPU cores, and at least one. The threads
+ * are only started once they are first needed.
+ *
+ * \sa SDL_ShaderCross_CompileDXILFromHLSLAsync
+ */
+#define SDL_SHADERCROSS_PROP_WORKER_THREADS_NUMBER "SDL.shadercross.worker_threads"
+
+/**
+ * A string for SDL_ShaderCross_InitWithProperties, the path of a file to
+ * capture every compile into from initialization until
+ * SDL_ShaderCross_Quit, for replaying later. The file is overwritten.
+ *
+ * \sa SDL_ShaderCross_StartCapture
+ * \sa SDL_ShaderCross_ReplayCapture
+ */
+#define SDL_SHADERCROSS_PROP_CAPTURE_FILE_STRING "SDL.shadercross.capture_file"
+
+/**
+ * Counters describing the in-memory compile result cache.
+ *
+ * \sa SDL_ShaderCross_GetMemoryCacheStats
+ */
+typedef struct SDL_ShaderCross_MemoryCacheStats
+{
+    Uint64 hits;         /**< Lookups that returned a cached result. */
+    Uint64 misses;       /**< Lookups that had to compile, including stale results. */
+    Uint64 evictions;    /**< Results evicted to stay within the budget. */
+    Uint64 bytes;        /**< The number of bytes currently used by cached results. */
+    Uint64 budget;       /**< The number of bytes cached results may use. */
+    Uint32 num_entries;  /**< The number of results currently cached. */
+} SDL_ShaderCross_MemoryCacheStats;
+
 /**
  * Initializes SDL_shadercross
  *
- * \threadsafety This should only be called once, from a single thread.
+ * Initialization is reference counted: calling this again while
+ * SDL_shadercross is initialized only adds a reference, and each call must
+ * be matched by a call to SDL_ShaderCross_Quit.
+ *
+ * \threadsafety This should not be called at the same time as
+ *               SDL_ShaderCross_Quit.
+ *
+ * \sa SDL_ShaderCross_InitWithProperties
  */
 extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_Init(void);
+
+/**
+ * Initializes SDL_shadercross with the specified properties.
+ *
+ * These are the supported properties:
+ *
+ * - `SDL_SHADERCROSS_PROP_CACHE_DIRECTORY_STRING`: a directory in which
+ *   compile results are cached across runs. Created if it does not exist.
+ * - `SDL_SHADERCROSS_PROP_MEMORY_CACHE_BUDGET_NUMBER`: the number of bytes
+ *   compile results cached in memory may take up, 0 to disable.
+ * - `SDL_SHADERCROSS_PROP_WORKER_THREADS_NUMBER`: the number of threads
+ *   that run async jobs and parallel compiles, 0 to pick one based on the
+ *   number of CPU cores.
+ * - `SDL_SHADERCROSS_PROP_CAPTURE_FILE_STRING`: a file to capture every
+ *   compile into, as with SDL_ShaderCross_StartCapture.
+ *
+ * The properties are only used by the first call; like SDL_ShaderCross_Init,
+ * later calls only add a reference until the matching SDL_ShaderCross_Quit.
+ *
+ * \param props the properties to use, or 0 for the same behavior as
+ *              SDL_ShaderCross_Init.
+ * \returns true on success, false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety This should not be called at the same time as
+ *               SDL_ShaderCross_Quit.
+ *
+ * \sa SDL_ShaderCross_Init
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_InitWithProperties(SDL_PropertiesID props);
 /**
  * De-initializes SDL_shadercross
  *
- * \threadsafety This should only be called once, from a single thread.
+ * Only the call matching the first SDL_ShaderCross_Init does anything.
+ *
+ * \threadsafety This should not be called at the same time as
+ *               SDL_ShaderCross_Init, or while any compile is running.
  */
 extern SDL_DECLSPEC void SDLCALL SDL_ShaderCross_Quit(void);
 
@@ -223,6 +521,48 @@ extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_ReflectComputeSPIRV(
     size_t bytecode_size,
     SDL_ShaderCross_ComputePipelineMetadata *metadata);
 
+/**
+ * Register an in-memory file that HLSL `#include` directives can resolve to.
+ *
+ * Includes are matched against `path` as DXC sees it, i.e. an include
+ * directory joined with the name in the `#include` directive. Virtual files
+ * take precedence over files on disk. Registering the same path again
+ * replaces the previous contents.
+ *
+ * \param path the path of the virtual file in UTF-8.
+ * \param data the file contents, copied by this function.
+ * \param size the length of the file contents in bytes.
+ * \returns true on success, false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_RegisterVirtualFile(
+    const char *path,
+    const void *data,
+    size_t size);
+
+/**
+ * Remove an in-memory file registered with SDL_ShaderCross_RegisterVirtualFile.
+ *
+ * \param path the path of the virtual file in UTF-8.
+ * \returns true on success, false if no such file was registered.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_UnregisterVirtualFile(
+    const char *path);
+
+/**
+ * Drop every include file that was cached from disk.
+ *
+ * Cached files are revalidated against their size and modification time
+ * when used, so this is only needed to reclaim memory.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ */
+extern SDL_DECLSPEC void SDLCALL SDL_ShaderCross_ClearIncludeCache(void);
+
 /**
  * Get the supported shader formats that HLSL cross-compilation can output
  *
@@ -305,6 +645,983 @@ extern SDL_DECLSPEC SDL_GPUComputePipeline * SDLCALL SDL_ShaderCross_CompileComp
     const SDL_ShaderCross_HLSL_Info *info,
     SDL_ShaderCross_ComputePipelineMetadata *metadata);
 
+/**
+ * Get a pointer to the contents of a blob.
+ *
+ * For source code outputs (MSL and HLSL) the contents are NUL-terminated.
+ *
+ * \param blob the blob to query.
+ * \returns a pointer to the blob contents, valid until the blob is released.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ */
+extern SDL_DECLSPEC const void * SDLCALL SDL_ShaderCross_GetBlobData(
+    SDL_ShaderCross_Blob *blob);
+
+/**
+ * Get the size of the contents of a blob.
+ *
+ * For source code outputs the size does not include the NUL terminator.
+ *
+ * \param blob the blob to query.
+ * \returns the size of the blob contents in bytes.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ */
+extern SDL_DECLSPEC size_t SDLCALL SDL_ShaderCross_GetBlobSize(
+    SDL_ShaderCross_Blob *blob);
+
+/**
+ * Release a blob and the compiler resources backing it.
+ *
+ * \param blob the blob to release. May be NULL.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ */
+extern SDL_DECLSPEC void SDLCALL SDL_ShaderCross_ReleaseBlob(
+    SDL_ShaderCross_Blob *blob);
+
+/**
+ * Transpile to MSL code from SPIRV code, without copying the output.
+ *
+ * You must call SDL_ShaderCross_ReleaseBlob once you are done with it.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \returns a blob containing MSL code, or NULL on failure.
+ *
+ * \sa SDL_ShaderCross_TranspileMSLFromSPIRV
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Blob * SDLCALL SDL_ShaderCross_TranspileMSLFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info);
+
+/**
+ * Transpile to HLSL code from SPIRV code, without copying the output.
+ *
+ * You must call SDL_ShaderCross_ReleaseBlob once you are done with it.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \returns a blob containing HLSL code, or NULL on failure.
+ *
+ * \sa SDL_ShaderCross_TranspileHLSLFromSPIRV
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Blob * SDLCALL SDL_ShaderCross_TranspileHLSLFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info);
+
+/**
+ * Compile DXBC bytecode from SPIRV code, without copying the output.
+ *
+ * You must call SDL_ShaderCross_ReleaseBlob once you are done with it.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \returns a blob containing DXBC bytecode, or NULL on failure.
+ *
+ * \sa SDL_ShaderCross_CompileDXBCFromSPIRV
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Blob * SDLCALL SDL_ShaderCross_CompileDXBCFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info);
+
+/**
+ * Compile DXIL bytecode from SPIRV code, without copying the output.
+ *
+ * You must call SDL_ShaderCross_ReleaseBlob once you are done with it.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \returns a blob containing DXIL bytecode, or NULL on failure.
+ *
+ * \sa SDL_ShaderCross_CompileDXILFromSPIRV
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Blob * SDLCALL SDL_ShaderCross_CompileDXILFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info);
+
+/**
+ * Compile to DXBC bytecode from HLSL code, without copying the output.
+ *
+ * You must call SDL_ShaderCross_ReleaseBlob once you are done with it.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \returns a blob containing DXBC bytecode, or NULL on failure.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileDXBCFromHLSL
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Blob * SDLCALL SDL_ShaderCross_CompileDXBCFromHLSLToBlob(
+    const SDL_ShaderCross_HLSL_Info *info);
+
+/**
+ * Compile to DXIL bytecode from HLSL code, without copying the output.
+ *
+ * You must call SDL_ShaderCross_ReleaseBlob once you are done with it.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \returns a blob containing DXIL bytecode, or NULL on failure.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileDXILFromHLSL
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Blob * SDLCALL SDL_ShaderCross_CompileDXILFromHLSLToBlob(
+    const SDL_ShaderCross_HLSL_Info *info);
+
+/**
+ * Compile to SPIRV bytecode from HLSL code, without copying the output.
+ *
+ * You must call SDL_ShaderCross_ReleaseBlob once you are done with it.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \returns a blob containing SPIRV bytecode, or NULL on failure.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileSPIRVFromHLSL
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Blob * SDLCALL SDL_ShaderCross_CompileSPIRVFromHLSLToBlob(
+    const SDL_ShaderCross_HLSL_Info *info);
+
+/**
+ * Compile DXBC bytecode from HLSL code into a buffer provided by the caller.
+ *
+ * The output is the same as the data of the blob from
+ * SDL_ShaderCross_CompileDXBCFromHLSLToBlob, copied straight into `buffer`.
+ * If `buffer` is NULL, nothing is written and only the size is returned. If
+ * `buffer_size` is too small, nothing is written and this fails, but the
+ * size is still returned. Either way the output is kept for the calling
+ * thread, so calling again with the same info and a large enough buffer
+ * writes it without compiling again, unless one of the files it included
+ * has changed since. The kept output is released by the next call to any of
+ * the ToBuffer functions on the thread, or by SDL_ShaderCross_Quit.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param buffer the memory to write the output to, or NULL to query the
+ *               size.
+ * \param buffer_size the size of `buffer` in bytes.
+ * \param size filled in with the size of the output in bytes.
+ * \returns true on success or false on failure, including when `buffer` is
+ *          too small; call SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileDXBCFromHLSLToBlob
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_CompileDXBCFromHLSLToBuffer(
+    const SDL_ShaderCross_HLSL_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size);
+
+/**
+ * Compile DXIL bytecode from HLSL code into a buffer provided by the caller.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLToBuffer.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param buffer the memory to write the output to, or NULL to query the
+ *               size.
+ * \param buffer_size the size of `buffer` in bytes.
+ * \param size filled in with the size of the output in bytes.
+ * \returns true on success or false on failure, including when `buffer` is
+ *          too small; call SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileDXILFromHLSLToBlob
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_CompileDXILFromHLSLToBuffer(
+    const SDL_ShaderCross_HLSL_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size);
+
+/**
+ * Compile SPIRV bytecode from HLSL code into a buffer provided by the caller.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLToBuffer.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param buffer the memory to write the output to, or NULL to query the
+ *               size.
+ * \param buffer_size the size of `buffer` in bytes.
+ * \param size filled in with the size of the output in bytes.
+ * \returns true on success or false on failure, including when `buffer` is
+ *          too small; call SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileSPIRVFromHLSLToBlob
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_CompileSPIRVFromHLSLToBuffer(
+    const SDL_ShaderCross_HLSL_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size);
+
+/**
+ * Transpile to MSL code from SPIRV code into a buffer provided by the caller.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLToBuffer. The output is the
+ * text of the code without a NUL terminator, so `size` does not count one
+ * and a buffer of exactly `size` bytes is large enough.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param buffer the memory to write the output to, or NULL to query the
+ *               size.
+ * \param buffer_size the size of `buffer` in bytes.
+ * \param size filled in with the size of the output in bytes.
+ * \returns true on success or false on failure, including when `buffer` is
+ *          too small; call SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_TranspileMSLFromSPIRVToBlob
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_TranspileMSLFromSPIRVToBuffer(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size);
+
+/**
+ * Transpile to HLSL code from SPIRV code into a buffer provided by the caller.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLToBuffer. The output is the
+ * text of the code without a NUL terminator, so `size` does not count one
+ * and a buffer of exactly `size` bytes is large enough.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param buffer the memory to write the output to, or NULL to query the
+ *               size.
+ * \param buffer_size the size of `buffer` in bytes.
+ * \param size filled in with the size of the output in bytes.
+ * \returns true on success or false on failure, including when `buffer` is
+ *          too small; call SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_TranspileHLSLFromSPIRVToBlob
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_TranspileHLSLFromSPIRVToBuffer(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size);
+
+/**
+ * Compile DXBC bytecode from SPIRV code into a buffer provided by the caller.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLToBuffer.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param buffer the memory to write the output to, or NULL to query the
+ *               size.
+ * \param buffer_size the size of `buffer` in bytes.
+ * \param size filled in with the size of the output in bytes.
+ * \returns true on success or false on failure, including when `buffer` is
+ *          too small; call SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileDXBCFromSPIRVToBlob
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_CompileDXBCFromSPIRVToBuffer(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size);
+
+/**
+ * Compile DXIL bytecode from SPIRV code into a buffer provided by the caller.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLToBuffer.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param buffer the memory to write the output to, or NULL to query the
+ *               size.
+ * \param buffer_size the size of `buffer` in bytes.
+ * \param size filled in with the size of the output in bytes.
+ * \returns true on success or false on failure, including when `buffer` is
+ *          too small; call SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileDXILFromSPIRVToBlob
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_CompileDXILFromSPIRVToBuffer(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size);
+
+/**
+ * The outcome of compiling a single permutation with
+ * SDL_ShaderCross_CompilePermutationsFromHLSL.
+ *
+ * \sa SDL_ShaderCross_CompilePermutationsFromHLSL
+ */
+typedef struct SDL_ShaderCross_PermutationResult
+{
+    SDL_ShaderCross_Blob *blob;  /**< The compiled bytecode, or NULL if this permutation failed. */
+    char *error;                 /**< The error message if this permutation failed, otherwise NULL. */
+} SDL_ShaderCross_PermutationResult;
+
+/**
+ * Compile several permutations of the same HLSL shader, each with its own
+ * set of defines.
+ *
+ * Everything but the defines is set up once and shared by all permutations,
+ * and the permutations are compiled in parallel by the calling thread and
+ * the worker threads started by SDL_ShaderCross_Init. Without
+ * SDL_ShaderCross_Init they are compiled on the calling thread alone. The
+ * defines in `info` are applied to every permutation, followed by that
+ * permutation's own set.
+ *
+ * A failing permutation does not stop the others; check each result's
+ * `blob` and `error` fields.
+ *
+ * \param info a struct describing the shader to compile.
+ * \param define_sets an array of `num_define_sets` define arrays, each
+ *                    terminated with a fully NULL define struct. An entry
+ *                    may be NULL for a permutation without extra defines.
+ * \param num_define_sets the number of permutations to compile.
+ * \param format the output format, one of SDL_GPU_SHADERFORMAT_SPIRV,
+ *               SDL_GPU_SHADERFORMAT_DXIL or SDL_GPU_SHADERFORMAT_DXBC.
+ * \returns an array of `num_define_sets` results, in the same order as
+ *          `define_sets`, or NULL on failure; call SDL_GetError() for more
+ *          information. Release it with
+ *          SDL_ShaderCross_ReleasePermutationResults.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_ReleasePermutationResults
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_PermutationResult * SDLCALL SDL_ShaderCross_CompilePermutationsFromHLSL(
+    const SDL_ShaderCross_HLSL_Info *info,
+    const SDL_ShaderCross_HLSL_Define * const *define_sets,
+    int num_define_sets,
+    SDL_GPUShaderFormat format);
+
+/**
+ * Release the results of SDL_ShaderCross_CompilePermutationsFromHLSL,
+ * including every blob and error message they hold.
+ *
+ * \param results the results to release. Can be NULL.
+ * \param num_results the number of results in the array.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompilePermutationsFromHLSL
+ */
+extern SDL_DECLSPEC void SDLCALL SDL_ShaderCross_ReleasePermutationResults(
+    SDL_ShaderCross_PermutationResult *results,
+    int num_results);
+
+/**
+ * The outputs of SDL_ShaderCross_CompileMultiTargetFromSPIRV.
+ *
+ * Outputs for targets that were not requested, or that failed, are NULL.
+ * Only the metadata matching the shader stage is filled in.
+ *
+ * \sa SDL_ShaderCross_CompileMultiTargetFromSPIRV
+ * \sa SDL_ShaderCross_ReleaseMultiTargetResult
+ */
+typedef struct SDL_ShaderCross_MultiTargetResult
+{
+    SDL_ShaderCross_Blob *msl;   /**< MSL source code. */
+    SDL_ShaderCross_Blob *hlsl;  /**< The HLSL source code the DXIL was compiled from. Only produced with the DXIL target. */
+    SDL_ShaderCross_Blob *dxbc;  /**< DXBC bytecode. */
+    SDL_ShaderCross_Blob *dxil;  /**< DXIL bytecode. */
+    char *msl_entrypoint;        /**< The MSL entry point name, which can differ from the SPIR-V one (e.g. main0). */
+    SDL_ShaderCross_GraphicsShaderMetadata graphics_metadata;  /**< Reflection metadata for vertex and fragment shaders. */
+    SDL_ShaderCross_ComputePipelineMetadata compute_metadata;  /**< Reflection metadata for compute shaders. */
+    char *error;                 /**< The first error message if any target failed, otherwise NULL. */
+} SDL_ShaderCross_MultiTargetResult;
+
+/**
+ * Compile SPIRV code to several target formats at once.
+ *
+ * The module is parsed and reflected once, then every requested backend
+ * runs from the shared IR, in parallel on the worker threads started by
+ * SDL_ShaderCross_Init if it was called. This is cheaper than calling
+ * SDL_ShaderCross_TranspileMSLFromSPIRV, SDL_ShaderCross_CompileDXBCFromSPIRV
+ * and SDL_ShaderCross_CompileDXILFromSPIRV separately.
+ *
+ * Even when this function fails, `results` holds every output that did
+ * succeed and must be released.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param targets a bitmask of SDL_GPU_SHADERFORMAT_MSL,
+ *                SDL_GPU_SHADERFORMAT_DXBC and SDL_GPU_SHADERFORMAT_DXIL.
+ * \param results filled in with the outputs and reflection metadata.
+ * \returns true if every requested target succeeded, false otherwise; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_ReleaseMultiTargetResult
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_CompileMultiTargetFromSPIRV(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_GPUShaderFormat targets,
+    SDL_ShaderCross_MultiTargetResult *results);
+
+/**
+ * Release the outputs held by an SDL_ShaderCross_MultiTargetResult and
+ * reset it.
+ *
+ * \param results the results to release. Can be NULL.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileMultiTargetFromSPIRV
+ */
+extern SDL_DECLSPEC void SDLCALL SDL_ShaderCross_ReleaseMultiTargetResult(
+    SDL_ShaderCross_MultiTargetResult *results);
+
+/**
+ * Change the number of bytes compile results cached in memory may take up.
+ *
+ * Results beyond the new budget are evicted right away, least recently used
+ * first. Results are only cached in memory while the budget is above 0.
+ *
+ * Cached results are returned by the functions producing blobs or GPU
+ * objects whenever the same input is compiled with the same options, and
+ * are reused across calls from any thread. Results compiled from HLSL are
+ * only reused while the files they included are unchanged.
+ *
+ * \param budget the budget in bytes, or 0 to disable and empty the cache.
+ * \returns true on success, false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_GetMemoryCacheStats
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_SetMemoryCacheBudget(Uint64 budget);
+
+/**
+ * Query the counters of the in-memory compile result cache.
+ *
+ * The hit, miss and eviction counters accumulate from
+ * SDL_ShaderCross_Init onwards.
+ *
+ * \param stats filled in with the current counters.
+ * \returns true on success, false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_SetMemoryCacheBudget
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_GetMemoryCacheStats(SDL_ShaderCross_MemoryCacheStats *stats);
+
+/**
+ * The size in bytes of a digest from SDL_ShaderCross_ComputeDigest.
+ */
+#define SDL_SHADERCROSS_DIGEST_SIZE 32
+
+/**
+ * Compute the SHA-256 digest of some data, the same hash the disk cache
+ * keys its results with.
+ *
+ * This is meant for build tools keeping their own records of what was
+ * compiled, where a collision would mean skipping a compile that was
+ * needed, so a weak hash won't do.
+ *
+ * \param data the data to hash. Can be NULL if `size` is 0.
+ * \param size the size of the data in bytes.
+ * \param digest filled in with the digest.
+ * \returns true on success, false on failure; call SDL_GetError() for more
+ *          information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_GetCompilerVersions
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_ComputeDigest(const void *data, size_t size, Uint8 digest[SDL_SHADERCROSS_DIGEST_SIZE]);
+
+/**
+ * Get a description of the versions of every compiler that can contribute
+ * to an output, the same one the disk cache is keyed with.
+ *
+ * The description changes whenever the library or one of its compilers is
+ * upgraded, so a build tool can include it in its own records to recompile
+ * after an upgrade. Its format is not specified and may change.
+ *
+ * SDL_ShaderCross_Init must have been called first.
+ *
+ * \returns a UTF-8 string that stays valid until SDL_ShaderCross_Quit, or
+ *          NULL on failure; call SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_ComputeDigest
+ */
+extern SDL_DECLSPEC const char * SDLCALL SDL_ShaderCross_GetCompilerVersions(void);
+
+typedef enum SDL_ShaderCross_TraceEventType
+{
+    SDL_SHADERCROSS_TRACE_BEGIN,  /**< A phase has started. */
+    SDL_SHADERCROSS_TRACE_END     /**< The phase most recently started on the same thread has ended. */
+} SDL_ShaderCross_TraceEventType;
+
+/**
+ * An event passed to the trace callback.
+ *
+ * \sa SDL_ShaderCross_SetTraceCallback
+ */
+typedef struct SDL_ShaderCross_TraceEvent
+{
+    SDL_ShaderCross_TraceEventType type;  /**< Whether the phase begins or ends. */
+    SDL_ShaderCross_CompilePhase phase;   /**< The phase of the compile. */
+    const char *stage;                    /**< A printable name for the phase, e.g. "DXC front end". */
+    const char *name;                     /**< The name of the shader from its info struct, or NULL. Only valid during the callback. */
+    SDL_ThreadID thread_id;               /**< The thread the phase runs on. */
+    Uint64 timestamp_ns;                  /**< The time of the event, as returned by SDL_GetTicksNS(). */
+} SDL_ShaderCross_TraceEvent;
+
+/**
+ * A function that is called when a phase of a compile begins and ends.
+ *
+ * \param userdata the pointer passed to SDL_ShaderCross_SetTraceCallback.
+ * \param event the event.
+ *
+ * \threadsafety This is called on the thread running the phase, and may be
+ *               called from several threads at once.
+ *
+ * \sa SDL_ShaderCross_SetTraceCallback
+ */
+typedef void (SDLCALL *SDL_ShaderCross_TraceCallback)(void *userdata, const SDL_ShaderCross_TraceEvent *event);
+
+/**
+ * Set a callback that is told when every phase of a compile begins and
+ * ends, such as for showing compiles in a frame profiler.
+ *
+ * Every phase listed in SDL_ShaderCross_CompilePhase is reported, on the
+ * thread it runs on, as a begin event followed by an end event. Phases do
+ * not nest within a thread. Results returned from the compile cache have no
+ * phases.
+ *
+ * When this returns, the previous callback is no longer running on any
+ * thread, so its userdata can be freed. It must not be called from a trace
+ * callback.
+ *
+ * \param callback the function to call, or NULL to stop tracing.
+ * \param userdata a pointer that is passed to `callback`.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_WriteChromeTraceEvent
+ */
+extern SDL_DECLSPEC void SDLCALL SDL_ShaderCross_SetTraceCallback(SDL_ShaderCross_TraceCallback callback, void *userdata);
+
+/**
+ * An opaque handle to a trace being written in the Chrome trace event
+ * format, which chrome://tracing and Perfetto can open.
+ *
+ * \sa SDL_ShaderCross_CreateChromeTrace
+ */
+typedef struct SDL_ShaderCross_ChromeTrace SDL_ShaderCross_ChromeTrace;
+
+/**
+ * Start writing a Chrome trace to a stream.
+ *
+ * Pass SDL_ShaderCross_WriteChromeTraceEvent with the returned trace to
+ * SDL_ShaderCross_SetTraceCallback to record compiles, or call it from a
+ * callback of your own.
+ *
+ * \param stream the stream to write the trace to.
+ * \param closeio true to close the stream when the trace is closed, even on
+ *                failure.
+ * \returns a trace on success or NULL on failure; call SDL_GetError() for
+ *          more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CloseChromeTrace
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_ChromeTrace * SDLCALL SDL_ShaderCross_CreateChromeTrace(SDL_IOStream *stream, bool closeio);
+
+/**
+ * Write a trace event to a Chrome trace.
+ *
+ * This is an SDL_ShaderCross_TraceCallback, so it can be passed straight to
+ * SDL_ShaderCross_SetTraceCallback.
+ *
+ * \param userdata the SDL_ShaderCross_ChromeTrace to write to.
+ * \param event the event to write.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CreateChromeTrace
+ */
+extern SDL_DECLSPEC void SDLCALL SDL_ShaderCross_WriteChromeTraceEvent(void *userdata, const SDL_ShaderCross_TraceEvent *event);
+
+/**
+ * Finish a Chrome trace and free it.
+ *
+ * Tracing into it must have been stopped first.
+ *
+ * \param trace the trace to close.
+ * \returns true if the whole trace was written, false on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CreateChromeTrace
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_CloseChromeTrace(SDL_ShaderCross_ChromeTrace *trace);
+
+/**
+ * Start capturing compiles to a stream, for replaying them later with
+ * SDL_ShaderCross_ReplayCapture.
+ *
+ * Every compile, transpile and reflection call is written to the capture
+ * when it finishes, along with all of its inputs and properties, how long
+ * it took and the size of its output. The contents of every file included
+ * by HLSL are captured too, so replaying does not need them. Asynchronous
+ * jobs are captured as the synchronous call they run, and the functions
+ * that create GPU objects as the compile that precedes creating the object.
+ * SDL_ShaderCross_CompileGraphicsShaderFromHLSL and
+ * SDL_ShaderCross_CompileComputePipelineFromHLSL are captured as their
+ * compile to SPIR-V followed by the compile for the device.
+ *
+ * Pointer properties other than
+ * `SDL_SHADERCROSS_PROP_HLSL_INCLUDE_DIRS_POINTER` are not captured.
+ * Captures hold the shaders verbatim and can grow large.
+ *
+ * SDL_ShaderCross_Init must have been called first.
+ *
+ * \param stream the stream to write the capture to.
+ * \param closeio true to close the stream when the capture is stopped,
+ *                even on failure.
+ * \returns true on success or false on failure, such as when a capture is
+ *          already running; call SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_StopCapture
+ * \sa SDL_SHADERCROSS_PROP_CAPTURE_FILE_STRING
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_StartCapture(SDL_IOStream *stream, bool closeio);
+
+/**
+ * Stop capturing compiles and finish the capture.
+ *
+ * Calls that are still running are left out of the capture.
+ *
+ * \returns true if the whole capture was written, false on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_StartCapture
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_StopCapture(void);
+
+/**
+ * A call from a capture that was replayed.
+ *
+ * \sa SDL_ShaderCross_ReplayCapture
+ */
+typedef struct SDL_ShaderCross_ReplayEvent
+{
+    const char *function;          /**< The public function that was called, e.g. "SDL_ShaderCross_CompileDXILFromHLSL". */
+    const char *name;              /**< The name of the shader from its info struct, or NULL. */
+    const char *captured_versions; /**< The versions of the compilers the capture was taken with, or NULL. */
+    SDL_ThreadID thread_id;        /**< The thread the call was captured on. */
+    Uint64 captured_start_ns;      /**< When the call started, in nanoseconds since the capture started. */
+    Uint64 captured_ns;            /**< How long the call took when captured. */
+    bool captured_success;         /**< Whether the call succeeded when captured. */
+    bool captured_cache_hit;       /**< Whether any of its compiles were served from a cache when captured. */
+    Uint64 captured_output_size;   /**< The size of the output when captured, in bytes. */
+    Uint64 replayed_ns;            /**< How long the call took when replayed. */
+    bool replayed_success;         /**< Whether the replayed call succeeded. */
+    Uint64 replayed_output_size;   /**< The size of the replayed output, in bytes. */
+    const char *error;             /**< The error message if the replayed call failed, otherwise NULL. */
+} SDL_ShaderCross_ReplayEvent;
+
+/**
+ * A function that is called for every call a capture replays.
+ *
+ * \param userdata the pointer passed to SDL_ShaderCross_ReplayCapture.
+ * \param event the replayed call. Its strings are only valid during the
+ *              callback.
+ *
+ * \threadsafety This is called on the thread that called
+ *               SDL_ShaderCross_ReplayCapture.
+ *
+ * \sa SDL_ShaderCross_ReplayCapture
+ */
+typedef void (SDLCALL *SDL_ShaderCross_ReplayCallback)(void *userdata, const SDL_ShaderCross_ReplayEvent *event);
+
+/**
+ * Run the calls in a capture again and time them, such as for measuring
+ * how a new version of the library or its compilers performs on a real
+ * workload.
+ *
+ * The calls are run one after another on the calling thread, in the order
+ * they finished when captured. They bypass the memory and disk caches, so
+ * that every call measures its compiles. Compiles that created GPU objects
+ * only compile, so no device is needed. The captured includes are
+ * registered as virtual files while the replay runs, replacing any
+ * registered at the same paths.
+ *
+ * A capture that was cut short, such as by a crash, is replayed up to the
+ * last complete call.
+ *
+ * SDL_ShaderCross_Init must have been called first.
+ *
+ * \param stream the stream to read the capture from.
+ * \param closeio true to close the stream when done, even on failure.
+ * \param callback a function called after every replayed call. Can be NULL.
+ * \param userdata a pointer that is passed to `callback`.
+ * \returns true if the capture was replayed, even if some of its calls
+ *          failed, or false if it could not be read; call SDL_GetError()
+ *          for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_StartCapture
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_ReplayCapture(SDL_IOStream *stream, bool closeio, SDL_ShaderCross_ReplayCallback callback, void *userdata);
+
+/**
+ * An opaque handle to a compile running in the background.
+ *
+ * \sa SDL_ShaderCross_CompileDXILFromHLSLAsync
+ * \sa SDL_ShaderCross_ReleaseJob
+ */
+typedef struct SDL_ShaderCross_Job SDL_ShaderCross_Job;
+
+/**
+ * A function called when an async job finishes, whether it succeeded or not.
+ *
+ * It is called on the worker thread that ran the job, and should return
+ * quickly since no other job runs on that thread meanwhile. The job is
+ * valid for the duration of the call even if it has already been released.
+ *
+ * \param userdata what was passed as `userdata` when starting the job.
+ * \param job the job that finished.
+ *
+ * \sa SDL_ShaderCross_GetJobResult
+ */
+typedef void (SDLCALL *SDL_ShaderCross_JobCallback)(void *userdata, SDL_ShaderCross_Job *job);
+
+/**
+ * Compile DXBC bytecode from HLSL code in the background.
+ *
+ * Everything `info` points to is copied, so it can be freed as soon as this
+ * function returns. Jobs run on a pool of worker threads sized with
+ * `SDL_SHADERCROSS_PROP_WORKER_THREADS_NUMBER`, and require
+ * SDL_ShaderCross_Init to have been called.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param callback a function to call when the job finishes. Can be NULL.
+ * \param userdata a pointer that is passed to `callback`.
+ * \returns a job handle that must be released with
+ *          SDL_ShaderCross_ReleaseJob, or NULL on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileDXBCFromHLSLToBlob
+ * \sa SDL_ShaderCross_GetJobResult
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Job * SDLCALL SDL_ShaderCross_CompileDXBCFromHLSLAsync(
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata);
+
+/**
+ * Compile DXIL bytecode from HLSL code in the background.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLAsync.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param callback a function to call when the job finishes. Can be NULL.
+ * \param userdata a pointer that is passed to `callback`.
+ * \returns a job handle that must be released with
+ *          SDL_ShaderCross_ReleaseJob, or NULL on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileDXILFromHLSLToBlob
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Job * SDLCALL SDL_ShaderCross_CompileDXILFromHLSLAsync(
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata);
+
+/**
+ * Compile SPIRV bytecode from HLSL code in the background.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLAsync.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param callback a function to call when the job finishes. Can be NULL.
+ * \param userdata a pointer that is passed to `callback`.
+ * \returns a job handle that must be released with
+ *          SDL_ShaderCross_ReleaseJob, or NULL on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileSPIRVFromHLSLToBlob
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Job * SDLCALL SDL_ShaderCross_CompileSPIRVFromHLSLAsync(
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata);
+
+/**
+ * Transpile to MSL code from SPIRV code in the background.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLAsync.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param callback a function to call when the job finishes. Can be NULL.
+ * \param userdata a pointer that is passed to `callback`.
+ * \returns a job handle that must be released with
+ *          SDL_ShaderCross_ReleaseJob, or NULL on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_TranspileMSLFromSPIRVToBlob
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Job * SDLCALL SDL_ShaderCross_TranspileMSLFromSPIRVAsync(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata);
+
+/**
+ * Transpile to HLSL code from SPIRV code in the background.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLAsync.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param callback a function to call when the job finishes. Can be NULL.
+ * \param userdata a pointer that is passed to `callback`.
+ * \returns a job handle that must be released with
+ *          SDL_ShaderCross_ReleaseJob, or NULL on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_TranspileHLSLFromSPIRVToBlob
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Job * SDLCALL SDL_ShaderCross_TranspileHLSLFromSPIRVAsync(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata);
+
+/**
+ * Compile DXBC bytecode from SPIRV code in the background.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLAsync.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param callback a function to call when the job finishes. Can be NULL.
+ * \param userdata a pointer that is passed to `callback`.
+ * \returns a job handle that must be released with
+ *          SDL_ShaderCross_ReleaseJob, or NULL on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileDXBCFromSPIRVToBlob
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Job * SDLCALL SDL_ShaderCross_CompileDXBCFromSPIRVAsync(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata);
+
+/**
+ * Compile DXIL bytecode from SPIRV code in the background.
+ *
+ * Works like SDL_ShaderCross_CompileDXBCFromHLSLAsync.
+ *
+ * \param info a struct describing the shader to transpile.
+ * \param callback a function to call when the job finishes. Can be NULL.
+ * \param userdata a pointer that is passed to `callback`.
+ * \returns a job handle that must be released with
+ *          SDL_ShaderCross_ReleaseJob, or NULL on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_CompileDXILFromSPIRVToBlob
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Job * SDLCALL SDL_ShaderCross_CompileDXILFromSPIRVAsync(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata);
+
+/**
+ * Check whether an async job has finished, without blocking.
+ *
+ * \param job the job to check.
+ * \returns true if the job has finished, successfully or not.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_WaitJob
+ */
+extern SDL_DECLSPEC bool SDLCALL SDL_ShaderCross_IsJobDone(SDL_ShaderCross_Job *job);
+
+/**
+ * Block until an async job has finished.
+ *
+ * \param job the job to wait for.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_IsJobDone
+ */
+extern SDL_DECLSPEC void SDLCALL SDL_ShaderCross_WaitJob(SDL_ShaderCross_Job *job);
+
+/**
+ * Take the output of an async job, waiting for it to finish if needed.
+ *
+ * The output is handed over once; later calls return NULL.
+ *
+ * \param job the job to take the output of.
+ * \returns the output, which must be released with
+ *          SDL_ShaderCross_ReleaseBlob, or NULL on failure; call
+ *          SDL_GetError() for more information.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_GetJobError
+ */
+extern SDL_DECLSPEC SDL_ShaderCross_Blob * SDLCALL SDL_ShaderCross_GetJobResult(SDL_ShaderCross_Job *job);
+
+/**
+ * Get the error message of a failed async job, waiting for it to finish if
+ * needed.
+ *
+ * \param job the job to query.
+ * \returns the error message, or NULL if the job succeeded. The string is
+ *          owned by the job.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ *
+ * \sa SDL_ShaderCross_GetJobResult
+ */
+extern SDL_DECLSPEC const char * SDLCALL SDL_ShaderCross_GetJobError(SDL_ShaderCross_Job *job);
+
+/**
+ * Release an async job handle.
+ *
+ * A job that has not finished yet keeps running, and its output is released
+ * when it does. Its callback is still called.
+ *
+ * \param job the job to release. Can be NULL.
+ *
+ * \threadsafety It is safe to call this function from any thread.
+ */
+extern SDL_DECLSPEC void SDLCALL SDL_ShaderCross_ReleaseJob(SDL_ShaderCross_Job *job);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,1136 +26,5457 @@
 /* Constants */
 #define MAX_DEFINES 64
 #define MAX_DEFINE_STRING_LENGTH 256
+#define MAX_INCLUDE_DIRS 64
+#define DEFAULT_DXIL_SHADER_MODEL 60
+#define DEFAULT_DXBC_SHADER_MODEL 51
+#define MAX_DXIL_SHADER_MODEL 69 /* The last one that fits the major * 10 + minor encoding */
 
-/* Win32 Type Definitions */
-
-typedef int HRESULT;
-typedef const void *LPCVOID;
-typedef size_t SIZE_T;
-typedef const char *LPCSTR;
-typedef unsigned int UINT;
-typedef unsigned long ULONG;
-typedef void *LPVOID;
-typedef void *REFIID;
+/* Result Blobs */
 
-/* DXIL via DXC */
-#ifdef SDL_SHADERCROSS_DXC
+struct SDL_ShaderCross_Blob
+{
+    const void *data;
+    size_t size;
+    void *owner;                  /* The compiler object that owns data */
+    void (*release)(void *owner); /* Releases the owner, called once */
+};
 
-/* dxcompiler Type Definitions */
-typedef int BOOL;
-typedef void *REFCLSID;
-typedef wchar_t *LPCWSTR;
-typedef void IDxcBlobEncoding;   /* hack, unused */
-typedef void IDxcBlobWide;       /* hack, unused */
-typedef void IDxcIncludeHandler; /* hack, unused */
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CreateBlob(
+    const void *data,
+    size_t size,
+    void *owner,
+    void (*release)(void *owner))
+{
+    SDL_ShaderCross_Blob *blob = SDL_malloc(sizeof(SDL_ShaderCross_Blob));
+    if (blob == NULL) {
+        release(owner);
+        return NULL;
+    }
 
-/* Unlike vkd3d-utils, libdxcompiler.so does not use msabi */
-#if !defined(_WIN32)
-#define __stdcall
-#endif
+    blob->data = data;
+    blob->size = size;
+    blob->owner = owner;
+    blob->release = release;
+    return blob;
+}
 
-/* Compiler Interface, _technically_ unofficial but it's MS C++, come on */
-typedef enum DXC_OUT_KIND
+// Copies the blob contents into a new SDL_malloc'd buffer and releases the blob.
+static void *SDL_ShaderCross_INTERNAL_CopyBlob(
+    SDL_ShaderCross_Blob *blob,
+    size_t *size)
 {
-    DXC_OUT_NONE = 0,
-    DXC_OUT_OBJECT = 1,
-    DXC_OUT_ERRORS = 2,
-    DXC_OUT_PDB = 3,
-    DXC_OUT_SHADER_HASH = 4,
-    DXC_OUT_DISASSEMBLY = 5,
-    DXC_OUT_HLSL = 6,
-    DXC_OUT_TEXT = 7,
-    DXC_OUT_REFLECTION = 8,
-    DXC_OUT_ROOT_SIGNATURE = 9,
-    DXC_OUT_EXTRA_OUTPUTS = 10,
-    DXC_OUT_REMARKS = 11,
-    DXC_OUT_TIME_REPORT = 12,
-    DXC_OUT_TIME_TRACE = 13,
-    DXC_OUT_LAST = DXC_OUT_TIME_TRACE,
-    DXC_OUT_NUM_ENUMS,
-    // DXC_OUT_FORCE_DWORD = 0xFFFFFFFF
-} DXC_OUT_KIND;
+    if (blob == NULL) {
+        return NULL;
+    }
 
-#define DXC_CP_UTF8  65001
-#define DXC_CP_UTF16 1200
-#define DXC_CP_UTF32 12000
-/* This is for binary, ANSI-text, or to tell the compiler to try autodetecting UTF using the BOM */
-#define DXC_CP_ACP 0
+    void *buffer = SDL_malloc(blob->size);
+    if (buffer != NULL) {
+        SDL_memcpy(buffer, blob->data, blob->size);
+        *size = blob->size;
+    }
 
-typedef struct DxcBuffer
+    SDL_ShaderCross_ReleaseBlob(blob);
+    return buffer;
+}
+
+// Same as above, but NUL-terminates the copy for source code outputs.
+static char *SDL_ShaderCross_INTERNAL_CopyBlobString(
+    SDL_ShaderCross_Blob *blob)
 {
-    LPCVOID Ptr;
-    SIZE_T Size;
-    UINT Encoding;
-} DxcBuffer;
+    if (blob == NULL) {
+        return NULL;
+    }
 
-/* *INDENT-OFF* */ // clang-format off
+    char *buffer = SDL_malloc(blob->size + 1);
+    if (buffer != NULL) {
+        SDL_memcpy(buffer, blob->data, blob->size);
+        buffer[blob->size] = '\0';
+    }
 
-static Uint8 IID_IDxcBlob[] = {
-    0x08, 0xFB, 0xA5, 0x8B,
-    0x95, 0x51,
-    0xE2, 0x40,
-    0xAC,
-    0x58,
-    0x0D,
-    0x98,
-    0x9C,
-    0x3A,
-    0x01,
-    0x02
-};
-typedef struct IDxcBlob IDxcBlob;
-typedef struct IDxcBlobVtbl
+    SDL_ShaderCross_ReleaseBlob(blob);
+    return buffer;
+}
+
+const void *SDL_ShaderCross_GetBlobData(SDL_ShaderCross_Blob *blob)
 {
-    HRESULT(__stdcall *QueryInterface)(IDxcBlob *This, REFIID riid, void **ppvObject);
-    ULONG(__stdcall *AddRef)(IDxcBlob *This);
-    ULONG(__stdcall *Release)(IDxcBlob *This);
+    if (blob == NULL) {
+        SDL_InvalidParamError("blob");
+        return NULL;
+    }
+    return blob->data;
+}
 
-    LPVOID(__stdcall *GetBufferPointer)(IDxcBlob *This);
-    SIZE_T(__stdcall *GetBufferSize)(IDxcBlob *This);
-} IDxcBlobVtbl;
-struct IDxcBlob
+size_t SDL_ShaderCross_GetBlobSize(SDL_ShaderCross_Blob *blob)
 {
-    IDxcBlobVtbl *lpVtbl;
-};
+    if (blob == NULL) {
+        SDL_InvalidParamError("blob");
+        return 0;
+    }
+    return blob->size;
+}
 
-static Uint8 IID_IDxcBlobUtf8[] = {
-    0xC9, 0x36, 0xA6, 0x3D,
-    0x71, 0xBA,
-    0x24, 0x40,
-    0xA3,
-    0x01,
-    0x30,
-    0xCB,
-    0xF1,
-    0x25,
-    0x30,
-    0x5B
-};
-typedef struct IDxcBlobUtf8 IDxcBlobUtf8;
-typedef struct IDxcBlobUtf8Vtbl
+void SDL_ShaderCross_ReleaseBlob(SDL_ShaderCross_Blob *blob)
 {
-    HRESULT(__stdcall *QueryInterface)(IDxcBlobUtf8 *This, REFIID riid, void **ppvObject);
-    ULONG(__stdcall *AddRef)(IDxcBlobUtf8 *This);
-    ULONG(__stdcall *Release)(IDxcBlobUtf8 *This);
+    if (blob == NULL) {
+        return;
+    }
+    blob->release(blob->owner);
+    SDL_free(blob);
+}
 
-    LPVOID(__stdcall *GetBufferPointer)(IDxcBlobUtf8 *This);
-    SIZE_T(__stdcall *GetBufferSize)(IDxcBlobUtf8 *This);
+/* Compile Statistics and Tracing
+ *
+ * The stats from SDL_SHADERCROSS_PROP_COMPILE_STATS_POINTER and the name of
+ * the shader are made current for the thread running a compile, and every
+ * phase that runs on it adds its time to the stats and is reported to the
+ * trace callback. Threads a compile starts make the same scope current, so
+ * several threads can add to the stats at once. The scope also carries the
+ * captured call the compile belongs to, see the API Capture section.
+ */
+
+typedef struct CompileScope
+{
+    SDL_ShaderCross_CompileStats *stats;
+    const char *name;
+    void *capture; /* The CaptureCall of the outermost call, NULL if not captured */
+} CompileScope;
+
+static const char *phaseNames[SDL_SHADERCROSS_PHASE_COUNT] = {
+    "DXC front end",
+    "SPIR-V parse",
+    "reflection",
+    "SPIRV-Cross codegen",
+    "DXC back end",
+    "FXC",
+    "GPU object creation"
+};
 
-    HRESULT(__stdcall *GetEncoding)(IDxcBlobUtf8 *This, BOOL *pKnown, Uint32 *pCodePage);
+static SDL_TLSID compileStatsTLS;
+static SDL_TLSID compileNameTLS;
+static SDL_TLSID captureCallTLS;
+static SDL_SpinLock compileStatsLock;
 
-    LPCSTR(__stdcall *GetStringPointer)(IDxcBlobUtf8 *This);
-    SIZE_T(__stdcall *GetStringLength)(IDxcBlobUtf8 *This);
-} IDxcBlobUtf8Vtbl;
-struct IDxcBlobUtf8
+static SDL_SpinLock traceLock;
+static SDL_ShaderCross_TraceCallback traceCallback = NULL;
+static void *traceUserdata = NULL;
+static SDL_AtomicInt traceEnabled;
+static SDL_AtomicInt traceCallsInFlight;
+
+static void SDL_ShaderCross_INTERNAL_GetScope(CompileScope *scope)
 {
-    IDxcBlobUtf8Vtbl *lpVtbl;
-};
+    scope->stats = (SDL_ShaderCross_CompileStats *)SDL_GetTLS(&compileStatsTLS);
+    scope->name = (const char *)SDL_GetTLS(&compileNameTLS);
+    scope->capture = SDL_GetTLS(&captureCallTLS);
+}
 
-static Uint8 IID_IDxcResult[] = {
-    0xDA, 0x6C, 0x34, 0x58,
-    0xE7, 0xDD,
-    0x97, 0x44,
-    0x94,
-    0x61,
-    0x6F,
-    0x87,
-    0xAF,
-    0x5E,
-    0x06,
-    0x59
-};
-typedef struct IDxcResult IDxcResult;
-typedef struct IDxcResultVtbl
+static void SDL_ShaderCross_INTERNAL_SetScope(const CompileScope *scope)
 {
-    HRESULT(__stdcall *QueryInterface)(IDxcResult *This, REFIID riid, void **ppvObject);
-    ULONG(__stdcall *AddRef)(IDxcResult *This);
-    ULONG(__stdcall *Release)(IDxcResult *This);
+    if (SDL_GetTLS(&compileStatsTLS) != scope->stats) {
+        SDL_SetTLS(&compileStatsTLS, scope->stats, NULL);
+    }
+    if (SDL_GetTLS(&compileNameTLS) != scope->name) {
+        SDL_SetTLS(&compileNameTLS, scope->name, NULL);
+    }
+    if (SDL_GetTLS(&captureCallTLS) != scope->capture) {
+        SDL_SetTLS(&captureCallTLS, scope->capture, NULL);
+    }
+}
 
-    HRESULT(__stdcall *GetStatus)(IDxcResult *This, HRESULT *pStatus);
-    HRESULT(__stdcall *GetResult)(IDxcResult *This, IDxcBlob **ppResult);
-    HRESULT(__stdcall *GetErrorBuffer)(IDxcResult *This, IDxcBlobEncoding **ppErrors);
+// Saves the current scope to outer, to pass to SDL_ShaderCross_INTERNAL_EndScope
+static void SDL_ShaderCross_INTERNAL_BeginScope(
+    CompileScope *outer,
+    SDL_PropertiesID props,
+    const char *name)
+{
+    CompileScope scope;
+    SDL_ShaderCross_INTERNAL_GetScope(outer);
+    scope = *outer;
+
+    // A nested compile without stats or a name of its own still belongs to the outer one
+    SDL_ShaderCross_CompileStats *stats = (SDL_ShaderCross_CompileStats *)SDL_GetPointerProperty(props, SDL_SHADERCROSS_PROP_COMPILE_STATS_POINTER, NULL);
+    if (stats != NULL) {
+        scope.stats = stats;
+    }
+    if (name != NULL) {
+        scope.name = name;
+    }
+    SDL_ShaderCross_INTERNAL_SetScope(&scope);
+}
 
-    BOOL(__stdcall *HasOutput)(IDxcResult *This, DXC_OUT_KIND dxcOutKind);
-    HRESULT(__stdcall *GetOutput)(
-        IDxcResult *This,
-        DXC_OUT_KIND dxcOutKind,
-        REFIID iid,
-        void **ppvObject,
-        IDxcBlobWide **ppOutputName
-    );
-    Uint32(__stdcall *GetNumOutputs)(IDxcResult *This);
-    DXC_OUT_KIND(__stdcall *GetOutputByIndex)(IDxcResult *This, Uint32 Index);
-    DXC_OUT_KIND(__stdcall *PrimaryOutput)(IDxcResult *This);
-} IDxcResultVtbl;
-struct IDxcResult
+static void SDL_ShaderCross_INTERNAL_EndScope(const CompileScope *outer)
 {
-    IDxcResultVtbl *lpVtbl;
-};
+    SDL_ShaderCross_INTERNAL_SetScope(outer);
+}
 
-static struct
+static void SDL_ShaderCross_INTERNAL_Trace(
+    SDL_ShaderCross_TraceEventType type,
+    SDL_ShaderCross_CompilePhase phase,
+    Uint64 timestamp)
 {
-    Uint32 Data1;
-    Uint16 Data2;
-    Uint16 Data3;
-    Uint8 Data4[8];
-} CLSID_DxcCompiler = {
-    .Data1 = 0x73e22d93,
-    .Data2 = 0xe6ce,
-    .Data3 = 0x47f3,
-    .Data4 = { 0xb5, 0xbf, 0xf0, 0x66, 0x4f, 0x39, 0xc1, 0xb0 }
-};
-static Uint8 IID_IDxcCompiler3[] = {
-    0x87, 0x46, 0x8B, 0x22,
-    0x6A, 0x5A,
-    0x30, 0x47,
-    0x90,
-    0x0C,
-    0x97,
-    0x02,
-    0xB2,
-    0x20,
-    0x3F,
-    0x54
-};
-typedef struct IDxcCompiler3 IDxcCompiler3;
-typedef struct IDxcCompiler3Vtbl
+    SDL_LockSpinlock(&traceLock);
+    SDL_ShaderCross_TraceCallback callback = traceCallback;
+    void *userdata = traceUserdata;
+    if (callback != NULL) {
+        SDL_AddAtomicInt(&traceCallsInFlight, 1);
+    }
+    SDL_UnlockSpinlock(&traceLock);
+
+    if (callback == NULL) {
+        return;
+    }
+
+    SDL_ShaderCross_TraceEvent event;
+    event.type = type;
+    event.phase = phase;
+    event.stage = phaseNames[phase];
+    event.name = (const char *)SDL_GetTLS(&compileNameTLS);
+    event.thread_id = SDL_GetCurrentThreadID();
+    event.timestamp_ns = timestamp;
+    callback(userdata, &event);
+
+    SDL_AddAtomicInt(&traceCallsInFlight, -1);
+}
+
+// Returns the start time for SDL_ShaderCross_INTERNAL_EndPhase, 0 if nothing is measuring it
+static Uint64 SDL_ShaderCross_INTERNAL_BeginPhase(SDL_ShaderCross_CompilePhase phase)
 {
-    HRESULT(__stdcall *QueryInterface)(IDxcCompiler3 *This, REFIID riid, void **ppvObject);
-    ULONG(__stdcall *AddRef)(IDxcCompiler3 *This);
-    ULONG(__stdcall *Release)(IDxcCompiler3 *This);
+    bool tracing = SDL_GetAtomicInt(&traceEnabled) != 0;
+    if (!tracing && SDL_GetTLS(&compileStatsTLS) == NULL) {
+        return 0;
+    }
 
-    HRESULT(__stdcall *Compile)(
-        IDxcCompiler3 *This,
-        const DxcBuffer *pSource,
-        LPCWSTR *pArguments,
-        Uint32 argCount,
-        IDxcIncludeHandler *pIncludeHandler,
-        REFIID riid,
-        LPVOID *ppResult
-    );
+    Uint64 start = SDL_GetTicksNS();
+    if (tracing) {
+        SDL_ShaderCross_INTERNAL_Trace(SDL_SHADERCROSS_TRACE_BEGIN, phase, start);
+    }
+    return start;
+}
 
-    HRESULT(__stdcall *Disassemble)(
-        IDxcCompiler3 *This,
-        const DxcBuffer *pObject,
-        REFIID riid,
-        LPVOID *ppResult
-    );
-} IDxcCompiler3Vtbl;
-struct IDxcCompiler3
+static void SDL_ShaderCross_INTERNAL_EndPhase(
+    SDL_ShaderCross_CompilePhase phase,
+    Uint64 start)
 {
-    const IDxcCompiler3Vtbl *lpVtbl;
-};
+    // Nothing was measuring the phase when it began
+    if (start == 0) {
+        return;
+    }
 
-// We need all this DxcUtils garbage for DXC include dir support. Thanks Microsoft!
-typedef struct IMalloc IMalloc;
-typedef struct IStream IStream;
-typedef struct DxcDefine DxcDefine;
-typedef struct IDxcCompilerArgs IDxcCompilerArgs;
+    Uint64 end = SDL_GetTicksNS();
+    if (SDL_GetAtomicInt(&traceEnabled)) {
+        SDL_ShaderCross_INTERNAL_Trace(SDL_SHADERCROSS_TRACE_END, phase, end);
+    }
 
-static struct
+    SDL_ShaderCross_CompileStats *stats = (SDL_ShaderCross_CompileStats *)SDL_GetTLS(&compileStatsTLS);
+    if (stats != NULL) {
+        SDL_LockSpinlock(&compileStatsLock);
+        stats->phase_ns[phase] += end - start;
+        stats->phase_count[phase] += 1;
+        SDL_UnlockSpinlock(&compileStatsLock);
+    }
+}
+
+static void SDL_ShaderCross_INTERNAL_CountCacheHit(void)
 {
-    Uint32 Data1;
-    Uint16 Data2;
-    Uint16 Data3;
-    Uint8 Data4[8];
-} CLSID_DxcUtils = {
-    .Data1 = 0x6245d6af,
-    .Data2 = 0x66e0,
-    .Data3 = 0x48fd,
-    .Data4 = {0x80, 0xb4, 0x4d, 0x27, 0x17, 0x96, 0x74, 0x8c}};
-static Uint8 IID_IDxcUtils[] = {
-    0xcb, 0xc4, 0x05, 0x46,
-    0x19, 0x20,
-    0x2a, 0x49,
-    0xad,
-    0xa4,
-    0x65,
-    0xf2,
-    0x0b,
-    0xb7,
-    0xd6,
-    0x7f
-};
-typedef struct IDxcUtilsVtbl
-{
-    HRESULT (__stdcall *QueryInterface)(void *pSelf, REFIID riid, void **ppvObject);
-    ULONG (__stdcall *AddRef)(void *pSelf);
-    ULONG (__stdcall *Release)(void *pSelf);
+    SDL_ShaderCross_CompileStats *stats = (SDL_ShaderCross_CompileStats *)SDL_GetTLS(&compileStatsTLS);
+    if (stats == NULL) {
+        return;
+    }
 
-    HRESULT (__stdcall *CreateBlobFromBlob)(void *pSelf, IDxcBlob *pBlob, UINT offset, UINT length, IDxcBlob **ppResult);
-    HRESULT (__stdcall *CreateBlobFromPinned)(void *pSelf, LPCVOID pData, UINT size, UINT codePage, IDxcBlobEncoding **pBlobEncoding);
-    HRESULT (__stdcall *MoveToBlob)(void *pSelf, LPCVOID pData, IMalloc *pIMalloc, UINT size, UINT codePage, IDxcBlobEncoding **pBlobEncoding);
-    HRESULT (__stdcall *CreateBlob)(void *pSelf, LPCVOID pData, UINT size, UINT codePage, IDxcBlobEncoding **pBlobEncoding);
-    HRESULT (__stdcall *LoadFile)(void *pSelf, LPCWSTR pFileName, UINT *pCodePage, IDxcBlobEncoding **pBlobEncoding);
-    HRESULT (__stdcall *CreateReadOnlyStreamFromBlob)(void *pSelf, IDxcBlob *pBlob, IStream **ppStream);
-    HRESULT (__stdcall *CreateDefaultIncludeHandler)(void *pSelf, IDxcIncludeHandler **ppResult);
-    HRESULT (__stdcall *GetBlobAsUtf8)(void *pSelf, IDxcBlob *pBlob, IDxcBlobUtf8 **pBlobEncoding);
-    HRESULT (__stdcall *GetBlobAsWide)(void *pSelf, IDxcBlob *pBlob, IDxcBlobWide **pBlobEncoding);
-    HRESULT (__stdcall *GetDxilContainerPart)(void *pSelf, const DxcBuffer *pShader, UINT DxcPart, void **ppPartData, UINT *pPartSizeInBytes);
-    HRESULT (__stdcall *CreateReflection)(void *pSelf, const DxcBuffer *pData, REFIID iid, void **ppvReflection);
-    HRESULT (__stdcall *BuildArguments)(void *pSelf, LPCWSTR pSourceName, LPCWSTR pEntryPoint, LPCWSTR pTargetProfile, LPCWSTR *pArguments, UINT argCount, const DxcDefine *pDefines, UINT defineCount, IDxcCompilerArgs **ppArgs);
-    HRESULT (__stdcall *GetPDBContents)(void *pSelf, IDxcBlob *pPDBBlob, IDxcBlob **ppHash, IDxcBlob **ppContainer);
-} IDxcUtilsVtbl;
+    SDL_LockSpinlock(&compileStatsLock);
+    stats->cache_hits += 1;
+    SDL_UnlockSpinlock(&compileStatsLock);
+}
 
-typedef struct IDxcUtils IDxcUtils;
-struct IDxcUtils
+void SDL_ShaderCross_SetTraceCallback(
+    SDL_ShaderCross_TraceCallback callback,
+    void *userdata)
 {
-    const IDxcUtilsVtbl *lpVtbl;
-};
-
-/* *INDENT-ON* */ // clang-format on
-
-/* DXCompiler */
-#if defined(SDL_PLATFORM_XBOXONE) || defined(SDL_PLATFORM_XBOXSERIES)
-extern HRESULT __stdcall DxcCreateInstance(REFCLSID rclsid, REFIID riid, LPVOID* ppv);
-#else
-extern HRESULT DxcCreateInstance(REFCLSID rclsid, REFIID riid, LPVOID *ppv);
-#endif
+    SDL_LockSpinlock(&traceLock);
+    traceCallback = callback;
+    traceUserdata = userdata;
+    SDL_SetAtomicInt(&traceEnabled, callback != NULL);
+    SDL_UnlockSpinlock(&traceLock);
+
+    // The previous callback may still be running on other threads
+    while (SDL_GetAtomicInt(&traceCallsInFlight) != 0) {
+        SDL_Delay(0);
+    }
+}
 
-#endif /* SDL_SHADERCROSS_DXC */
+/* Chrome Trace Writer
+ *
+ * Writes the JSON Array Format understood by chrome://tracing and Perfetto,
+ * one duration event per line. Both accept a trace that is missing its
+ * closing bracket, so a process that never closes its trace still leaves
+ * a usable one behind.
+ */
 
-static void *SDL_ShaderCross_INTERNAL_CompileUsingDXC(
-    const SDL_ShaderCross_HLSL_Info *info,
-    bool spirv,
-    size_t *size) // filled in with number of bytes of returned buffer
+struct SDL_ShaderCross_ChromeTrace
 {
-#ifdef SDL_SHADERCROSS_DXC
-    DxcBuffer source;
-    IDxcResult *dxcResult;
-    IDxcBlob *blob;
-    IDxcBlobUtf8 *errors;
-    size_t entryPointLength = SDL_utf8strlen(info->entrypoint) + 1;
-    wchar_t *entryPointUtf16 = NULL;
-    size_t includeDirLength = 0;
-    wchar_t *includeDirUtf16 = NULL;
-    wchar_t *nameUtf16 = NULL;
-    wchar_t **defineStringsUtf16 = NULL;
-    size_t numDefineStrings = 0;
-    HRESULT ret;
-
-    /* Non-static DxcInstance, since the functions we call on it are not thread-safe */
-    IDxcCompiler3 *dxcInstance = NULL;
-    IDxcUtils *utils = NULL;
-    IDxcIncludeHandler *includeHandler = NULL;
-
-    DxcCreateInstance(
-        &CLSID_DxcCompiler,
-        IID_IDxcCompiler3,
-        (void **)&dxcInstance);
-
-    DxcCreateInstance(
-        &CLSID_DxcUtils,
-        &IID_IDxcUtils,
-        (void **)(&utils));
+    SDL_IOStream *stream;
+    bool closeio;
+    SDL_Mutex *lock;
+    bool first;
+    bool failed;
+};
 
-    if (dxcInstance == NULL) {
-        SDL_SetError("%s", "Could not create DXC instance!");
+SDL_ShaderCross_ChromeTrace *SDL_ShaderCross_CreateChromeTrace(
+    SDL_IOStream *stream,
+    bool closeio)
+{
+    if (stream == NULL) {
+        SDL_InvalidParamError("stream");
         return NULL;
     }
 
-    if (utils == NULL) {
-        SDL_SetError("%s", "Could not create DXC utils instance!");
-        dxcInstance->lpVtbl->Release(dxcInstance);
+    SDL_ShaderCross_ChromeTrace *trace = SDL_calloc(1, sizeof(SDL_ShaderCross_ChromeTrace));
+    if (trace == NULL) {
+        if (closeio) {
+            SDL_CloseIO(stream);
+        }
         return NULL;
     }
-
-    utils->lpVtbl->CreateDefaultIncludeHandler(utils, &includeHandler);
-    if (includeHandler == NULL) {
-        SDL_SetError("%s", "Failed to create a default include handler!");
-        dxcInstance->lpVtbl->Release(dxcInstance);
-        utils->lpVtbl->Release(utils);
+    trace->lock = SDL_CreateMutex();
+    if (trace->lock == NULL || !SDL_IOprintf(stream, "[")) {
+        SDL_DestroyMutex(trace->lock);
+        SDL_free(trace);
+        if (closeio) {
+            SDL_CloseIO(stream);
+        }
         return NULL;
     }
 
-    entryPointUtf16 = (wchar_t *)SDL_iconv_string("WCHAR_T", "UTF-8", info->entrypoint, entryPointLength);
-    if (entryPointUtf16 == NULL) {
-        SDL_SetError("%s", "Failed to convert entrypoint to WCHAR_T!");
-        dxcInstance->lpVtbl->Release(dxcInstance);
-        utils->lpVtbl->Release(utils);
-        return NULL;
-    }
+    trace->stream = stream;
+    trace->closeio = closeio;
+    trace->first = true;
+    return trace;
+}
 
-    if (info->defines != NULL) {
-        for (Uint32 i = 0; i < MAX_DEFINES; i += 1) {
-            if (info->defines[i].name == NULL) {
-                break;
-            }
-            numDefineStrings += 1;
+static void SDL_ShaderCross_INTERNAL_WriteJSONString(SDL_IOStream *stream, const char *str)
+{
+    SDL_WriteU8(stream, '"');
+    for (const char *c = str; *c != '\0'; c += 1) {
+        if (*c == '"' || *c == '\\') {
+            SDL_WriteU8(stream, '\\');
+            SDL_WriteU8(stream, (Uint8)*c);
+        } else if ((unsigned char)*c < 0x20) {
+            SDL_IOprintf(stream, "\\u%04x", (unsigned char)*c);
+        } else {
+            SDL_WriteU8(stream, (Uint8)*c);
         }
     }
+    SDL_WriteU8(stream, '"');
+}
 
-    char defineString[MAX_DEFINE_STRING_LENGTH];
-    defineStringsUtf16 = SDL_malloc(sizeof(LPCWSTR) * numDefineStrings);
-    for (Uint32 i = 0; i < numDefineStrings; i += 1) {
-        if (info->defines[i].value == NULL) {
-            SDL_snprintf(defineString, MAX_DEFINE_STRING_LENGTH, "-D%s=%s", info->defines[i].name, "1");
-        } else {
-            SDL_snprintf(defineString, MAX_DEFINE_STRING_LENGTH, "-D%s=%s", info->defines[i].name, info->defines[i].value);
-        }
+void SDLCALL SDL_ShaderCross_WriteChromeTraceEvent(
+    void *userdata,
+    const SDL_ShaderCross_TraceEvent *event)
+{
+    SDL_ShaderCross_ChromeTrace *trace = (SDL_ShaderCross_ChromeTrace *)userdata;
+    if (trace == NULL || event == NULL) {
+        return;
+    }
 
-        defineStringsUtf16[i] = (wchar_t *)SDL_iconv_string("WCHAR_T", "UTF-8", defineString, MAX_DEFINE_STRING_LENGTH);
+    SDL_LockMutex(trace->lock);
+    SDL_IOStream *stream = trace->stream;
+    bool success = SDL_IOprintf(
+        stream,
+        "%s\n{\"name\":",
+        trace->first ? "" : ",") > 0;
+    SDL_ShaderCross_INTERNAL_WriteJSONString(stream, event->stage);
+    success = success && SDL_IOprintf(
+        stream,
+        ",\"cat\":\"shadercross\",\"ph\":\"%s\",\"ts\":%" SDL_PRIu64 ".%03u,\"pid\":1,\"tid\":%" SDL_PRIu64,
+        event->type == SDL_SHADERCROSS_TRACE_BEGIN ? "B" : "E",
+        event->timestamp_ns / 1000,
+        (unsigned int)(event->timestamp_ns % 1000),
+        (Uint64)event->thread_id) > 0;
+    if (event->type == SDL_SHADERCROSS_TRACE_BEGIN && event->name != NULL) {
+        SDL_IOprintf(stream, ",\"args\":{\"shader\":");
+        SDL_ShaderCross_INTERNAL_WriteJSONString(stream, event->name);
+        SDL_WriteU8(stream, '}');
+    }
+    success = success && SDL_WriteU8(stream, '}');
+    if (!success) {
+        trace->failed = true;
     }
+    trace->first = false;
+    SDL_UnlockMutex(trace->lock);
+}
 
-    LPCWSTR *args = SDL_malloc(sizeof(LPCWSTR) * (numDefineStrings + 10));
-    Uint32 argCount = 0;
+bool SDL_ShaderCross_CloseChromeTrace(SDL_ShaderCross_ChromeTrace *trace)
+{
+    if (trace == NULL) {
+        return SDL_InvalidParamError("trace");
+    }
 
-    for (Uint32 i = 0; i < numDefineStrings; i += 1) {
-        args[argCount++] = defineStringsUtf16[i];
+    bool success = !trace->failed && SDL_IOprintf(trace->stream, "\n]\n") > 0;
+    if (trace->closeio) {
+        success = SDL_CloseIO(trace->stream) && success;
+    } else {
+        success = SDL_FlushIO(trace->stream) && success;
     }
+    if (!success && trace->failed) {
+        SDL_SetError("%s", "Failed to write the trace!");
+    }
+
+    SDL_DestroyMutex(trace->lock);
+    SDL_free(trace);
+    return success;
+}
 
-    args[argCount++] = (LPCWSTR)L"-E";
-    args[argCount++] = (LPCWSTR)entryPointUtf16;
+/* Scratch Memory
+ *
+ * Temporaries that only live for part of a compile, such as the compiler
+ * arguments converted to wide strings, are bump allocated from a scratch
+ * arena for the thread and released all at once by rewinding the arena to
+ * a mark taken before they were allocated. The largest block a thread used
+ * is kept for its next compile, so a thread that compiles continuously soon
+ * stops allocating temporaries at all. A caller can also provide the memory
+ * with SDL_SHADERCROSS_PROP_SCRATCH_BUFFER_POINTER.
+ */
+
+#define SCRATCH_ALIGNMENT 16
+#define SCRATCH_BLOCK_SIZE (16 * 1024)
+#define SCRATCH_MAX_SPARE_SIZE (1024 * 1024)
+
+typedef struct ScratchBlock
+{
+    struct ScratchBlock *prev;
+    size_t size; /* Including this header */
+    size_t used; /* Including this header */
+    bool owned;  /* False for memory provided by the caller */
+} ScratchBlock;
 
-    if (info->include_dir != NULL) {
-        includeDirLength = SDL_utf8strlen(info->include_dir) + 1;
-        includeDirUtf16 = (wchar_t *)SDL_iconv_string("WCHAR_T", "UTF-8", info->include_dir, includeDirLength);
+#define SCRATCH_HEADER_SIZE ((sizeof(ScratchBlock) + SCRATCH_ALIGNMENT - 1) & ~(size_t)(SCRATCH_ALIGNMENT - 1))
 
-        if (includeDirUtf16 == NULL) {
-            SDL_SetError("%s", "Failed to convert include dir to WCHAR_T!");
-            dxcInstance->lpVtbl->Release(dxcInstance);
-            utils->lpVtbl->Release(utils);
-            SDL_free(entryPointUtf16);
-            return NULL;
+typedef struct ScratchArena
+{
+    ScratchBlock *current;
+    ScratchBlock *spare; /* Kept between compiles, to be reused by the next one */
+} ScratchArena;
+
+typedef struct ScratchMark
+{
+    ScratchBlock *block;
+    size_t used;
+} ScratchMark;
+
+static SDL_TLSID scratchArenaTLS;
+
+static void SDLCALL SDL_ShaderCross_INTERNAL_DestroyScratchArena(void *value)
+{
+    ScratchArena *arena = (ScratchArena *)value;
+    while (arena->current != NULL) {
+        ScratchBlock *block = arena->current;
+        arena->current = block->prev;
+        if (block->owned) {
+            SDL_free(block);
         }
-        args[2] = (LPCWSTR)L"-I";
-        args[3] = includeDirUtf16;
-        argCount += 2;
     }
+    SDL_free(arena->spare);
+    SDL_free(arena);
+}
 
-    source.Ptr = info->source;
-    source.Size = SDL_strlen(info->source) + 1;
-    source.Encoding = DXC_CP_ACP;
-
-    if (info->shader_stage == SDL_SHADERCROSS_SHADERSTAGE_VERTEX) {
-        args[argCount++] = (LPCWSTR)L"-T";
-        args[argCount++] = (LPCWSTR)L"vs_6_0";
-    } else if (info->shader_stage == SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT) {
-        args[argCount++] = (LPCWSTR)L"-T";
-        args[argCount++] = (LPCWSTR)L"ps_6_0";
-    } else { // compute
-        args[argCount++] = (LPCWSTR)L"-T";
-        args[argCount++] = (LPCWSTR)L"cs_6_0";
+static ScratchArena *SDL_ShaderCross_INTERNAL_GetScratchArena(void)
+{
+    ScratchArena *arena = (ScratchArena *)SDL_GetTLS(&scratchArenaTLS);
+    if (arena == NULL) {
+        arena = SDL_calloc(1, sizeof(ScratchArena));
+        if (arena == NULL) {
+            return NULL;
+        }
+        if (!SDL_SetTLS(&scratchArenaTLS, arena, SDL_ShaderCross_INTERNAL_DestroyScratchArena)) {
+            SDL_free(arena);
+            return NULL;
+        }
     }
+    return arena;
+}
 
-    if (spirv) {
-        args[argCount++] = (LPCWSTR)L"-spirv";
+// Saves where the thread's arena is up to in mark, to pass to SDL_ShaderCross_INTERNAL_EndScratch
+static void SDL_ShaderCross_INTERNAL_BeginScratch(
+    ScratchMark *mark,
+    SDL_PropertiesID props)
+{
+    ScratchArena *arena = SDL_ShaderCross_INTERNAL_GetScratchArena();
+    mark->block = (arena != NULL) ? arena->current : NULL;
+    mark->used = (mark->block != NULL) ? mark->block->used : 0;
+
+    void *buffer = SDL_GetPointerProperty(props, SDL_SHADERCROSS_PROP_SCRATCH_BUFFER_POINTER, NULL);
+    Sint64 size = SDL_GetNumberProperty(props, SDL_SHADERCROSS_PROP_SCRATCH_BUFFER_SIZE_NUMBER, 0);
+    if (arena == NULL || buffer == NULL || size <= 0) {
+        return;
     }
 
-    if (info->enable_debug) {
-        if (spirv) {
-            // https://github.com/microsoft/DirectXShaderCompiler/blob/main/docs/SPIR-V.rst#debugging
-            args[argCount++] = (LPCWSTR)L"-fspv-debug=vulkan-with-source";
-        } else {
-            // https://github.com/microsoft/DirectXShaderCompiler/blob/main/docs/SourceLevelDebuggingHLSL.rst#command-line-options
-            args[argCount++] = (LPCWSTR)L"-Zi";
-        }
+    // The block header goes at the start of the buffer, aligned like the allocations after it
+    uintptr_t address = ((uintptr_t)buffer + SCRATCH_ALIGNMENT - 1) & ~(uintptr_t)(SCRATCH_ALIGNMENT - 1);
+    size_t padding = (size_t)(address - (uintptr_t)buffer);
+    if ((Uint64)size <= padding + SCRATCH_HEADER_SIZE) {
+        return;
     }
 
-    if (info->name) {
-        nameUtf16 = (wchar_t *)SDL_iconv_string("WCHAR_T", "UTF-8", info->name, SDL_utf8strlen(info->name) + 1);
-        if (nameUtf16 != NULL) {
-            args[argCount++] = nameUtf16; // a bare string inserted into the arguments is treated as the source file name
+    // A nested compile with the same properties keeps allocating from the buffer the outer one pushed
+    for (ScratchBlock *block = arena->current; block != NULL; block = block->prev) {
+        if ((uintptr_t)block == address) {
+            return;
         }
     }
 
-#if defined(SDL_PLATFORM_XBOXONE) || defined(SDL_PLATFORM_XBOXSERIES)
-    args[argCount++] = L"-D__XBOX_DISABLE_PRECOMPILE=1";
-#endif
+    ScratchBlock *block = (ScratchBlock *)address;
+    block->prev = arena->current;
+    block->size = (size_t)size - padding;
+    block->used = SCRATCH_HEADER_SIZE;
+    block->owned = false;
+    arena->current = block;
+}
 
-    ret = dxcInstance->lpVtbl->Compile(
-        dxcInstance,
-        &source,
-        args,
-        argCount,
-        includeHandler,
-        IID_IDxcResult,
-        (void **)&dxcResult);
+// Frees everything allocated since the mark was taken
+static void SDL_ShaderCross_INTERNAL_EndScratch(const ScratchMark *mark)
+{
+    ScratchArena *arena = (ScratchArena *)SDL_GetTLS(&scratchArenaTLS);
+    if (arena == NULL) {
+        return;
+    }
 
-    SDL_free(entryPointUtf16);
-    if (includeDirUtf16 != NULL) {
-        SDL_free(includeDirUtf16);
+    while (arena->current != mark->block) {
+        ScratchBlock *block = arena->current;
+        arena->current = block->prev;
+        if (!block->owned) {
+            continue;
+        }
+        // Keep the largest block within reason, so the next compile can fit in it
+        if (block->size <= SCRATCH_MAX_SPARE_SIZE && (arena->spare == NULL || block->size > arena->spare->size)) {
+            SDL_free(arena->spare);
+            arena->spare = block;
+        } else {
+            SDL_free(block);
+        }
     }
-    if (nameUtf16 != NULL) {
-        SDL_free(nameUtf16);
+    if (arena->current != NULL) {
+        arena->current->used = mark->used;
     }
+}
 
-    if (ret < 0) {
-        SDL_SetError("IDxcShaderCompiler3::Compile failed: %X", ret);
-        dxcInstance->lpVtbl->Release(dxcInstance);
-        utils->lpVtbl->Release(utils);
-        return NULL;
-    } else if (dxcResult == NULL) {
-        SDL_SetError("%s", "HLSL compilation failed with no IDxcResult");
-        dxcInstance->lpVtbl->Release(dxcInstance);
-        utils->lpVtbl->Release(utils);
+// Allocates from the thread's arena, only valid until the enclosing SDL_ShaderCross_INTERNAL_EndScratch
+static void *SDL_ShaderCross_INTERNAL_AllocScratch(size_t size)
+{
+    ScratchArena *arena = SDL_ShaderCross_INTERNAL_GetScratchArena();
+    if (arena == NULL) {
         return NULL;
     }
 
-    ret = dxcResult->lpVtbl->GetOutput(dxcResult,
-                                       DXC_OUT_OBJECT,
-                                       IID_IDxcBlob,
-                                       (void **)&blob,
-                                       NULL);
-    if (ret < 0) {
-        // Compilation failed, display errors
-        dxcResult->lpVtbl->GetOutput(
-            dxcResult,
-            DXC_OUT_ERRORS,
-            IID_IDxcBlobUtf8,
-            (void **)&errors,
-            NULL);
-
-        if (errors != NULL && errors->lpVtbl->GetBufferSize(errors) != 0) {
-            SDL_SetError(
-            "HLSL compilation failed: %s",
-                (char *)errors->lpVtbl->GetBufferPointer(errors));
+    size = (size + SCRATCH_ALIGNMENT - 1) & ~(size_t)(SCRATCH_ALIGNMENT - 1);
+    ScratchBlock *block = arena->current;
+    if (block == NULL || block->size - block->used < size) {
+        if (arena->spare != NULL && arena->spare->size - SCRATCH_HEADER_SIZE >= size) {
+            block = arena->spare;
+            arena->spare = NULL;
         } else {
-            SDL_SetError("%s", "Compilation failed with unknown error");
+            // Blocks double in size, so a large compile only needs a few of them
+            size_t blockSize = (block != NULL) ? block->size * 2 : SCRATCH_BLOCK_SIZE;
+            blockSize = SDL_max(blockSize, SCRATCH_HEADER_SIZE + size);
+            block = SDL_malloc(blockSize);
+            if (block == NULL) {
+                return NULL;
+            }
+            block->size = blockSize;
+            block->owned = true;
         }
-
-        // teardown
-        dxcResult->lpVtbl->Release(dxcResult);
-        dxcInstance->lpVtbl->Release(dxcInstance);
-        utils->lpVtbl->Release(utils);
-        return NULL;
+        block->prev = arena->current;
+        block->used = SCRATCH_HEADER_SIZE;
+        arena->current = block;
     }
 
-    // If compilation succeeded, but there are errors, those are warnings
-    dxcResult->lpVtbl->GetOutput(
-        dxcResult,
-        DXC_OUT_ERRORS,
-        IID_IDxcBlobUtf8,
-        (void **)&errors,
-        NULL);
+    void *result = (Uint8 *)block + block->used;
+    block->used += size;
+    return result;
+}
 
-    if (errors != NULL && errors->lpVtbl->GetBufferSize(errors) != 0) {
-        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "HLSL compiled with warnings: %s",
-            (char *)errors->lpVtbl->GetBufferPointer(errors));
-    }
+/* Shader Models */
 
-    *size = blob->lpVtbl->GetBufferSize(blob);
-    void *buffer = SDL_malloc(*size);
-    SDL_memcpy(buffer, blob->lpVtbl->GetBufferPointer(blob), *size);
+// Returns the shader model to target for the given format, e.g. 62 for SM 6.2
+static Uint32 SDL_ShaderCross_INTERNAL_GetShaderModel(
+    SDL_PropertiesID props,
+    SDL_GPUShaderFormat format)
+{
+    Sint64 shaderModel = SDL_GetNumberProperty(props, SDL_SHADERCROSS_PROP_SHADER_MODEL_NUMBER, 0);
 
-    blob->lpVtbl->Release(blob);
-    dxcResult->lpVtbl->Release(dxcResult);
-    dxcInstance->lpVtbl->Release(dxcInstance);
-    utils->lpVtbl->Release(utils);
+    if (format == SDL_GPU_SHADERFORMAT_DXBC) {
+        // FXC tops out at Shader Model 5.1
+        if (shaderModel < 50 || shaderModel > DEFAULT_DXBC_SHADER_MODEL) {
+            return DEFAULT_DXBC_SHADER_MODEL;
+        }
+    } else if (shaderModel < DEFAULT_DXIL_SHADER_MODEL) {
+        return DEFAULT_DXIL_SHADER_MODEL;
+    }
+    return (Uint32)shaderModel;
+}
+
+#ifdef SDL_SHADERCROSS_DXC
+/* Defined with the DXC code below */
+static Uint32 SDL_ShaderCross_INTERNAL_GetDXCMaxShaderModel(void);
+#endif
 
-    for (Uint32 i = 0; i < numDefineStrings; i += 1) {
-        SDL_free(defineStringsUtf16[i]);
+/* Fails if SDL_SHADERCROSS_PROP_SHADER_MODEL_NUMBER is set to a shader model
+ * that can't be targeted for the given format, 0 meaning HLSL source.
+ * DXBC is clamped to what FXC supports instead, see GetShaderModel above.
+ */
+static bool SDL_ShaderCross_INTERNAL_CheckShaderModel(
+    SDL_PropertiesID props,
+    SDL_GPUShaderFormat format)
+{
+    Sint64 shaderModel = SDL_GetNumberProperty(props, SDL_SHADERCROSS_PROP_SHADER_MODEL_NUMBER, 0);
+    if (shaderModel == 0 || format == SDL_GPU_SHADERFORMAT_DXBC || format == SDL_GPU_SHADERFORMAT_MSL) {
+        return true;
     }
-    SDL_free(args);
 
-    return buffer;
-#else
-    SDL_SetError("%s", "Shadercross was not built with DXC support, cannot compile using DXC!");
-    return NULL;
-#endif /* SDL_SHADERCROSS_DXC */
+    Sint64 maxShaderModel = MAX_DXIL_SHADER_MODEL;
+#ifdef SDL_SHADERCROSS_DXC
+    // DXC compiles both, and only knows the shader models it was released with
+    if (format == SDL_GPU_SHADERFORMAT_DXIL || format == SDL_GPU_SHADERFORMAT_SPIRV) {
+        maxShaderModel = SDL_ShaderCross_INTERNAL_GetDXCMaxShaderModel();
+    }
+#endif
+    if (shaderModel < DEFAULT_DXIL_SHADER_MODEL || shaderModel > maxShaderModel) {
+        return SDL_SetError(
+            "Unsupported shader model %" SDL_PRIs64 ", must be between %d and %" SDL_PRIs64,
+            shaderModel,
+            DEFAULT_DXIL_SHADER_MODEL,
+            maxShaderModel);
+    }
+    return true;
 }
 
-void *SDL_ShaderCross_CompileDXILFromHLSL(
-    const SDL_ShaderCross_HLSL_Info *info,
-    size_t *size)
+static void SDL_ShaderCross_INTERNAL_GetShaderProfile(
+    char *profile,
+    size_t maxlen,
+    SDL_ShaderCross_ShaderStage shaderStage,
+    Uint32 shaderModel)
 {
-#if SDL_PLATFORM_GDK
-    return SDL_ShaderCross_INTERNAL_CompileUsingDXC(info, false, size);
-#else
-    // Roundtrip to SPIR-V to support things like Structured Buffers.
-    size_t spirvSize;
-    void *spirv = SDL_ShaderCross_CompileSPIRVFromHLSL(
-        info,
-        &spirvSize);
+    const char *prefix;
+    if (shaderStage == SDL_SHADERCROSS_SHADERSTAGE_VERTEX) {
+        prefix = "vs";
+    } else if (shaderStage == SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT) {
+        prefix = "ps";
+    } else { // compute
+        prefix = "cs";
+    }
+    SDL_snprintf(profile, maxlen, "%s_%u_%u", prefix, shaderModel / 10, shaderModel % 10);
+}
 
-    if (spirv == NULL) {
-        return NULL;
+// The caller may pass a source that is not NUL-terminated, see SDL_SHADERCROSS_PROP_HLSL_SOURCE_SIZE_NUMBER
+static size_t SDL_ShaderCross_INTERNAL_GetHLSLSourceSize(const SDL_ShaderCross_HLSL_Info *info)
+{
+    Sint64 sourceSize = SDL_GetNumberProperty(info->props, SDL_SHADERCROSS_PROP_HLSL_SOURCE_SIZE_NUMBER, 0);
+    if (sourceSize > 0) {
+        return (size_t)sourceSize;
     }
+    return SDL_strlen(info->source);
+}
 
-    SDL_ShaderCross_SPIRV_Info spirvInfo;
-    spirvInfo.bytecode = spirv;
-    spirvInfo.bytecode_size = spirvSize;
-    spirvInfo.entrypoint = info->entrypoint;
-    spirvInfo.shader_stage = info->shader_stage;
-    spirvInfo.enable_debug = info->enable_debug;
-    spirvInfo.name = info->name;
-    spirvInfo.props = 0;
+/* Defined with the SPIRV-Cross code below */
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_TranspileHLSLFromSPIRV(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    Uint32 shaderModel);
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_TranspileHLSLFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info);
 
-    void *translatedSource = SDL_ShaderCross_TranspileHLSLFromSPIRV(
-        &spirvInfo);
+/* SHA-256
+ *
+ * Used for disk cache keys, where a collision would hand back the wrong
+ * shader, so a weak hash won't do.
+ */
 
-    SDL_free(spirv);
-    if (translatedSource == NULL) {
-        return NULL;
+#define SHA256_DIGEST_SIZE 32
+
+typedef struct SHA256Context
+{
+    Uint32 state[8];
+    Uint64 length;
+    Uint8 buffer[64];
+    Uint32 bufferSize;
+} SHA256Context;
+
+static const Uint32 sha256RoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define SHA256_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void SDL_ShaderCross_INTERNAL_SHA256Transform(SHA256Context *ctx, const Uint8 *block)
+{
+    Uint32 w[64];
+    Uint32 s[8];
+
+    for (int i = 0; i < 16; i += 1) {
+        w[i] = ((Uint32)block[i * 4] << 24) |
+               ((Uint32)block[i * 4 + 1] << 16) |
+               ((Uint32)block[i * 4 + 2] << 8) |
+               ((Uint32)block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; i += 1) {
+        Uint32 s0 = SHA256_ROTR(w[i - 15], 7) ^ SHA256_ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        Uint32 s1 = SHA256_ROTR(w[i - 2], 17) ^ SHA256_ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
     }
 
-    SDL_ShaderCross_HLSL_Info translatedHlslInfo;
-    SDL_memcpy(&translatedHlslInfo, info, sizeof(SDL_ShaderCross_HLSL_Info));
-    translatedHlslInfo.source = translatedSource;
+    SDL_memcpy(s, ctx->state, sizeof(s));
+    for (int i = 0; i < 64; i += 1) {
+        Uint32 S1 = SHA256_ROTR(s[4], 6) ^ SHA256_ROTR(s[4], 11) ^ SHA256_ROTR(s[4], 25);
+        Uint32 ch = (s[4] & s[5]) ^ (~s[4] & s[6]);
+        Uint32 t1 = s[7] + S1 + ch + sha256RoundConstants[i] + w[i];
+        Uint32 S0 = SHA256_ROTR(s[0], 2) ^ SHA256_ROTR(s[0], 13) ^ SHA256_ROTR(s[0], 22);
+        Uint32 maj = (s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]);
+        Uint32 t2 = S0 + maj;
+        s[7] = s[6];
+        s[6] = s[5];
+        s[5] = s[4];
+        s[4] = s[3] + t1;
+        s[3] = s[2];
+        s[2] = s[1];
+        s[1] = s[0];
+        s[0] = t1 + t2;
+    }
+    for (int i = 0; i < 8; i += 1) {
+        ctx->state[i] += s[i];
+    }
+}
 
-    return SDL_ShaderCross_INTERNAL_CompileUsingDXC(
-        &translatedHlslInfo,
-        false,
-        size);
-#endif
+static void SDL_ShaderCross_INTERNAL_SHA256Init(SHA256Context *ctx)
+{
+    ctx->state[0] = 0x6a09e667;
+    ctx->state[1] = 0xbb67ae85;
+    ctx->state[2] = 0x3c6ef372;
+    ctx->state[3] = 0xa54ff53a;
+    ctx->state[4] = 0x510e527f;
+    ctx->state[5] = 0x9b05688c;
+    ctx->state[6] = 0x1f83d9ab;
+    ctx->state[7] = 0x5be0cd19;
+    ctx->length = 0;
+    ctx->bufferSize = 0;
 }
 
-void *SDL_ShaderCross_CompileSPIRVFromHLSL(
-    const SDL_ShaderCross_HLSL_Info *info,
-    size_t *size)
+static void SDL_ShaderCross_INTERNAL_SHA256Update(SHA256Context *ctx, const void *data, size_t size)
 {
-    return SDL_ShaderCross_INTERNAL_CompileUsingDXC(
-        info,
-        true,
-        size);
+    const Uint8 *bytes = (const Uint8 *)data;
+
+    ctx->length += size;
+    while (size > 0) {
+        Uint32 amount = (Uint32)SDL_min(size, sizeof(ctx->buffer) - ctx->bufferSize);
+        SDL_memcpy(ctx->buffer + ctx->bufferSize, bytes, amount);
+        ctx->bufferSize += amount;
+        bytes += amount;
+        size -= amount;
+
+        if (ctx->bufferSize == sizeof(ctx->buffer)) {
+            SDL_ShaderCross_INTERNAL_SHA256Transform(ctx, ctx->buffer);
+            ctx->bufferSize = 0;
+        }
+    }
 }
 
-/* DXBC via FXC */
+static void SDL_ShaderCross_INTERNAL_SHA256Final(SHA256Context *ctx, Uint8 digest[SHA256_DIGEST_SIZE])
+{
+    Uint64 bitLength = ctx->length * 8;
+    Uint8 padding[72];
+    Uint32 paddingSize = (ctx->bufferSize < 56 ? 56 : 120) - ctx->bufferSize;
+
+    SDL_zeroa(padding);
+    padding[0] = 0x80;
+    for (int i = 0; i < 8; i += 1) {
+        padding[paddingSize + i] = (Uint8)(bitLength >> (56 - i * 8));
+    }
+    SDL_ShaderCross_INTERNAL_SHA256Update(ctx, padding, paddingSize + 8);
 
-/* d3dcompiler Type Definitions */
-typedef void D3D_SHADER_MACRO; /* hack, unused */
-typedef void ID3DInclude;      /* hack, unused */
+    for (int i = 0; i < 8; i += 1) {
+        digest[i * 4] = (Uint8)(ctx->state[i] >> 24);
+        digest[i * 4 + 1] = (Uint8)(ctx->state[i] >> 16);
+        digest[i * 4 + 2] = (Uint8)(ctx->state[i] >> 8);
+        digest[i * 4 + 3] = (Uint8)(ctx->state[i]);
+    }
+}
 
-/* Dynamic Library / Linking */
-#ifdef D3DCOMPILER_DLL
-#undef D3DCOMPILER_DLL
-#endif
-#if defined(_WIN32)
-#define D3DCOMPILER_DLL "d3dcompiler_47.dll"
-#elif defined(__APPLE__)
-#define D3DCOMPILER_DLL "libvkd3d-utils.1.dylib"
-#else
-#define D3DCOMPILER_DLL "libvkd3d-utils.so.1"
-#endif
+static void SDL_ShaderCross_INTERNAL_SHA256Number(SHA256Context *ctx, Uint64 value)
+{
+    Uint8 bytes[8];
+    for (int i = 0; i < 8; i += 1) {
+        bytes[i] = (Uint8)(value >> (i * 8));
+    }
+    SDL_ShaderCross_INTERNAL_SHA256Update(ctx, bytes, sizeof(bytes));
+}
 
-/* __stdcall declaration, largely taken from vkd3d_windows.h */
-#ifndef _WIN32
-#ifdef __stdcall
-#undef __stdcall
-#endif
-#if defined(__x86_64__) || defined(__arm64__)
-#define __stdcall __attribute__((ms_abi))
-#else
-#if (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 2)) || defined(__APPLE__)
-#define __stdcall __attribute__((__stdcall__)) __attribute__((__force_align_arg_pointer__))
-#else
-#define __stdcall __attribute__((__stdcall__))
-#endif
-#endif
-#endif
+// Length-prefixed, so that adjacent strings can't run into each other and NULL differs from ""
+static void SDL_ShaderCross_INTERNAL_SHA256String(SHA256Context *ctx, const char *str)
+{
+    if (str == NULL) {
+        SDL_ShaderCross_INTERNAL_SHA256Number(ctx, ~(Uint64)0);
+        return;
+    }
+    size_t length = SDL_strlen(str);
+    SDL_ShaderCross_INTERNAL_SHA256Number(ctx, length);
+    SDL_ShaderCross_INTERNAL_SHA256Update(ctx, str, length);
+}
 
-/* ID3DBlob definition, used by both D3DCompiler and DXCompiler */
-typedef struct ID3DBlob ID3DBlob;
-typedef struct ID3DBlobVtbl
+/* API Capture
+ *
+ * While a capture is running, every public compile call that is not made
+ * from within another one is written to the capture stream with all of its
+ * inputs and how long it took, along with the contents of every file the
+ * compiles included, so that SDL_ShaderCross_ReplayCapture can run the same
+ * compiles again without the application or the files. Records are written
+ * as calls finish, each in one piece under captureLock. Calls note whether
+ * any of their compiles were served from a cache, since a replay never is.
+ *
+ * All numbers are little-endian. The header holds CAPTURE_MAGIC, the format
+ * version and the versions of the compilers the capture was taken with, and
+ * is followed by records, each starting with its CaptureRecord tag. Strings
+ * are a Uint32 length, or CAPTURE_NULL_STRING for NULL, followed by their
+ * bytes, and byte arrays are a Uint64 length followed by their bytes.
+ */
+
+#define CAPTURE_MAGIC "SDLSCCAP"
+#define CAPTURE_MAGIC_SIZE 8
+#define CAPTURE_VERSION 2
+#define CAPTURE_NULL_STRING 0xFFFFFFFF
+#define CAPTURE_INCLUDE_BUCKETS 256
+
+typedef enum CaptureRecord
 {
-    HRESULT(__stdcall *QueryInterface)
-    (ID3DBlob *This, REFIID riid, void **ppvObject);
-    ULONG(__stdcall *AddRef)
-    (ID3DBlob *This);
-    ULONG(__stdcall *Release)
-    (ID3DBlob *This);
-    LPVOID(__stdcall *GetBufferPointer)
-    (ID3DBlob *This);
-    SIZE_T(__stdcall *GetBufferSize)
-    (ID3DBlob *This);
-} ID3DBlobVtbl;
-struct ID3DBlob
+    CAPTURE_RECORD_INCLUDE = 1, /* A path and the contents it resolved to */
+    CAPTURE_RECORD_CALL         /* A finished call and its inputs */
+} CaptureRecord;
+
+// Stored in captures, so new functions can only be added at the end
+typedef enum CaptureFunction
 {
-    const ID3DBlobVtbl *lpVtbl;
+    CAPTURE_COMPILE_SPIRV_FROM_HLSL,
+    CAPTURE_COMPILE_DXIL_FROM_HLSL,
+    CAPTURE_COMPILE_DXBC_FROM_HLSL,
+    CAPTURE_COMPILE_PERMUTATIONS_FROM_HLSL,
+    CAPTURE_TRANSPILE_MSL_FROM_SPIRV,
+    CAPTURE_TRANSPILE_HLSL_FROM_SPIRV,
+    CAPTURE_COMPILE_DXBC_FROM_SPIRV,
+    CAPTURE_COMPILE_DXIL_FROM_SPIRV,
+    CAPTURE_COMPILE_MULTI_TARGET_FROM_SPIRV,
+    CAPTURE_REFLECT_GRAPHICS_SPIRV,
+    CAPTURE_REFLECT_COMPUTE_SPIRV,
+    CAPTURE_COMPILE_SHADER_FOR_DEVICE,
+    CAPTURE_COMPILE_HLSL_SHADER_FOR_DEVICE,
+    CAPTURE_FUNCTION_COUNT
+} CaptureFunction;
+
+static const char *captureFunctionNames[CAPTURE_FUNCTION_COUNT] = {
+    "SDL_ShaderCross_CompileSPIRVFromHLSL",
+    "SDL_ShaderCross_CompileDXILFromHLSL",
+    "SDL_ShaderCross_CompileDXBCFromHLSL",
+    "SDL_ShaderCross_CompilePermutationsFromHLSL",
+    "SDL_ShaderCross_TranspileMSLFromSPIRV",
+    "SDL_ShaderCross_TranspileHLSLFromSPIRV",
+    "SDL_ShaderCross_CompileDXBCFromSPIRV",
+    "SDL_ShaderCross_CompileDXILFromSPIRV",
+    "SDL_ShaderCross_CompileMultiTargetFromSPIRV",
+    "SDL_ShaderCross_ReflectGraphicsSPIRV",
+    "SDL_ShaderCross_ReflectComputeSPIRV",
+    "SDL_ShaderCross_CompileGraphicsShaderFromSPIRV",
+    "SDL_ShaderCross_CompileGraphicsShaderFromHLSL"
 };
-#define ID3D10Blob ID3DBlob
 
-/* D3DCompiler */
-static SDL_SharedObject *d3dcompiler_dll = NULL;
+typedef struct CaptureCall
+{
+    bool active; /* False if the call is not being captured */
+    CaptureFunction function;
+    Uint64 start;
+    const SDL_ShaderCross_HLSL_Info *hlslInfo; /* Set for calls taking HLSL */
+    const SDL_ShaderCross_SPIRV_Info *spirvInfo; /* Otherwise */
+    SDL_GPUShaderFormat format; /* The output format or targets, if the call takes one */
+    const SDL_ShaderCross_HLSL_Define *const *defineSets;
+    int numDefineSets;
+    SDL_AtomicInt cacheHit; /* Set by any thread working on the call */
+} CaptureCall;
+
+typedef struct CapturedInclude
+{
+    Uint8 digest[SHA256_DIGEST_SIZE];
+    struct CapturedInclude *next;
+} CapturedInclude;
 
-typedef HRESULT(__stdcall *pfn_D3DCompile)(
-    LPCVOID pSrcData,
-    SIZE_T SrcDataSize,
-    LPCSTR pSourceName,
-    const D3D_SHADER_MACRO *pDefines,
-    ID3DInclude *pInclude,
-    LPCSTR pEntrypoint,
-    LPCSTR pTarget,
-    UINT Flags1,
-    UINT Flags2,
-    ID3DBlob **ppCode,
-    ID3DBlob **ppErrorMsgs);
+static SDL_Mutex *captureLock = NULL;
+static SDL_IOStream *captureStream = NULL;
+static bool captureCloseIO = false;
+static bool captureFailed = false;
+static Uint64 captureStartTime = 0;
+static CapturedInclude *capturedIncludes[CAPTURE_INCLUDE_BUCKETS];
+static SDL_AtomicInt captureEnabled;
 
-static pfn_D3DCompile SDL_D3DCompile = NULL;
+static char *SDL_ShaderCross_INTERNAL_QueryCompilerVersions(void);
 
-// FIXME: includes and defines
-static ID3DBlob *SDL_ShaderCross_INTERNAL_CompileDXBC(
-    const char *hlslSource,
-    const char *entrypoint,
-    const char *shaderProfile,
-    bool enableDebug)
+static bool SDL_ShaderCross_INTERNAL_WriteCaptureString(SDL_IOStream *stream, const char *str)
 {
-    ID3DBlob *blob;
-    ID3DBlob *errorBlob;
-    HRESULT ret;
-
-    if (SDL_D3DCompile == NULL) {
-        SDL_SetError("%s", "Could not load D3DCompile!");
-        return NULL;
+    if (str == NULL) {
+        return SDL_WriteU32LE(stream, CAPTURE_NULL_STRING);
     }
+    size_t length = SDL_strlen(str);
+    return SDL_WriteU32LE(stream, (Uint32)length) &&
+        SDL_WriteIO(stream, str, length) == length;
+}
 
-    ret = SDL_D3DCompile(
-        hlslSource,
-        SDL_strlen(hlslSource),
-        NULL,
-        NULL,
-        NULL,
-        entrypoint,
-        shaderProfile,
-        enableDebug ? 1 : 0, // D3DCOMPILE_DEBUG = 1
-        0,
-        &blob,
-        &errorBlob);
+static bool SDL_ShaderCross_INTERNAL_WriteCaptureBytes(SDL_IOStream *stream, const void *data, size_t size)
+{
+    return SDL_WriteU64LE(stream, size) &&
+        SDL_WriteIO(stream, data, size) == size;
+}
 
-    if (ret < 0) {
-        if (errorBlob != NULL) {
-            SDL_SetError(
-                "HLSL compilation failed: %s",
-                (char *)errorBlob->lpVtbl->GetBufferPointer(errorBlob));
-        } else {
-            SDL_SetError("HLSL compilation failed for an unknown reason.");
-        }
-        return NULL;
+static bool SDL_ShaderCross_INTERNAL_WriteCaptureDefines(SDL_IOStream *stream, const SDL_ShaderCross_HLSL_Define *defines)
+{
+    Uint32 count = 0;
+    while (defines != NULL && defines[count].name != NULL) {
+        count += 1;
     }
 
-    return blob;
+    bool success = SDL_WriteU32LE(stream, count);
+    for (Uint32 i = 0; success && i < count; i += 1) {
+        success = SDL_ShaderCross_INTERNAL_WriteCaptureString(stream, defines[i].name) &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureString(stream, defines[i].value);
+    }
+    return success;
 }
 
-void *SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSL(
-    const SDL_ShaderCross_HLSL_Info *info,
-    bool enableRoundtrip,
-    size_t *size) // filled in with number of bytes of returned buffer
+typedef struct CapturePropertiesContext
 {
-    char *transpiledSource = NULL;
-
-    if (enableRoundtrip) {
-        // Need to roundtrip to SM 5.1
-        size_t spirv_size;
-        void *spirv = SDL_ShaderCross_CompileSPIRVFromHLSL(
-            info,
-            &spirv_size);
+    SDL_IOStream *stream; /* NULL while counting */
+    Uint32 count;
+    bool success;
+} CapturePropertiesContext;
+
+static void SDLCALL SDL_ShaderCross_INTERNAL_CaptureProperty(
+    void *userdata,
+    SDL_PropertiesID props,
+    const char *name)
+{
+    CapturePropertiesContext *context = (CapturePropertiesContext *)userdata;
+    SDL_PropertyType type = SDL_GetPropertyType(props, name);
 
-        if (spirv == NULL) {
-            return NULL;
-        }
+    // Pointers mean nothing in another process, the include directories are written separately
+    if (type == SDL_PROPERTY_TYPE_POINTER || type == SDL_PROPERTY_TYPE_INVALID) {
+        return;
+    }
+    if (context->stream == NULL) {
+        context->count += 1;
+        return;
+    }
+    if (!context->success) {
+        return;
+    }
 
-        SDL_ShaderCross_SPIRV_Info spirvInfo;
-        spirvInfo.bytecode = spirv;
-        spirvInfo.bytecode_size = spirv_size;
-        spirvInfo.entrypoint = info->entrypoint;
-        spirvInfo.shader_stage = info->shader_stage;
-        spirvInfo.enable_debug = info->enable_debug;
-        spirvInfo.name = info->name;
-        spirvInfo.props = 0;
+    SDL_IOStream *stream = context->stream;
+    bool success = SDL_ShaderCross_INTERNAL_WriteCaptureString(stream, name) &&
+        SDL_WriteU32LE(stream, (Uint32)type);
+    if (type == SDL_PROPERTY_TYPE_STRING) {
+        success = success && SDL_ShaderCross_INTERNAL_WriteCaptureString(stream, SDL_GetStringProperty(props, name, NULL));
+    } else if (type == SDL_PROPERTY_TYPE_NUMBER) {
+        success = success && SDL_WriteS64LE(stream, SDL_GetNumberProperty(props, name, 0));
+    } else if (type == SDL_PROPERTY_TYPE_FLOAT) {
+        union { float f; Uint32 u; } value;
+        value.f = SDL_GetFloatProperty(props, name, 0.0f);
+        success = success && SDL_WriteU32LE(stream, value.u);
+    } else {
+        success = success && SDL_WriteU8(stream, SDL_GetBooleanProperty(props, name, false));
+    }
+    context->success = success;
+}
 
-        transpiledSource = SDL_ShaderCross_TranspileHLSLFromSPIRV(
-            &spirvInfo);
-        SDL_free(spirv);
+static bool SDL_ShaderCross_INTERNAL_WriteCaptureProperties(SDL_IOStream *stream, SDL_PropertiesID props)
+{
+    CapturePropertiesContext context;
+    context.stream = NULL;
+    context.count = 0;
+    context.success = true;
 
-        if (transpiledSource == NULL) {
-            return NULL;
-        }
+    if (props != 0) {
+        SDL_EnumerateProperties(props, SDL_ShaderCross_INTERNAL_CaptureProperty, &context);
     }
-
-    const char *shaderProfile;
-    if (info->shader_stage == SDL_SHADERCROSS_SHADERSTAGE_VERTEX) {
-        shaderProfile = "vs_5_1";
-    } else if (info->shader_stage == SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT) {
-        shaderProfile = "ps_5_1";
-    } else { // compute
-        shaderProfile = "cs_5_1";
+    bool success = SDL_WriteU32LE(stream, context.count);
+    if (success && context.count > 0) {
+        context.stream = stream;
+        SDL_EnumerateProperties(props, SDL_ShaderCross_INTERNAL_CaptureProperty, &context);
+        success = context.success;
     }
 
-    ID3DBlob *blob = SDL_ShaderCross_INTERNAL_CompileDXBC(
-        transpiledSource != NULL ? transpiledSource : info->source,
-        info->entrypoint,
-        shaderProfile,
-        info->enable_debug);
+    const char **includeDirs = (const char **)SDL_GetPointerProperty(props, SDL_SHADERCROSS_PROP_HLSL_INCLUDE_DIRS_POINTER, NULL);
+    Uint32 numIncludeDirs = 0;
+    while (includeDirs != NULL && includeDirs[numIncludeDirs] != NULL) {
+        numIncludeDirs += 1;
+    }
+    success = success && SDL_WriteU32LE(stream, numIncludeDirs);
+    for (Uint32 i = 0; success && i < numIncludeDirs; i += 1) {
+        success = SDL_ShaderCross_INTERNAL_WriteCaptureString(stream, includeDirs[i]);
+    }
+    return success;
+}
 
-    if (blob == NULL) {
-        *size = 0;
-        return NULL;
+static bool SDL_ShaderCross_INTERNAL_WriteCaptureCall(
+    SDL_IOStream *stream,
+    const CaptureCall *call,
+    Uint64 end,
+    bool success,
+    Uint64 outputSize)
+{
+    bool written = SDL_WriteU32LE(stream, CAPTURE_RECORD_CALL) &&
+        SDL_WriteU32LE(stream, call->function) &&
+        SDL_WriteU64LE(stream, SDL_GetCurrentThreadID()) &&
+        SDL_WriteU64LE(stream, call->start > captureStartTime ? call->start - captureStartTime : 0) &&
+        SDL_WriteU64LE(stream, end - call->start) &&
+        SDL_WriteU8(stream, success) &&
+        SDL_WriteU8(stream, SDL_GetAtomicInt((SDL_AtomicInt *)&call->cacheHit) != 0) &&
+        SDL_WriteU64LE(stream, outputSize);
+
+    if (call->hlslInfo != NULL) {
+        const SDL_ShaderCross_HLSL_Info *info = call->hlslInfo;
+        written = written &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureString(stream, info->name) &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureString(stream, info->entrypoint) &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureString(stream, info->include_dir) &&
+            SDL_WriteU32LE(stream, (Uint32)info->shader_stage) &&
+            SDL_WriteU8(stream, info->enable_debug) &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureBytes(stream, info->source, SDL_ShaderCross_INTERNAL_GetHLSLSourceSize(info)) &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureDefines(stream, info->defines) &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureProperties(stream, info->props);
+    } else {
+        const SDL_ShaderCross_SPIRV_Info *info = call->spirvInfo;
+        written = written &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureString(stream, info->name) &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureString(stream, info->entrypoint) &&
+            SDL_WriteU32LE(stream, (Uint32)info->shader_stage) &&
+            SDL_WriteU8(stream, info->enable_debug) &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureBytes(stream, info->bytecode, info->bytecode_size) &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureProperties(stream, info->props);
     }
 
-    *size = blob->lpVtbl->GetBufferSize(blob);
-    void *buffer = SDL_malloc(*size);
-    SDL_memcpy(buffer, blob->lpVtbl->GetBufferPointer(blob), *size);
-    blob->lpVtbl->Release(blob);
+    written = written &&
+        SDL_WriteU32LE(stream, call->format) &&
+        SDL_WriteU32LE(stream, (Uint32)call->numDefineSets);
+    for (int i = 0; written && i < call->numDefineSets; i += 1) {
+        written = SDL_ShaderCross_INTERNAL_WriteCaptureDefines(stream, call->defineSets[i]);
+    }
+    return written;
+}
 
-    if (transpiledSource != NULL) {
-        SDL_free(transpiledSource);
+// Only the outermost call on a thread is captured, the calls it makes are part of it
+static void SDL_ShaderCross_INTERNAL_BeginCapture(CaptureCall *call, CaptureFunction function)
+{
+    SDL_zerop(call);
+    call->function = function;
+    if (!SDL_GetAtomicInt(&captureEnabled) || SDL_GetTLS(&captureCallTLS) != NULL) {
+        return;
     }
+    SDL_SetTLS(&captureCallTLS, call, NULL);
+    call->active = true;
+    call->start = SDL_GetTicksNS();
+}
 
-    return buffer;
+static void SDL_ShaderCross_INTERNAL_BeginHLSLCapture(
+    CaptureCall *call,
+    CaptureFunction function,
+    const SDL_ShaderCross_HLSL_Info *info)
+{
+    SDL_ShaderCross_INTERNAL_BeginCapture(call, function);
+    call->hlslInfo = info;
 }
 
-// Returns raw byte buffer
-void *SDL_ShaderCross_CompileDXBCFromHLSL(
-    const SDL_ShaderCross_HLSL_Info *info,
-    size_t *size) // filled in with number of bytes of returned buffer
+static void SDL_ShaderCross_INTERNAL_BeginSPIRVCapture(
+    CaptureCall *call,
+    CaptureFunction function,
+    const SDL_ShaderCross_SPIRV_Info *info)
 {
-    return SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSL(
-        info,
-        true,
-        size);
+    SDL_ShaderCross_INTERNAL_BeginCapture(call, function);
+    call->spirvInfo = info;
 }
 
-static void *SDL_ShaderCross_INTERNAL_CreateShaderFromHLSL(
-    SDL_GPUDevice *device,
-    const SDL_ShaderCross_HLSL_Info *info,
-    SDL_ShaderCross_GraphicsShaderMetadata *metadata)
+static void SDL_ShaderCross_INTERNAL_EndCapture(
+    CaptureCall *call,
+    bool success,
+    Uint64 outputSize)
 {
-    size_t bytecodeSize;
+    if (!call->active) {
+        return;
+    }
 
-    // We'll go through SPIRV-Cross for all of these to more easily obtain reflection metadata.
-    void *spirv = SDL_ShaderCross_CompileSPIRVFromHLSL(
-        info,
-        &bytecodeSize);
+    Uint64 end = SDL_GetTicksNS();
+    SDL_SetTLS(&captureCallTLS, NULL, NULL);
 
-    if (spirv == NULL) {
-        // Error output from DXC will have already been set
-        return NULL;
+    // Calls rejected for missing inputs can't be replayed
+    if (call->hlslInfo != NULL ? call->hlslInfo->source == NULL :
+        (call->spirvInfo == NULL || call->spirvInfo->bytecode == NULL)) {
+        return;
     }
 
-    SDL_ShaderCross_SPIRV_Info spirvInfo;
-    spirvInfo.bytecode = spirv;
-    spirvInfo.bytecode_size = bytecodeSize;
-    spirvInfo.entrypoint = info->entrypoint;
-    spirvInfo.shader_stage = info->shader_stage;
-    spirvInfo.enable_debug = info->enable_debug;
-    spirvInfo.name = info->name;
-    spirvInfo.props = 0;
+    // A failed call's error has to survive a failed write
+    char *error = success ? NULL : SDL_strdup(SDL_GetError());
 
-    void *result;
-    if (info->shader_stage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
-        result = SDL_ShaderCross_CompileComputePipelineFromSPIRV(
-            device,
-            &spirvInfo,
-            (void *)metadata);
-    } else {
-        result = SDL_ShaderCross_CompileGraphicsShaderFromSPIRV(
-            device,
-            &spirvInfo,
-            (void *)metadata);
+    SDL_LockMutex(captureLock);
+    if (captureStream != NULL && !captureFailed) {
+        if (!SDL_ShaderCross_INTERNAL_WriteCaptureCall(captureStream, call, end, success, outputSize)) {
+            captureFailed = true;
+            if (error != NULL) {
+                SDL_SetError("%s", error);
+            }
+        }
     }
-    SDL_free(spirv);
+    SDL_UnlockMutex(captureLock);
+    SDL_free(error);
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_EndBlobCapture(
+    CaptureCall *call,
+    SDL_ShaderCross_Blob *result)
+{
+    SDL_ShaderCross_INTERNAL_EndCapture(call, result != NULL, result != NULL ? result->size : 0);
     return result;
 }
 
-SDL_GPUShader *SDL_ShaderCross_CompileGraphicsShaderFromHLSL(
-    SDL_GPUDevice *device,
-    const SDL_ShaderCross_HLSL_Info *info,
-    SDL_ShaderCross_GraphicsShaderMetadata *metadata)
+static void SDL_ShaderCross_INTERNAL_CaptureCacheHit(void)
 {
-    return (SDL_GPUShader *)SDL_ShaderCross_INTERNAL_CreateShaderFromHLSL(
-        device,
-        info,
-        (void *)metadata);
+    CaptureCall *call = (CaptureCall *)SDL_GetTLS(&captureCallTLS);
+    if (call != NULL) {
+        SDL_SetAtomicInt(&call->cacheHit, 1);
+    }
 }
 
-SDL_GPUComputePipeline *SDL_ShaderCross_CompileComputePipelineFromHLSL(
-    SDL_GPUDevice *device,
-    const SDL_ShaderCross_HLSL_Info *info,
-    SDL_ShaderCross_ComputePipelineMetadata *metadata)
+static Uint64 SDL_ShaderCross_INTERNAL_GetPermutationsOutputSize(
+    const SDL_ShaderCross_PermutationResult *results,
+    int numResults,
+    bool *success)
 {
-    return (SDL_GPUComputePipeline *)SDL_ShaderCross_INTERNAL_CreateShaderFromHLSL(
-        device,
-        info,
-        (void *)metadata);
+    Uint64 outputSize = 0;
+    *success = results != NULL;
+    for (int i = 0; results != NULL && i < numResults; i += 1) {
+        if (results[i].blob != NULL) {
+            outputSize += results[i].blob->size;
+        } else {
+            *success = false;
+        }
+    }
+    return outputSize;
 }
 
-#include <spirv_cross_c.h>
+static Uint64 SDL_ShaderCross_INTERNAL_GetMultiTargetOutputSize(const SDL_ShaderCross_MultiTargetResult *results)
+{
+    const SDL_ShaderCross_Blob *blobs[] = { results->msl, results->hlsl, results->dxbc, results->dxil };
+    Uint64 outputSize = 0;
+    for (size_t i = 0; i < SDL_arraysize(blobs); i += 1) {
+        if (blobs[i] != NULL) {
+            outputSize += blobs[i]->size;
+        }
+    }
+    return outputSize;
+}
 
-#define SPVC_ERROR(func) \
-    SDL_SetError(#func " failed: %s", spvc_context_get_last_error_string(context))
+// Each distinct path and contents pair is written once, before the first call that used it finishes
+static void SDL_ShaderCross_INTERNAL_CaptureInclude(
+    const char *path,
+    const Uint8 contentDigest[SHA256_DIGEST_SIZE],
+    const void *data,
+    size_t size)
+{
+    if (!SDL_GetAtomicInt(&captureEnabled)) {
+        return;
+    }
 
-typedef struct SPIRVTranspileContext {
-    spvc_context context;
-    const char *translated_source;
-    const char *cleansed_entrypoint;
-} SPIRVTranspileContext;
+    SHA256Context ctx;
+    Uint8 digest[SHA256_DIGEST_SIZE];
+    SDL_ShaderCross_INTERNAL_SHA256Init(&ctx);
+    SDL_ShaderCross_INTERNAL_SHA256String(&ctx, path);
+    SDL_ShaderCross_INTERNAL_SHA256Update(&ctx, contentDigest, SHA256_DIGEST_SIZE);
+    SDL_ShaderCross_INTERNAL_SHA256Final(&ctx, digest);
+
+    SDL_LockMutex(captureLock);
+    if (captureStream != NULL && !captureFailed) {
+        CapturedInclude **bucket = &capturedIncludes[digest[0] % CAPTURE_INCLUDE_BUCKETS];
+        CapturedInclude *include = *bucket;
+        while (include != NULL && SDL_memcmp(include->digest, digest, SHA256_DIGEST_SIZE) != 0) {
+            include = include->next;
+        }
 
-static void SDL_ShaderCross_INTERNAL_DestroyTranspileContext(
-    SPIRVTranspileContext *context)
-{
-    spvc_context_destroy(context->context);
-    SDL_free(context);
+        if (include == NULL) {
+            // Without the entry the include is just written again next time
+            include = SDL_malloc(sizeof(CapturedInclude));
+            if (include != NULL) {
+                SDL_memcpy(include->digest, digest, SHA256_DIGEST_SIZE);
+                include->next = *bucket;
+                *bucket = include;
+            }
+            if (!SDL_WriteU32LE(captureStream, CAPTURE_RECORD_INCLUDE) ||
+                !SDL_ShaderCross_INTERNAL_WriteCaptureString(captureStream, path) ||
+                !SDL_ShaderCross_INTERNAL_WriteCaptureBytes(captureStream, data, size)) {
+                captureFailed = true;
+            }
+        }
+    }
+    SDL_UnlockMutex(captureLock);
 }
 
-static SPIRVTranspileContext *SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
-    spvc_backend backend,
-    unsigned shadermodel, // only used for HLSL
-    SDL_ShaderCross_ShaderStage shaderStage, // only used for MSL
-    const Uint8 *code,
-    size_t codeSize,
-    const char *entrypoint
-) {
-    spvc_result result;
-    spvc_context context = NULL;
-    spvc_parsed_ir ir = NULL;
-    spvc_compiler compiler = NULL;
-    spvc_compiler_options options = NULL;
-    SPIRVTranspileContext *transpileContext = NULL;
-    const char *translated_source;
-    const char *cleansed_entrypoint;
-
-    /* Create the SPIRV-Cross context */
-    result = spvc_context_create(&context);
-    if (result < 0) {
-        SDL_SetError("spvc_context_create failed: %X", result);
-        return NULL;
+bool SDL_ShaderCross_StartCapture(SDL_IOStream *stream, bool closeio)
+{
+    if (stream == NULL) {
+        return SDL_InvalidParamError("stream");
+    }
+    if (captureLock == NULL) {
+        if (closeio) {
+            SDL_CloseIO(stream);
+        }
+        return SDL_SetError("%s", "SDL_ShaderCross_Init has not been called!");
     }
 
-    /* Parse the SPIR-V into IR */
-    result = spvc_context_parse_spirv(context, (const SpvId *)code, codeSize / sizeof(SpvId), &ir);
-    if (result < 0) {
-        SPVC_ERROR(spvc_context_parse_spirv);
-        spvc_context_destroy(context);
-        return NULL;
+    char *versions = SDL_ShaderCross_INTERNAL_QueryCompilerVersions();
+    bool success;
+
+    SDL_LockMutex(captureLock);
+    if (captureStream != NULL) {
+        success = SDL_SetError("%s", "A capture is already running!");
+    } else {
+        success = SDL_WriteIO(stream, CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE) == CAPTURE_MAGIC_SIZE &&
+            SDL_WriteU32LE(stream, CAPTURE_VERSION) &&
+            SDL_ShaderCross_INTERNAL_WriteCaptureString(stream, versions);
+    }
+    if (success) {
+        captureStream = stream;
+        captureCloseIO = closeio;
+        captureFailed = false;
+        captureStartTime = SDL_GetTicksNS();
+        SDL_SetAtomicInt(&captureEnabled, 1);
     }
+    SDL_UnlockMutex(captureLock);
 
-    /* Create the cross-compiler */
-    result = spvc_context_create_compiler(context, backend, ir, SPVC_CAPTURE_MODE_TAKE_OWNERSHIP, &compiler);
-    if (result < 0) {
-        SPVC_ERROR(spvc_context_create_compiler);
-        spvc_context_destroy(context);
-        return NULL;
+    SDL_free(versions);
+    if (!success && closeio) {
+        SDL_CloseIO(stream);
     }
+    return success;
+}
 
-    /* Set up the cross-compiler options */
-    result = spvc_compiler_create_compiler_options(compiler, &options);
-    if (result < 0) {
-        SPVC_ERROR(spvc_compiler_create_compiler_options);
-        spvc_context_destroy(context);
-        return NULL;
+bool SDL_ShaderCross_StopCapture(void)
+{
+    if (captureLock == NULL) {
+        return SDL_SetError("%s", "No capture is running!");
     }
 
-    if (backend == SPVC_BACKEND_HLSL) {
-        spvc_compiler_options_set_uint(options, SPVC_COMPILER_OPTION_HLSL_SHADER_MODEL, shadermodel);
-        spvc_compiler_options_set_uint(options, SPVC_COMPILER_OPTION_HLSL_NONWRITABLE_UAV_TEXTURE_AS_SRV, 1);
-        spvc_compiler_options_set_uint(options, SPVC_COMPILER_OPTION_HLSL_FLATTEN_MATRIX_VERTEX_INPUT_SEMANTICS, 1);
-        spvc_compiler_options_set_bool(options, SPVC_COMPILER_OPTION_HLSL_USE_ENTRY_POINT_NAME, true);
+    // Calls still running when the capture stops are dropped
+    SDL_LockMutex(captureLock);
+    SDL_IOStream *stream = captureStream;
+    bool closeio = captureCloseIO;
+    bool failed = captureFailed;
+    captureStream = NULL;
+    SDL_SetAtomicInt(&captureEnabled, 0);
+    for (int i = 0; i < CAPTURE_INCLUDE_BUCKETS; i += 1) {
+        while (capturedIncludes[i] != NULL) {
+            CapturedInclude *next = capturedIncludes[i]->next;
+            SDL_free(capturedIncludes[i]);
+            capturedIncludes[i] = next;
+        }
     }
+    SDL_UnlockMutex(captureLock);
 
-    SpvExecutionModel executionModel;
-    if (shaderStage == SDL_SHADERCROSS_SHADERSTAGE_VERTEX) {
-        executionModel = SpvExecutionModelVertex;
-    } else if (shaderStage == SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT) {
-        executionModel = SpvExecutionModelFragment;
-    } else { // compute
-        executionModel = SpvExecutionModelKernel;
+    if (stream == NULL) {
+        return SDL_SetError("%s", "No capture is running!");
     }
 
-    // MSL doesn't have descriptor sets, so we have to set up index remapping
-    if (backend == SPVC_BACKEND_MSL && shaderStage != SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
-        spvc_resources resources;
-        spvc_reflected_resource *reflected_resources;
-        size_t num_texture_samplers;
-        size_t num_storage_textures;
-        size_t num_storage_buffers;
-        size_t num_uniform_buffers;
-        size_t num_separate_samplers = 0;
-        size_t num_separate_images = 0;
-        spvc_msl_resource_binding binding;
-        unsigned int num_textures = 0;
-        unsigned int num_buffers = 0;
+    bool success = !failed;
+    if (closeio) {
+        success = SDL_CloseIO(stream) && success;
+    } else {
+        success = SDL_FlushIO(stream) && success;
+    }
+    if (!success && failed) {
+        SDL_SetError("%s", "Failed to write the capture!");
+    }
+    return success;
+}
 
-        result = spvc_compiler_create_shader_resources(compiler, &resources);
-        if (result < 0) {
-            SPVC_ERROR(spvc_compiler_create_shader_resources);
-            spvc_context_destroy(context);
-            return NULL;
-        }
+/* Include Cache
+ *
+ * Serves HLSL #include requests from memory. Files loaded from disk are
+ * revalidated against their size and modification time on every lookup,
+ * while virtual files registered by the application are served as-is.
+ *
+ * Entries are never modified once they are in the table, a changed file is
+ * stored as a new entry replacing the old one. Entries are reference counted
+ * so that the lock only needs to be held to look them up and swap them in,
+ * loading and hashing the file happens without it.
+ */
+
+#define INCLUDE_CACHE_BUCKETS 256
+
+typedef struct IncludeCacheEntry
+{
+    char *path;
+    Uint32 hash;
+    void *data;
+    size_t size;
+    SDL_Time modifyTime;
+    Uint8 digest[SHA256_DIGEST_SIZE]; /* Of the contents, computed once when the entry is created */
+    bool isVirtual;
+    SDL_AtomicInt refcount; /* One for the table, one for every thread using the entry */
+    struct IncludeCacheEntry *next;
+} IncludeCacheEntry;
+
+static SDL_Mutex *includeCacheLock = NULL;
+static IncludeCacheEntry *includeCache[INCLUDE_CACHE_BUCKETS];
+
+// Converts backslashes and strips "./" segments so that DXC's view of a path matches the application's.
+static char *SDL_ShaderCross_INTERNAL_NormalizeIncludePath(const char *path)
+{
+    char *result = SDL_malloc(SDL_strlen(path) + 1);
+    char *dst = result;
 
-        // Combined texture-samplers
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_SAMPLED_IMAGE,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_texture_samplers);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return NULL;
-        }
+    if (result == NULL) {
+        return NULL;
+    }
 
-        // If source is HLSL, we might have separate images and samplers
-        if (num_texture_samplers == 0) {
-            result = spvc_resources_get_resource_list_for_type(
-                resources,
-                SPVC_RESOURCE_TYPE_SEPARATE_SAMPLERS,
-                (const spvc_reflected_resource **)&reflected_resources,
-                &num_separate_samplers);
-            if (result < 0) {
-                SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-                spvc_context_destroy(context);
-                return false;
-            }
-            num_texture_samplers = num_separate_samplers;
+    while (*path != '\0') {
+        char c = (*path == '\\') ? '/' : *path;
+        bool segmentStart = (dst == result || dst[-1] == '/');
+
+        if (segmentStart && c == '/' && dst != result) {
+            path += 1; // collapse repeated separators
+        } else if (segmentStart && c == '.' && (path[1] == '/' || path[1] == '\\')) {
+            path += 2; // skip "./"
+        } else {
+            *dst++ = c;
+            path += 1;
         }
+    }
+    *dst = '\0';
 
-        for (size_t i = 0; i < num_texture_samplers; i += 1) {
-            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    return result;
+}
 
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
-            if (!(descriptor_set_index == 0 || descriptor_set_index == 2)) {
-                SDL_SetError("%s", "Descriptor set index for graphics texture-sampler must be 0 or 2!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+static IncludeCacheEntry **SDL_ShaderCross_INTERNAL_FindIncludeCacheEntry(const char *path, Uint32 hash)
+{
+    IncludeCacheEntry **entry = &includeCache[hash % INCLUDE_CACHE_BUCKETS];
+    while (*entry != NULL) {
+        if ((*entry)->hash == hash && SDL_strcmp((*entry)->path, path) == 0) {
+            break;
+        }
+        entry = &(*entry)->next;
+    }
+    return entry;
+}
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+// Takes ownership of data, even on failure
+static IncludeCacheEntry *SDL_ShaderCross_INTERNAL_CreateIncludeCacheEntry(
+    const char *path,
+    Uint32 hash,
+    void *data,
+    size_t size,
+    SDL_Time modifyTime,
+    bool isVirtual)
+{
+    IncludeCacheEntry *entry = SDL_calloc(1, sizeof(IncludeCacheEntry));
+    if (entry == NULL) {
+        SDL_free(data);
+        return NULL;
+    }
+    entry->path = SDL_strdup(path);
+    if (entry->path == NULL) {
+        SDL_free(data);
+        SDL_free(entry);
+        return NULL;
+    }
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_texture = binding_index;
-            binding.msl_sampler = binding_index;
-            result = spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
-            }
-            num_textures += 1;
-        }
-        num_textures += num_texture_samplers;
+    SHA256Context ctx;
+    SDL_ShaderCross_INTERNAL_SHA256Init(&ctx);
+    SDL_ShaderCross_INTERNAL_SHA256Update(&ctx, data, size);
+    SDL_ShaderCross_INTERNAL_SHA256Final(&ctx, entry->digest);
+
+    entry->hash = hash;
+    entry->data = data;
+    entry->size = size;
+    entry->modifyTime = modifyTime;
+    entry->isVirtual = isVirtual;
+    SDL_SetAtomicInt(&entry->refcount, 1);
+    return entry;
+}
 
-        // Storage textures
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_STORAGE_IMAGE,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_storage_textures);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return NULL;
-        }
+static void SDL_ShaderCross_INTERNAL_ReleaseIncludeCacheEntry(IncludeCacheEntry *entry)
+{
+    if (entry != NULL && SDL_AtomicDecRef(&entry->refcount)) {
+        SDL_free(entry->path);
+        SDL_free(entry->data);
+        SDL_free(entry);
+    }
+}
 
-        for (size_t i = 0; i < num_storage_textures; i += 1) {
-            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+/* Puts entry in the table, replacing any entry for the same path, and gives the table its own reference.
+ * A file from disk never replaces a virtual file. Must be called with the cache locked.
+ */
+static void SDL_ShaderCross_INTERNAL_StoreIncludeCacheEntry(IncludeCacheEntry *entry)
+{
+    IncludeCacheEntry **slot = SDL_ShaderCross_INTERNAL_FindIncludeCacheEntry(entry->path, entry->hash);
+    IncludeCacheEntry *previous = *slot;
 
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
-            if (!(descriptor_set_index == 0 || descriptor_set_index == 2)) {
-                SDL_SetError("%s", "Descriptor set index for graphics storage texture must be 0 or 2!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    if (previous != NULL && previous->isVirtual && !entry->isVirtual) {
+        return;
+    }
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+    SDL_AtomicIncRef(&entry->refcount);
+    entry->next = (previous != NULL) ? previous->next : NULL;
+    *slot = entry;
+    SDL_ShaderCross_INTERNAL_ReleaseIncludeCacheEntry(previous);
+}
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_texture = num_textures + binding_index;
-            spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
+static void SDL_ShaderCross_INTERNAL_ClearIncludeCache(bool keepVirtualFiles)
+{
+    for (Uint32 i = 0; i < INCLUDE_CACHE_BUCKETS; i += 1) {
+        IncludeCacheEntry **entry = &includeCache[i];
+        while (*entry != NULL) {
+            IncludeCacheEntry *current = *entry;
+            if (keepVirtualFiles && current->isVirtual) {
+                entry = &current->next;
+            } else {
+                *entry = current->next;
+                SDL_ShaderCross_INTERNAL_ReleaseIncludeCacheEntry(current);
             }
         }
-        num_textures += num_storage_textures;
-
-        // If source is HLSL, storage images might be marked as separate images
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_SEPARATE_IMAGE,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_separate_images);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return NULL;
-        }
+    }
+}
 
-        // We only want to iterate the images that don't have an associated sampler
-        for (size_t i = num_separate_samplers; i < num_separate_images; i += 1) {
-            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+/* Include dependencies
+ *
+ * While a compile that may be stored in the disk cache is running, every
+ * include it resolves is recorded for the compiling thread, so that a later
+ * hit can be checked against the current contents of those files.
+ */
+typedef struct IncludeDependency
+{
+    char *path;
+    Uint8 digest[SHA256_DIGEST_SIZE];
+    struct IncludeDependency *next;
+} IncludeDependency;
 
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
-            if (!(descriptor_set_index == 0 || descriptor_set_index == 2)) {
-                SDL_SetError("%s", "Descriptor set index for graphics storage texture must be 0 or 2!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+typedef struct IncludeDependencyList
+{
+    IncludeDependency *first;
+    Uint32 count;
+    bool incomplete; /* A dependency could not be recorded, the result must not be cached */
+} IncludeDependencyList;
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+static SDL_TLSID includeDependenciesTLS;
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_texture = num_textures + binding_index;
-            spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
-            }
+static void SDL_ShaderCross_INTERNAL_AddIncludeDependency(
+    IncludeDependencyList *dependencies,
+    const char *path,
+    const Uint8 digest[SHA256_DIGEST_SIZE])
+{
+    for (IncludeDependency *dependency = dependencies->first; dependency != NULL; dependency = dependency->next) {
+        if (SDL_strcmp(dependency->path, path) == 0) {
+            return;
         }
-        num_textures += (num_separate_images - num_separate_samplers);
+    }
 
-        // Storage buffers
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_STORAGE_BUFFER,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_storage_buffers);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return NULL;
-        }
+    IncludeDependency *dependency = SDL_malloc(sizeof(IncludeDependency));
+    if (dependency == NULL) {
+        dependencies->incomplete = true;
+        return;
+    }
+    dependency->path = SDL_strdup(path);
+    if (dependency->path == NULL) {
+        SDL_free(dependency);
+        dependencies->incomplete = true;
+        return;
+    }
 
-        for (size_t i = 0; i < num_storage_buffers; i += 1) {
-            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    SDL_memcpy(dependency->digest, digest, SHA256_DIGEST_SIZE);
+    dependency->next = dependencies->first;
+    dependencies->first = dependency;
+    dependencies->count += 1;
+}
 
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
-            if (!(descriptor_set_index == 0 || descriptor_set_index == 2)) {
-                SDL_SetError("%s", "Descriptor set index for graphics storage buffer must be 0 or 2!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+static void SDL_ShaderCross_INTERNAL_RecordIncludeDependency(
+    const char *path,
+    const Uint8 digest[SHA256_DIGEST_SIZE])
+{
+    IncludeDependencyList *dependencies = (IncludeDependencyList *)SDL_GetTLS(&includeDependenciesTLS);
+    if (dependencies != NULL) {
+        SDL_ShaderCross_INTERNAL_AddIncludeDependency(dependencies, path, digest);
+    }
+}
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+static void SDL_ShaderCross_INTERNAL_DestroyIncludeDependencies(IncludeDependencyList *dependencies)
+{
+    while (dependencies->first != NULL) {
+        IncludeDependency *next = dependencies->first->next;
+        SDL_free(dependencies->first->path);
+        SDL_free(dependencies->first);
+        dependencies->first = next;
+    }
+    dependencies->count = 0;
+}
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_buffer = binding_index;
-            spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
-            }
+// Adds the includes of a nested compile to the list of the compile around it, if any
+static void SDL_ShaderCross_INTERNAL_MergeIncludeDependencies(
+    IncludeDependencyList *dependencies,
+    const IncludeDependencyList *nested)
+{
+    if (dependencies == NULL) {
+        return;
+    }
+    for (IncludeDependency *dependency = nested->first; dependency != NULL; dependency = dependency->next) {
+        SDL_ShaderCross_INTERNAL_AddIncludeDependency(dependencies, dependency->path, dependency->digest);
+    }
+    if (nested->incomplete) {
+        dependencies->incomplete = true;
+    }
+}
+
+/* Returns a reference to the current entry for a normalized path, loading the file from disk
+ * if it is missing or changed, or NULL if it doesn't exist. Release it when done.
+ */
+static IncludeCacheEntry *SDL_ShaderCross_INTERNAL_AcquireIncludeCacheEntry(const char *path)
+{
+    Uint32 hash = SDL_murmur3_32(path, SDL_strlen(path), 0);
+    IncludeCacheEntry *entry = NULL;
+    SDL_PathInfo pathInfo;
+
+    // Without SDL_ShaderCross_Init there is nothing to cache into, the entry is only used once
+    if (includeCacheLock != NULL) {
+        SDL_LockMutex(includeCacheLock);
+        entry = *SDL_ShaderCross_INTERNAL_FindIncludeCacheEntry(path, hash);
+        if (entry != NULL) {
+            SDL_AtomicIncRef(&entry->refcount);
         }
-        num_buffers += num_storage_buffers;
+        SDL_UnlockMutex(includeCacheLock);
+    }
 
-        // Uniform buffers
-        result = spvc_resources_get_resource_list_for_type(
+    if (entry != NULL && entry->isVirtual) {
+        return entry;
+    }
+
+    if (!SDL_GetPathInfo(path, &pathInfo) || pathInfo.type != SDL_PATHTYPE_FILE) {
+        SDL_ShaderCross_INTERNAL_ReleaseIncludeCacheEntry(entry);
+        return NULL;
+    }
+    if (entry != NULL && entry->size == pathInfo.size && entry->modifyTime == pathInfo.modify_time) {
+        return entry;
+    }
+    SDL_ShaderCross_INTERNAL_ReleaseIncludeCacheEntry(entry);
+
+    size_t size;
+    void *data = SDL_LoadFile(path, &size);
+    if (data == NULL) {
+        return NULL;
+    }
+    entry = SDL_ShaderCross_INTERNAL_CreateIncludeCacheEntry(path, hash, data, size, pathInfo.modify_time, false);
+    if (entry != NULL && includeCacheLock != NULL) {
+        SDL_LockMutex(includeCacheLock);
+        SDL_ShaderCross_INTERNAL_StoreIncludeCacheEntry(entry);
+        SDL_UnlockMutex(includeCacheLock);
+    }
+    return entry;
+}
+
+/* Looks up an include, loading it from disk if needed, and passes its contents to the callback.
+ * The contents are only valid for the duration of the callback.
+ */
+static bool SDL_ShaderCross_INTERNAL_LoadInclude(
+    const char *path,
+    bool (*callback)(void *userdata, const void *data, size_t size),
+    void *userdata)
+{
+    char *normalizedPath = SDL_ShaderCross_INTERNAL_NormalizeIncludePath(path);
+    bool result = false;
+
+    if (normalizedPath == NULL) {
+        return false;
+    }
+
+    IncludeCacheEntry *entry = SDL_ShaderCross_INTERNAL_AcquireIncludeCacheEntry(normalizedPath);
+    if (entry != NULL) {
+        SDL_ShaderCross_INTERNAL_RecordIncludeDependency(normalizedPath, entry->digest);
+        SDL_ShaderCross_INTERNAL_CaptureInclude(normalizedPath, entry->digest, entry->data, entry->size);
+        result = callback(userdata, entry->data, entry->size);
+        SDL_ShaderCross_INTERNAL_ReleaseIncludeCacheEntry(entry);
+    }
+
+    SDL_free(normalizedPath);
+    return result;
+}
+
+bool SDL_ShaderCross_RegisterVirtualFile(
+    const char *path,
+    const void *data,
+    size_t size)
+{
+    if (path == NULL) {
+        return SDL_InvalidParamError("path");
+    }
+    if (data == NULL && size > 0) {
+        return SDL_InvalidParamError("data");
+    }
+    if (includeCacheLock == NULL) {
+        return SDL_SetError("%s", "SDL_ShaderCross_Init must be called before registering virtual files!");
+    }
+
+    char *normalizedPath = SDL_ShaderCross_INTERNAL_NormalizeIncludePath(path);
+    void *copy = SDL_malloc(size > 0 ? size : 1);
+    if (normalizedPath == NULL || copy == NULL) {
+        SDL_free(normalizedPath);
+        SDL_free(copy);
+        return false;
+    }
+    SDL_memcpy(copy, data, size);
+
+    Uint32 hash = SDL_murmur3_32(normalizedPath, SDL_strlen(normalizedPath), 0);
+
+    IncludeCacheEntry *entry = SDL_ShaderCross_INTERNAL_CreateIncludeCacheEntry(
+        normalizedPath,
+        hash,
+        copy,
+        size,
+        0,
+        true);
+    SDL_free(normalizedPath);
+    if (entry == NULL) {
+        return false;
+    }
+
+    SDL_LockMutex(includeCacheLock);
+    SDL_ShaderCross_INTERNAL_StoreIncludeCacheEntry(entry);
+    SDL_UnlockMutex(includeCacheLock);
+
+    SDL_ShaderCross_INTERNAL_ReleaseIncludeCacheEntry(entry);
+    return true;
+}
+
+bool SDL_ShaderCross_UnregisterVirtualFile(
+    const char *path)
+{
+    if (path == NULL) {
+        return SDL_InvalidParamError("path");
+    }
+    if (includeCacheLock == NULL) {
+        return SDL_SetError("%s", "SDL_ShaderCross_Init must be called before unregistering virtual files!");
+    }
+
+    char *normalizedPath = SDL_ShaderCross_INTERNAL_NormalizeIncludePath(path);
+    if (normalizedPath == NULL) {
+        return false;
+    }
+
+    Uint32 hash = SDL_murmur3_32(normalizedPath, SDL_strlen(normalizedPath), 0);
+    bool found = false;
+
+    SDL_LockMutex(includeCacheLock);
+    IncludeCacheEntry **slot = SDL_ShaderCross_INTERNAL_FindIncludeCacheEntry(normalizedPath, hash);
+    IncludeCacheEntry *entry = *slot;
+    if (entry != NULL && entry->isVirtual) {
+        *slot = entry->next;
+        SDL_ShaderCross_INTERNAL_ReleaseIncludeCacheEntry(entry);
+        found = true;
+    }
+    SDL_UnlockMutex(includeCacheLock);
+
+    SDL_free(normalizedPath);
+    if (!found) {
+        return SDL_SetError("No virtual file registered at %s", path);
+    }
+    return true;
+}
+
+void SDL_ShaderCross_ClearIncludeCache(void)
+{
+    if (includeCacheLock == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(includeCacheLock);
+    SDL_ShaderCross_INTERNAL_ClearIncludeCache(true);
+    SDL_UnlockMutex(includeCacheLock);
+}
+
+/* Result Cache
+ *
+ * Compile results are keyed on a SHA-256 of everything that can affect the
+ * output: the input bytes, every option and the versions of the compilers
+ * involved. Results for HLSL inputs also remember the includes that were
+ * resolved along with a hash of their contents, and are only reused if
+ * those still match.
+ *
+ * There are two layers, both optional: a bounded in-memory LRU cache for
+ * runtime compiles, checked first, and a persistent cache on disk.
+ */
+
+static SDL_Mutex *cacheLock = NULL;
+static char *cacheCompilerVersions = NULL;
+
+typedef struct CacheRequest
+{
+    bool active; /* False if includes are not being recorded */
+    bool store;  /* False if the result is not to be cached */
+    bool memory; /* True if the memory cache is used */
+    Uint8 digest[SHA256_DIGEST_SIZE];
+    const char *directory;
+    char *path; /* NULL if the disk cache is not used */
+    IncludeDependencyList dependencies;
+    IncludeDependencyList *outerDependencies; /* Restored when a nested compile ends */
+    CompileScope outerScope; /* Likewise */
+    SDL_ShaderCross_DependencyCallback dependencyCallback;
+    void *dependencyUserdata;
+} CacheRequest;
+
+static void SDL_ShaderCross_INTERNAL_ReleaseMemory(void *owner)
+{
+    SDL_free(owner);
+}
+
+static void SDL_ShaderCross_INTERNAL_ReportIncludeDependencies(
+    const CacheRequest *request,
+    const IncludeDependencyList *dependencies)
+{
+    if (request->dependencyCallback == NULL) {
+        return;
+    }
+    for (IncludeDependency *dependency = dependencies->first; dependency != NULL; dependency = dependency->next) {
+        request->dependencyCallback(request->dependencyUserdata, dependency->path);
+    }
+}
+
+/* An include that was changed or removed since the result was cached makes it stale.
+ * Dependency paths are stored normalized. Unless the file's size or modification time
+ * changed, this compares against the digest already stored in the include cache.
+ */
+static bool SDL_ShaderCross_INTERNAL_IsIncludeUnchanged(
+    const char *path,
+    const Uint8 digest[SHA256_DIGEST_SIZE])
+{
+    IncludeCacheEntry *entry = SDL_ShaderCross_INTERNAL_AcquireIncludeCacheEntry(path);
+    if (entry == NULL) {
+        return false;
+    }
+
+    bool unchanged = SDL_memcmp(entry->digest, digest, SHA256_DIGEST_SIZE) == 0;
+    if (unchanged) {
+        SDL_ShaderCross_INTERNAL_RecordIncludeDependency(path, entry->digest);
+        SDL_ShaderCross_INTERNAL_CaptureInclude(path, entry->digest, entry->data, entry->size);
+    }
+    SDL_ShaderCross_INTERNAL_ReleaseIncludeCacheEntry(entry);
+    return unchanged;
+}
+
+/* Memory Cache
+ *
+ * Split into shards by key, each with its own lock, hash table and LRU list,
+ * so that concurrent compiles rarely contend. Every shard gets an equal part
+ * of the byte budget. Entries are reference counted, so blobs returned from
+ * the cache share its copy of the data and stay valid after eviction.
+ */
+
+#define MEMORY_CACHE_SHARDS 16
+#define MEMORY_CACHE_BUCKETS 64
+
+typedef struct MemoryCacheEntry
+{
+    Uint8 digest[SHA256_DIGEST_SIZE];
+    SDL_AtomicInt refcount; /* One for the cache, plus one for every blob handed out */
+    void *data;
+    size_t size;
+    IncludeDependencyList dependencies;
+    struct MemoryCacheEntry *next;       /* Hash chain */
+    struct MemoryCacheEntry *newer;      /* LRU list */
+    struct MemoryCacheEntry *older;
+    struct MemoryCacheShard *shard;      /* NULL once evicted */
+} MemoryCacheEntry;
+
+typedef struct MemoryCacheShard
+{
+    SDL_Mutex *lock;
+    MemoryCacheEntry *buckets[MEMORY_CACHE_BUCKETS];
+    MemoryCacheEntry *newest;
+    MemoryCacheEntry *oldest;
+    Uint64 budget;
+    Uint64 bytes;
+    Uint32 numEntries;
+    Uint64 hits;
+    Uint64 misses;
+    Uint64 evictions;
+} MemoryCacheShard;
+
+static MemoryCacheShard memoryCache[MEMORY_CACHE_SHARDS];
+static SDL_AtomicInt memoryCacheEnabled;
+
+static MemoryCacheShard *SDL_ShaderCross_INTERNAL_GetMemoryCacheShard(const Uint8 digest[SHA256_DIGEST_SIZE])
+{
+    return &memoryCache[digest[0] % MEMORY_CACHE_SHARDS];
+}
+
+static MemoryCacheEntry **SDL_ShaderCross_INTERNAL_FindMemoryCacheEntry(
+    MemoryCacheShard *shard,
+    const Uint8 digest[SHA256_DIGEST_SIZE])
+{
+    // The digest is already uniformly distributed, any of its bytes make a fine bucket index
+    MemoryCacheEntry **entry = &shard->buckets[digest[1] % MEMORY_CACHE_BUCKETS];
+    while (*entry != NULL && SDL_memcmp((*entry)->digest, digest, SHA256_DIGEST_SIZE) != 0) {
+        entry = &(*entry)->next;
+    }
+    return entry;
+}
+
+static size_t SDL_ShaderCross_INTERNAL_GetMemoryCacheEntryCost(size_t size)
+{
+    return sizeof(MemoryCacheEntry) + size;
+}
+
+static void SDL_ShaderCross_INTERNAL_ReleaseMemoryCacheEntry(void *owner)
+{
+    MemoryCacheEntry *entry = (MemoryCacheEntry *)owner;
+    if (SDL_AddAtomicInt(&entry->refcount, -1) == 1) {
+        SDL_ShaderCross_INTERNAL_DestroyIncludeDependencies(&entry->dependencies);
+        SDL_free(entry->data);
+        SDL_free(entry);
+    }
+}
+
+static void SDL_ShaderCross_INTERNAL_UnlinkMemoryCacheEntryLRU(MemoryCacheEntry *entry)
+{
+    MemoryCacheShard *shard = entry->shard;
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    } else {
+        shard->newest = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    } else {
+        shard->oldest = entry->newer;
+    }
+    entry->newer = NULL;
+    entry->older = NULL;
+}
+
+static void SDL_ShaderCross_INTERNAL_LinkMemoryCacheEntryLRU(MemoryCacheEntry *entry)
+{
+    MemoryCacheShard *shard = entry->shard;
+    entry->older = shard->newest;
+    if (shard->newest != NULL) {
+        shard->newest->newer = entry;
+    }
+    shard->newest = entry;
+    if (shard->oldest == NULL) {
+        shard->oldest = entry;
+    }
+}
+
+// Must be called with the shard locked. Drops the cache's reference.
+static void SDL_ShaderCross_INTERNAL_RemoveMemoryCacheEntry(MemoryCacheEntry *entry)
+{
+    MemoryCacheShard *shard = entry->shard;
+    *SDL_ShaderCross_INTERNAL_FindMemoryCacheEntry(shard, entry->digest) = entry->next;
+    SDL_ShaderCross_INTERNAL_UnlinkMemoryCacheEntryLRU(entry);
+    shard->bytes -= SDL_ShaderCross_INTERNAL_GetMemoryCacheEntryCost(entry->size);
+    shard->numEntries -= 1;
+    entry->shard = NULL;
+    SDL_ShaderCross_INTERNAL_ReleaseMemoryCacheEntry(entry);
+}
+
+// Must be called with the shard locked.
+static void SDL_ShaderCross_INTERNAL_TrimMemoryCacheShard(MemoryCacheShard *shard)
+{
+    while (shard->bytes > shard->budget && shard->oldest != NULL) {
+        SDL_ShaderCross_INTERNAL_RemoveMemoryCacheEntry(shard->oldest);
+        shard->evictions += 1;
+    }
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_LookupMemoryCache(
+    const CacheRequest *request,
+    const Uint8 digest[SHA256_DIGEST_SIZE])
+{
+    MemoryCacheShard *shard = SDL_ShaderCross_INTERNAL_GetMemoryCacheShard(digest);
+
+    SDL_LockMutex(shard->lock);
+    MemoryCacheEntry *entry = *SDL_ShaderCross_INTERNAL_FindMemoryCacheEntry(shard, digest);
+    if (entry != NULL) {
+        SDL_AddAtomicInt(&entry->refcount, 1);
+        SDL_ShaderCross_INTERNAL_UnlinkMemoryCacheEntryLRU(entry);
+        SDL_ShaderCross_INTERNAL_LinkMemoryCacheEntryLRU(entry);
+    }
+    SDL_UnlockMutex(shard->lock);
+
+    // Includes are checked without holding the lock, since they may have to be read from disk
+    bool valid = entry != NULL;
+    for (IncludeDependency *dependency = valid ? entry->dependencies.first : NULL; dependency != NULL; dependency = dependency->next) {
+        if (!SDL_ShaderCross_INTERNAL_IsIncludeUnchanged(dependency->path, dependency->digest)) {
+            valid = false;
+            break;
+        }
+    }
+
+    SDL_LockMutex(shard->lock);
+    if (valid) {
+        shard->hits += 1;
+    } else {
+        shard->misses += 1;
+        if (entry != NULL && entry->shard != NULL) {
+            SDL_ShaderCross_INTERNAL_RemoveMemoryCacheEntry(entry);
+        }
+    }
+    SDL_UnlockMutex(shard->lock);
+
+    if (!valid) {
+        if (entry != NULL) {
+            SDL_ShaderCross_INTERNAL_ReleaseMemoryCacheEntry(entry);
+        }
+        return NULL;
+    }
+
+    // The entry is referenced, so its list stays put even if it is evicted meanwhile
+    SDL_ShaderCross_INTERNAL_ReportIncludeDependencies(request, &entry->dependencies);
+
+    return SDL_ShaderCross_INTERNAL_CreateBlob(
+        entry->data,
+        entry->size,
+        entry,
+        SDL_ShaderCross_INTERNAL_ReleaseMemoryCacheEntry);
+}
+
+static void SDL_ShaderCross_INTERNAL_InsertMemoryCache(
+    const Uint8 digest[SHA256_DIGEST_SIZE],
+    const IncludeDependencyList *dependencies,
+    const SDL_ShaderCross_Blob *blob)
+{
+    MemoryCacheShard *shard = SDL_ShaderCross_INTERNAL_GetMemoryCacheShard(digest);
+    size_t cost = SDL_ShaderCross_INTERNAL_GetMemoryCacheEntryCost(blob->size);
+
+    // Checked again under the lock, this just avoids copying results that can never fit
+    SDL_LockMutex(shard->lock);
+    bool fits = cost <= shard->budget;
+    SDL_UnlockMutex(shard->lock);
+    if (!fits) {
+        return;
+    }
+
+    MemoryCacheEntry *entry = SDL_calloc(1, sizeof(MemoryCacheEntry));
+    if (entry == NULL) {
+        return;
+    }
+    entry->data = SDL_malloc(blob->size > 0 ? blob->size : 1);
+    if (entry->data == NULL) {
+        SDL_free(entry);
+        return;
+    }
+    SDL_memcpy(entry->data, blob->data, blob->size);
+    SDL_memcpy(entry->digest, digest, SHA256_DIGEST_SIZE);
+    entry->size = blob->size;
+    SDL_SetAtomicInt(&entry->refcount, 1);
+
+    for (IncludeDependency *dependency = dependencies->first; dependency != NULL; dependency = dependency->next) {
+        SDL_ShaderCross_INTERNAL_AddIncludeDependency(&entry->dependencies, dependency->path, dependency->digest);
+    }
+    if (entry->dependencies.incomplete) {
+        SDL_ShaderCross_INTERNAL_ReleaseMemoryCacheEntry(entry);
+        return;
+    }
+
+    SDL_LockMutex(shard->lock);
+    MemoryCacheEntry *existing = *SDL_ShaderCross_INTERNAL_FindMemoryCacheEntry(shard, digest);
+    if (existing != NULL) {
+        SDL_ShaderCross_INTERNAL_RemoveMemoryCacheEntry(existing);
+    }
+    if (cost <= shard->budget) {
+        MemoryCacheEntry **bucket = &shard->buckets[digest[1] % MEMORY_CACHE_BUCKETS];
+        entry->shard = shard;
+        entry->next = *bucket;
+        *bucket = entry;
+        SDL_ShaderCross_INTERNAL_LinkMemoryCacheEntryLRU(entry);
+        shard->bytes += cost;
+        shard->numEntries += 1;
+        SDL_ShaderCross_INTERNAL_TrimMemoryCacheShard(shard);
+        entry = NULL;
+    }
+    SDL_UnlockMutex(shard->lock);
+
+    if (entry != NULL) {
+        SDL_ShaderCross_INTERNAL_ReleaseMemoryCacheEntry(entry);
+    }
+}
+
+static bool SDL_ShaderCross_INTERNAL_CreateMemoryCache(Uint64 budget)
+{
+    for (int i = 0; i < MEMORY_CACHE_SHARDS; i += 1) {
+        memoryCache[i].lock = SDL_CreateMutex();
+        if (memoryCache[i].lock == NULL) {
+            return false;
+        }
+        memoryCache[i].budget = budget / MEMORY_CACHE_SHARDS;
+    }
+    SDL_SetAtomicInt(&memoryCacheEnabled, budget > 0);
+    return true;
+}
+
+static void SDL_ShaderCross_INTERNAL_DestroyMemoryCache(void)
+{
+    SDL_SetAtomicInt(&memoryCacheEnabled, 0);
+    for (int i = 0; i < MEMORY_CACHE_SHARDS; i += 1) {
+        MemoryCacheShard *shard = &memoryCache[i];
+        while (shard->oldest != NULL) {
+            SDL_ShaderCross_INTERNAL_RemoveMemoryCacheEntry(shard->oldest);
+        }
+        SDL_DestroyMutex(shard->lock);
+        SDL_zerop(shard);
+    }
+}
+
+bool SDL_ShaderCross_SetMemoryCacheBudget(Uint64 budget)
+{
+    if (cacheLock == NULL) {
+        return SDL_SetError("%s", "SDL_ShaderCross_Init must be called before configuring the memory cache!");
+    }
+
+    for (int i = 0; i < MEMORY_CACHE_SHARDS; i += 1) {
+        MemoryCacheShard *shard = &memoryCache[i];
+        SDL_LockMutex(shard->lock);
+        shard->budget = budget / MEMORY_CACHE_SHARDS;
+        SDL_ShaderCross_INTERNAL_TrimMemoryCacheShard(shard);
+        SDL_UnlockMutex(shard->lock);
+    }
+    SDL_SetAtomicInt(&memoryCacheEnabled, budget > 0);
+    return true;
+}
+
+bool SDL_ShaderCross_GetMemoryCacheStats(SDL_ShaderCross_MemoryCacheStats *stats)
+{
+    if (stats == NULL) {
+        return SDL_InvalidParamError("stats");
+    }
+    SDL_zerop(stats);
+    if (cacheLock == NULL) {
+        return SDL_SetError("%s", "SDL_ShaderCross_Init must be called before querying the memory cache!");
+    }
+
+    for (int i = 0; i < MEMORY_CACHE_SHARDS; i += 1) {
+        MemoryCacheShard *shard = &memoryCache[i];
+        SDL_LockMutex(shard->lock);
+        stats->hits += shard->hits;
+        stats->misses += shard->misses;
+        stats->evictions += shard->evictions;
+        stats->num_entries += shard->numEntries;
+        stats->bytes += shard->bytes;
+        stats->budget += shard->budget;
+        SDL_UnlockMutex(shard->lock);
+    }
+    return true;
+}
+
+bool SDL_ShaderCross_ComputeDigest(const void *data, size_t size, Uint8 digest[SDL_SHADERCROSS_DIGEST_SIZE])
+{
+    SHA256Context ctx;
+
+    if (data == NULL && size > 0) {
+        return SDL_InvalidParamError("data");
+    }
+    if (digest == NULL) {
+        return SDL_InvalidParamError("digest");
+    }
+    SDL_ShaderCross_INTERNAL_SHA256Init(&ctx);
+    SDL_ShaderCross_INTERNAL_SHA256Update(&ctx, data, size);
+    SDL_ShaderCross_INTERNAL_SHA256Final(&ctx, digest);
+    return true;
+}
+
+const char *SDL_ShaderCross_GetCompilerVersions(void)
+{
+    if (cacheLock == NULL) {
+        SDL_SetError("%s", "SDL_ShaderCross_Init must be called before querying the compiler versions!");
+        return NULL;
+    }
+
+    SDL_LockMutex(cacheLock);
+    if (cacheCompilerVersions == NULL) {
+        cacheCompilerVersions = SDL_ShaderCross_INTERNAL_QueryCompilerVersions();
+    }
+    const char *compilerVersions = cacheCompilerVersions;
+    SDL_UnlockMutex(cacheLock);
+
+    if (compilerVersions == NULL) {
+        SDL_SetError("%s", "Could not query the compiler versions!");
+    }
+    return compilerVersions;
+}
+
+/* Disk Cache
+ *
+ * One file per result, holding the include dependencies followed by the
+ * output. Entries are written to a temporary file and renamed into place,
+ * so several processes can share a directory.
+ */
+
+#define DISK_CACHE_MAGIC "SDLSXC01"
+#define DISK_CACHE_MAGIC_SIZE 8
+
+static char *diskCacheDirectory = NULL;
+
+// Returns the cached output, or NULL if the entry is missing, corrupt or stale.
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_LoadDiskCacheEntry(
+    const char *path,
+    IncludeDependencyList *dependencies)
+{
+    size_t fileSize;
+    Uint8 *file = SDL_LoadFile(path, &fileSize);
+    if (file == NULL) {
+        return NULL;
+    }
+
+    SDL_IOStream *io = SDL_IOFromConstMem(file, fileSize);
+    char magic[DISK_CACHE_MAGIC_SIZE];
+    Uint32 numDependencies = 0;
+    Uint64 payloadSize = 0;
+
+    bool valid = io != NULL &&
+        SDL_ReadIO(io, magic, sizeof(magic)) == sizeof(magic) &&
+        SDL_memcmp(magic, DISK_CACHE_MAGIC, sizeof(magic)) == 0 &&
+        SDL_ReadU32LE(io, &numDependencies);
+
+    for (Uint32 i = 0; valid && i < numDependencies; i += 1) {
+        Uint32 pathLength = 0;
+        Uint8 digest[SHA256_DIGEST_SIZE];
+        char *dependencyPath = NULL;
+
+        valid = SDL_ReadU32LE(io, &pathLength) && pathLength < fileSize;
+        if (valid) {
+            dependencyPath = SDL_malloc(pathLength + 1);
+            valid = dependencyPath != NULL &&
+                SDL_ReadIO(io, dependencyPath, pathLength) == pathLength &&
+                SDL_ReadIO(io, digest, sizeof(digest)) == sizeof(digest);
+        }
+        if (valid) {
+            dependencyPath[pathLength] = '\0';
+            valid = SDL_ShaderCross_INTERNAL_IsIncludeUnchanged(dependencyPath, digest);
+        }
+        if (valid) {
+            SDL_ShaderCross_INTERNAL_AddIncludeDependency(dependencies, dependencyPath, digest);
+        }
+        SDL_free(dependencyPath);
+    }
+
+    Sint64 offset = 0;
+    if (valid) {
+        valid = SDL_ReadU64LE(io, &payloadSize);
+        offset = SDL_TellIO(io);
+        valid = valid && offset >= 0 && payloadSize == (Uint64)(fileSize - (size_t)offset);
+    }
+    SDL_CloseIO(io);
+
+    if (!valid) {
+        SDL_free(file);
+        return NULL;
+    }
+
+    // SDL_LoadFile NUL-terminates, so source code outputs stay usable as strings
+    return SDL_ShaderCross_INTERNAL_CreateBlob(
+        file + offset,
+        (size_t)payloadSize,
+        file,
+        SDL_ShaderCross_INTERNAL_ReleaseMemory);
+}
+
+static bool SDL_ShaderCross_INTERNAL_StoreDiskCacheEntry(
+    const char *directory,
+    const char *path,
+    const IncludeDependencyList *dependencies,
+    const SDL_ShaderCross_Blob *blob)
+{
+    // Neither the cache directory nor the subdirectory the entry goes in have to exist yet
+    char *subdirectory = SDL_strdup(path);
+    if (subdirectory == NULL) {
+        return false;
+    }
+    *SDL_strrchr(subdirectory, '/') = '\0';
+    bool success = SDL_CreateDirectory(directory) && SDL_CreateDirectory(subdirectory);
+    SDL_free(subdirectory);
+    if (!success) {
+        return false;
+    }
+
+    // Other processes may be writing the same entry, so the temporary name has to be unique across processes
+    SDL_Time now = 0;
+    SDL_GetCurrentTime(&now);
+    char *tempPath = NULL;
+    if (SDL_asprintf(&tempPath, "%s.%" SDL_PRIs64 ".%" SDL_PRIu64 ".%" SDL_PRIu32 ".tmp", path, now, SDL_GetCurrentThreadID(), SDL_rand_bits()) < 0) {
+        return false;
+    }
+
+    SDL_IOStream *io = SDL_IOFromFile(tempPath, "wb");
+    success = io != NULL &&
+        SDL_WriteIO(io, DISK_CACHE_MAGIC, DISK_CACHE_MAGIC_SIZE) == DISK_CACHE_MAGIC_SIZE &&
+        SDL_WriteU32LE(io, dependencies->count);
+
+    for (IncludeDependency *dependency = dependencies->first; success && dependency != NULL; dependency = dependency->next) {
+        size_t pathLength = SDL_strlen(dependency->path);
+        success = SDL_WriteU32LE(io, (Uint32)pathLength) &&
+            SDL_WriteIO(io, dependency->path, pathLength) == pathLength &&
+            SDL_WriteIO(io, dependency->digest, SHA256_DIGEST_SIZE) == SHA256_DIGEST_SIZE;
+    }
+
+    success = success &&
+        SDL_WriteU64LE(io, blob->size) &&
+        SDL_WriteIO(io, blob->data, blob->size) == blob->size;
+
+    if (io != NULL && !SDL_CloseIO(io)) {
+        success = false;
+    }
+
+    // Readers only ever see complete entries, whoever wins the rename
+    if (!success || !SDL_RenamePath(tempPath, path)) {
+        SDL_RemovePath(tempPath);
+        success = false;
+    }
+    SDL_free(tempPath);
+    return success;
+}
+
+static void SDL_ShaderCross_INTERNAL_HashDefines(
+    SHA256Context *key,
+    const SDL_ShaderCross_HLSL_Define *defines)
+{
+    Uint32 count = 0;
+    if (defines != NULL) {
+        while (count < MAX_DEFINES && defines[count].name != NULL) {
+            SDL_ShaderCross_INTERNAL_SHA256String(key, defines[count].name);
+            SDL_ShaderCross_INTERNAL_SHA256String(key, defines[count].value);
+            count += 1;
+        }
+    }
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, count);
+}
+
+static void SDL_ShaderCross_INTERNAL_HashOptions(
+    SHA256Context *key,
+    SDL_GPUShaderFormat format,
+    Uint32 shaderModel,
+    SDL_ShaderCross_ShaderStage shaderStage,
+    bool enableDebug,
+    const char *name,
+    SDL_PropertiesID props)
+{
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, format);
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, shaderModel);
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, shaderStage);
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, enableDebug);
+    SDL_ShaderCross_INTERNAL_SHA256String(key, name);
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, (Uint64)SDL_GetNumberProperty(props, SDL_SHADERCROSS_PROP_OPTIMIZATION_LEVEL_NUMBER, -1));
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, SDL_GetBooleanProperty(props, SDL_SHADERCROSS_PROP_SKIP_VALIDATION_BOOLEAN, false));
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, SDL_GetBooleanProperty(props, SDL_SHADERCROSS_PROP_ALL_RESOURCES_BOUND_BOOLEAN, false));
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, SDL_GetBooleanProperty(props, SDL_SHADERCROSS_PROP_AVOID_FLOW_CONTROL_BOOLEAN, false));
+}
+
+/* Result Cache Lookups */
+
+// Returns the disk cache directory to use, or NULL. An empty string turns the disk cache off for one compile.
+static const char *SDL_ShaderCross_INTERNAL_GetDiskCacheDirectory(SDL_PropertiesID props)
+{
+    const char *directory = SDL_GetStringProperty(props, SDL_SHADERCROSS_PROP_CACHE_DIRECTORY_STRING, diskCacheDirectory);
+    if (directory == NULL || *directory == '\0') {
+        return NULL;
+    }
+    return directory;
+}
+
+// Set on replayed calls, which empty the cache directory too, so that they measure compiles and not cache lookups
+#define SDL_SHADERCROSS_INTERNAL_PROP_NO_MEMORY_CACHE_BOOLEAN "SDL.shadercross.internal.no_memory_cache"
+
+static bool SDL_ShaderCross_INTERNAL_IsMemoryCacheEnabled(SDL_PropertiesID props)
+{
+    return SDL_GetAtomicInt(&memoryCacheEnabled) &&
+        !SDL_GetBooleanProperty(props, SDL_SHADERCROSS_INTERNAL_PROP_NO_MEMORY_CACHE_BOOLEAN, false);
+}
+
+// Both caches need SDL_ShaderCross_Init. This is checked before hashing, so a disabled cache costs nothing.
+static bool SDL_ShaderCross_INTERNAL_IsCacheEnabled(SDL_PropertiesID props)
+{
+    return cacheLock != NULL &&
+        (SDL_ShaderCross_INTERNAL_IsMemoryCacheEnabled(props) || SDL_ShaderCross_INTERNAL_GetDiskCacheDirectory(props) != NULL);
+}
+
+// Records includes for the dependency callback alone, for a compile that is not cached
+static void SDL_ShaderCross_INTERNAL_StartRecordingIncludes(CacheRequest *request)
+{
+    if (request->dependencyCallback != NULL) {
+        request->active = true;
+        request->outerDependencies = (IncludeDependencyList *)SDL_GetTLS(&includeDependenciesTLS);
+        SDL_SetTLS(&includeDependenciesTLS, &request->dependencies, NULL);
+    }
+}
+
+/* Looks the key up in the memory cache, then the disk cache. On a hit, the
+ * cached output is returned. On a miss, NULL is returned and
+ * SDL_ShaderCross_INTERNAL_EndCache must be called with the result of the
+ * compile.
+ */
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_BeginCache(
+    CacheRequest *request,
+    SHA256Context *key,
+    SDL_PropertiesID props)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    SDL_LockMutex(cacheLock);
+    if (cacheCompilerVersions == NULL) {
+        cacheCompilerVersions = SDL_ShaderCross_INTERNAL_QueryCompilerVersions();
+    }
+    const char *compilerVersions = cacheCompilerVersions;
+    SDL_UnlockMutex(cacheLock);
+
+    if (compilerVersions == NULL) {
+        SDL_ShaderCross_INTERNAL_StartRecordingIncludes(request);
+        return NULL;
+    }
+
+    SDL_ShaderCross_INTERNAL_SHA256String(key, compilerVersions);
+    SDL_ShaderCross_INTERNAL_SHA256Final(key, request->digest);
+
+    request->memory = SDL_ShaderCross_INTERNAL_IsMemoryCacheEnabled(props);
+    if (request->memory) {
+        SDL_ShaderCross_Blob *blob = SDL_ShaderCross_INTERNAL_LookupMemoryCache(request, request->digest);
+        if (blob != NULL) {
+            SDL_ShaderCross_INTERNAL_CountCacheHit();
+            SDL_ShaderCross_INTERNAL_CaptureCacheHit();
+            SDL_ShaderCross_INTERNAL_EndScope(&request->outerScope);
+            return blob;
+        }
+    }
+
+    const char *directory = SDL_ShaderCross_INTERNAL_GetDiskCacheDirectory(props);
+    if (directory != NULL) {
+        char name[SHA256_DIGEST_SIZE * 2 + 1];
+        for (int i = 0; i < SHA256_DIGEST_SIZE; i += 1) {
+            name[i * 2] = hexDigits[request->digest[i] >> 4];
+            name[i * 2 + 1] = hexDigits[request->digest[i] & 0xF];
+        }
+        name[SHA256_DIGEST_SIZE * 2] = '\0';
+
+        // Entries are spread over 256 subdirectories to keep directory sizes down
+        request->directory = directory;
+        if (SDL_asprintf(&request->path, "%s/%.2s/%s", directory, name, name + 2) < 0) {
+            request->path = NULL;
+        }
+    }
+
+    if (request->path != NULL) {
+        SDL_ShaderCross_Blob *blob = SDL_ShaderCross_INTERNAL_LoadDiskCacheEntry(request->path, &request->dependencies);
+        if (blob != NULL) {
+            if (request->memory) {
+                SDL_ShaderCross_INTERNAL_InsertMemoryCache(request->digest, &request->dependencies, blob);
+            }
+            SDL_ShaderCross_INTERNAL_ReportIncludeDependencies(request, &request->dependencies);
+            SDL_ShaderCross_INTERNAL_DestroyIncludeDependencies(&request->dependencies);
+            SDL_free(request->path);
+            request->path = NULL;
+            SDL_ShaderCross_INTERNAL_CountCacheHit();
+            SDL_ShaderCross_INTERNAL_CaptureCacheHit();
+            SDL_ShaderCross_INTERNAL_EndScope(&request->outerScope);
+            return blob;
+        }
+
+        // Forget whatever a stale entry listed, the compile records its own includes
+        SDL_ShaderCross_INTERNAL_DestroyIncludeDependencies(&request->dependencies);
+        SDL_zero(request->dependencies);
+    }
+
+    request->store = true;
+    request->active = true;
+    request->outerDependencies = (IncludeDependencyList *)SDL_GetTLS(&includeDependenciesTLS);
+    SDL_SetTLS(&includeDependenciesTLS, &request->dependencies, NULL);
+    return NULL;
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_EndCache(
+    CacheRequest *request,
+    SDL_ShaderCross_Blob *result)
+{
+    SDL_ShaderCross_INTERNAL_EndScope(&request->outerScope);
+
+    if (!request->active) {
+        return result;
+    }
+
+    SDL_SetTLS(&includeDependenciesTLS, request->outerDependencies, NULL);
+    SDL_ShaderCross_INTERNAL_MergeIncludeDependencies(request->outerDependencies, &request->dependencies);
+
+    SDL_ShaderCross_INTERNAL_ReportIncludeDependencies(request, &request->dependencies);
+
+    // A failed store only costs a compile next time, so it is not an error
+    if (result != NULL && request->store && !request->dependencies.incomplete) {
+        if (request->memory) {
+            SDL_ShaderCross_INTERNAL_InsertMemoryCache(request->digest, &request->dependencies, result);
+        }
+        if (request->path != NULL) {
+            SDL_ShaderCross_INTERNAL_StoreDiskCacheEntry(
+                request->directory,
+                request->path,
+                &request->dependencies,
+                result);
+        }
+    }
+
+    SDL_ShaderCross_INTERNAL_DestroyIncludeDependencies(&request->dependencies);
+    SDL_free(request->path);
+    request->path = NULL;
+    request->active = false;
+    request->store = false;
+    return result;
+}
+
+// Hashes everything about an HLSL compile except the options shared with SPIR-V
+static void SDL_ShaderCross_INTERNAL_HashHLSLInput(
+    SHA256Context *key,
+    const SDL_ShaderCross_HLSL_Info *info,
+    size_t sourceSize,
+    const SDL_ShaderCross_HLSL_Define *extraDefines)
+{
+    const char **extraIncludeDirs = (const char **)SDL_GetPointerProperty(info->props, SDL_SHADERCROSS_PROP_HLSL_INCLUDE_DIRS_POINTER, NULL);
+
+    SDL_ShaderCross_INTERNAL_SHA256String(key, "HLSL");
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, sourceSize);
+    SDL_ShaderCross_INTERNAL_SHA256Update(key, info->source, sourceSize);
+    SDL_ShaderCross_INTERNAL_SHA256String(key, info->entrypoint);
+    SDL_ShaderCross_INTERNAL_SHA256String(key, info->include_dir);
+    if (extraIncludeDirs != NULL) {
+        for (Uint32 i = 0; i < MAX_INCLUDE_DIRS && extraIncludeDirs[i] != NULL; i += 1) {
+            SDL_ShaderCross_INTERNAL_SHA256String(key, extraIncludeDirs[i]);
+        }
+    }
+    SDL_ShaderCross_INTERNAL_SHA256String(key, NULL);
+    SDL_ShaderCross_INTERNAL_HashDefines(key, info->defines);
+    SDL_ShaderCross_INTERNAL_HashDefines(key, extraDefines);
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, SDL_GetBooleanProperty(info->props, SDL_SHADERCROSS_PROP_HLSL_DXIL_DIRECT_BOOLEAN, false));
+}
+
+static void SDL_ShaderCross_INTERNAL_HashSPIRVInput(
+    SHA256Context *key,
+    const SDL_ShaderCross_SPIRV_Info *info,
+    bool forDevice)
+{
+    SDL_ShaderCross_INTERNAL_SHA256String(key, "SPIRV");
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, forDevice);
+    SDL_ShaderCross_INTERNAL_SHA256Number(key, info->bytecode_size);
+    SDL_ShaderCross_INTERNAL_SHA256Update(key, info->bytecode, info->bytecode_size);
+    SDL_ShaderCross_INTERNAL_SHA256String(key, info->entrypoint);
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_BeginHLSLCache(
+    CacheRequest *request,
+    const SDL_ShaderCross_HLSL_Info *info,
+    size_t sourceSize,
+    const SDL_ShaderCross_HLSL_Define *extraDefines,
+    SDL_GPUShaderFormat format,
+    Uint32 shaderModel)
+{
+    SHA256Context key;
+
+    SDL_zerop(request);
+    SDL_ShaderCross_INTERNAL_BeginScope(&request->outerScope, info->props, info->name);
+    const SDL_ShaderCross_DependencyReporter *reporter = (const SDL_ShaderCross_DependencyReporter *)SDL_GetPointerProperty(info->props, SDL_SHADERCROSS_PROP_HLSL_DEPENDENCY_REPORTER_POINTER, NULL);
+    if (reporter != NULL) {
+        request->dependencyCallback = reporter->callback;
+        request->dependencyUserdata = reporter->userdata;
+    }
+
+    if (!SDL_ShaderCross_INTERNAL_IsCacheEnabled(info->props)) {
+        SDL_ShaderCross_INTERNAL_StartRecordingIncludes(request);
+        return NULL;
+    }
+
+    SDL_ShaderCross_INTERNAL_SHA256Init(&key);
+    SDL_ShaderCross_INTERNAL_HashHLSLInput(&key, info, sourceSize, extraDefines);
+    SDL_ShaderCross_INTERNAL_HashOptions(
+        &key,
+        format,
+        shaderModel,
+        info->shader_stage,
+        info->enable_debug,
+        info->name,
+        info->props);
+
+    return SDL_ShaderCross_INTERNAL_BeginCache(request, &key, info->props);
+}
+
+/* format is 0 when transpiling to HLSL source. forDevice selects the combined
+ * output of SDL_ShaderCross_INTERNAL_CompileShaderForDevice instead of the
+ * plain shader code.
+ */
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_BeginSPIRVCache(
+    CacheRequest *request,
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_GPUShaderFormat format,
+    Uint32 shaderModel,
+    bool forDevice)
+{
+    SHA256Context key;
+
+    SDL_zerop(request);
+    SDL_ShaderCross_INTERNAL_BeginScope(&request->outerScope, info->props, info->name);
+    if (!SDL_ShaderCross_INTERNAL_IsCacheEnabled(info->props)) {
+        return NULL;
+    }
+
+    SDL_ShaderCross_INTERNAL_SHA256Init(&key);
+    SDL_ShaderCross_INTERNAL_HashSPIRVInput(&key, info, forDevice);
+    SDL_ShaderCross_INTERNAL_HashOptions(
+        &key,
+        format,
+        shaderModel,
+        info->shader_stage,
+        info->enable_debug,
+        info->name,
+        info->props);
+
+    return SDL_ShaderCross_INTERNAL_BeginCache(request, &key, info->props);
+}
+
+typedef struct DXCArguments DXCArguments;
+
+/* Win32 Type Definitions */
+
+typedef int HRESULT;
+typedef const void *LPCVOID;
+typedef size_t SIZE_T;
+typedef const char *LPCSTR;
+typedef unsigned int UINT;
+typedef unsigned long ULONG;
+typedef void *LPVOID;
+typedef void *REFIID;
+
+/* DXIL via DXC */
+#ifdef SDL_SHADERCROSS_DXC
+
+/* dxcompiler Type Definitions */
+typedef int BOOL;
+typedef void *REFCLSID;
+typedef wchar_t *LPCWSTR;
+typedef void IDxcBlobEncoding;   /* hack, unused */
+typedef void IDxcBlobWide;       /* hack, unused */
+typedef struct IDxcIncludeHandler IDxcIncludeHandler;
+
+/* Unlike vkd3d-utils, libdxcompiler.so does not use msabi */
+#if !defined(_WIN32)
+#define __stdcall
+#endif
+
+/* Compiler Interface, _technically_ unofficial but it's MS C++, come on */
+typedef enum DXC_OUT_KIND
+{
+    DXC_OUT_NONE = 0,
+    DXC_OUT_OBJECT = 1,
+    DXC_OUT_ERRORS = 2,
+    DXC_OUT_PDB = 3,
+    DXC_OUT_SHADER_HASH = 4,
+    DXC_OUT_DISASSEMBLY = 5,
+    DXC_OUT_HLSL = 6,
+    DXC_OUT_TEXT = 7,
+    DXC_OUT_REFLECTION = 8,
+    DXC_OUT_ROOT_SIGNATURE = 9,
+    DXC_OUT_EXTRA_OUTPUTS = 10,
+    DXC_OUT_REMARKS = 11,
+    DXC_OUT_TIME_REPORT = 12,
+    DXC_OUT_TIME_TRACE = 13,
+    DXC_OUT_LAST = DXC_OUT_TIME_TRACE,
+    DXC_OUT_NUM_ENUMS,
+    // DXC_OUT_FORCE_DWORD = 0xFFFFFFFF
+} DXC_OUT_KIND;
+
+#define DXC_CP_UTF8  65001
+#define DXC_CP_UTF16 1200
+#define DXC_CP_UTF32 12000
+/* This is for binary, ANSI-text, or to tell the compiler to try autodetecting UTF using the BOM */
+#define DXC_CP_ACP 0
+
+typedef struct DxcBuffer
+{
+    LPCVOID Ptr;
+    SIZE_T Size;
+    UINT Encoding;
+} DxcBuffer;
+
+/* *INDENT-OFF* */ // clang-format off
+
+static Uint8 IID_IDxcBlob[] = {
+    0x08, 0xFB, 0xA5, 0x8B,
+    0x95, 0x51,
+    0xE2, 0x40,
+    0xAC,
+    0x58,
+    0x0D,
+    0x98,
+    0x9C,
+    0x3A,
+    0x01,
+    0x02
+};
+typedef struct IDxcBlob IDxcBlob;
+typedef struct IDxcBlobVtbl
+{
+    HRESULT(__stdcall *QueryInterface)(IDxcBlob *This, REFIID riid, void **ppvObject);
+    ULONG(__stdcall *AddRef)(IDxcBlob *This);
+    ULONG(__stdcall *Release)(IDxcBlob *This);
+
+    LPVOID(__stdcall *GetBufferPointer)(IDxcBlob *This);
+    SIZE_T(__stdcall *GetBufferSize)(IDxcBlob *This);
+} IDxcBlobVtbl;
+struct IDxcBlob
+{
+    IDxcBlobVtbl *lpVtbl;
+};
+
+static Uint8 IID_IDxcBlobUtf8[] = {
+    0xC9, 0x36, 0xA6, 0x3D,
+    0x71, 0xBA,
+    0x24, 0x40,
+    0xA3,
+    0x01,
+    0x30,
+    0xCB,
+    0xF1,
+    0x25,
+    0x30,
+    0x5B
+};
+typedef struct IDxcBlobUtf8 IDxcBlobUtf8;
+typedef struct IDxcBlobUtf8Vtbl
+{
+    HRESULT(__stdcall *QueryInterface)(IDxcBlobUtf8 *This, REFIID riid, void **ppvObject);
+    ULONG(__stdcall *AddRef)(IDxcBlobUtf8 *This);
+    ULONG(__stdcall *Release)(IDxcBlobUtf8 *This);
+
+    LPVOID(__stdcall *GetBufferPointer)(IDxcBlobUtf8 *This);
+    SIZE_T(__stdcall *GetBufferSize)(IDxcBlobUtf8 *This);
+
+    HRESULT(__stdcall *GetEncoding)(IDxcBlobUtf8 *This, BOOL *pKnown, Uint32 *pCodePage);
+
+    LPCSTR(__stdcall *GetStringPointer)(IDxcBlobUtf8 *This);
+    SIZE_T(__stdcall *GetStringLength)(IDxcBlobUtf8 *This);
+} IDxcBlobUtf8Vtbl;
+struct IDxcBlobUtf8
+{
+    IDxcBlobUtf8Vtbl *lpVtbl;
+};
+
+static Uint8 IID_IDxcResult[] = {
+    0xDA, 0x6C, 0x34, 0x58,
+    0xE7, 0xDD,
+    0x97, 0x44,
+    0x94,
+    0x61,
+    0x6F,
+    0x87,
+    0xAF,
+    0x5E,
+    0x06,
+    0x59
+};
+typedef struct IDxcResult IDxcResult;
+typedef struct IDxcResultVtbl
+{
+    HRESULT(__stdcall *QueryInterface)(IDxcResult *This, REFIID riid, void **ppvObject);
+    ULONG(__stdcall *AddRef)(IDxcResult *This);
+    ULONG(__stdcall *Release)(IDxcResult *This);
+
+    HRESULT(__stdcall *GetStatus)(IDxcResult *This, HRESULT *pStatus);
+    HRESULT(__stdcall *GetResult)(IDxcResult *This, IDxcBlob **ppResult);
+    HRESULT(__stdcall *GetErrorBuffer)(IDxcResult *This, IDxcBlobEncoding **ppErrors);
+
+    BOOL(__stdcall *HasOutput)(IDxcResult *This, DXC_OUT_KIND dxcOutKind);
+    HRESULT(__stdcall *GetOutput)(
+        IDxcResult *This,
+        DXC_OUT_KIND dxcOutKind,
+        REFIID iid,
+        void **ppvObject,
+        IDxcBlobWide **ppOutputName
+    );
+    Uint32(__stdcall *GetNumOutputs)(IDxcResult *This);
+    DXC_OUT_KIND(__stdcall *GetOutputByIndex)(IDxcResult *This, Uint32 Index);
+    DXC_OUT_KIND(__stdcall *PrimaryOutput)(IDxcResult *This);
+} IDxcResultVtbl;
+struct IDxcResult
+{
+    IDxcResultVtbl *lpVtbl;
+};
+
+static struct
+{
+    Uint32 Data1;
+    Uint16 Data2;
+    Uint16 Data3;
+    Uint8 Data4[8];
+} CLSID_DxcCompiler = {
+    .Data1 = 0x73e22d93,
+    .Data2 = 0xe6ce,
+    .Data3 = 0x47f3,
+    .Data4 = { 0xb5, 0xbf, 0xf0, 0x66, 0x4f, 0x39, 0xc1, 0xb0 }
+};
+static Uint8 IID_IDxcCompiler3[] = {
+    0x87, 0x46, 0x8B, 0x22,
+    0x6A, 0x5A,
+    0x30, 0x47,
+    0x90,
+    0x0C,
+    0x97,
+    0x02,
+    0xB2,
+    0x20,
+    0x3F,
+    0x54
+};
+typedef struct IDxcCompiler3 IDxcCompiler3;
+typedef struct IDxcCompiler3Vtbl
+{
+    HRESULT(__stdcall *QueryInterface)(IDxcCompiler3 *This, REFIID riid, void **ppvObject);
+    ULONG(__stdcall *AddRef)(IDxcCompiler3 *This);
+    ULONG(__stdcall *Release)(IDxcCompiler3 *This);
+
+    HRESULT(__stdcall *Compile)(
+        IDxcCompiler3 *This,
+        const DxcBuffer *pSource,
+        LPCWSTR *pArguments,
+        Uint32 argCount,
+        IDxcIncludeHandler *pIncludeHandler,
+        REFIID riid,
+        LPVOID *ppResult
+    );
+
+    HRESULT(__stdcall *Disassemble)(
+        IDxcCompiler3 *This,
+        const DxcBuffer *pObject,
+        REFIID riid,
+        LPVOID *ppResult
+    );
+} IDxcCompiler3Vtbl;
+struct IDxcCompiler3
+{
+    const IDxcCompiler3Vtbl *lpVtbl;
+};
+
+// We need all this DxcUtils garbage for DXC include dir support. Thanks Microsoft!
+typedef struct IMalloc IMalloc;
+typedef struct IStream IStream;
+typedef struct DxcDefine DxcDefine;
+typedef struct IDxcCompilerArgs IDxcCompilerArgs;
+
+static struct
+{
+    Uint32 Data1;
+    Uint16 Data2;
+    Uint16 Data3;
+    Uint8 Data4[8];
+} CLSID_DxcUtils = {
+    .Data1 = 0x6245d6af,
+    .Data2 = 0x66e0,
+    .Data3 = 0x48fd,
+    .Data4 = {0x80, 0xb4, 0x4d, 0x27, 0x17, 0x96, 0x74, 0x8c}};
+static Uint8 IID_IDxcUtils[] = {
+    0xcb, 0xc4, 0x05, 0x46,
+    0x19, 0x20,
+    0x2a, 0x49,
+    0xad,
+    0xa4,
+    0x65,
+    0xf2,
+    0x0b,
+    0xb7,
+    0xd6,
+    0x7f
+};
+typedef struct IDxcUtilsVtbl
+{
+    HRESULT (__stdcall *QueryInterface)(void *pSelf, REFIID riid, void **ppvObject);
+    ULONG (__stdcall *AddRef)(void *pSelf);
+    ULONG (__stdcall *Release)(void *pSelf);
+
+    HRESULT (__stdcall *CreateBlobFromBlob)(void *pSelf, IDxcBlob *pBlob, UINT offset, UINT length, IDxcBlob **ppResult);
+    HRESULT (__stdcall *CreateBlobFromPinned)(void *pSelf, LPCVOID pData, UINT size, UINT codePage, IDxcBlobEncoding **pBlobEncoding);
+    HRESULT (__stdcall *MoveToBlob)(void *pSelf, LPCVOID pData, IMalloc *pIMalloc, UINT size, UINT codePage, IDxcBlobEncoding **pBlobEncoding);
+    HRESULT (__stdcall *CreateBlob)(void *pSelf, LPCVOID pData, UINT size, UINT codePage, IDxcBlobEncoding **pBlobEncoding);
+    HRESULT (__stdcall *LoadFile)(void *pSelf, LPCWSTR pFileName, UINT *pCodePage, IDxcBlobEncoding **pBlobEncoding);
+    HRESULT (__stdcall *CreateReadOnlyStreamFromBlob)(void *pSelf, IDxcBlob *pBlob, IStream **ppStream);
+    HRESULT (__stdcall *CreateDefaultIncludeHandler)(void *pSelf, IDxcIncludeHandler **ppResult);
+    HRESULT (__stdcall *GetBlobAsUtf8)(void *pSelf, IDxcBlob *pBlob, IDxcBlobUtf8 **pBlobEncoding);
+    HRESULT (__stdcall *GetBlobAsWide)(void *pSelf, IDxcBlob *pBlob, IDxcBlobWide **pBlobEncoding);
+    HRESULT (__stdcall *GetDxilContainerPart)(void *pSelf, const DxcBuffer *pShader, UINT DxcPart, void **ppPartData, UINT *pPartSizeInBytes);
+    HRESULT (__stdcall *CreateReflection)(void *pSelf, const DxcBuffer *pData, REFIID iid, void **ppvReflection);
+    HRESULT (__stdcall *BuildArguments)(void *pSelf, LPCWSTR pSourceName, LPCWSTR pEntryPoint, LPCWSTR pTargetProfile, LPCWSTR *pArguments, UINT argCount, const DxcDefine *pDefines, UINT defineCount, IDxcCompilerArgs **ppArgs);
+    HRESULT (__stdcall *GetPDBContents)(void *pSelf, IDxcBlob *pPDBBlob, IDxcBlob **ppHash, IDxcBlob **ppContainer);
+} IDxcUtilsVtbl;
+
+typedef struct IDxcUtils IDxcUtils;
+struct IDxcUtils
+{
+    const IDxcUtilsVtbl *lpVtbl;
+};
+
+typedef struct IDxcIncludeHandlerVtbl
+{
+    HRESULT(__stdcall *QueryInterface)(IDxcIncludeHandler *This, REFIID riid, void **ppvObject);
+    ULONG(__stdcall *AddRef)(IDxcIncludeHandler *This);
+    ULONG(__stdcall *Release)(IDxcIncludeHandler *This);
+
+    HRESULT(__stdcall *LoadSource)(IDxcIncludeHandler *This, LPCWSTR pFilename, IDxcBlob **ppIncludeSource);
+} IDxcIncludeHandlerVtbl;
+struct IDxcIncludeHandler
+{
+    const IDxcIncludeHandlerVtbl *lpVtbl;
+};
+
+static Uint8 IID_IUnknown[] = {
+    0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00,
+    0x00, 0x00,
+    0xC0,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x46
+};
+static Uint8 IID_IDxcIncludeHandler[] = {
+    0x7D, 0xFC, 0x61, 0x7F,
+    0x0D, 0x95,
+    0x7F, 0x46,
+    0xB3,
+    0xE3,
+    0x3C,
+    0x02,
+    0xFB,
+    0x49,
+    0x18,
+    0x7C
+};
+
+static Uint8 IID_IDxcVersionInfo[] = {
+    0x50, 0x5B, 0x4F, 0xB0,
+    0x59, 0x20,
+    0x12, 0x4F,
+    0xA8,
+    0xFF,
+    0xA1,
+    0xE0,
+    0xCD,
+    0xE1,
+    0xCC,
+    0x7E
+};
+typedef struct IDxcVersionInfo IDxcVersionInfo;
+typedef struct IDxcVersionInfoVtbl
+{
+    HRESULT(__stdcall *QueryInterface)(IDxcVersionInfo *This, REFIID riid, void **ppvObject);
+    ULONG(__stdcall *AddRef)(IDxcVersionInfo *This);
+    ULONG(__stdcall *Release)(IDxcVersionInfo *This);
+
+    HRESULT(__stdcall *GetVersion)(IDxcVersionInfo *This, Uint32 *pMajor, Uint32 *pMinor);
+    HRESULT(__stdcall *GetFlags)(IDxcVersionInfo *This, Uint32 *pFlags);
+} IDxcVersionInfoVtbl;
+struct IDxcVersionInfo
+{
+    const IDxcVersionInfoVtbl *lpVtbl;
+};
+
+/* *INDENT-ON* */ // clang-format on
+
+#define S_OK          ((HRESULT)0)
+#define E_NOINTERFACE ((HRESULT)0x80004002)
+#define E_POINTER     ((HRESULT)0x80004003)
+#define E_FAIL        ((HRESULT)0x80004005)
+
+/* DXCompiler */
+#if defined(SDL_PLATFORM_XBOXONE) || defined(SDL_PLATFORM_XBOXSERIES)
+extern HRESULT __stdcall DxcCreateInstance(REFCLSID rclsid, REFIID riid, LPVOID* ppv);
+#else
+extern HRESULT DxcCreateInstance(REFCLSID rclsid, REFIID riid, LPVOID *ppv);
+#endif
+
+/* Caching Include Handler
+ *
+ * Our own IDxcIncludeHandler, which resolves includes through the include
+ * cache instead of reading every file from disk on every compile.
+ */
+typedef struct IncludeHandler
+{
+    IDxcIncludeHandler base; /* Must be first, DXC only sees this part */
+    SDL_AtomicInt refcount;
+    IDxcUtils *utils;
+    IDxcBlob *loadedBlob;
+} IncludeHandler;
+
+static HRESULT __stdcall SDL_ShaderCross_INTERNAL_IncludeHandler_QueryInterface(
+    IDxcIncludeHandler *This,
+    REFIID riid,
+    void **ppvObject)
+{
+    if (ppvObject == NULL) {
+        return E_POINTER;
+    }
+
+    if (SDL_memcmp(riid, IID_IUnknown, sizeof(IID_IUnknown)) == 0 ||
+        SDL_memcmp(riid, IID_IDxcIncludeHandler, sizeof(IID_IDxcIncludeHandler)) == 0) {
+        This->lpVtbl->AddRef(This);
+        *ppvObject = This;
+        return S_OK;
+    }
+
+    *ppvObject = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG __stdcall SDL_ShaderCross_INTERNAL_IncludeHandler_AddRef(
+    IDxcIncludeHandler *This)
+{
+    IncludeHandler *handler = (IncludeHandler *)This;
+    return (ULONG)(SDL_AddAtomicInt(&handler->refcount, 1) + 1);
+}
+
+static ULONG __stdcall SDL_ShaderCross_INTERNAL_IncludeHandler_Release(
+    IDxcIncludeHandler *This)
+{
+    IncludeHandler *handler = (IncludeHandler *)This;
+    int refcount = SDL_AddAtomicInt(&handler->refcount, -1) - 1;
+    if (refcount == 0) {
+        SDL_free(handler);
+    }
+    return (ULONG)refcount;
+}
+
+static bool SDL_ShaderCross_INTERNAL_IncludeHandler_CreateBlob(
+    void *userdata,
+    const void *data,
+    size_t size)
+{
+    IncludeHandler *handler = (IncludeHandler *)userdata;
+    IDxcBlobEncoding *blob = NULL;
+
+    // CreateBlob copies the data, so the cache entry is free to change afterwards
+    handler->utils->lpVtbl->CreateBlob(
+        handler->utils,
+        data,
+        (UINT)size,
+        DXC_CP_UTF8,
+        &blob);
+
+    handler->loadedBlob = (IDxcBlob *)blob;
+    return blob != NULL;
+}
+
+static HRESULT __stdcall SDL_ShaderCross_INTERNAL_IncludeHandler_LoadSource(
+    IDxcIncludeHandler *This,
+    LPCWSTR pFilename,
+    IDxcBlob **ppIncludeSource)
+{
+    IncludeHandler *handler = (IncludeHandler *)This;
+
+    if (pFilename == NULL || ppIncludeSource == NULL) {
+        return E_POINTER;
+    }
+    *ppIncludeSource = NULL;
+
+    char *filename = SDL_iconv_string(
+        "UTF-8",
+        "WCHAR_T",
+        (const char *)pFilename,
+        (SDL_wcslen(pFilename) + 1) * sizeof(wchar_t));
+    if (filename == NULL) {
+        return E_FAIL;
+    }
+
+    handler->loadedBlob = NULL;
+    bool found = SDL_ShaderCross_INTERNAL_LoadInclude(
+        filename,
+        SDL_ShaderCross_INTERNAL_IncludeHandler_CreateBlob,
+        handler);
+    SDL_free(filename);
+
+    // Failing here is expected, DXC probes every include directory in turn
+    if (!found) {
+        return E_FAIL;
+    }
+
+    *ppIncludeSource = handler->loadedBlob;
+    handler->loadedBlob = NULL;
+    return S_OK;
+}
+
+static const IDxcIncludeHandlerVtbl includeHandlerVtbl = {
+    SDL_ShaderCross_INTERNAL_IncludeHandler_QueryInterface,
+    SDL_ShaderCross_INTERNAL_IncludeHandler_AddRef,
+    SDL_ShaderCross_INTERNAL_IncludeHandler_Release,
+    SDL_ShaderCross_INTERNAL_IncludeHandler_LoadSource
+};
+
+static IDxcIncludeHandler *SDL_ShaderCross_INTERNAL_CreateIncludeHandler(IDxcUtils *utils)
+{
+    IncludeHandler *handler = SDL_calloc(1, sizeof(IncludeHandler));
+    if (handler == NULL) {
+        return NULL;
+    }
+
+    handler->base.lpVtbl = &includeHandlerVtbl;
+    SDL_SetAtomicInt(&handler->refcount, 1);
+    handler->utils = utils; // not referenced, the owning DXCInstance outlives the handler
+    return &handler->base;
+}
+
+/* DXC instance pool
+ *
+ * The compiler, utils and include handler objects are not thread-safe, so
+ * each compile checks out a full set for exclusive use and returns it when
+ * done. Sets are created lazily and kept around until SDL_ShaderCross_Quit.
+ */
+typedef struct DXCInstance
+{
+    IDxcCompiler3 *compiler;
+    IDxcUtils *utils;
+    IDxcIncludeHandler *includeHandler;
+    struct DXCInstance *next;
+} DXCInstance;
+
+// Only accessed atomically, since compiles may check for it on any thread
+static SDL_Mutex *dxcPoolLock = NULL;
+static DXCInstance *dxcPool = NULL;
+
+static SDL_Mutex *SDL_ShaderCross_INTERNAL_GetDXCPoolLock(void)
+{
+    return (SDL_Mutex *)SDL_GetAtomicPointer((void **)&dxcPoolLock);
+}
+
+static void SDL_ShaderCross_INTERNAL_DestroyDXCInstance(DXCInstance *instance)
+{
+    if (instance->includeHandler != NULL) {
+        instance->includeHandler->lpVtbl->Release(instance->includeHandler);
+    }
+    if (instance->utils != NULL) {
+        instance->utils->lpVtbl->Release(instance->utils);
+    }
+    if (instance->compiler != NULL) {
+        instance->compiler->lpVtbl->Release(instance->compiler);
+    }
+    SDL_free(instance);
+}
+
+static DXCInstance *SDL_ShaderCross_INTERNAL_CreateDXCInstance(void)
+{
+    DXCInstance *instance = SDL_calloc(1, sizeof(DXCInstance));
+    if (instance == NULL) {
+        return NULL;
+    }
+
+    DxcCreateInstance(
+        &CLSID_DxcCompiler,
+        IID_IDxcCompiler3,
+        (void **)&instance->compiler);
+
+    if (instance->compiler == NULL) {
+        SDL_SetError("%s", "Could not create DXC instance!");
+        SDL_ShaderCross_INTERNAL_DestroyDXCInstance(instance);
+        return NULL;
+    }
+
+    DxcCreateInstance(
+        &CLSID_DxcUtils,
+        &IID_IDxcUtils,
+        (void **)&instance->utils);
+
+    if (instance->utils == NULL) {
+        SDL_SetError("%s", "Could not create DXC utils instance!");
+        SDL_ShaderCross_INTERNAL_DestroyDXCInstance(instance);
+        return NULL;
+    }
+
+    instance->includeHandler = SDL_ShaderCross_INTERNAL_CreateIncludeHandler(instance->utils);
+    if (instance->includeHandler == NULL) {
+        SDL_SetError("%s", "Failed to create an include handler!");
+        SDL_ShaderCross_INTERNAL_DestroyDXCInstance(instance);
+        return NULL;
+    }
+
+    return instance;
+}
+
+static DXCInstance *SDL_ShaderCross_INTERNAL_AcquireDXCInstance(void)
+{
+    DXCInstance *instance = NULL;
+    SDL_Mutex *lock = SDL_ShaderCross_INTERNAL_GetDXCPoolLock();
+
+    if (lock != NULL) {
+        SDL_LockMutex(lock);
+        instance = dxcPool;
+        if (instance != NULL) {
+            dxcPool = instance->next;
+            instance->next = NULL;
+        }
+        SDL_UnlockMutex(lock);
+    }
+
+    if (instance == NULL) {
+        instance = SDL_ShaderCross_INTERNAL_CreateDXCInstance();
+    }
+
+    return instance;
+}
+
+static void SDL_ShaderCross_INTERNAL_ReturnDXCInstance(DXCInstance *instance)
+{
+    SDL_Mutex *lock = SDL_ShaderCross_INTERNAL_GetDXCPoolLock();
+
+    // Without the pool (SDL_ShaderCross_Init not called) we can't keep the instance around
+    if (lock == NULL) {
+        SDL_ShaderCross_INTERNAL_DestroyDXCInstance(instance);
+        return;
+    }
+
+    SDL_LockMutex(lock);
+    instance->next = dxcPool;
+    dxcPool = instance;
+    SDL_UnlockMutex(lock);
+}
+
+static bool SDL_ShaderCross_INTERNAL_CreateDXCPool(void)
+{
+    SDL_Mutex *lock = SDL_CreateMutex();
+    if (lock == NULL) {
+        return false;
+    }
+    SDL_SetAtomicPointer((void **)&dxcPoolLock, lock);
+    return true;
+}
+
+static void SDL_ShaderCross_INTERNAL_DestroyDXCPool(void)
+{
+    // Compiles that start from now on create and destroy their own instances
+    SDL_Mutex *lock = (SDL_Mutex *)SDL_SetAtomicPointer((void **)&dxcPoolLock, NULL);
+    if (lock == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(lock);
+    while (dxcPool != NULL) {
+        DXCInstance *next = dxcPool->next;
+        SDL_ShaderCross_INTERNAL_DestroyDXCInstance(dxcPool);
+        dxcPool = next;
+    }
+    SDL_UnlockMutex(lock);
+
+    SDL_DestroyMutex(lock);
+}
+
+static bool SDL_ShaderCross_INTERNAL_GetDXCVersion(Uint32 *major, Uint32 *minor, Uint32 *flags)
+{
+    DXCInstance *instance = SDL_ShaderCross_INTERNAL_AcquireDXCInstance();
+    IDxcVersionInfo *versionInfo = NULL;
+
+    if (instance == NULL) {
+        return false;
+    }
+
+    instance->compiler->lpVtbl->QueryInterface(
+        instance->compiler,
+        IID_IDxcVersionInfo,
+        (void **)&versionInfo);
+
+    if (versionInfo == NULL) {
+        SDL_ShaderCross_INTERNAL_ReturnDXCInstance(instance);
+        return SDL_SetError("%s", "Could not query the DXC version!");
+    }
+
+    versionInfo->lpVtbl->GetVersion(versionInfo, major, minor);
+    versionInfo->lpVtbl->GetFlags(versionInfo, flags);
+    versionInfo->lpVtbl->Release(versionInfo);
+
+    SDL_ShaderCross_INTERNAL_ReturnDXCInstance(instance);
+    return true;
+}
+
+static SDL_AtomicInt dxcMaxShaderModel;
+
+/* DXC 1.x supports Shader Model 6.x from its first release, e.g. SM 6.8
+ * from DXC 1.8. A newer major version than we know of gets the benefit of
+ * the doubt.
+ */
+static Uint32 SDL_ShaderCross_INTERNAL_GetDXCMaxShaderModel(void)
+{
+    int maxShaderModel = SDL_GetAtomicInt(&dxcMaxShaderModel);
+    if (maxShaderModel == 0) {
+        Uint32 major, minor, flags;
+        maxShaderModel = MAX_DXIL_SHADER_MODEL;
+        if (SDL_ShaderCross_INTERNAL_GetDXCVersion(&major, &minor, &flags) && major == 1) {
+            maxShaderModel = (int)SDL_clamp(DEFAULT_DXIL_SHADER_MODEL + minor, DEFAULT_DXIL_SHADER_MODEL, MAX_DXIL_SHADER_MODEL);
+        }
+        SDL_SetAtomicInt(&dxcMaxShaderModel, maxShaderModel);
+    }
+    return (Uint32)maxShaderModel;
+}
+
+static void SDL_ShaderCross_INTERNAL_ReleaseDXCBlob(void *owner)
+{
+    IDxcBlob *blob = (IDxcBlob *)owner;
+    blob->lpVtbl->Release(blob);
+}
+
+/* Compiler arguments that are shared by every compile of the same
+ * HLSL_Info, converted to UTF-16 once up front. Per-compile defines are
+ * appended after these when compiling permutations. The arguments and their
+ * strings are scratch memory, so they live until the scratch is rewound.
+ */
+struct DXCArguments
+{
+    LPCWSTR *args;
+    Uint32 argCount;
+    bool spirv; /* Compiling to SPIR-V rather than DXIL */
+};
+
+static Uint32 SDL_ShaderCross_INTERNAL_CountDefines(const SDL_ShaderCross_HLSL_Define *defines)
+{
+    Uint32 count = 0;
+    if (defines != NULL) {
+        while (count < MAX_DEFINES && defines[count].name != NULL) {
+            count += 1;
+        }
+    }
+    return count;
+}
+
+/* Converts UTF-8 to a wide string in scratch memory. Like the WCHAR_T
+ * encoding of SDL_iconv, that is UTF-16 where wchar_t is 16 bits, as on
+ * Windows, and UTF-32 elsewhere.
+ */
+static wchar_t *SDL_ShaderCross_INTERNAL_ConvertToWide(const char *str)
+{
+    size_t length = SDL_strlen(str);
+
+    // Each byte of UTF-8 becomes at most one UTF-16 or UTF-32 code unit
+    wchar_t *result = (wchar_t *)SDL_ShaderCross_INTERNAL_AllocScratch((length + 1) * sizeof(wchar_t));
+    if (result == NULL) {
+        return NULL;
+    }
+
+    wchar_t *dst = result;
+    Uint32 codepoint;
+    while ((codepoint = SDL_StepUTF8(&str, &length)) != 0) {
+        if (sizeof(wchar_t) == 2 && codepoint > 0xFFFF) {
+            codepoint -= 0x10000;
+            *dst++ = (wchar_t)(0xD800 + (codepoint >> 10));
+            *dst++ = (wchar_t)(0xDC00 + (codepoint & 0x3FF));
+        } else {
+            *dst++ = (wchar_t)codepoint;
+        }
+    }
+    *dst = 0;
+    return result;
+}
+
+static wchar_t *SDL_ShaderCross_INTERNAL_ConvertDefine(const SDL_ShaderCross_HLSL_Define *define)
+{
+    char defineString[MAX_DEFINE_STRING_LENGTH];
+    SDL_snprintf(defineString, MAX_DEFINE_STRING_LENGTH, "-D%s=%s", define->name, define->value != NULL ? define->value : "1");
+    return SDL_ShaderCross_INTERNAL_ConvertToWide(defineString);
+}
+
+#endif /* SDL_SHADERCROSS_DXC */
+
+static DXCArguments *SDL_ShaderCross_INTERNAL_CreateDXCArguments(
+    const SDL_ShaderCross_HLSL_Info *info,
+    bool spirv)
+{
+#ifdef SDL_SHADERCROSS_DXC
+    if (!SDL_ShaderCross_INTERNAL_CheckShaderModel(info->props, spirv ? SDL_GPU_SHADERFORMAT_SPIRV : SDL_GPU_SHADERFORMAT_DXIL)) {
+        return NULL;
+    }
+
+    const char **extraIncludeDirs = (const char **)SDL_GetPointerProperty(info->props, SDL_SHADERCROSS_PROP_HLSL_INCLUDE_DIRS_POINTER, NULL);
+    Uint32 numDefines = SDL_ShaderCross_INTERNAL_CountDefines(info->defines);
+    Uint32 numExtraIncludeDirs = 0;
+
+    if (extraIncludeDirs != NULL) {
+        while (numExtraIncludeDirs < MAX_INCLUDE_DIRS && extraIncludeDirs[numExtraIncludeDirs] != NULL) {
+            numExtraIncludeDirs += 1;
+        }
+    }
+
+    Uint32 maxStrings = numDefines + numExtraIncludeDirs + 4;
+    DXCArguments *arguments = (DXCArguments *)SDL_ShaderCross_INTERNAL_AllocScratch(sizeof(DXCArguments));
+    if (arguments == NULL) {
+        return NULL;
+    }
+    arguments->args = (LPCWSTR *)SDL_ShaderCross_INTERNAL_AllocScratch(sizeof(LPCWSTR) * (maxStrings * 2 + 16));
+    arguments->argCount = 0;
+    if (arguments->args == NULL) {
+        return NULL;
+    }
+
+    for (Uint32 i = 0; i < numDefines; i += 1) {
+        wchar_t *defineUtf16 = SDL_ShaderCross_INTERNAL_ConvertDefine(&info->defines[i]);
+        if (defineUtf16 == NULL) {
+            SDL_SetError("%s", "Failed to convert define to WCHAR_T!");
+            return NULL;
+        }
+        arguments->args[arguments->argCount++] = defineUtf16;
+    }
+
+    wchar_t *entryPointUtf16 = SDL_ShaderCross_INTERNAL_ConvertToWide(info->entrypoint);
+    if (entryPointUtf16 == NULL) {
+        SDL_SetError("%s", "Failed to convert entrypoint to WCHAR_T!");
+        return NULL;
+    }
+    arguments->args[arguments->argCount++] = (LPCWSTR)L"-E";
+    arguments->args[arguments->argCount++] = entryPointUtf16;
+
+    // info->include_dir is searched first, followed by any extra directories
+    for (Uint32 i = 0; i < numExtraIncludeDirs + 1; i += 1) {
+        const char *includeDir = (i == 0) ? info->include_dir : extraIncludeDirs[i - 1];
+        if (includeDir == NULL) {
+            continue;
+        }
+        wchar_t *includeDirUtf16 = SDL_ShaderCross_INTERNAL_ConvertToWide(includeDir);
+        if (includeDirUtf16 == NULL) {
+            SDL_SetError("%s", "Failed to convert include dir to WCHAR_T!");
+            return NULL;
+        }
+        arguments->args[arguments->argCount++] = (LPCWSTR)L"-I";
+        arguments->args[arguments->argCount++] = includeDirUtf16;
+    }
+
+    char shaderProfile[16];
+    SDL_ShaderCross_INTERNAL_GetShaderProfile(
+        shaderProfile,
+        sizeof(shaderProfile),
+        info->shader_stage,
+        SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, SDL_GPU_SHADERFORMAT_DXIL));
+    wchar_t *shaderProfileUtf16 = SDL_ShaderCross_INTERNAL_ConvertToWide(shaderProfile);
+    if (shaderProfileUtf16 == NULL) {
+        SDL_SetError("%s", "Failed to convert shader profile to WCHAR_T!");
+        return NULL;
+    }
+    arguments->args[arguments->argCount++] = (LPCWSTR)L"-T";
+    arguments->args[arguments->argCount++] = shaderProfileUtf16;
+
+    if (spirv) {
+        arguments->args[arguments->argCount++] = (LPCWSTR)L"-spirv";
+    }
+    arguments->spirv = spirv;
+
+    if (info->enable_debug) {
+        if (spirv) {
+            // https://github.com/microsoft/DirectXShaderCompiler/blob/main/docs/SPIR-V.rst#debugging
+            arguments->args[arguments->argCount++] = (LPCWSTR)L"-fspv-debug=vulkan-with-source";
+        } else {
+            // https://github.com/microsoft/DirectXShaderCompiler/blob/main/docs/SourceLevelDebuggingHLSL.rst#command-line-options
+            arguments->args[arguments->argCount++] = (LPCWSTR)L"-Zi";
+        }
+    }
+
+    Sint64 optimizationLevel = SDL_GetNumberProperty(info->props, SDL_SHADERCROSS_PROP_OPTIMIZATION_LEVEL_NUMBER, -1);
+    if (optimizationLevel == 0) {
+        arguments->args[arguments->argCount++] = (LPCWSTR)L"-O0";
+    } else if (optimizationLevel == 1) {
+        arguments->args[arguments->argCount++] = (LPCWSTR)L"-O1";
+    } else if (optimizationLevel == 2) {
+        arguments->args[arguments->argCount++] = (LPCWSTR)L"-O2";
+    } else if (optimizationLevel == 3) {
+        arguments->args[arguments->argCount++] = (LPCWSTR)L"-O3";
+    } // otherwise DXC defaults to -O3
+
+    if (SDL_GetBooleanProperty(info->props, SDL_SHADERCROSS_PROP_SKIP_VALIDATION_BOOLEAN, false)) {
+        arguments->args[arguments->argCount++] = (LPCWSTR)L"-Vd";
+    }
+    if (SDL_GetBooleanProperty(info->props, SDL_SHADERCROSS_PROP_ALL_RESOURCES_BOUND_BOOLEAN, false)) {
+        arguments->args[arguments->argCount++] = (LPCWSTR)L"-all_resources_bound";
+    }
+    if (SDL_GetBooleanProperty(info->props, SDL_SHADERCROSS_PROP_AVOID_FLOW_CONTROL_BOOLEAN, false)) {
+        arguments->args[arguments->argCount++] = (LPCWSTR)L"-Gfa";
+    }
+
+    if (info->name) {
+        wchar_t *nameUtf16 = SDL_ShaderCross_INTERNAL_ConvertToWide(info->name);
+        if (nameUtf16 != NULL) {
+            arguments->args[arguments->argCount++] = nameUtf16; // a bare string inserted into the arguments is treated as the source file name
+        }
+    }
+
+#if defined(SDL_PLATFORM_XBOXONE) || defined(SDL_PLATFORM_XBOXSERIES)
+    arguments->args[arguments->argCount++] = L"-D__XBOX_DISABLE_PRECOMPILE=1";
+#endif
+
+    return arguments;
+#else
+    SDL_SetError("%s", "Shadercross was not built with DXC support, cannot compile using DXC!");
+    return NULL;
+#endif /* SDL_SHADERCROSS_DXC */
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileUsingDXCArguments(
+    const char *source,
+    size_t sourceSize,
+    const DXCArguments *arguments,
+    const SDL_ShaderCross_HLSL_Define *extraDefines)
+{
+#ifdef SDL_SHADERCROSS_DXC
+    DxcBuffer sourceBuffer;
+    IDxcResult *dxcResult;
+    IDxcBlob *blob;
+    IDxcBlobUtf8 *errors;
+    LPCWSTR *args = arguments->args;
+    Uint32 argCount = arguments->argCount;
+    Uint32 numExtraDefines = SDL_ShaderCross_INTERNAL_CountDefines(extraDefines);
+    ScratchMark scratch;
+    HRESULT ret;
+
+    SDL_ShaderCross_INTERNAL_BeginScratch(&scratch, 0);
+    if (numExtraDefines > 0) {
+        LPCWSTR *combinedArgs = (LPCWSTR *)SDL_ShaderCross_INTERNAL_AllocScratch(sizeof(LPCWSTR) * (arguments->argCount + numExtraDefines));
+        if (combinedArgs == NULL) {
+            SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+            return NULL;
+        }
+
+        SDL_memcpy(combinedArgs, arguments->args, sizeof(LPCWSTR) * arguments->argCount);
+        for (Uint32 i = 0; i < numExtraDefines; i += 1) {
+            wchar_t *defineUtf16 = SDL_ShaderCross_INTERNAL_ConvertDefine(&extraDefines[i]);
+            if (defineUtf16 == NULL) {
+                SDL_SetError("%s", "Failed to convert define to WCHAR_T!");
+                SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+                return NULL;
+            }
+            combinedArgs[argCount++] = defineUtf16;
+        }
+        args = combinedArgs;
+    }
+
+    /* Pooled instance, checked out for exclusive use since the functions we call on it are not thread-safe */
+    DXCInstance *dxc = SDL_ShaderCross_INTERNAL_AcquireDXCInstance();
+    if (dxc == NULL) {
+        ret = E_FAIL;
+        dxcResult = NULL;
+    } else {
+        IDxcCompiler3 *dxcInstance = dxc->compiler;
+
+        sourceBuffer.Ptr = source;
+        sourceBuffer.Size = sourceSize;
+        sourceBuffer.Encoding = DXC_CP_ACP;
+
+        SDL_ShaderCross_CompilePhase phase = arguments->spirv ? SDL_SHADERCROSS_PHASE_DXC_FRONTEND : SDL_SHADERCROSS_PHASE_DXC_BACKEND;
+        Uint64 start = SDL_ShaderCross_INTERNAL_BeginPhase(phase);
+        ret = dxcInstance->lpVtbl->Compile(
+            dxcInstance,
+            &sourceBuffer,
+            args,
+            argCount,
+            dxc->includeHandler,
+            IID_IDxcResult,
+            (void **)&dxcResult);
+        SDL_ShaderCross_INTERNAL_EndPhase(phase, start);
+
+        SDL_ShaderCross_INTERNAL_ReturnDXCInstance(dxc);
+    }
+
+    SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+
+    if (dxc == NULL) {
+        return NULL;
+    } else if (ret < 0) {
+        SDL_SetError("IDxcShaderCompiler3::Compile failed: %X", ret);
+        return NULL;
+    } else if (dxcResult == NULL) {
+        SDL_SetError("%s", "HLSL compilation failed with no IDxcResult");
+        return NULL;
+    }
+
+    ret = dxcResult->lpVtbl->GetOutput(dxcResult,
+                                       DXC_OUT_OBJECT,
+                                       IID_IDxcBlob,
+                                       (void **)&blob,
+                                       NULL);
+    if (ret < 0) {
+        // Compilation failed, display errors
+        errors = NULL;
+        dxcResult->lpVtbl->GetOutput(
+            dxcResult,
+            DXC_OUT_ERRORS,
+            IID_IDxcBlobUtf8,
+            (void **)&errors,
+            NULL);
+
+        if (errors != NULL && errors->lpVtbl->GetBufferSize(errors) != 0) {
+            SDL_SetError(
+            "HLSL compilation failed: %s",
+                (char *)errors->lpVtbl->GetBufferPointer(errors));
+        } else {
+            SDL_SetError("%s", "Compilation failed with unknown error");
+        }
+
+        // teardown
+        if (errors != NULL) {
+            errors->lpVtbl->Release(errors);
+        }
+        dxcResult->lpVtbl->Release(dxcResult);
+        return NULL;
+    }
+
+    // If compilation succeeded, but there are errors, those are warnings
+    errors = NULL;
+    dxcResult->lpVtbl->GetOutput(
+        dxcResult,
+        DXC_OUT_ERRORS,
+        IID_IDxcBlobUtf8,
+        (void **)&errors,
+        NULL);
+
+    if (errors != NULL && errors->lpVtbl->GetBufferSize(errors) != 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "HLSL compiled with warnings: %s",
+            (char *)errors->lpVtbl->GetBufferPointer(errors));
+    }
+    if (errors != NULL) {
+        errors->lpVtbl->Release(errors);
+    }
+
+    // The output blob holds its own reference, so it outlives the result
+    dxcResult->lpVtbl->Release(dxcResult);
+
+    return SDL_ShaderCross_INTERNAL_CreateBlob(
+        blob->lpVtbl->GetBufferPointer(blob),
+        blob->lpVtbl->GetBufferSize(blob),
+        blob,
+        SDL_ShaderCross_INTERNAL_ReleaseDXCBlob);
+#else
+    SDL_SetError("%s", "Shadercross was not built with DXC support, cannot compile using DXC!");
+    return NULL;
+#endif /* SDL_SHADERCROSS_DXC */
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileUsingDXC(
+    const SDL_ShaderCross_HLSL_Info *info,
+    bool spirv)
+{
+    ScratchMark scratch;
+    SDL_ShaderCross_INTERNAL_BeginScratch(&scratch, info->props);
+
+    DXCArguments *arguments = SDL_ShaderCross_INTERNAL_CreateDXCArguments(info, spirv);
+    if (arguments == NULL) {
+        SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+        return NULL;
+    }
+
+    SDL_ShaderCross_Blob *result = SDL_ShaderCross_INTERNAL_CompileUsingDXCArguments(
+        info->source,
+        SDL_ShaderCross_INTERNAL_GetHLSLSourceSize(info),
+        arguments,
+        NULL);
+
+    SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+    return result;
+}
+
+/* Direct DXIL Bindings
+ *
+ * The SPIR-V roundtrip is what moves resources to the registers and spaces
+ * SDL_GPU expects. A direct compile is only kept if its bindings already
+ * follow those rules. They are read from the pipeline state validation
+ * (PSV0) part of the DXIL container, so no reflection interface is needed.
+ */
+
+#define DXIL_FOURCC(a, b, c, d) ((Uint32)(a) | ((Uint32)(b) << 8) | ((Uint32)(c) << 16) | ((Uint32)(d) << 24))
+#define DXIL_CONTAINER_HEADER_SIZE 32
+#define DXIL_MAX_BINDINGS 256
+
+// PSVResourceType in DxilPipelineStateValidation.h
+typedef enum DXILResourceType
+{
+    DXIL_RESOURCE_INVALID,
+    DXIL_RESOURCE_SAMPLER,
+    DXIL_RESOURCE_CBV,
+    DXIL_RESOURCE_SRV_TYPED,
+    DXIL_RESOURCE_SRV_RAW,
+    DXIL_RESOURCE_SRV_STRUCTURED,
+    DXIL_RESOURCE_UAV_TYPED,
+    DXIL_RESOURCE_UAV_RAW,
+    DXIL_RESOURCE_UAV_STRUCTURED,
+    DXIL_RESOURCE_UAV_STRUCTURED_WITH_COUNTER
+} DXILResourceType;
+
+typedef struct DXILBinding
+{
+    Uint32 type;
+    Uint32 space;
+    Uint32 lowerBound;
+    Uint32 upperBound;
+} DXILBinding;
+
+// Finds the PSV0 part and reads its resource bindings. Returns false if there is none or it is malformed.
+static bool SDL_ShaderCross_INTERNAL_ReadDXILBindings(
+    const void *dxil,
+    size_t size,
+    DXILBinding *bindings,
+    Uint32 *numBindings)
+{
+    SDL_IOStream *io = SDL_IOFromConstMem(dxil, size);
+    Uint32 fourCC = 0;
+    Uint32 partCount = 0;
+    bool found = false;
+
+    if (io == NULL) {
+        return false;
+    }
+
+    bool success = SDL_ReadU32LE(io, &fourCC) && fourCC == DXIL_FOURCC('D', 'X', 'B', 'C') &&
+                   SDL_SeekIO(io, DXIL_CONTAINER_HEADER_SIZE - 4, SDL_IO_SEEK_SET) >= 0 &&
+                   SDL_ReadU32LE(io, &partCount);
+
+    for (Uint32 i = 0; success && !found && i < partCount; i += 1) {
+        Uint32 partOffset = 0;
+        Uint32 partFourCC = 0;
+        success = SDL_SeekIO(io, DXIL_CONTAINER_HEADER_SIZE + (Sint64)i * 4, SDL_IO_SEEK_SET) >= 0 &&
+                  SDL_ReadU32LE(io, &partOffset) &&
+                  SDL_SeekIO(io, partOffset, SDL_IO_SEEK_SET) >= 0 &&
+                  SDL_ReadU32LE(io, &partFourCC);
+        found = success && partFourCC == DXIL_FOURCC('P', 'S', 'V', '0');
+    }
+
+    if (success && found) {
+        Uint32 runtimeInfoSize = 0;
+        Uint32 count = 0;
+        Uint32 bindingSize = 0;
+
+        // The runtime info and each binding grow with the PSV version, so step over them by their stated sizes
+        success = SDL_SeekIO(io, sizeof(Uint32), SDL_IO_SEEK_CUR) >= 0 && // The part size
+                  SDL_ReadU32LE(io, &runtimeInfoSize) &&
+                  SDL_SeekIO(io, runtimeInfoSize, SDL_IO_SEEK_CUR) >= 0 &&
+                  SDL_ReadU32LE(io, &count) &&
+                  count <= DXIL_MAX_BINDINGS &&
+                  (count == 0 || (SDL_ReadU32LE(io, &bindingSize) && bindingSize >= sizeof(Uint32) * 4));
+
+        for (Uint32 i = 0; success && i < count; i += 1) {
+            Sint64 start = SDL_TellIO(io);
+            success = SDL_ReadU32LE(io, &bindings[i].type) &&
+                      SDL_ReadU32LE(io, &bindings[i].space) &&
+                      SDL_ReadU32LE(io, &bindings[i].lowerBound) &&
+                      SDL_ReadU32LE(io, &bindings[i].upperBound) &&
+                      SDL_SeekIO(io, start + bindingSize, SDL_IO_SEEK_SET) >= 0;
+        }
+        *numBindings = count;
+    }
+
+    SDL_CloseIO(io);
+    return success && found;
+}
+
+/* Checks that the bindings of one register class sit in the expected space
+ * and fill it from register 0 up without gaps, with the typed resources
+ * (textures) before the raw and structured ones (buffers).
+ */
+static bool SDL_ShaderCross_INTERNAL_CheckDXILRegisterClass(
+    const DXILBinding *bindings,
+    Uint32 numBindings,
+    Uint32 firstType,
+    Uint32 lastType,
+    Uint32 typedType,
+    Uint32 space,
+    Uint32 *numRegisters)
+{
+    Uint32 total = 0;
+    Uint32 end = 0;
+    Uint32 typedEnd = 0;
+    Uint32 untypedStart = SDL_MAX_UINT32;
+
+    for (Uint32 i = 0; i < numBindings; i += 1) {
+        const DXILBinding *binding = &bindings[i];
+        if (binding->type < firstType || binding->type > lastType) {
+            continue;
+        }
+        // Unbounded arrays have no place in SDL_GPU's layout
+        if (binding->space != space || binding->upperBound < binding->lowerBound || binding->upperBound == SDL_MAX_UINT32) {
+            return false;
+        }
+        total += binding->upperBound - binding->lowerBound + 1;
+        end = SDL_max(end, binding->upperBound + 1);
+        if (binding->type == typedType) {
+            typedEnd = SDL_max(typedEnd, binding->upperBound + 1);
+        } else {
+            untypedStart = SDL_min(untypedStart, binding->lowerBound);
+        }
+    }
+
+    if (numRegisters != NULL) {
+        *numRegisters = typedEnd;
+    }
+    return total == end && (untypedStart == SDL_MAX_UINT32 || typedEnd <= untypedStart);
+}
+
+static bool SDL_ShaderCross_INTERNAL_HasSDLGPUBindings(
+    const SDL_ShaderCross_Blob *dxil,
+    SDL_ShaderCross_ShaderStage stage)
+{
+    DXILBinding bindings[DXIL_MAX_BINDINGS];
+    Uint32 numBindings = 0;
+    Uint32 numSamplers = 0;
+    Uint32 numTextures = 0;
+
+    if (!SDL_ShaderCross_INTERNAL_ReadDXILBindings(dxil->data, dxil->size, bindings, &numBindings)) {
+        return false;
+    }
+
+    if (stage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+        return SDL_ShaderCross_INTERNAL_CheckDXILRegisterClass(bindings, numBindings, DXIL_RESOURCE_SAMPLER, DXIL_RESOURCE_SAMPLER, DXIL_RESOURCE_SAMPLER, 0, NULL) &&
+               SDL_ShaderCross_INTERNAL_CheckDXILRegisterClass(bindings, numBindings, DXIL_RESOURCE_SRV_TYPED, DXIL_RESOURCE_SRV_STRUCTURED, DXIL_RESOURCE_SRV_TYPED, 0, NULL) &&
+               SDL_ShaderCross_INTERNAL_CheckDXILRegisterClass(bindings, numBindings, DXIL_RESOURCE_UAV_TYPED, DXIL_RESOURCE_UAV_STRUCTURED_WITH_COUNTER, DXIL_RESOURCE_UAV_TYPED, 1, NULL) &&
+               SDL_ShaderCross_INTERNAL_CheckDXILRegisterClass(bindings, numBindings, DXIL_RESOURCE_CBV, DXIL_RESOURCE_CBV, DXIL_RESOURCE_CBV, 2, NULL);
+    }
+
+    // Graphics stages have no writable resources
+    for (Uint32 i = 0; i < numBindings; i += 1) {
+        if (bindings[i].type >= DXIL_RESOURCE_UAV_TYPED) {
+            return false;
+        }
+    }
+
+    // Every sampler pairs with one of the first textures
+    Uint32 resourceSpace = (stage == SDL_SHADERCROSS_SHADERSTAGE_VERTEX) ? 0 : 2;
+    return SDL_ShaderCross_INTERNAL_CheckDXILRegisterClass(bindings, numBindings, DXIL_RESOURCE_SAMPLER, DXIL_RESOURCE_SAMPLER, DXIL_RESOURCE_SAMPLER, resourceSpace, &numSamplers) &&
+           SDL_ShaderCross_INTERNAL_CheckDXILRegisterClass(bindings, numBindings, DXIL_RESOURCE_SRV_TYPED, DXIL_RESOURCE_SRV_STRUCTURED, DXIL_RESOURCE_SRV_TYPED, resourceSpace, &numTextures) &&
+           SDL_ShaderCross_INTERNAL_CheckDXILRegisterClass(bindings, numBindings, DXIL_RESOURCE_CBV, DXIL_RESOURCE_CBV, DXIL_RESOURCE_CBV, resourceSpace + 1, NULL) &&
+           numSamplers <= numTextures;
+}
+
+/* Compiles HLSL to DXIL. spirvArguments is only used for the roundtrip
+ * and may be NULL when compiling directly. With the direct DXIL property
+ * set, DXIL is compiled with a single DXC invocation first, and the
+ * roundtrip is only taken if its bindings need legalizing.
+ */
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileDXILFromHLSL(
+    const SDL_ShaderCross_HLSL_Info *info,
+    size_t sourceSize,
+    const DXCArguments *spirvArguments,
+    const DXCArguments *dxilArguments,
+    const SDL_ShaderCross_HLSL_Define *extraDefines)
+{
+    if (spirvArguments == NULL) {
+        return SDL_ShaderCross_INTERNAL_CompileUsingDXCArguments(
+            info->source,
+            sourceSize,
+            dxilArguments,
+            extraDefines);
+    }
+
+    if (SDL_GetBooleanProperty(info->props, SDL_SHADERCROSS_PROP_HLSL_DXIL_DIRECT_BOOLEAN, false)) {
+        SDL_ShaderCross_Blob *direct = SDL_ShaderCross_INTERNAL_CompileUsingDXCArguments(
+            info->source,
+            sourceSize,
+            dxilArguments,
+            extraDefines);
+
+        // A failure is a real error in the source, which the roundtrip would only hit again
+        if (direct == NULL || SDL_ShaderCross_INTERNAL_HasSDLGPUBindings(direct, info->shader_stage)) {
+            return direct;
+        }
+        SDL_ShaderCross_ReleaseBlob(direct);
+    }
+
+    // Roundtrip to SPIR-V to support things like Structured Buffers.
+    SDL_ShaderCross_Blob *spirv = SDL_ShaderCross_INTERNAL_CompileUsingDXCArguments(
+        info->source,
+        sourceSize,
+        spirvArguments,
+        extraDefines);
+
+    if (spirv == NULL) {
+        return NULL;
+    }
+
+    SDL_ShaderCross_SPIRV_Info spirvInfo;
+    spirvInfo.bytecode = spirv->data;
+    spirvInfo.bytecode_size = spirv->size;
+    spirvInfo.entrypoint = info->entrypoint;
+    spirvInfo.shader_stage = info->shader_stage;
+    spirvInfo.enable_debug = info->enable_debug;
+    spirvInfo.name = info->name;
+    spirvInfo.props = info->props;
+
+    SDL_ShaderCross_Blob *translatedSource = SDL_ShaderCross_INTERNAL_TranspileHLSLFromSPIRVToBlob(
+        &spirvInfo);
+
+    SDL_ShaderCross_ReleaseBlob(spirv);
+    if (translatedSource == NULL) {
+        return NULL;
+    }
+
+    SDL_ShaderCross_Blob *result = SDL_ShaderCross_INTERNAL_CompileUsingDXCArguments(
+        (const char *)translatedSource->data,
+        translatedSource->size,
+        dxilArguments,
+        extraDefines);
+
+    SDL_ShaderCross_ReleaseBlob(translatedSource);
+    return result;
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileDXILFromHLSLSource(
+    const SDL_ShaderCross_HLSL_Info *info,
+    size_t sourceSize)
+{
+    DXCArguments *spirvArguments = NULL;
+    ScratchMark scratch;
+    SDL_ShaderCross_INTERNAL_BeginScratch(&scratch, info->props);
+#if !SDL_PLATFORM_GDK
+    spirvArguments = SDL_ShaderCross_INTERNAL_CreateDXCArguments(info, true);
+    if (spirvArguments == NULL) {
+        SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+        return NULL;
+    }
+#endif
+    DXCArguments *dxilArguments = SDL_ShaderCross_INTERNAL_CreateDXCArguments(info, false);
+    if (dxilArguments == NULL) {
+        SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+        return NULL;
+    }
+
+    SDL_ShaderCross_Blob *result = SDL_ShaderCross_INTERNAL_CompileDXILFromHLSL(
+        info,
+        sourceSize,
+        spirvArguments,
+        dxilArguments,
+        NULL);
+
+    SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+    return result;
+}
+
+SDL_ShaderCross_Blob *SDL_ShaderCross_CompileDXILFromHLSLToBlob(
+    const SDL_ShaderCross_HLSL_Info *info)
+{
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginHLSLCapture(&capture, CAPTURE_COMPILE_DXIL_FROM_HLSL, info);
+
+    size_t sourceSize = SDL_ShaderCross_INTERNAL_GetHLSLSourceSize(info);
+    CacheRequest cache;
+
+    SDL_ShaderCross_Blob *result = SDL_ShaderCross_INTERNAL_BeginHLSLCache(
+        &cache,
+        info,
+        sourceSize,
+        NULL,
+        SDL_GPU_SHADERFORMAT_DXIL,
+        SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, SDL_GPU_SHADERFORMAT_DXIL));
+
+    if (result == NULL) {
+        result = SDL_ShaderCross_INTERNAL_EndCache(
+            &cache,
+            SDL_ShaderCross_INTERNAL_CompileDXILFromHLSLSource(info, sourceSize));
+    }
+    return SDL_ShaderCross_INTERNAL_EndBlobCapture(&capture, result);
+}
+
+void *SDL_ShaderCross_CompileDXILFromHLSL(
+    const SDL_ShaderCross_HLSL_Info *info,
+    size_t *size)
+{
+    return SDL_ShaderCross_INTERNAL_CopyBlob(
+        SDL_ShaderCross_CompileDXILFromHLSLToBlob(info),
+        size);
+}
+
+SDL_ShaderCross_Blob *SDL_ShaderCross_CompileSPIRVFromHLSLToBlob(
+    const SDL_ShaderCross_HLSL_Info *info)
+{
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginHLSLCapture(&capture, CAPTURE_COMPILE_SPIRV_FROM_HLSL, info);
+
+    CacheRequest cache;
+
+    SDL_ShaderCross_Blob *result = SDL_ShaderCross_INTERNAL_BeginHLSLCache(
+        &cache,
+        info,
+        SDL_ShaderCross_INTERNAL_GetHLSLSourceSize(info),
+        NULL,
+        SDL_GPU_SHADERFORMAT_SPIRV,
+        SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, SDL_GPU_SHADERFORMAT_SPIRV));
+
+    if (result == NULL) {
+        result = SDL_ShaderCross_INTERNAL_EndCache(
+            &cache,
+            SDL_ShaderCross_INTERNAL_CompileUsingDXC(info, true));
+    }
+    return SDL_ShaderCross_INTERNAL_EndBlobCapture(&capture, result);
+}
+
+void *SDL_ShaderCross_CompileSPIRVFromHLSL(
+    const SDL_ShaderCross_HLSL_Info *info,
+    size_t *size)
+{
+    return SDL_ShaderCross_INTERNAL_CopyBlob(
+        SDL_ShaderCross_CompileSPIRVFromHLSLToBlob(info),
+        size);
+}
+
+/* DXBC via FXC */
+
+/* d3dcompiler Type Definitions */
+typedef void D3D_SHADER_MACRO; /* hack, unused */
+typedef void ID3DInclude;      /* hack, unused */
+
+#define D3DCOMPILE_DEBUG                (1 << 0)
+#define D3DCOMPILE_SKIP_VALIDATION      (1 << 1)
+#define D3DCOMPILE_SKIP_OPTIMIZATION    (1 << 2)
+#define D3DCOMPILE_AVOID_FLOW_CONTROL   (1 << 9)
+#define D3DCOMPILE_OPTIMIZATION_LEVEL0  (1 << 14)
+#define D3DCOMPILE_OPTIMIZATION_LEVEL1  0
+#define D3DCOMPILE_OPTIMIZATION_LEVEL2  ((1 << 14) | (1 << 15))
+#define D3DCOMPILE_OPTIMIZATION_LEVEL3  (1 << 15)
+#define D3DCOMPILE_ALL_RESOURCES_BOUND  (1 << 21)
+
+/* Dynamic Library / Linking */
+#ifdef D3DCOMPILER_DLL
+#undef D3DCOMPILER_DLL
+#endif
+#if defined(_WIN32)
+#define D3DCOMPILER_DLL "d3dcompiler_47.dll"
+#elif defined(__APPLE__)
+#define D3DCOMPILER_DLL "libvkd3d-utils.1.dylib"
+#else
+#define D3DCOMPILER_DLL "libvkd3d-utils.so.1"
+#endif
+
+/* __stdcall declaration, largely taken from vkd3d_windows.h */
+#ifndef _WIN32
+#ifdef __stdcall
+#undef __stdcall
+#endif
+#if defined(__x86_64__) || defined(__arm64__)
+#define __stdcall __attribute__((ms_abi))
+#else
+#if (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 2)) || defined(__APPLE__)
+#define __stdcall __attribute__((__stdcall__)) __attribute__((__force_align_arg_pointer__))
+#else
+#define __stdcall __attribute__((__stdcall__))
+#endif
+#endif
+#endif
+
+/* ID3DBlob definition, used by both D3DCompiler and DXCompiler */
+typedef struct ID3DBlob ID3DBlob;
+typedef struct ID3DBlobVtbl
+{
+    HRESULT(__stdcall *QueryInterface)
+    (ID3DBlob *This, REFIID riid, void **ppvObject);
+    ULONG(__stdcall *AddRef)
+    (ID3DBlob *This);
+    ULONG(__stdcall *Release)
+    (ID3DBlob *This);
+    LPVOID(__stdcall *GetBufferPointer)
+    (ID3DBlob *This);
+    SIZE_T(__stdcall *GetBufferSize)
+    (ID3DBlob *This);
+} ID3DBlobVtbl;
+struct ID3DBlob
+{
+    const ID3DBlobVtbl *lpVtbl;
+};
+#define ID3D10Blob ID3DBlob
+
+/* D3DCompiler */
+static SDL_SharedObject *d3dcompiler_dll = NULL;
+
+typedef HRESULT(__stdcall *pfn_D3DCompile)(
+    LPCVOID pSrcData,
+    SIZE_T SrcDataSize,
+    LPCSTR pSourceName,
+    const D3D_SHADER_MACRO *pDefines,
+    ID3DInclude *pInclude,
+    LPCSTR pEntrypoint,
+    LPCSTR pTarget,
+    UINT Flags1,
+    UINT Flags2,
+    ID3DBlob **ppCode,
+    ID3DBlob **ppErrorMsgs);
+
+static pfn_D3DCompile SDL_D3DCompile = NULL;
+
+// FIXME: includes and defines
+static ID3DBlob *SDL_ShaderCross_INTERNAL_CompileDXBC(
+    const char *hlslSource,
+    size_t hlslSourceSize,
+    const char *entrypoint,
+    const char *shaderProfile,
+    Uint32 flags)
+{
+    ID3DBlob *blob;
+    ID3DBlob *errorBlob;
+    HRESULT ret;
+
+    if (SDL_D3DCompile == NULL) {
+        SDL_SetError("%s", "Could not load D3DCompile!");
+        return NULL;
+    }
+
+    Uint64 start = SDL_ShaderCross_INTERNAL_BeginPhase(SDL_SHADERCROSS_PHASE_FXC);
+    ret = SDL_D3DCompile(
+        hlslSource,
+        hlslSourceSize,
+        NULL,
+        NULL,
+        NULL,
+        entrypoint,
+        shaderProfile,
+        flags,
+        0,
+        &blob,
+        &errorBlob);
+    SDL_ShaderCross_INTERNAL_EndPhase(SDL_SHADERCROSS_PHASE_FXC, start);
+
+    if (ret < 0) {
+        if (errorBlob != NULL) {
+            SDL_SetError(
+                "HLSL compilation failed: %s",
+                (char *)errorBlob->lpVtbl->GetBufferPointer(errorBlob));
+        } else {
+            SDL_SetError("HLSL compilation failed for an unknown reason.");
+        }
+        return NULL;
+    }
+
+    return blob;
+}
+
+static Uint32 SDL_ShaderCross_INTERNAL_GetD3DCompileFlags(
+    const SDL_ShaderCross_HLSL_Info *info)
+{
+    Uint32 flags = 0;
+
+    if (info->enable_debug) {
+        flags |= D3DCOMPILE_DEBUG;
+    }
+
+    Sint64 optimizationLevel = SDL_GetNumberProperty(info->props, SDL_SHADERCROSS_PROP_OPTIMIZATION_LEVEL_NUMBER, -1);
+    if (optimizationLevel == 0) {
+        flags |= D3DCOMPILE_SKIP_OPTIMIZATION | D3DCOMPILE_OPTIMIZATION_LEVEL0;
+    } else if (optimizationLevel == 1) {
+        flags |= D3DCOMPILE_OPTIMIZATION_LEVEL1;
+    } else if (optimizationLevel == 2) {
+        flags |= D3DCOMPILE_OPTIMIZATION_LEVEL2;
+    } else if (optimizationLevel == 3) {
+        flags |= D3DCOMPILE_OPTIMIZATION_LEVEL3;
+    } // otherwise FXC defaults to level 1
+
+    if (SDL_GetBooleanProperty(info->props, SDL_SHADERCROSS_PROP_SKIP_VALIDATION_BOOLEAN, false)) {
+        flags |= D3DCOMPILE_SKIP_VALIDATION;
+    }
+    if (SDL_GetBooleanProperty(info->props, SDL_SHADERCROSS_PROP_ALL_RESOURCES_BOUND_BOOLEAN, false)) {
+        flags |= D3DCOMPILE_ALL_RESOURCES_BOUND;
+    }
+    if (SDL_GetBooleanProperty(info->props, SDL_SHADERCROSS_PROP_AVOID_FLOW_CONTROL_BOOLEAN, false)) {
+        flags |= D3DCOMPILE_AVOID_FLOW_CONTROL;
+    }
+
+    return flags;
+}
+
+static void SDL_ShaderCross_INTERNAL_ReleaseD3DBlob(void *owner)
+{
+    ID3DBlob *blob = (ID3DBlob *)owner;
+    blob->lpVtbl->Release(blob);
+}
+
+/* Compiles HLSL to DXBC. When roundtripArguments is non-NULL the source is
+ * first compiled to SPIR-V with those arguments and transpiled to SM 5.1.
+ */
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSL(
+    const SDL_ShaderCross_HLSL_Info *info,
+    size_t sourceSize,
+    const DXCArguments *roundtripArguments,
+    const SDL_ShaderCross_HLSL_Define *extraDefines)
+{
+    SDL_ShaderCross_Blob *transpiledSource = NULL;
+
+    if (roundtripArguments != NULL) {
+        // Need to roundtrip to SM 5.1
+        SDL_ShaderCross_Blob *spirv = SDL_ShaderCross_INTERNAL_CompileUsingDXCArguments(
+            info->source,
+            sourceSize,
+            roundtripArguments,
+            extraDefines);
+
+        if (spirv == NULL) {
+            return NULL;
+        }
+
+        SDL_ShaderCross_SPIRV_Info spirvInfo;
+        spirvInfo.bytecode = spirv->data;
+        spirvInfo.bytecode_size = spirv->size;
+        spirvInfo.entrypoint = info->entrypoint;
+        spirvInfo.shader_stage = info->shader_stage;
+        spirvInfo.enable_debug = info->enable_debug;
+        spirvInfo.name = info->name;
+        spirvInfo.props = info->props;
+
+        transpiledSource = SDL_ShaderCross_INTERNAL_TranspileHLSLFromSPIRV(
+            &spirvInfo,
+            SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, SDL_GPU_SHADERFORMAT_DXBC));
+        SDL_ShaderCross_ReleaseBlob(spirv);
+
+        if (transpiledSource == NULL) {
+            return NULL;
+        }
+    }
+
+    char shaderProfile[16];
+    SDL_ShaderCross_INTERNAL_GetShaderProfile(
+        shaderProfile,
+        sizeof(shaderProfile),
+        info->shader_stage,
+        SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, SDL_GPU_SHADERFORMAT_DXBC));
+
+    ID3DBlob *blob = SDL_ShaderCross_INTERNAL_CompileDXBC(
+        transpiledSource != NULL ? (const char *)transpiledSource->data : info->source,
+        transpiledSource != NULL ? transpiledSource->size : sourceSize,
+        info->entrypoint,
+        shaderProfile,
+        SDL_ShaderCross_INTERNAL_GetD3DCompileFlags(info));
+
+    SDL_ShaderCross_ReleaseBlob(transpiledSource);
+
+    if (blob == NULL) {
+        return NULL;
+    }
+
+    return SDL_ShaderCross_INTERNAL_CreateBlob(
+        blob->lpVtbl->GetBufferPointer(blob),
+        blob->lpVtbl->GetBufferSize(blob),
+        blob,
+        SDL_ShaderCross_INTERNAL_ReleaseD3DBlob);
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSLToBlob(
+    const SDL_ShaderCross_HLSL_Info *info)
+{
+    size_t sourceSize = SDL_ShaderCross_INTERNAL_GetHLSLSourceSize(info);
+    CacheRequest cache;
+
+    SDL_ShaderCross_Blob *result = SDL_ShaderCross_INTERNAL_BeginHLSLCache(
+        &cache,
+        info,
+        sourceSize,
+        NULL,
+        SDL_GPU_SHADERFORMAT_DXBC,
+        SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, SDL_GPU_SHADERFORMAT_DXBC));
+    if (result != NULL) {
+        return result;
+    }
+
+    ScratchMark scratch;
+    SDL_ShaderCross_INTERNAL_BeginScratch(&scratch, info->props);
+    DXCArguments *spirvArguments = SDL_ShaderCross_INTERNAL_CreateDXCArguments(info, true);
+    if (spirvArguments == NULL) {
+        SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+        return SDL_ShaderCross_INTERNAL_EndCache(&cache, NULL);
+    }
+
+    result = SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSL(
+        info,
+        sourceSize,
+        spirvArguments,
+        NULL);
+
+    SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+    return SDL_ShaderCross_INTERNAL_EndCache(&cache, result);
+}
+
+SDL_ShaderCross_Blob *SDL_ShaderCross_CompileDXBCFromHLSLToBlob(
+    const SDL_ShaderCross_HLSL_Info *info)
+{
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginHLSLCapture(&capture, CAPTURE_COMPILE_DXBC_FROM_HLSL, info);
+    return SDL_ShaderCross_INTERNAL_EndBlobCapture(
+        &capture,
+        SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSLToBlob(info));
+}
+
+// Returns raw byte buffer
+void *SDL_ShaderCross_CompileDXBCFromHLSL(
+    const SDL_ShaderCross_HLSL_Info *info,
+    size_t *size) // filled in with number of bytes of returned buffer
+{
+    return SDL_ShaderCross_INTERNAL_CopyBlob(
+        SDL_ShaderCross_CompileDXBCFromHLSLToBlob(info),
+        size);
+}
+
+static SDL_ShaderCross_Job *SDL_ShaderCross_INTERNAL_StartTask(void (*task)(void *data), void *data);
+static void SDL_ShaderCross_INTERNAL_FinishTask(SDL_ShaderCross_Job *job);
+
+/* HLSL Permutations */
+
+typedef struct PermutationBatch
+{
+    const SDL_ShaderCross_HLSL_Info *info;
+    size_t sourceSize;
+    const SDL_ShaderCross_HLSL_Define *const *defineSets;
+    int numDefineSets;
+    SDL_GPUShaderFormat format;
+    const DXCArguments *spirvArguments; /* NULL for direct DXIL compiles */
+    const DXCArguments *dxilArguments;  /* NULL unless compiling DXIL */
+    SDL_AtomicInt nextIndex;
+    SDL_ShaderCross_PermutationResult *results;
+} PermutationBatch;
+
+static void SDL_ShaderCross_INTERNAL_PermutationWorker(void *data)
+{
+    PermutationBatch *batch = (PermutationBatch *)data;
+
+    for (;;) {
+        int index = SDL_AddAtomicInt(&batch->nextIndex, 1);
+        if (index >= batch->numDefineSets) {
+            break;
+        }
+
+        const SDL_ShaderCross_HLSL_Define *defines = batch->defineSets[index];
+        CacheRequest cache;
+
+        SDL_ShaderCross_Blob *blob = SDL_ShaderCross_INTERNAL_BeginHLSLCache(
+            &cache,
+            batch->info,
+            batch->sourceSize,
+            defines,
+            batch->format,
+            SDL_ShaderCross_INTERNAL_GetShaderModel(batch->info->props, batch->format));
+
+        if (blob == NULL) {
+            if (batch->format == SDL_GPU_SHADERFORMAT_SPIRV) {
+                blob = SDL_ShaderCross_INTERNAL_CompileUsingDXCArguments(
+                    batch->info->source,
+                    batch->sourceSize,
+                    batch->spirvArguments,
+                    defines);
+            } else if (batch->format == SDL_GPU_SHADERFORMAT_DXIL) {
+                blob = SDL_ShaderCross_INTERNAL_CompileDXILFromHLSL(
+                    batch->info,
+                    batch->sourceSize,
+                    batch->spirvArguments,
+                    batch->dxilArguments,
+                    defines);
+            } else {
+                blob = SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSL(
+                    batch->info,
+                    batch->sourceSize,
+                    batch->spirvArguments,
+                    defines);
+            }
+            blob = SDL_ShaderCross_INTERNAL_EndCache(&cache, blob);
+        }
+
+        // The error string is thread-local, so capture it for the caller
+        batch->results[index].blob = blob;
+        if (blob == NULL) {
+            batch->results[index].error = SDL_strdup(SDL_GetError());
+        }
+    }
+}
+
+static SDL_ShaderCross_PermutationResult *SDL_ShaderCross_INTERNAL_CompilePermutationsFromHLSL(
+    const SDL_ShaderCross_HLSL_Info *info,
+    const SDL_ShaderCross_HLSL_Define *const *define_sets,
+    int num_define_sets,
+    SDL_GPUShaderFormat format)
+{
+    PermutationBatch batch;
+    DXCArguments *spirvArguments = NULL;
+    DXCArguments *dxilArguments = NULL;
+    ScratchMark scratch;
+
+    if (info == NULL) {
+        SDL_InvalidParamError("info");
+        return NULL;
+    }
+    if (define_sets == NULL || num_define_sets <= 0) {
+        SDL_InvalidParamError("define_sets");
+        return NULL;
+    }
+    if (format != SDL_GPU_SHADERFORMAT_SPIRV &&
+        format != SDL_GPU_SHADERFORMAT_DXIL &&
+        format != SDL_GPU_SHADERFORMAT_DXBC) {
+        SDL_SetError("%s", "Unsupported shader format for HLSL permutations!");
+        return NULL;
+    }
+
+    // Everything except the per-permutation defines is converted once, and
+    // only read by the workers, which use scratch of their own for the rest
+    SDL_ShaderCross_INTERNAL_BeginScratch(&scratch, info->props);
+#if SDL_PLATFORM_GDK
+    if (format != SDL_GPU_SHADERFORMAT_DXIL) {
+#endif
+        spirvArguments = SDL_ShaderCross_INTERNAL_CreateDXCArguments(info, true);
+        if (spirvArguments == NULL) {
+            SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+            return NULL;
+        }
+#if SDL_PLATFORM_GDK
+    }
+#endif
+    if (format == SDL_GPU_SHADERFORMAT_DXIL) {
+        dxilArguments = SDL_ShaderCross_INTERNAL_CreateDXCArguments(info, false);
+        if (dxilArguments == NULL) {
+            SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+            return NULL;
+        }
+    }
+
+    SDL_ShaderCross_PermutationResult *results = SDL_calloc(num_define_sets, sizeof(SDL_ShaderCross_PermutationResult));
+    if (results == NULL) {
+        SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+        return NULL;
+    }
+
+    batch.info = info;
+    batch.sourceSize = SDL_ShaderCross_INTERNAL_GetHLSLSourceSize(info);
+    batch.defineSets = define_sets;
+    batch.numDefineSets = num_define_sets;
+    batch.format = format;
+    batch.spirvArguments = spirvArguments;
+    batch.dxilArguments = dxilArguments;
+    SDL_SetAtomicInt(&batch.nextIndex, 0);
+    batch.results = results;
+
+    // The calling thread works too, so ask the pool for one less worker than we need
+    int numTasks = SDL_min(SDL_GetNumLogicalCPUCores(), num_define_sets) - 1;
+    SDL_ShaderCross_Job **tasks = NULL;
+    if (numTasks > 0) {
+        tasks = (SDL_ShaderCross_Job **)SDL_ShaderCross_INTERNAL_AllocScratch(sizeof(SDL_ShaderCross_Job *) * numTasks);
+        if (tasks == NULL) {
+            numTasks = 0;
+        }
+    }
+    for (int i = 0; i < numTasks; i += 1) {
+        // If a task can't be queued, the other workers pick up the slack
+        tasks[i] = SDL_ShaderCross_INTERNAL_StartTask(SDL_ShaderCross_INTERNAL_PermutationWorker, &batch);
+    }
+
+    SDL_ShaderCross_INTERNAL_PermutationWorker(&batch);
+
+    for (int i = 0; i < numTasks; i += 1) {
+        if (tasks[i] != NULL) {
+            SDL_ShaderCross_INTERNAL_FinishTask(tasks[i]);
+        }
+    }
+
+    SDL_ShaderCross_INTERNAL_EndScratch(&scratch);
+    return results;
+}
+
+SDL_ShaderCross_PermutationResult *SDL_ShaderCross_CompilePermutationsFromHLSL(
+    const SDL_ShaderCross_HLSL_Info *info,
+    const SDL_ShaderCross_HLSL_Define *const *define_sets,
+    int num_define_sets,
+    SDL_GPUShaderFormat format)
+{
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginHLSLCapture(&capture, CAPTURE_COMPILE_PERMUTATIONS_FROM_HLSL, info);
+    capture.format = format;
+    capture.defineSets = define_sets;
+    capture.numDefineSets = define_sets != NULL ? SDL_max(num_define_sets, 0) : 0;
+
+    SDL_ShaderCross_PermutationResult *results = SDL_ShaderCross_INTERNAL_CompilePermutationsFromHLSL(
+        info,
+        define_sets,
+        num_define_sets,
+        format);
+
+    bool success;
+    Uint64 outputSize = SDL_ShaderCross_INTERNAL_GetPermutationsOutputSize(results, num_define_sets, &success);
+    SDL_ShaderCross_INTERNAL_EndCapture(&capture, success, outputSize);
+    return results;
+}
+
+void SDL_ShaderCross_ReleasePermutationResults(
+    SDL_ShaderCross_PermutationResult *results,
+    int num_results)
+{
+    if (results == NULL) {
+        return;
+    }
+    for (int i = 0; i < num_results; i += 1) {
+        SDL_ShaderCross_ReleaseBlob(results[i].blob);
+        SDL_free(results[i].error);
+    }
+    SDL_free(results);
+}
+
+static SDL_GPUShaderFormat SDL_ShaderCross_INTERNAL_GetDeviceShaderFormat(SDL_GPUDevice *device);
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileShaderForDeviceCached(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_GPUShaderFormat format);
+static void *SDL_ShaderCross_INTERNAL_CreateShaderFromCompiled(
+    SDL_GPUDevice *device,
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_GPUShaderFormat format,
+    SDL_ShaderCross_Blob *compiled,
+    void *metadata);
+
+/* Everything SDL_ShaderCross_INTERNAL_CreateShaderFromHLSL does short of creating the GPU object,
+ * captured as a single call.
+ */
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileHLSLShaderForDevice(
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_GPUShaderFormat format)
+{
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginHLSLCapture(&capture, CAPTURE_COMPILE_HLSL_SHADER_FOR_DEVICE, info);
+    capture.format = format;
+
+    // We'll go through SPIRV-Cross for all of these to more easily obtain reflection metadata.
+    SDL_ShaderCross_Blob *spirv = SDL_ShaderCross_CompileSPIRVFromHLSLToBlob(
+        info);
+
+    SDL_ShaderCross_Blob *compiled = NULL;
+    if (spirv != NULL) {
+        SDL_ShaderCross_SPIRV_Info spirvInfo;
+        spirvInfo.bytecode = spirv->data;
+        spirvInfo.bytecode_size = spirv->size;
+        spirvInfo.entrypoint = info->entrypoint;
+        spirvInfo.shader_stage = info->shader_stage;
+        spirvInfo.enable_debug = info->enable_debug;
+        spirvInfo.name = info->name;
+        spirvInfo.props = info->props;
+        compiled = SDL_ShaderCross_INTERNAL_CompileShaderForDeviceCached(&spirvInfo, format);
+        SDL_ShaderCross_ReleaseBlob(spirv);
+    }
+    // Otherwise the error output from DXC will have already been set
+    return SDL_ShaderCross_INTERNAL_EndBlobCapture(&capture, compiled);
+}
+
+static void *SDL_ShaderCross_INTERNAL_CreateShaderFromHLSL(
+    SDL_GPUDevice *device,
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_ShaderCross_GraphicsShaderMetadata *metadata)
+{
+    if (info == NULL) {
+        SDL_InvalidParamError("info");
+        return NULL;
+    }
+
+    SDL_GPUShaderFormat format = SDL_ShaderCross_INTERNAL_GetDeviceShaderFormat(device);
+    if (format == 0) {
+        return NULL;
+    }
+
+    // Creating the GPU object only needs the fields the SPIR-V info shares with the HLSL info
+    SDL_ShaderCross_SPIRV_Info spirvInfo;
+    SDL_zero(spirvInfo);
+    spirvInfo.entrypoint = info->entrypoint;
+    spirvInfo.shader_stage = info->shader_stage;
+    spirvInfo.enable_debug = info->enable_debug;
+    spirvInfo.name = info->name;
+    spirvInfo.props = info->props;
+
+    return SDL_ShaderCross_INTERNAL_CreateShaderFromCompiled(
+        device,
+        &spirvInfo,
+        format,
+        SDL_ShaderCross_INTERNAL_CompileHLSLShaderForDevice(info, format),
+        (void *)metadata);
+}
+
+SDL_GPUShader *SDL_ShaderCross_CompileGraphicsShaderFromHLSL(
+    SDL_GPUDevice *device,
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_ShaderCross_GraphicsShaderMetadata *metadata)
+{
+    return (SDL_GPUShader *)SDL_ShaderCross_INTERNAL_CreateShaderFromHLSL(
+        device,
+        info,
+        (void *)metadata);
+}
+
+SDL_GPUComputePipeline *SDL_ShaderCross_CompileComputePipelineFromHLSL(
+    SDL_GPUDevice *device,
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_ShaderCross_ComputePipelineMetadata *metadata)
+{
+    return (SDL_GPUComputePipeline *)SDL_ShaderCross_INTERNAL_CreateShaderFromHLSL(
+        device,
+        info,
+        (void *)metadata);
+}
+
+#include <spirv_cross_c.h>
+
+#define SPVC_ERROR(func) \
+    SDL_SetError(#func " failed: %s", spvc_context_get_last_error_string(context))
+
+typedef struct SPIRVTranspileContext {
+    spvc_context context;
+    const char *translated_source;
+    const char *cleansed_entrypoint;
+} SPIRVTranspileContext;
+
+static void SDL_ShaderCross_INTERNAL_DestroyTranspileContext(
+    SPIRVTranspileContext *context)
+{
+    spvc_context_destroy(context->context);
+    SDL_free(context);
+}
+
+static void SDL_ShaderCross_INTERNAL_ReleaseTranspileContext(void *owner)
+{
+    SDL_ShaderCross_INTERNAL_DestroyTranspileContext((SPIRVTranspileContext *)owner);
+}
+
+// Wraps the translated source in a blob, which takes ownership of the transpile context.
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CreateBlobFromTranspileContext(
+    SPIRVTranspileContext *context)
+{
+    if (context == NULL) {
+        return NULL;
+    }
+
+    return SDL_ShaderCross_INTERNAL_CreateBlob(
+        context->translated_source,
+        SDL_strlen(context->translated_source),
+        context,
+        SDL_ShaderCross_INTERNAL_ReleaseTranspileContext);
+}
+
+// Reflection helpers, shared by the public reflection functions and the
+// transpiler so that a module only needs to be parsed once per compile.
+// On failure the error is set and the caller still owns the context.
+static bool SDL_ShaderCross_INTERNAL_ReflectGraphics(
+    spvc_context context,
+    spvc_resources resources,
+    SDL_ShaderCross_GraphicsShaderMetadata *metadata // filled in with reflected data
+) {
+    spvc_result result;
+    spvc_reflected_resource *reflected_resources;
+    size_t num_texture_samplers = 0;
+    size_t num_storage_textures = 0;
+    size_t num_storage_buffers = 0;
+    size_t num_uniform_buffers = 0;
+    size_t num_separate_samplers = 0; // HLSL edge case
+    size_t num_separate_images = 0; // HLSL edge case
+
+    // Combined texture-samplers
+    result = spvc_resources_get_resource_list_for_type(
+        resources,
+        SPVC_RESOURCE_TYPE_SAMPLED_IMAGE,
+        (const spvc_reflected_resource **)&reflected_resources,
+        &num_texture_samplers);
+    if (result < 0) {
+        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+        return false;
+    }
+
+    // If source is HLSL, we might have separate images and samplers
+    if (num_texture_samplers == 0) {
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_SEPARATE_SAMPLERS,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_separate_samplers);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            return false;
+        }
+        num_texture_samplers = num_separate_samplers;
+    }
+
+    // Storage textures
+    result = spvc_resources_get_resource_list_for_type(
+        resources,
+        SPVC_RESOURCE_TYPE_STORAGE_IMAGE,
+        (const spvc_reflected_resource **)&reflected_resources,
+        &num_storage_textures);
+    if (result < 0) {
+        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+        return false;
+    }
+
+    // If source is HLSL, storage images might be marked as separate images
+    result = spvc_resources_get_resource_list_for_type(
+        resources,
+        SPVC_RESOURCE_TYPE_SEPARATE_IMAGE,
+        (const spvc_reflected_resource **)&reflected_resources,
+        &num_separate_images);
+    if (result < 0) {
+        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+        return false;
+    }
+    // The number of storage textures is the number of separate images minus the number of samplers.
+    num_storage_textures += (num_separate_images - num_separate_samplers);
+
+    // Storage buffers
+    result = spvc_resources_get_resource_list_for_type(
+        resources,
+        SPVC_RESOURCE_TYPE_STORAGE_BUFFER,
+        (const spvc_reflected_resource **)&reflected_resources,
+        &num_storage_buffers);
+    if (result < 0) {
+        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+        return false;
+    }
+
+    // Uniform buffers
+    result = spvc_resources_get_resource_list_for_type(
+        resources,
+        SPVC_RESOURCE_TYPE_UNIFORM_BUFFER,
+        (const spvc_reflected_resource **)&reflected_resources,
+        &num_uniform_buffers);
+    if (result < 0) {
+        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+        return false;
+    }
+
+    metadata->num_samplers = num_texture_samplers;
+    metadata->num_storage_textures = num_storage_textures;
+    metadata->num_storage_buffers = num_storage_buffers;
+    metadata->num_uniform_buffers = num_uniform_buffers;
+    return true;
+}
+
+static bool SDL_ShaderCross_INTERNAL_ReflectCompute(
+    spvc_context context,
+    spvc_compiler compiler,
+    spvc_resources resources,
+    SDL_ShaderCross_ComputePipelineMetadata *metadata // filled in with reflected data
+) {
+    spvc_result result;
+    spvc_reflected_resource *reflected_resources;
+    size_t num_texture_samplers = 0;
+    size_t num_readonly_storage_textures = 0;
+    size_t num_readonly_storage_buffers = 0;
+    size_t num_readwrite_storage_textures = 0;
+    size_t num_readwrite_storage_buffers = 0;
+    size_t num_uniform_buffers = 0;
+
+    size_t num_storage_textures = 0;
+    size_t num_storage_buffers = 0;
+    size_t num_separate_samplers = 0; // HLSL edge case
+    size_t num_separate_images = 0; // HLSL edge case
+
+    // Combined texture-samplers
+    result = spvc_resources_get_resource_list_for_type(
+        resources,
+        SPVC_RESOURCE_TYPE_SAMPLED_IMAGE,
+        (const spvc_reflected_resource **)&reflected_resources,
+        &num_texture_samplers);
+    if (result < 0) {
+        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+        return false;
+    }
+
+    // If source is HLSL, we might have separate images and samplers
+    if (num_texture_samplers == 0) {
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_SEPARATE_SAMPLERS,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_separate_samplers);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            return false;
+        }
+        num_texture_samplers = num_separate_samplers;
+    }
+
+    // Storage textures
+    result = spvc_resources_get_resource_list_for_type(
+        resources,
+        SPVC_RESOURCE_TYPE_STORAGE_IMAGE,
+        (const spvc_reflected_resource **)&reflected_resources,
+        &num_storage_textures);
+    if (result < 0) {
+        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+        return false;
+    }
+
+    for (size_t i = 0; i < num_storage_textures; i += 1) {
+        if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+            SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+            return false;
+        }
+
+        unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+
+        if (descriptor_set_index == 0) {
+            num_readonly_storage_textures += 1;
+        } else if (descriptor_set_index == 1) {
+            num_readwrite_storage_textures += 1;
+        } else {
+            SDL_SetError("%s", "Descriptor set index for compute storage texture must be 0 or 1!");
+            return false;
+        }
+    }
+
+    // If source is HLSL, readonly storage images might be marked as separate images
+    result = spvc_resources_get_resource_list_for_type(
+        resources,
+        SPVC_RESOURCE_TYPE_SEPARATE_IMAGE,
+        (const spvc_reflected_resource **)&reflected_resources,
+        &num_separate_images);
+    if (result < 0) {
+        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+        return false;
+    }
+
+    // The number of storage textures is the number of separate images minus the number of samplers.
+    num_storage_textures += (num_separate_images - num_separate_samplers);
+
+    for (size_t i = num_separate_samplers; i < num_separate_images; i += 1) {
+        if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+            SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+            return false;
+        }
+
+        unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+
+        if (descriptor_set_index == 0) {
+            num_readonly_storage_textures += 1;
+        } else if (descriptor_set_index == 1) {
+            num_readwrite_storage_textures += 1;
+        } else {
+            SDL_SetError("%s", "Descriptor set index for compute storage texture must be 0 or 1!");
+            return false;
+        }
+    }
+
+    // Storage buffers
+    result = spvc_resources_get_resource_list_for_type(
+        resources,
+        SPVC_RESOURCE_TYPE_STORAGE_BUFFER,
+        (const spvc_reflected_resource **)&reflected_resources,
+        &num_storage_buffers);
+    if (result < 0) {
+        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+        return false;
+    }
+
+    // Readonly storage buffers
+    for (size_t i = 0; i < num_storage_buffers; i += 1) {
+        if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+            SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+            return false;
+        }
+
+        unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+        if (!(descriptor_set_index == 0 || descriptor_set_index == 1)) {
+            SDL_SetError("%s", "Descriptor set index for compute storage buffer must be 0 or 1!");
+            return false;
+        }
+
+        if (descriptor_set_index == 0) {
+            num_readonly_storage_buffers += 1;
+        } else if (descriptor_set_index == 1) {
+            num_readwrite_storage_buffers += 1;
+        } else {
+            SDL_SetError("%s", "Descriptor set index for compute storage buffer must be 0 or 1!");
+            return false;
+        }
+    }
+
+    // Uniform buffers
+    result = spvc_resources_get_resource_list_for_type(
+        resources,
+        SPVC_RESOURCE_TYPE_UNIFORM_BUFFER,
+        (const spvc_reflected_resource **)&reflected_resources,
+        &num_uniform_buffers);
+    if (result < 0) {
+        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+        return false;
+    }
+
+    // Threadcount
+    metadata->threadcount_x = spvc_compiler_get_execution_mode_argument_by_index(compiler, SpvExecutionModeLocalSize, 0);
+    metadata->threadcount_y = spvc_compiler_get_execution_mode_argument_by_index(compiler, SpvExecutionModeLocalSize, 1);
+    metadata->threadcount_z = spvc_compiler_get_execution_mode_argument_by_index(compiler, SpvExecutionModeLocalSize, 2);
+
+    metadata->num_samplers = num_texture_samplers;
+    metadata->num_readonly_storage_textures = num_readonly_storage_textures;
+    metadata->num_readonly_storage_buffers = num_readonly_storage_buffers;
+    metadata->num_readwrite_storage_textures = num_readwrite_storage_textures;
+    metadata->num_readwrite_storage_buffers = num_readwrite_storage_buffers;
+    metadata->num_uniform_buffers = num_uniform_buffers;
+    return true;
+}
+
+// Parses the module into a reflection-only compiler. On success the caller must destroy the context.
+static bool SDL_ShaderCross_INTERNAL_CreateReflectionCompiler(
+    const Uint8 *code,
+    size_t codeSize,
+    spvc_context *pContext,
+    spvc_compiler *pCompiler,
+    spvc_resources *pResources
+) {
+    spvc_result result;
+    spvc_context context = NULL;
+    spvc_parsed_ir ir = NULL;
+
+    /* Create the SPIRV-Cross context */
+    result = spvc_context_create(&context);
+    if (result < 0) {
+        SDL_SetError("spvc_context_create failed: %X", result);
+        return false;
+    }
+
+    /* Parse the SPIR-V into IR */
+    Uint64 parseStart = SDL_ShaderCross_INTERNAL_BeginPhase(SDL_SHADERCROSS_PHASE_SPIRV_PARSE);
+    result = spvc_context_parse_spirv(context, (const SpvId *)code, codeSize / sizeof(SpvId), &ir);
+    SDL_ShaderCross_INTERNAL_EndPhase(SDL_SHADERCROSS_PHASE_SPIRV_PARSE, parseStart);
+    if (result < 0) {
+        SPVC_ERROR(spvc_context_parse_spirv);
+        spvc_context_destroy(context);
+        return false;
+    }
+
+    /* Create a reflection-only compiler */
+    result = spvc_context_create_compiler(context, SPVC_BACKEND_NONE, ir, SPVC_CAPTURE_MODE_TAKE_OWNERSHIP, pCompiler);
+    if (result < 0) {
+        SPVC_ERROR(spvc_context_create_compiler);
+        spvc_context_destroy(context);
+        return false;
+    }
+
+    result = spvc_compiler_create_shader_resources(*pCompiler, pResources);
+    if (result < 0) {
+        SPVC_ERROR(spvc_compiler_create_shader_resources);
+        spvc_context_destroy(context);
+        return false;
+    }
+
+    *pContext = context;
+    return true;
+}
+
+/* Transpiles already parsed IR. The context is owned by the returned
+ * transpile context, or destroyed on failure. With SPVC_CAPTURE_MODE_COPY
+ * the IR may belong to another context and be shared between threads.
+ */
+static SPIRVTranspileContext *SDL_ShaderCross_INTERNAL_TranspileFromParsedIR(
+    spvc_context context,
+    spvc_parsed_ir ir,
+    spvc_capture_mode captureMode,
+    spvc_backend backend,
+    unsigned shadermodel, // only used for HLSL
+    SDL_ShaderCross_ShaderStage shaderStage, // used for MSL and reflection
+    const char *entrypoint,
+    void *metadata // optional, filled in with reflected data for shaderStage
+) {
+    spvc_result result;
+    spvc_compiler compiler = NULL;
+    spvc_compiler_options options = NULL;
+    spvc_resources resources = NULL;
+    SPIRVTranspileContext *transpileContext = NULL;
+    const char *translated_source;
+    const char *cleansed_entrypoint;
+
+    /* Create the cross-compiler */
+    result = spvc_context_create_compiler(context, backend, ir, captureMode, &compiler);
+    if (result < 0) {
+        SPVC_ERROR(spvc_context_create_compiler);
+        spvc_context_destroy(context);
+        return NULL;
+    }
+
+    /* Set up the cross-compiler options */
+    result = spvc_compiler_create_compiler_options(compiler, &options);
+    if (result < 0) {
+        SPVC_ERROR(spvc_compiler_create_compiler_options);
+        spvc_context_destroy(context);
+        return NULL;
+    }
+
+    if (backend == SPVC_BACKEND_HLSL) {
+        spvc_compiler_options_set_uint(options, SPVC_COMPILER_OPTION_HLSL_SHADER_MODEL, shadermodel);
+        spvc_compiler_options_set_uint(options, SPVC_COMPILER_OPTION_HLSL_NONWRITABLE_UAV_TEXTURE_AS_SRV, 1);
+        spvc_compiler_options_set_uint(options, SPVC_COMPILER_OPTION_HLSL_FLATTEN_MATRIX_VERTEX_INPUT_SEMANTICS, 1);
+        spvc_compiler_options_set_bool(options, SPVC_COMPILER_OPTION_HLSL_USE_ENTRY_POINT_NAME, true);
+    }
+
+    // One resource list feeds both reflection and the MSL binding remap
+    if (backend == SPVC_BACKEND_MSL || metadata != NULL) {
+        result = spvc_compiler_create_shader_resources(compiler, &resources);
+        if (result < 0) {
+            SPVC_ERROR(spvc_compiler_create_shader_resources);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+    }
+
+    if (metadata != NULL) {
+        bool reflected;
+        Uint64 reflectStart = SDL_ShaderCross_INTERNAL_BeginPhase(SDL_SHADERCROSS_PHASE_REFLECTION);
+        if (shaderStage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+            reflected = SDL_ShaderCross_INTERNAL_ReflectCompute(
+                context,
+                compiler,
+                resources,
+                (SDL_ShaderCross_ComputePipelineMetadata *)metadata);
+        } else {
+            reflected = SDL_ShaderCross_INTERNAL_ReflectGraphics(
+                context,
+                resources,
+                (SDL_ShaderCross_GraphicsShaderMetadata *)metadata);
+        }
+        SDL_ShaderCross_INTERNAL_EndPhase(SDL_SHADERCROSS_PHASE_REFLECTION, reflectStart);
+        if (!reflected) {
+            spvc_context_destroy(context);
+            return NULL;
+        }
+    }
+
+    SpvExecutionModel executionModel;
+    if (shaderStage == SDL_SHADERCROSS_SHADERSTAGE_VERTEX) {
+        executionModel = SpvExecutionModelVertex;
+    } else if (shaderStage == SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT) {
+        executionModel = SpvExecutionModelFragment;
+    } else { // compute
+        executionModel = SpvExecutionModelKernel;
+    }
+
+    // MSL doesn't have descriptor sets, so we have to set up index remapping
+    if (backend == SPVC_BACKEND_MSL && shaderStage != SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+        spvc_reflected_resource *reflected_resources;
+        size_t num_texture_samplers;
+        size_t num_storage_textures;
+        size_t num_storage_buffers;
+        size_t num_uniform_buffers;
+        size_t num_separate_samplers = 0;
+        size_t num_separate_images = 0;
+        spvc_msl_resource_binding binding;
+        unsigned int num_textures = 0;
+        unsigned int num_buffers = 0;
+
+        // Combined texture-samplers
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_SAMPLED_IMAGE,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_texture_samplers);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+
+        // If source is HLSL, we might have separate images and samplers
+        if (num_texture_samplers == 0) {
+            result = spvc_resources_get_resource_list_for_type(
+                resources,
+                SPVC_RESOURCE_TYPE_SEPARATE_SAMPLERS,
+                (const spvc_reflected_resource **)&reflected_resources,
+                &num_separate_samplers);
+            if (result < 0) {
+                SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+                spvc_context_destroy(context);
+                return false;
+            }
+            num_texture_samplers = num_separate_samplers;
+        }
+
+        for (size_t i = 0; i < num_texture_samplers; i += 1) {
+            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+            if (!(descriptor_set_index == 0 || descriptor_set_index == 2)) {
+                SDL_SetError("%s", "Descriptor set index for graphics texture-sampler must be 0 or 2!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_texture = binding_index;
+            binding.msl_sampler = binding_index;
+            result = spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+            num_textures += 1;
+        }
+        num_textures += num_texture_samplers;
+
+        // Storage textures
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_STORAGE_IMAGE,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_storage_textures);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+
+        for (size_t i = 0; i < num_storage_textures; i += 1) {
+            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+            if (!(descriptor_set_index == 0 || descriptor_set_index == 2)) {
+                SDL_SetError("%s", "Descriptor set index for graphics storage texture must be 0 or 2!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_texture = num_textures + binding_index;
+            spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+        }
+        num_textures += num_storage_textures;
+
+        // If source is HLSL, storage images might be marked as separate images
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_SEPARATE_IMAGE,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_separate_images);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+
+        // We only want to iterate the images that don't have an associated sampler
+        for (size_t i = num_separate_samplers; i < num_separate_images; i += 1) {
+            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+            if (!(descriptor_set_index == 0 || descriptor_set_index == 2)) {
+                SDL_SetError("%s", "Descriptor set index for graphics storage texture must be 0 or 2!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_texture = num_textures + binding_index;
+            spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+        }
+        num_textures += (num_separate_images - num_separate_samplers);
+
+        // Storage buffers
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_STORAGE_BUFFER,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_storage_buffers);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+
+        for (size_t i = 0; i < num_storage_buffers; i += 1) {
+            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+            if (!(descriptor_set_index == 0 || descriptor_set_index == 2)) {
+                SDL_SetError("%s", "Descriptor set index for graphics storage buffer must be 0 or 2!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_buffer = binding_index;
+            spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+        }
+        num_buffers += num_storage_buffers;
+
+        // Uniform buffers
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_UNIFORM_BUFFER,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_uniform_buffers);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+
+        for (size_t i = 0; i < num_uniform_buffers; i += 1) {
+            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+            if (!(descriptor_set_index == 1 || descriptor_set_index == 3)) {
+                SDL_SetError("%s", "Descriptor set index for graphics uniform buffer must be 1 or 3!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_buffer = num_buffers + binding_index;
+            spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+        }
+        num_buffers += num_uniform_buffers;
+    }
+
+    if (backend == SPVC_BACKEND_MSL && shaderStage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+        spvc_reflected_resource *reflected_resources;
+        size_t num_texture_samplers;
+        size_t num_storage_textures; // total storage textures
+        size_t num_storage_buffers; // total storage buffers
+        size_t num_uniform_buffers;
+        size_t num_separate_samplers = 0;
+        size_t num_separate_images = 0;
+        spvc_msl_resource_binding binding;
+        unsigned int num_textures = 0;
+        unsigned int num_buffers = 0;
+
+        // Combined texture-samplers
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_SAMPLED_IMAGE,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_texture_samplers);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+
+        // If source is HLSL, we might have separate images and samplers
+        if (num_texture_samplers == 0) {
+            result = spvc_resources_get_resource_list_for_type(
+                resources,
+                SPVC_RESOURCE_TYPE_SEPARATE_SAMPLERS,
+                (const spvc_reflected_resource **)&reflected_resources,
+                &num_separate_samplers);
+            if (result < 0) {
+                SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+                spvc_context_destroy(context);
+                return false;
+            }
+            num_texture_samplers = num_separate_samplers;
+        }
+
+        for (size_t i = 0; i < num_texture_samplers; i += 1) {
+            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+            if (descriptor_set_index != 0) {
+                SDL_SetError("%s", "Descriptor set index for compute texture-sampler must be 0!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_texture = binding_index;
+            binding.msl_sampler = binding_index;
+            result = spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+        }
+        num_textures += num_texture_samplers;
+
+        // Readonly storage textures
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_STORAGE_IMAGE,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_storage_textures);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+
+        size_t current_num_textures = num_textures;
+        for (size_t i = 0; i < num_storage_textures; i += 1) {
+            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+            if (!(descriptor_set_index == 0 || descriptor_set_index == 1)) {
+                SDL_SetError("%s", "Descriptor set index for compute storage texture must be 0 or 1!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            // Skip readwrite textures
+            if (descriptor_set_index != 0) { continue; }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_texture = current_num_textures + binding_index;
+            spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+            num_textures += 1;
+        }
+
+        // If source is HLSL, storage images might be marked as separate images
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_SEPARATE_IMAGE,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_separate_images);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+
+        // We only want to iterate the images that don't have an associated sampler
+        current_num_textures = num_textures;
+        for (size_t i = num_separate_samplers; i < num_separate_images; i += 1) {
+            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+            if (!(descriptor_set_index == 0 || descriptor_set_index == 1)) {
+                SDL_SetError("%s", "Descriptor set index for compute storage texture must be 0 or 1!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            // Skip readwrite textures
+            if (descriptor_set_index != 0) { continue; }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_texture = current_num_textures + binding_index;
+            spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+            num_textures += 1;
+        }
+
+        // Readwrite storage textures
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_STORAGE_IMAGE,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_storage_textures);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+
+        current_num_textures = num_textures;
+        for (size_t i = 0; i < num_storage_textures; i += 1) {
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+
+            // Skip readonly textures
+            if (descriptor_set_index != 1) { continue; }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_texture = current_num_textures + binding_index;
+            spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+            num_textures += 1;
+        }
+
+        // If source is HLSL, storage images might be marked as separate images
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_SEPARATE_IMAGE,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_separate_images);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+
+        // We only want to iterate the images that don't have an associated sampler
+        current_num_textures = num_textures;
+        for (size_t i = num_separate_samplers; i < num_separate_images; i += 1) {
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+
+            // Skip readonly textures
+            if (descriptor_set_index != 1) { continue; }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_texture = current_num_textures + binding_index;
+            spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+            num_textures += 1;
+        }
+
+        // Storage buffers
+        result = spvc_resources_get_resource_list_for_type(
+            resources,
+            SPVC_RESOURCE_TYPE_STORAGE_BUFFER,
+            (const spvc_reflected_resource **)&reflected_resources,
+            &num_storage_buffers);
+        if (result < 0) {
+            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
+            spvc_context_destroy(context);
+            return NULL;
+        }
+
+        // Readonly storage buffers
+        for (size_t i = 0; i < num_storage_buffers; i += 1) {
+            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+            if (!(descriptor_set_index == 0 || descriptor_set_index == 1)) {
+                SDL_SetError("%s", "Descriptor set index for compute storage buffer must be 0 or 1!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            // Skip readwrite buffers
+            if (descriptor_set_index != 0) { continue; }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_buffer = binding_index;
+            spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            num_buffers += 1;
+        }
+
+        // Readwrite storage buffers
+        size_t current_num_buffers = num_buffers;
+        for (size_t i = 0; i < num_storage_buffers; i += 1) {
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+
+            // Skip readonly buffers
+            if (descriptor_set_index != 1) { continue; }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_buffer = current_num_buffers + binding_index;
+            spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            num_buffers += 1;
+        }
+
+        // Uniform buffers
+        result = spvc_resources_get_resource_list_for_type(
             resources,
             SPVC_RESOURCE_TYPE_UNIFORM_BUFFER,
             (const spvc_reflected_resource **)&reflected_resources,
@@ -1166,1117 +5487,2489 @@ static SPIRVTranspileContext *SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
             return NULL;
         }
 
-        for (size_t i = 0; i < num_uniform_buffers; i += 1) {
-            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+        for (size_t i = 0; i < num_uniform_buffers; i += 1) {
+            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
+                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+            if (descriptor_set_index != 2) {
+                SDL_SetError("%s", "Descriptor set index for compute uniform buffer must be 2!");
+                spvc_context_destroy(context);
+                return NULL;
+            }
+
+            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+
+            binding.stage = executionModel;
+            binding.desc_set = descriptor_set_index;
+            binding.binding = binding_index;
+            binding.msl_buffer = num_buffers + binding_index;
+            spvc_compiler_msl_add_resource_binding(compiler, &binding);
+            if (result < 0) {
+                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
+                spvc_context_destroy(context);
+                return NULL;
+            }
+        }
+        num_buffers += num_uniform_buffers;
+    }
+
+    result = spvc_compiler_install_compiler_options(compiler, options);
+    if (result < 0) {
+        SPVC_ERROR(spvc_compiler_install_compiler_options);
+        spvc_context_destroy(context);
+        return NULL;
+    }
+
+    /* Compile to the target shader language */
+    Uint64 codegenStart = SDL_ShaderCross_INTERNAL_BeginPhase(SDL_SHADERCROSS_PHASE_CODEGEN);
+    result = spvc_compiler_compile(compiler, &translated_source);
+    SDL_ShaderCross_INTERNAL_EndPhase(SDL_SHADERCROSS_PHASE_CODEGEN, codegenStart);
+    if (result < 0) {
+        SPVC_ERROR(spvc_compiler_compile);
+        spvc_context_destroy(context);
+        return NULL;
+    }
+
+    if (backend == SPVC_BACKEND_MSL) {
+        // Metal doesn't allow a "main" entrypoint, so determine the "cleansed" entrypoint name (e.g. main -> main0 on MSL)
+        cleansed_entrypoint = spvc_compiler_get_cleansed_entry_point_name(
+            compiler,
+            entrypoint,
+            spvc_compiler_get_execution_model(compiler));
+    } else {
+        cleansed_entrypoint = entrypoint;
+    }
+
+    transpileContext = SDL_malloc(sizeof(SPIRVTranspileContext));
+    transpileContext->context = context;
+    transpileContext->cleansed_entrypoint = cleansed_entrypoint;
+    transpileContext->translated_source = translated_source;
+    return transpileContext;
+}
+
+static SPIRVTranspileContext *SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
+    spvc_backend backend,
+    unsigned shadermodel, // only used for HLSL
+    SDL_ShaderCross_ShaderStage shaderStage, // used for MSL and reflection
+    const Uint8 *code,
+    size_t codeSize,
+    const char *entrypoint,
+    void *metadata // optional, filled in with reflected data for shaderStage
+) {
+    spvc_result result;
+    spvc_context context = NULL;
+    spvc_parsed_ir ir = NULL;
+
+    /* Create the SPIRV-Cross context */
+    result = spvc_context_create(&context);
+    if (result < 0) {
+        SDL_SetError("spvc_context_create failed: %X", result);
+        return NULL;
+    }
+
+    /* Parse the SPIR-V into IR */
+    Uint64 parseStart = SDL_ShaderCross_INTERNAL_BeginPhase(SDL_SHADERCROSS_PHASE_SPIRV_PARSE);
+    result = spvc_context_parse_spirv(context, (const SpvId *)code, codeSize / sizeof(SpvId), &ir);
+    SDL_ShaderCross_INTERNAL_EndPhase(SDL_SHADERCROSS_PHASE_SPIRV_PARSE, parseStart);
+    if (result < 0) {
+        SPVC_ERROR(spvc_context_parse_spirv);
+        spvc_context_destroy(context);
+        return NULL;
+    }
+
+    return SDL_ShaderCross_INTERNAL_TranspileFromParsedIR(
+        context,
+        ir,
+        SPVC_CAPTURE_MODE_TAKE_OWNERSHIP,
+        backend,
+        shadermodel,
+        shaderStage,
+        entrypoint,
+        metadata);
+}
+
+// Acquire metadata from SPIRV bytecode.
+// TODO: validate descriptor sets
+static bool SDL_ShaderCross_INTERNAL_ReflectGraphicsSPIRV(
+    const Uint8 *code,
+    size_t codeSize,
+    SDL_ShaderCross_GraphicsShaderMetadata *metadata)
+{
+    spvc_context context;
+    spvc_compiler compiler;
+    spvc_resources resources;
+
+    if (!SDL_ShaderCross_INTERNAL_CreateReflectionCompiler(code, codeSize, &context, &compiler, &resources)) {
+        return false;
+    }
+
+    Uint64 reflectStart = SDL_ShaderCross_INTERNAL_BeginPhase(SDL_SHADERCROSS_PHASE_REFLECTION);
+    bool success = SDL_ShaderCross_INTERNAL_ReflectGraphics(context, resources, metadata);
+    SDL_ShaderCross_INTERNAL_EndPhase(SDL_SHADERCROSS_PHASE_REFLECTION, reflectStart);
+    spvc_context_destroy(context);
+    return success;
+}
+
+static bool SDL_ShaderCross_INTERNAL_ReflectComputeSPIRV(
+    const Uint8 *bytecode,
+    size_t bytecodeSize,
+    SDL_ShaderCross_ComputePipelineMetadata *metadata)
+{
+    spvc_context context;
+    spvc_compiler compiler;
+    spvc_resources resources;
+
+    if (!SDL_ShaderCross_INTERNAL_CreateReflectionCompiler(bytecode, bytecodeSize, &context, &compiler, &resources)) {
+        return false;
+    }
+
+    Uint64 reflectStart = SDL_ShaderCross_INTERNAL_BeginPhase(SDL_SHADERCROSS_PHASE_REFLECTION);
+    bool success = SDL_ShaderCross_INTERNAL_ReflectCompute(context, compiler, resources, metadata);
+    SDL_ShaderCross_INTERNAL_EndPhase(SDL_SHADERCROSS_PHASE_REFLECTION, reflectStart);
+    spvc_context_destroy(context);
+    return success;
+}
+
+bool SDL_ShaderCross_ReflectGraphicsSPIRV(
+    const Uint8 *code,
+    size_t codeSize,
+    SDL_ShaderCross_GraphicsShaderMetadata *metadata // filled in with reflected data
+) {
+    SDL_ShaderCross_SPIRV_Info info;
+    SDL_zero(info);
+    info.bytecode = code;
+    info.bytecode_size = codeSize;
+
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginSPIRVCapture(&capture, CAPTURE_REFLECT_GRAPHICS_SPIRV, &info);
+    bool success = SDL_ShaderCross_INTERNAL_ReflectGraphicsSPIRV(code, codeSize, metadata);
+    SDL_ShaderCross_INTERNAL_EndCapture(&capture, success, success ? sizeof(*metadata) : 0);
+    return success;
+}
+
+bool SDL_ShaderCross_ReflectComputeSPIRV(
+    const Uint8 *bytecode,
+    size_t bytecodeSize,
+    SDL_ShaderCross_ComputePipelineMetadata *metadata // filled in with reflected data
+) {
+    SDL_ShaderCross_SPIRV_Info info;
+    SDL_zero(info);
+    info.bytecode = bytecode;
+    info.bytecode_size = bytecodeSize;
+
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginSPIRVCapture(&capture, CAPTURE_REFLECT_COMPUTE_SPIRV, &info);
+    bool success = SDL_ShaderCross_INTERNAL_ReflectComputeSPIRV(bytecode, bytecodeSize, metadata);
+    SDL_ShaderCross_INTERNAL_EndCapture(&capture, success, success ? sizeof(*metadata) : 0);
+    return success;
+}
+
+/* Shaders for a device are compiled into a single blob holding the reflection
+ * metadata, the NUL-terminated entrypoint and the shader code, in that order,
+ * so that the result cache can hold everything needed to create the object.
+ */
+static size_t SDL_ShaderCross_INTERNAL_GetMetadataSize(SDL_ShaderCross_ShaderStage shaderStage)
+{
+    if (shaderStage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+        return sizeof(SDL_ShaderCross_ComputePipelineMetadata);
+    }
+    return sizeof(SDL_ShaderCross_GraphicsShaderMetadata);
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileShaderForDevice(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_GPUShaderFormat targetFormat)
+{
+    union
+    {
+        SDL_ShaderCross_GraphicsShaderMetadata graphics;
+        SDL_ShaderCross_ComputePipelineMetadata compute;
+    } metadata;
+    size_t metadataSize = SDL_ShaderCross_INTERNAL_GetMetadataSize(info->shader_stage);
+    SPIRVTranspileContext *transpileContext = NULL;
+    SDL_ShaderCross_Blob *bytecode = NULL;
+    const char *entrypoint;
+    const void *code;
+    size_t codeSize;
+
+    SDL_zero(metadata);
+
+    if (targetFormat == SDL_GPU_SHADERFORMAT_SPIRV) {
+        bool reflected;
+        if (info->shader_stage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+            reflected = SDL_ShaderCross_INTERNAL_ReflectComputeSPIRV(info->bytecode, info->bytecode_size, &metadata.compute);
+        } else {
+            reflected = SDL_ShaderCross_INTERNAL_ReflectGraphicsSPIRV(info->bytecode, info->bytecode_size, &metadata.graphics);
+        }
+        if (!reflected) {
+            return NULL;
+        }
+
+        entrypoint = info->entrypoint;
+        code = info->bytecode;
+        codeSize = info->bytecode_size;
+    } else {
+        spvc_backend backend;
+        unsigned shadermodel = 0;
+
+        if (targetFormat == SDL_GPU_SHADERFORMAT_DXBC || targetFormat == SDL_GPU_SHADERFORMAT_DXIL) {
+            backend = SPVC_BACKEND_HLSL;
+            shadermodel = SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, targetFormat);
+        } else if (targetFormat == SDL_GPU_SHADERFORMAT_MSL) {
+            backend = SPVC_BACKEND_MSL;
+        } else {
+            SDL_SetError("SDL_ShaderCross_INTERNAL_CompileShaderForDevice: Unexpected SDL_GPUBackend");
+            return NULL;
+        }
+
+        transpileContext = SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
+            backend,
+            shadermodel,
+            info->shader_stage,
+            info->bytecode,
+            info->bytecode_size,
+            info->entrypoint,
+            &metadata);
+
+        if (transpileContext == NULL) {
+            return NULL;
+        }
+
+        entrypoint = transpileContext->cleansed_entrypoint;
+
+        if (targetFormat == SDL_GPU_SHADERFORMAT_MSL) {
+            code = transpileContext->translated_source;
+            codeSize = SDL_strlen(transpileContext->translated_source) + 1;
+        } else {
+            SDL_ShaderCross_HLSL_Info hlslInfo;
+            hlslInfo.source = transpileContext->translated_source;
+            hlslInfo.entrypoint = transpileContext->cleansed_entrypoint;
+            hlslInfo.include_dir = NULL;
+            hlslInfo.defines = NULL;
+            hlslInfo.enable_debug = info->enable_debug;
+            hlslInfo.shader_stage = info->shader_stage;
+            hlslInfo.name = info->name;
+            hlslInfo.props = info->props;
+
+            if (targetFormat == SDL_GPU_SHADERFORMAT_DXBC) {
+                bytecode = SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSL(
+                    &hlslInfo,
+                    SDL_strlen(hlslInfo.source),
+                    NULL,
+                    NULL);
+            } else {
+                bytecode = SDL_ShaderCross_INTERNAL_CompileDXILFromHLSLSource(
+                    &hlslInfo,
+                    SDL_strlen(hlslInfo.source));
+            }
+
+            if (bytecode == NULL) {
+                SDL_ShaderCross_INTERNAL_DestroyTranspileContext(transpileContext);
+                return NULL;
+            }
+            code = bytecode->data;
+            codeSize = bytecode->size;
+        }
+    }
+
+    size_t entrypointSize = SDL_strlen(entrypoint) + 1;
+    size_t size = metadataSize + entrypointSize + codeSize;
+    Uint8 *buffer = SDL_malloc(size);
+    if (buffer != NULL) {
+        SDL_memcpy(buffer, &metadata, metadataSize);
+        SDL_memcpy(buffer + metadataSize, entrypoint, entrypointSize);
+        SDL_memcpy(buffer + metadataSize + entrypointSize, code, codeSize);
+    }
+
+    SDL_ShaderCross_ReleaseBlob(bytecode);
+    if (transpileContext != NULL) {
+        SDL_ShaderCross_INTERNAL_DestroyTranspileContext(transpileContext);
+    }
+
+    if (buffer == NULL) {
+        return NULL;
+    }
+    return SDL_ShaderCross_INTERNAL_CreateBlob(
+        buffer,
+        size,
+        buffer,
+        SDL_ShaderCross_INTERNAL_ReleaseMemory);
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_TranspileMSLFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info)
+{
+    CacheRequest cache;
+    SDL_ShaderCross_Blob *result = SDL_ShaderCross_INTERNAL_BeginSPIRVCache(
+        &cache,
+        info,
+        SDL_GPU_SHADERFORMAT_MSL,
+        0,
+        false);
+    if (result != NULL) {
+        return result;
+    }
+
+    SPIRVTranspileContext *context = SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
+        SPVC_BACKEND_MSL,
+        0,
+        info->shader_stage,
+        info->bytecode,
+        info->bytecode_size,
+        info->entrypoint,
+        NULL
+    );
+
+    return SDL_ShaderCross_INTERNAL_EndCache(
+        &cache,
+        SDL_ShaderCross_INTERNAL_CreateBlobFromTranspileContext(context));
+}
+
+SDL_ShaderCross_Blob *SDL_ShaderCross_TranspileMSLFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info)
+{
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginSPIRVCapture(&capture, CAPTURE_TRANSPILE_MSL_FROM_SPIRV, info);
+    return SDL_ShaderCross_INTERNAL_EndBlobCapture(
+        &capture,
+        SDL_ShaderCross_INTERNAL_TranspileMSLFromSPIRVToBlob(info));
+}
+
+void *SDL_ShaderCross_TranspileMSLFromSPIRV(
+    const SDL_ShaderCross_SPIRV_Info *info)
+{
+    return SDL_ShaderCross_INTERNAL_CopyBlobString(
+        SDL_ShaderCross_TranspileMSLFromSPIRVToBlob(info));
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_TranspileHLSLFromSPIRV(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    Uint32 shaderModel)
+{
+    SPIRVTranspileContext *context = SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
+        SPVC_BACKEND_HLSL,
+        shaderModel,
+        info->shader_stage,
+        info->bytecode,
+        info->bytecode_size,
+        info->entrypoint,
+        NULL
+    );
+
+    return SDL_ShaderCross_INTERNAL_CreateBlobFromTranspileContext(context);
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_TranspileHLSLFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info)
+{
+    if (!SDL_ShaderCross_INTERNAL_CheckShaderModel(info->props, 0)) {
+        return NULL;
+    }
+
+    Uint32 shaderModel = SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, SDL_GPU_SHADERFORMAT_DXIL);
+    CacheRequest cache;
+
+    SDL_ShaderCross_Blob *result = SDL_ShaderCross_INTERNAL_BeginSPIRVCache(
+        &cache,
+        info,
+        0,
+        shaderModel,
+        false);
+
+    if (result == NULL) {
+        result = SDL_ShaderCross_INTERNAL_EndCache(
+            &cache,
+            SDL_ShaderCross_INTERNAL_TranspileHLSLFromSPIRV(info, shaderModel));
+    }
+    return result;
+}
+
+SDL_ShaderCross_Blob *SDL_ShaderCross_TranspileHLSLFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info)
+{
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginSPIRVCapture(&capture, CAPTURE_TRANSPILE_HLSL_FROM_SPIRV, info);
+    return SDL_ShaderCross_INTERNAL_EndBlobCapture(
+        &capture,
+        SDL_ShaderCross_INTERNAL_TranspileHLSLFromSPIRVToBlob(info));
+}
+
+void *SDL_ShaderCross_TranspileHLSLFromSPIRV(
+    const SDL_ShaderCross_SPIRV_Info *info)
+{
+    return SDL_ShaderCross_INTERNAL_CopyBlobString(
+        SDL_ShaderCross_TranspileHLSLFromSPIRVToBlob(info));
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileDXBCFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info)
+{
+    Uint32 shaderModel = SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, SDL_GPU_SHADERFORMAT_DXBC);
+    CacheRequest cache;
+    SDL_ShaderCross_Blob *result = SDL_ShaderCross_INTERNAL_BeginSPIRVCache(
+        &cache,
+        info,
+        SDL_GPU_SHADERFORMAT_DXBC,
+        shaderModel,
+        false);
+    if (result != NULL) {
+        return result;
+    }
+
+    SPIRVTranspileContext *context = SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
+        SPVC_BACKEND_HLSL,
+        shaderModel,
+        info->shader_stage,
+        info->bytecode,
+        info->bytecode_size,
+        info->entrypoint,
+        NULL);
+
+    if (context == NULL) {
+        return SDL_ShaderCross_INTERNAL_EndCache(&cache, NULL);
+    }
+
+    SDL_ShaderCross_HLSL_Info hlslInfo;
+    hlslInfo.source = context->translated_source;
+    hlslInfo.entrypoint = context->cleansed_entrypoint;
+    hlslInfo.include_dir = NULL;
+    hlslInfo.defines = NULL;
+    hlslInfo.shader_stage = info->shader_stage;
+    hlslInfo.enable_debug = info->enable_debug;
+    hlslInfo.name = info->name;
+    hlslInfo.props = info->props;
+
+    result = SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSL(
+        &hlslInfo,
+        SDL_strlen(hlslInfo.source),
+        NULL,
+        NULL);
+
+    SDL_ShaderCross_INTERNAL_DestroyTranspileContext(context);
+    return SDL_ShaderCross_INTERNAL_EndCache(&cache, result);
+}
+
+SDL_ShaderCross_Blob *SDL_ShaderCross_CompileDXBCFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info)
+{
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginSPIRVCapture(&capture, CAPTURE_COMPILE_DXBC_FROM_SPIRV, info);
+    return SDL_ShaderCross_INTERNAL_EndBlobCapture(
+        &capture,
+        SDL_ShaderCross_INTERNAL_CompileDXBCFromSPIRVToBlob(info));
+}
+
+void *SDL_ShaderCross_CompileDXBCFromSPIRV(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    size_t *size)
+{
+    return SDL_ShaderCross_INTERNAL_CopyBlob(
+        SDL_ShaderCross_CompileDXBCFromSPIRVToBlob(info),
+        size);
+}
+
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileDXILFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info)
+{
+#ifndef SDL_SHADERCROSS_DXC
+    SDL_SetError("%s", "Shadercross was not compiled with DXC support, cannot compile to SPIR-V!");
+    return NULL;
+#endif
+
+    // Checked before transpiling, rather than once DXC gets the HLSL
+    if (!SDL_ShaderCross_INTERNAL_CheckShaderModel(info->props, SDL_GPU_SHADERFORMAT_DXIL)) {
+        return NULL;
+    }
+
+    Uint32 shaderModel = SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, SDL_GPU_SHADERFORMAT_DXIL);
+    CacheRequest cache;
+    SDL_ShaderCross_Blob *result = SDL_ShaderCross_INTERNAL_BeginSPIRVCache(
+        &cache,
+        info,
+        SDL_GPU_SHADERFORMAT_DXIL,
+        shaderModel,
+        false);
+    if (result != NULL) {
+        return result;
+    }
+
+    SPIRVTranspileContext *context = SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
+        SPVC_BACKEND_HLSL,
+        shaderModel,
+        info->shader_stage,
+        info->bytecode,
+        info->bytecode_size,
+        info->entrypoint,
+        NULL);
+
+    if (context == NULL) {
+        return SDL_ShaderCross_INTERNAL_EndCache(&cache, NULL);
+    }
+
+    SDL_ShaderCross_HLSL_Info hlslInfo;
+    hlslInfo.source = context->translated_source;
+    hlslInfo.entrypoint = context->cleansed_entrypoint;
+    hlslInfo.include_dir = NULL;
+    hlslInfo.defines = NULL;
+    hlslInfo.shader_stage = info->shader_stage;
+    hlslInfo.enable_debug = info->enable_debug;
+    hlslInfo.name = info->name;
+    hlslInfo.props = info->props;
+
+    result = SDL_ShaderCross_INTERNAL_CompileDXILFromHLSLSource(
+        &hlslInfo,
+        SDL_strlen(hlslInfo.source));
+
+    SDL_ShaderCross_INTERNAL_DestroyTranspileContext(context);
+    return SDL_ShaderCross_INTERNAL_EndCache(&cache, result);
+}
+
+SDL_ShaderCross_Blob *SDL_ShaderCross_CompileDXILFromSPIRVToBlob(
+    const SDL_ShaderCross_SPIRV_Info *info)
+{
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginSPIRVCapture(&capture, CAPTURE_COMPILE_DXIL_FROM_SPIRV, info);
+    return SDL_ShaderCross_INTERNAL_EndBlobCapture(
+        &capture,
+        SDL_ShaderCross_INTERNAL_CompileDXILFromSPIRVToBlob(info));
+}
+
+void *SDL_ShaderCross_CompileDXILFromSPIRV(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    size_t *size)
+{
+    return SDL_ShaderCross_INTERNAL_CopyBlob(
+        SDL_ShaderCross_CompileDXILFromSPIRVToBlob(info),
+        size);
+}
+
+/* Multi-Target Compilation */
+
+typedef struct MultiTargetJob
+{
+    const SDL_ShaderCross_SPIRV_Info *info;
+    spvc_parsed_ir ir; /* Shared, read-only, every job copies it into its own context */
+    SDL_GPUShaderFormat format;
+    SDL_ShaderCross_Blob *source; /* Transpiled source */
+    SDL_ShaderCross_Blob *bytecode; /* DXBC or DXIL */
+    char *entrypoint;
+    char *error;
+} MultiTargetJob;
+
+static void SDL_ShaderCross_INTERNAL_RunMultiTargetJob(void *data)
+{
+    MultiTargetJob *job = (MultiTargetJob *)data;
+    const SDL_ShaderCross_SPIRV_Info *info = job->info;
+    spvc_context context = NULL;
+    spvc_result result;
+
+    result = spvc_context_create(&context);
+    if (result < 0) {
+        SDL_SetError("spvc_context_create failed: %X", result);
+        job->error = SDL_strdup(SDL_GetError());
+        return;
+    }
+
+    SPIRVTranspileContext *transpileContext = SDL_ShaderCross_INTERNAL_TranspileFromParsedIR(
+        context,
+        job->ir,
+        SPVC_CAPTURE_MODE_COPY,
+        job->format == SDL_GPU_SHADERFORMAT_MSL ? SPVC_BACKEND_MSL : SPVC_BACKEND_HLSL,
+        SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, job->format),
+        info->shader_stage,
+        info->entrypoint,
+        NULL);
+
+    if (transpileContext == NULL) {
+        job->error = SDL_strdup(SDL_GetError());
+        return;
+    }
+
+    job->entrypoint = SDL_strdup(transpileContext->cleansed_entrypoint);
+    job->source = SDL_ShaderCross_INTERNAL_CreateBlobFromTranspileContext(transpileContext);
+    if (job->source == NULL || job->entrypoint == NULL) {
+        job->error = SDL_strdup(SDL_GetError());
+        return;
+    }
+
+    if (job->format != SDL_GPU_SHADERFORMAT_MSL) {
+        SDL_ShaderCross_HLSL_Info hlslInfo;
+        hlslInfo.source = (const char *)job->source->data;
+        hlslInfo.entrypoint = job->entrypoint;
+        hlslInfo.include_dir = NULL;
+        hlslInfo.defines = NULL;
+        hlslInfo.shader_stage = info->shader_stage;
+        hlslInfo.enable_debug = info->enable_debug;
+        hlslInfo.name = info->name;
+        hlslInfo.props = info->props;
+
+        if (job->format == SDL_GPU_SHADERFORMAT_DXBC) {
+            job->bytecode = SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSL(
+                &hlslInfo,
+                job->source->size,
+                NULL,
+                NULL);
+        } else {
+            job->bytecode = SDL_ShaderCross_INTERNAL_CompileDXILFromHLSLSource(
+                &hlslInfo,
+                job->source->size);
+        }
+
+        if (job->bytecode == NULL) {
+            job->error = SDL_strdup(SDL_GetError());
+            return;
+        }
+    }
+}
 
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
-            if (!(descriptor_set_index == 1 || descriptor_set_index == 3)) {
-                SDL_SetError("%s", "Descriptor set index for graphics uniform buffer must be 1 or 3!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+static bool SDL_ShaderCross_INTERNAL_CompileMultiTarget(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_GPUShaderFormat targets,
+    SDL_ShaderCross_MultiTargetResult *results)
+{
+    static const SDL_GPUShaderFormat supportedFormats[] = {
+        SDL_GPU_SHADERFORMAT_MSL,
+        SDL_GPU_SHADERFORMAT_DXBC,
+        SDL_GPU_SHADERFORMAT_DXIL
+    };
+    MultiTargetJob jobs[SDL_arraysize(supportedFormats)];
+    SDL_ShaderCross_Job *tasks[SDL_arraysize(supportedFormats)];
+    int numJobs = 0;
+    spvc_result result;
+    spvc_context context = NULL;
+    spvc_parsed_ir ir = NULL;
+    spvc_compiler compiler = NULL;
+    spvc_resources resources = NULL;
+    bool success;
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+    SDL_zerop(results);
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_buffer = num_buffers + binding_index;
-            spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
-            }
-        }
-        num_buffers += num_uniform_buffers;
+    if (targets & ~(SDL_GPU_SHADERFORMAT_MSL | SDL_GPU_SHADERFORMAT_DXBC | SDL_GPU_SHADERFORMAT_DXIL)) {
+        SDL_SetError("%s", "Only MSL, DXBC and DXIL targets are supported!");
+        return false;
     }
 
-    if (backend == SPVC_BACKEND_MSL && shaderStage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
-        spvc_resources resources;
-        spvc_reflected_resource *reflected_resources;
-        size_t num_texture_samplers;
-        size_t num_storage_textures; // total storage textures
-        size_t num_storage_buffers; // total storage buffers
-        size_t num_uniform_buffers;
-        size_t num_separate_samplers = 0;
-        size_t num_separate_images = 0;
-        spvc_msl_resource_binding binding;
-        unsigned int num_textures = 0;
-        unsigned int num_buffers = 0;
+    /* Parse the SPIR-V into IR, once for every target */
+    result = spvc_context_create(&context);
+    if (result < 0) {
+        SDL_SetError("spvc_context_create failed: %X", result);
+        return false;
+    }
 
-        result = spvc_compiler_create_shader_resources(compiler, &resources);
-        if (result < 0) {
-            SPVC_ERROR(spvc_compiler_create_shader_resources);
-            spvc_context_destroy(context);
-            return NULL;
+    Uint64 parseStart = SDL_ShaderCross_INTERNAL_BeginPhase(SDL_SHADERCROSS_PHASE_SPIRV_PARSE);
+    result = spvc_context_parse_spirv(context, (const SpvId *)info->bytecode, info->bytecode_size / sizeof(SpvId), &ir);
+    SDL_ShaderCross_INTERNAL_EndPhase(SDL_SHADERCROSS_PHASE_SPIRV_PARSE, parseStart);
+    if (result < 0) {
+        SPVC_ERROR(spvc_context_parse_spirv);
+        spvc_context_destroy(context);
+        return false;
+    }
+
+    /* Reflect before the backends start, the context is not thread-safe */
+    result = spvc_context_create_compiler(context, SPVC_BACKEND_NONE, ir, SPVC_CAPTURE_MODE_COPY, &compiler);
+    if (result < 0) {
+        SPVC_ERROR(spvc_context_create_compiler);
+        spvc_context_destroy(context);
+        return false;
+    }
+
+    result = spvc_compiler_create_shader_resources(compiler, &resources);
+    if (result < 0) {
+        SPVC_ERROR(spvc_compiler_create_shader_resources);
+        spvc_context_destroy(context);
+        return false;
+    }
+
+    Uint64 reflectStart = SDL_ShaderCross_INTERNAL_BeginPhase(SDL_SHADERCROSS_PHASE_REFLECTION);
+    if (info->shader_stage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+        success = SDL_ShaderCross_INTERNAL_ReflectCompute(context, compiler, resources, &results->compute_metadata);
+    } else {
+        success = SDL_ShaderCross_INTERNAL_ReflectGraphics(context, resources, &results->graphics_metadata);
+    }
+    SDL_ShaderCross_INTERNAL_EndPhase(SDL_SHADERCROSS_PHASE_REFLECTION, reflectStart);
+    if (!success) {
+        spvc_context_destroy(context);
+        return false;
+    }
+
+    for (size_t i = 0; i < SDL_arraysize(supportedFormats); i += 1) {
+        if (targets & supportedFormats[i]) {
+            SDL_zero(jobs[numJobs]);
+            jobs[numJobs].info = info;
+            jobs[numJobs].ir = ir;
+            jobs[numJobs].format = supportedFormats[i];
+            numJobs += 1;
         }
+    }
 
-        // Combined texture-samplers
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_SAMPLED_IMAGE,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_texture_samplers);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return NULL;
+    /* Run the backends in parallel on the pool, the calling thread takes the last one */
+    for (int i = 0; i < numJobs - 1; i += 1) {
+        tasks[i] = SDL_ShaderCross_INTERNAL_StartTask(SDL_ShaderCross_INTERNAL_RunMultiTargetJob, &jobs[i]);
+        if (tasks[i] == NULL) {
+            SDL_ShaderCross_INTERNAL_RunMultiTargetJob(&jobs[i]);
         }
+    }
+    if (numJobs > 0) {
+        SDL_ShaderCross_INTERNAL_RunMultiTargetJob(&jobs[numJobs - 1]);
+    }
+    for (int i = 0; i < numJobs - 1; i += 1) {
+        if (tasks[i] != NULL) {
+            SDL_ShaderCross_INTERNAL_FinishTask(tasks[i]);
+        }
+    }
 
-        // If source is HLSL, we might have separate images and samplers
-        if (num_texture_samplers == 0) {
-            result = spvc_resources_get_resource_list_for_type(
-                resources,
-                SPVC_RESOURCE_TYPE_SEPARATE_SAMPLERS,
-                (const spvc_reflected_resource **)&reflected_resources,
-                &num_separate_samplers);
-            if (result < 0) {
-                SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-                spvc_context_destroy(context);
-                return false;
-            }
-            num_texture_samplers = num_separate_samplers;
+    spvc_context_destroy(context);
+
+    for (int i = 0; i < numJobs; i += 1) {
+        MultiTargetJob *job = &jobs[i];
+        if (job->error != NULL && results->error == NULL) {
+            results->error = job->error;
+        } else {
+            SDL_free(job->error);
         }
 
-        for (size_t i = 0; i < num_texture_samplers; i += 1) {
-            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+        if (job->format == SDL_GPU_SHADERFORMAT_MSL) {
+            results->msl = job->source;
+            results->msl_entrypoint = job->entrypoint;
+        } else if (job->format == SDL_GPU_SHADERFORMAT_DXBC) {
+            // The SM 5.1 HLSL is an intermediate, only the SM 6 one is returned
+            SDL_ShaderCross_ReleaseBlob(job->source);
+            SDL_free(job->entrypoint);
+            results->dxbc = job->bytecode;
+        } else {
+            results->hlsl = job->source;
+            SDL_free(job->entrypoint);
+            results->dxil = job->bytecode;
+        }
+    }
 
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
-            if (descriptor_set_index != 0) {
-                SDL_SetError("%s", "Descriptor set index for compute texture-sampler must be 0!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    if (results->error != NULL) {
+        SDL_SetError("%s", results->error);
+        return false;
+    }
+    return true;
+}
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+bool SDL_ShaderCross_CompileMultiTargetFromSPIRV(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_GPUShaderFormat targets,
+    SDL_ShaderCross_MultiTargetResult *results)
+{
+    if (info == NULL) {
+        SDL_InvalidParamError("info");
+        return false;
+    }
+    if (results == NULL) {
+        SDL_InvalidParamError("results");
+        return false;
+    }
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_texture = binding_index;
-            binding.msl_sampler = binding_index;
-            result = spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
-            }
-        }
-        num_textures += num_texture_samplers;
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginSPIRVCapture(&capture, CAPTURE_COMPILE_MULTI_TARGET_FROM_SPIRV, info);
+    capture.format = targets;
+
+    CompileScope outerScope;
+    SDL_ShaderCross_INTERNAL_BeginScope(&outerScope, info->props, info->name);
+    bool success = SDL_ShaderCross_INTERNAL_CompileMultiTarget(info, targets, results);
+    SDL_ShaderCross_INTERNAL_EndScope(&outerScope);
+
+    SDL_ShaderCross_INTERNAL_EndCapture(&capture, success, SDL_ShaderCross_INTERNAL_GetMultiTargetOutputSize(results));
+    return success;
+}
+
+void SDL_ShaderCross_ReleaseMultiTargetResult(
+    SDL_ShaderCross_MultiTargetResult *results)
+{
+    if (results == NULL) {
+        return;
+    }
+    SDL_ShaderCross_ReleaseBlob(results->msl);
+    SDL_ShaderCross_ReleaseBlob(results->hlsl);
+    SDL_ShaderCross_ReleaseBlob(results->dxbc);
+    SDL_ShaderCross_ReleaseBlob(results->dxil);
+    SDL_free(results->msl_entrypoint);
+    SDL_free(results->error);
+    SDL_zerop(results);
+}
+
+// Everything SDL_ShaderCross_INTERNAL_CreateShaderFromSPIRV does short of creating the GPU object
+static SDL_ShaderCross_Blob *SDL_ShaderCross_INTERNAL_CompileShaderForDeviceCached(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_GPUShaderFormat format)
+{
+    CaptureCall capture;
+    SDL_ShaderCross_INTERNAL_BeginSPIRVCapture(&capture, CAPTURE_COMPILE_SHADER_FOR_DEVICE, info);
+    capture.format = format;
+
+    CacheRequest cache;
+    SDL_ShaderCross_Blob *compiled = SDL_ShaderCross_INTERNAL_BeginSPIRVCache(
+        &cache,
+        info,
+        format,
+        SDL_ShaderCross_INTERNAL_GetShaderModel(info->props, format),
+        true);
+
+    if (compiled == NULL) {
+        compiled = SDL_ShaderCross_INTERNAL_EndCache(
+            &cache,
+            SDL_ShaderCross_INTERNAL_CompileShaderForDevice(info, format));
+    }
+    return SDL_ShaderCross_INTERNAL_EndBlobCapture(&capture, compiled);
+}
+
+// Returns 0 if the device takes no format we can produce
+static SDL_GPUShaderFormat SDL_ShaderCross_INTERNAL_GetDeviceShaderFormat(SDL_GPUDevice *device)
+{
+    SDL_GPUShaderFormat shader_formats = SDL_GetGPUShaderFormats(device);
+
+    if (shader_formats & SDL_GPU_SHADERFORMAT_SPIRV) {
+        return SDL_GPU_SHADERFORMAT_SPIRV;
+    } else if (shader_formats & SDL_GPU_SHADERFORMAT_MSL) {
+        return SDL_GPU_SHADERFORMAT_MSL;
+    } else if ((shader_formats & SDL_GPU_SHADERFORMAT_DXBC) && SDL_D3DCompile != NULL) {
+        return SDL_GPU_SHADERFORMAT_DXBC;
+    }
+#ifdef SDL_SHADERCROSS_DXC
+    else if (shader_formats & SDL_GPU_SHADERFORMAT_DXIL) {
+        return SDL_GPU_SHADERFORMAT_DXIL;
+    }
+#endif
+
+    SDL_SetError("SDL_ShaderCross_INTERNAL_CreateShaderFromSPIRV: Unexpected SDL_GPUBackend");
+    return 0;
+}
+
+// Creates the GPU object from the output of SDL_ShaderCross_INTERNAL_CompileShaderForDevice, releasing it
+static void *SDL_ShaderCross_INTERNAL_CreateShaderFromCompiled(
+    SDL_GPUDevice *device,
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_GPUShaderFormat format,
+    SDL_ShaderCross_Blob *compiled,
+    void *metadata)
+{
+    if (compiled == NULL) {
+        return NULL;
+    }
+
+    // Everything is already NUL-terminated, but a damaged disk cache entry could be too short
+    const Uint8 *data = (const Uint8 *)compiled->data;
+    size_t metadataSize = SDL_ShaderCross_INTERNAL_GetMetadataSize(info->shader_stage);
+    size_t entrypointSize = metadataSize < compiled->size ? SDL_strlen((const char *)data + metadataSize) + 1 : 0;
+    if (entrypointSize == 0 || metadataSize + entrypointSize > compiled->size) {
+        SDL_ShaderCross_ReleaseBlob(compiled);
+        SDL_SetError("%s", "Invalid compiled shader!");
+        return NULL;
+    }
+
+    const char *entrypoint = (const char *)data + metadataSize;
+    const Uint8 *code = data + metadataSize + entrypointSize;
+    size_t codeSize = compiled->size - metadataSize - entrypointSize;
+    void *shaderObject;
+
+    SDL_memcpy(metadata, data, metadataSize);
+
+    CompileScope outerScope;
+    SDL_ShaderCross_INTERNAL_BeginScope(&outerScope, info->props, info->name);
+    Uint64 start = SDL_ShaderCross_INTERNAL_BeginPhase(SDL_SHADERCROSS_PHASE_GPU_OBJECT);
+
+    if (info->shader_stage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+        SDL_GPUComputePipelineCreateInfo createInfo;
+        SDL_ShaderCross_ComputePipelineMetadata *pipelineMetadata = (SDL_ShaderCross_ComputePipelineMetadata *)metadata;
+        createInfo.code = code;
+        createInfo.code_size = codeSize;
+        createInfo.entrypoint = entrypoint;
+        createInfo.format = format;
+        createInfo.props = 0;
+        createInfo.num_samplers = pipelineMetadata->num_samplers;
+        createInfo.num_readonly_storage_textures = pipelineMetadata->num_readonly_storage_textures;
+        createInfo.num_readonly_storage_buffers = pipelineMetadata->num_readonly_storage_buffers;
+        createInfo.num_readwrite_storage_textures = pipelineMetadata->num_readwrite_storage_textures;
+        createInfo.num_readwrite_storage_buffers = pipelineMetadata->num_readwrite_storage_buffers;
+        createInfo.num_uniform_buffers = pipelineMetadata->num_uniform_buffers;
+        createInfo.threadcount_x = pipelineMetadata->threadcount_x;
+        createInfo.threadcount_y = pipelineMetadata->threadcount_y;
+        createInfo.threadcount_z = pipelineMetadata->threadcount_z;
+        shaderObject = SDL_CreateGPUComputePipeline(device, &createInfo);
+    } else {
+        SDL_GPUShaderCreateInfo createInfo;
+        SDL_ShaderCross_GraphicsShaderMetadata *shaderMetadata = (SDL_ShaderCross_GraphicsShaderMetadata *)metadata;
+        createInfo.code = code;
+        createInfo.code_size = codeSize;
+        createInfo.entrypoint = entrypoint;
+        createInfo.format = format;
+        createInfo.stage = (SDL_GPUShaderStage)info->shader_stage;
+        createInfo.props = 0;
+        createInfo.num_samplers = shaderMetadata->num_samplers;
+        createInfo.num_storage_textures = shaderMetadata->num_storage_textures;
+        createInfo.num_storage_buffers = shaderMetadata->num_storage_buffers;
+        createInfo.num_uniform_buffers = shaderMetadata->num_uniform_buffers;
+        shaderObject = SDL_CreateGPUShader(device, &createInfo);
+    }
+
+    SDL_ShaderCross_INTERNAL_EndPhase(SDL_SHADERCROSS_PHASE_GPU_OBJECT, start);
+    SDL_ShaderCross_INTERNAL_EndScope(&outerScope);
+
+    SDL_ShaderCross_ReleaseBlob(compiled);
+    return shaderObject;
+}
+
+static void *SDL_ShaderCross_INTERNAL_CreateShaderFromSPIRV(
+    SDL_GPUDevice *device,
+    const SDL_ShaderCross_SPIRV_Info *info,
+    void *metadata)
+{
+    SDL_GPUShaderFormat format = SDL_ShaderCross_INTERNAL_GetDeviceShaderFormat(device);
+    if (format == 0) {
+        return NULL;
+    }
+
+    return SDL_ShaderCross_INTERNAL_CreateShaderFromCompiled(
+        device,
+        info,
+        format,
+        SDL_ShaderCross_INTERNAL_CompileShaderForDeviceCached(info, format),
+        metadata);
+}
+
+SDL_GPUShader *SDL_ShaderCross_CompileGraphicsShaderFromSPIRV(
+    SDL_GPUDevice *device,
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_ShaderCross_GraphicsShaderMetadata *metadata)
+{
+    return (SDL_GPUShader *)SDL_ShaderCross_INTERNAL_CreateShaderFromSPIRV(
+        device,
+        info,
+        metadata);
+}
+
+SDL_GPUComputePipeline *SDL_ShaderCross_CompileComputePipelineFromSPIRV(
+    SDL_GPUDevice *device,
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_ShaderCross_ComputePipelineMetadata *metadata)
+{
+    return (SDL_GPUComputePipeline *)SDL_ShaderCross_INTERNAL_CreateShaderFromSPIRV(
+        device,
+        info,
+        metadata);
+}
+
+/* Caller-Provided Buffers
+ *
+ * The ToBuffer functions copy the output straight into the caller's buffer.
+ * When it doesn't fit, or no buffer is given to query the size, the output
+ * blob is kept for the thread along with a digest of the call and the
+ * includes the compile read, so the call that follows with a large enough
+ * buffer doesn't compile again. It is released by the next ToBuffer call on
+ * the thread, or by SDL_ShaderCross_Quit, since it may belong to a compiler
+ * that is unloaded before the thread exits.
+ */
+
+typedef struct PendingOutput
+{
+    Uint8 digest[SHA256_DIGEST_SIZE];
+    SDL_ShaderCross_Blob *blob; /* NULL if nothing is kept */
+    IncludeDependencyList dependencies;
+    struct PendingOutput *prev;
+    struct PendingOutput *next;
+} PendingOutput;
+
+static SDL_TLSID pendingOutputTLS;
+static SDL_SpinLock pendingOutputLock;
+static PendingOutput *pendingOutputs = NULL; /* Of every thread, for SDL_ShaderCross_Quit */
+
+static void SDL_ShaderCross_INTERNAL_ClearPendingOutput(PendingOutput *pending)
+{
+    SDL_ShaderCross_ReleaseBlob(pending->blob);
+    pending->blob = NULL;
+    SDL_ShaderCross_INTERNAL_DestroyIncludeDependencies(&pending->dependencies);
+    SDL_zero(pending->dependencies);
+}
 
-        // Readonly storage textures
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_STORAGE_IMAGE,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_storage_textures);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return NULL;
-        }
+static void SDLCALL SDL_ShaderCross_INTERNAL_DestroyPendingOutput(void *value)
+{
+    PendingOutput *pending = (PendingOutput *)value;
 
-        size_t current_num_textures = num_textures;
-        for (size_t i = 0; i < num_storage_textures; i += 1) {
-            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    SDL_LockSpinlock(&pendingOutputLock);
+    if (pending->prev != NULL) {
+        pending->prev->next = pending->next;
+    } else {
+        pendingOutputs = pending->next;
+    }
+    if (pending->next != NULL) {
+        pending->next->prev = pending->prev;
+    }
+    SDL_ShaderCross_INTERNAL_ClearPendingOutput(pending);
+    SDL_UnlockSpinlock(&pendingOutputLock);
 
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
-            if (!(descriptor_set_index == 0 || descriptor_set_index == 1)) {
-                SDL_SetError("%s", "Descriptor set index for compute storage texture must be 0 or 1!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    SDL_free(pending);
+}
 
-            // Skip readwrite textures
-            if (descriptor_set_index != 0) { continue; }
+static void SDL_ShaderCross_INTERNAL_ReleasePendingOutputs(void)
+{
+    SDL_LockSpinlock(&pendingOutputLock);
+    // The dependencies belong to the thread, which drops them when it finds the blob gone
+    for (PendingOutput *pending = pendingOutputs; pending != NULL; pending = pending->next) {
+        SDL_ShaderCross_ReleaseBlob(pending->blob);
+        pending->blob = NULL;
+    }
+    SDL_UnlockSpinlock(&pendingOutputLock);
+}
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+// Returns true if the call matches the output kept by the previous one, with the result of the call in result
+static bool SDL_ShaderCross_INTERNAL_ResumeToBuffer(
+    const Uint8 digest[SHA256_DIGEST_SIZE],
+    void *buffer,
+    size_t buffer_size,
+    size_t *size,
+    bool *result)
+{
+    PendingOutput *pending = (PendingOutput *)SDL_GetTLS(&pendingOutputTLS);
+    if (pending == NULL) {
+        return false;
+    }
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_texture = current_num_textures + binding_index;
-            spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
-            }
-            num_textures += 1;
+    // Quit may release the output from another thread
+    SDL_LockSpinlock(&pendingOutputLock);
+    SDL_ShaderCross_Blob *blob = pending->blob;
+    pending->blob = NULL;
+    SDL_UnlockSpinlock(&pendingOutputLock);
+
+    bool matches = blob != NULL && SDL_memcmp(pending->digest, digest, SHA256_DIGEST_SIZE) == 0;
+    for (IncludeDependency *dependency = matches ? pending->dependencies.first : NULL; dependency != NULL; dependency = dependency->next) {
+        if (!SDL_ShaderCross_INTERNAL_IsIncludeUnchanged(dependency->path, dependency->digest)) {
+            matches = false;
+            break;
         }
+    }
 
-        // If source is HLSL, storage images might be marked as separate images
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_SEPARATE_IMAGE,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_separate_images);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return NULL;
-        }
+    if (!matches) {
+        // The caller moved on to something else or an include changed, so the output won't be asked for again
+        SDL_ShaderCross_ReleaseBlob(blob);
+        SDL_ShaderCross_INTERNAL_DestroyIncludeDependencies(&pending->dependencies);
+        SDL_zero(pending->dependencies);
+        return false;
+    }
 
-        // We only want to iterate the images that don't have an associated sampler
-        current_num_textures = num_textures;
-        for (size_t i = num_separate_samplers; i < num_separate_images; i += 1) {
-            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    *size = blob->size;
+    if (buffer != NULL && buffer_size >= blob->size) {
+        SDL_memcpy(buffer, blob->data, blob->size);
+        SDL_ShaderCross_ReleaseBlob(blob);
+        SDL_ShaderCross_INTERNAL_DestroyIncludeDependencies(&pending->dependencies);
+        SDL_zero(pending->dependencies);
+        *result = true;
+        return true;
+    }
 
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
-            if (!(descriptor_set_index == 0 || descriptor_set_index == 1)) {
-                SDL_SetError("%s", "Descriptor set index for compute storage texture must be 0 or 1!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    SDL_LockSpinlock(&pendingOutputLock);
+    pending->blob = blob;
+    SDL_UnlockSpinlock(&pendingOutputLock);
+    if (buffer == NULL) {
+        *result = true;
+    } else {
+        *result = SDL_SetError("Buffer too small, the output is %" SDL_PRIu64 " bytes", (Uint64)blob->size);
+    }
+    return true;
+}
 
-            // Skip readwrite textures
-            if (descriptor_set_index != 0) { continue; }
+// Takes ownership of the blob and the dependencies
+static bool SDL_ShaderCross_INTERNAL_FinishToBuffer(
+    const Uint8 digest[SHA256_DIGEST_SIZE],
+    IncludeDependencyList *dependencies,
+    SDL_ShaderCross_Blob *blob,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size)
+{
+    if (blob == NULL) {
+        SDL_ShaderCross_INTERNAL_DestroyIncludeDependencies(dependencies);
+        return false;
+    }
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+    *size = blob->size;
+    if (buffer != NULL && buffer_size >= blob->size) {
+        SDL_memcpy(buffer, blob->data, blob->size);
+        SDL_ShaderCross_ReleaseBlob(blob);
+        SDL_ShaderCross_INTERNAL_DestroyIncludeDependencies(dependencies);
+        return true;
+    }
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_texture = current_num_textures + binding_index;
-            spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
+    // Without the output kept, the next call simply compiles again
+    PendingOutput *pending = (PendingOutput *)SDL_GetTLS(&pendingOutputTLS);
+    if (pending == NULL) {
+        pending = SDL_calloc(1, sizeof(PendingOutput));
+        if (pending != NULL && !SDL_SetTLS(&pendingOutputTLS, pending, SDL_ShaderCross_INTERNAL_DestroyPendingOutput)) {
+            SDL_free(pending);
+            pending = NULL;
+        }
+        if (pending != NULL) {
+            SDL_LockSpinlock(&pendingOutputLock);
+            pending->next = pendingOutputs;
+            if (pendingOutputs != NULL) {
+                pendingOutputs->prev = pending;
             }
-            num_textures += 1;
+            pendingOutputs = pending;
+            SDL_UnlockSpinlock(&pendingOutputLock);
         }
+    }
+    if (pending != NULL && !dependencies->incomplete) {
+        SDL_memcpy(pending->digest, digest, SHA256_DIGEST_SIZE);
+        pending->dependencies = *dependencies;
+        SDL_zerop(dependencies);
+        SDL_LockSpinlock(&pendingOutputLock);
+        pending->blob = blob;
+        SDL_UnlockSpinlock(&pendingOutputLock);
+    } else {
+        SDL_ShaderCross_ReleaseBlob(blob);
+        SDL_ShaderCross_INTERNAL_DestroyIncludeDependencies(dependencies);
+    }
 
-        // Readwrite storage textures
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_STORAGE_IMAGE,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_storage_textures);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return NULL;
-        }
+    if (buffer != NULL) {
+        return SDL_SetError("Buffer too small, the output is %" SDL_PRIu64 " bytes", (Uint64)*size);
+    }
+    return true;
+}
 
-        current_num_textures = num_textures;
-        for (size_t i = 0; i < num_storage_textures; i += 1) {
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+// Records the includes the compile reads, so that the kept output can be checked against them
+static IncludeDependencyList *SDL_ShaderCross_INTERNAL_BeginBufferCompile(IncludeDependencyList *dependencies)
+{
+    IncludeDependencyList *outerDependencies = (IncludeDependencyList *)SDL_GetTLS(&includeDependenciesTLS);
+    SDL_zerop(dependencies);
+    SDL_SetTLS(&includeDependenciesTLS, dependencies, NULL);
+    return outerDependencies;
+}
 
-            // Skip readonly textures
-            if (descriptor_set_index != 1) { continue; }
+static void SDL_ShaderCross_INTERNAL_EndBufferCompile(
+    IncludeDependencyList *outerDependencies,
+    const IncludeDependencyList *dependencies)
+{
+    SDL_SetTLS(&includeDependenciesTLS, outerDependencies, NULL);
+    SDL_ShaderCross_INTERNAL_MergeIncludeDependencies(outerDependencies, dependencies);
+}
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+static bool SDL_ShaderCross_INTERNAL_CompileHLSLToBuffer(
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_ShaderCross_Blob *(SDLCALL *compile)(const SDL_ShaderCross_HLSL_Info *info),
+    void *buffer,
+    size_t buffer_size,
+    size_t *size)
+{
+    Uint8 digest[SHA256_DIGEST_SIZE];
+    SHA256Context key;
+    bool result;
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_texture = current_num_textures + binding_index;
-            spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
-            }
-            num_textures += 1;
-        }
+    if (info == NULL || info->source == NULL) {
+        return SDL_InvalidParamError("info");
+    }
+    if (size == NULL) {
+        return SDL_InvalidParamError("size");
+    }
+    *size = 0;
 
-        // If source is HLSL, storage images might be marked as separate images
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_SEPARATE_IMAGE,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_separate_images);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return NULL;
-        }
+    SDL_ShaderCross_INTERNAL_SHA256Init(&key);
+    SDL_ShaderCross_INTERNAL_SHA256Update(&key, &compile, sizeof(compile));
+    SDL_ShaderCross_INTERNAL_HashHLSLInput(&key, info, SDL_ShaderCross_INTERNAL_GetHLSLSourceSize(info), NULL);
+    SDL_ShaderCross_INTERNAL_HashOptions(
+        &key,
+        0,
+        (Uint32)SDL_GetNumberProperty(info->props, SDL_SHADERCROSS_PROP_SHADER_MODEL_NUMBER, 0),
+        info->shader_stage,
+        info->enable_debug,
+        info->name,
+        info->props);
+    SDL_ShaderCross_INTERNAL_SHA256Final(&key, digest);
 
-        // We only want to iterate the images that don't have an associated sampler
-        current_num_textures = num_textures;
-        for (size_t i = num_separate_samplers; i < num_separate_images; i += 1) {
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+    if (SDL_ShaderCross_INTERNAL_ResumeToBuffer(digest, buffer, buffer_size, size, &result)) {
+        return result;
+    }
 
-            // Skip readonly textures
-            if (descriptor_set_index != 1) { continue; }
+    IncludeDependencyList dependencies;
+    IncludeDependencyList *outerDependencies = SDL_ShaderCross_INTERNAL_BeginBufferCompile(&dependencies);
+    SDL_ShaderCross_Blob *blob = compile(info);
+    SDL_ShaderCross_INTERNAL_EndBufferCompile(outerDependencies, &dependencies);
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+    return SDL_ShaderCross_INTERNAL_FinishToBuffer(digest, &dependencies, blob, buffer, buffer_size, size);
+}
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_texture = current_num_textures + binding_index;
-            spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
-            }
-            num_textures += 1;
-        }
+static bool SDL_ShaderCross_INTERNAL_CompileSPIRVToBuffer(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_ShaderCross_Blob *(SDLCALL *compile)(const SDL_ShaderCross_SPIRV_Info *info),
+    void *buffer,
+    size_t buffer_size,
+    size_t *size)
+{
+    Uint8 digest[SHA256_DIGEST_SIZE];
+    SHA256Context key;
+    bool result;
 
-        // Storage buffers
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_STORAGE_BUFFER,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_storage_buffers);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return NULL;
-        }
+    if (info == NULL || info->bytecode == NULL) {
+        return SDL_InvalidParamError("info");
+    }
+    if (size == NULL) {
+        return SDL_InvalidParamError("size");
+    }
+    *size = 0;
 
-        // Readonly storage buffers
-        for (size_t i = 0; i < num_storage_buffers; i += 1) {
-            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    SDL_ShaderCross_INTERNAL_SHA256Init(&key);
+    SDL_ShaderCross_INTERNAL_SHA256Update(&key, &compile, sizeof(compile));
+    SDL_ShaderCross_INTERNAL_HashSPIRVInput(&key, info, false);
+    SDL_ShaderCross_INTERNAL_HashOptions(
+        &key,
+        0,
+        (Uint32)SDL_GetNumberProperty(info->props, SDL_SHADERCROSS_PROP_SHADER_MODEL_NUMBER, 0),
+        info->shader_stage,
+        info->enable_debug,
+        info->name,
+        info->props);
+    SDL_ShaderCross_INTERNAL_SHA256Final(&key, digest);
 
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
-            if (!(descriptor_set_index == 0 || descriptor_set_index == 1)) {
-                SDL_SetError("%s", "Descriptor set index for compute storage buffer must be 0 or 1!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    if (SDL_ShaderCross_INTERNAL_ResumeToBuffer(digest, buffer, buffer_size, size, &result)) {
+        return result;
+    }
 
-            // Skip readwrite buffers
-            if (descriptor_set_index != 0) { continue; }
+    IncludeDependencyList dependencies;
+    IncludeDependencyList *outerDependencies = SDL_ShaderCross_INTERNAL_BeginBufferCompile(&dependencies);
+    SDL_ShaderCross_Blob *blob = compile(info);
+    SDL_ShaderCross_INTERNAL_EndBufferCompile(outerDependencies, &dependencies);
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+    return SDL_ShaderCross_INTERNAL_FinishToBuffer(digest, &dependencies, blob, buffer, buffer_size, size);
+}
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_buffer = binding_index;
-            spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
-            }
+bool SDL_ShaderCross_CompileDXBCFromHLSLToBuffer(
+    const SDL_ShaderCross_HLSL_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size)
+{
+    return SDL_ShaderCross_INTERNAL_CompileHLSLToBuffer(info, SDL_ShaderCross_CompileDXBCFromHLSLToBlob, buffer, buffer_size, size);
+}
 
-            num_buffers += 1;
-        }
+bool SDL_ShaderCross_CompileDXILFromHLSLToBuffer(
+    const SDL_ShaderCross_HLSL_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size)
+{
+    return SDL_ShaderCross_INTERNAL_CompileHLSLToBuffer(info, SDL_ShaderCross_CompileDXILFromHLSLToBlob, buffer, buffer_size, size);
+}
 
-        // Readwrite storage buffers
-        size_t current_num_buffers = num_buffers;
-        for (size_t i = 0; i < num_storage_buffers; i += 1) {
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+bool SDL_ShaderCross_CompileSPIRVFromHLSLToBuffer(
+    const SDL_ShaderCross_HLSL_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size)
+{
+    return SDL_ShaderCross_INTERNAL_CompileHLSLToBuffer(info, SDL_ShaderCross_CompileSPIRVFromHLSLToBlob, buffer, buffer_size, size);
+}
+
+bool SDL_ShaderCross_TranspileMSLFromSPIRVToBuffer(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size)
+{
+    return SDL_ShaderCross_INTERNAL_CompileSPIRVToBuffer(info, SDL_ShaderCross_TranspileMSLFromSPIRVToBlob, buffer, buffer_size, size);
+}
+
+bool SDL_ShaderCross_TranspileHLSLFromSPIRVToBuffer(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size)
+{
+    return SDL_ShaderCross_INTERNAL_CompileSPIRVToBuffer(info, SDL_ShaderCross_TranspileHLSLFromSPIRVToBlob, buffer, buffer_size, size);
+}
 
-            // Skip readonly buffers
-            if (descriptor_set_index != 1) { continue; }
+bool SDL_ShaderCross_CompileDXBCFromSPIRVToBuffer(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size)
+{
+    return SDL_ShaderCross_INTERNAL_CompileSPIRVToBuffer(info, SDL_ShaderCross_CompileDXBCFromSPIRVToBlob, buffer, buffer_size, size);
+}
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+bool SDL_ShaderCross_CompileDXILFromSPIRVToBuffer(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    void *buffer,
+    size_t buffer_size,
+    size_t *size)
+{
+    return SDL_ShaderCross_INTERNAL_CompileSPIRVToBuffer(info, SDL_ShaderCross_CompileDXILFromSPIRVToBlob, buffer, buffer_size, size);
+}
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_buffer = current_num_buffers + binding_index;
-            spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
-            }
+/* Async Jobs
+ *
+ * Jobs run on a pool of worker threads, created on first use and sized at
+ * init. Each worker has its own queue, new jobs are dealt out round-robin,
+ * and a worker whose queue is empty steals from the back of another's. A
+ * semaphore counts queued jobs, so a worker that wakes up is guaranteed to
+ * find one somewhere. Calls that split their work across threads, such as
+ * permutations and multi-target compiles, queue internal tasks on the same
+ * pool rather than starting threads of their own.
+ */
+
+struct SDL_ShaderCross_Job
+{
+    SDL_AtomicInt refcount; /* One for the caller, one for the pool */
+    SDL_AtomicInt done;
+    SDL_Mutex *lock;
+    SDL_Condition *finished;
 
-            num_buffers += 1;
-        }
+    /* Deep copies of the caller's info, which only has to live until the job is submitted */
+    SDL_ShaderCross_HLSL_Info hlslInfo;
+    SDL_ShaderCross_SPIRV_Info spirvInfo;
+    SDL_ShaderCross_HLSL_Define *defines;
+    char **includeDirs;
+    SDL_ShaderCross_Blob *(SDLCALL *compileHLSL)(const SDL_ShaderCross_HLSL_Info *info);
+    SDL_ShaderCross_Blob *(SDLCALL *compileSPIRV)(const SDL_ShaderCross_SPIRV_Info *info);
 
-        // Uniform buffers
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_UNIFORM_BUFFER,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_uniform_buffers);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return NULL;
-        }
+    /* Internal tasks, which run instead of a compile in the scope of the submitting thread */
+    void (*task)(void *data);
+    void *taskData;
+    CompileScope scope;
 
-        for (size_t i = 0; i < num_uniform_buffers; i += 1) {
-            if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-                SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    SDL_ShaderCross_JobCallback callback;
+    void *userdata;
 
-            unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
-            if (descriptor_set_index != 2) {
-                SDL_SetError("%s", "Descriptor set index for compute uniform buffer must be 2!");
-                spvc_context_destroy(context);
-                return NULL;
-            }
+    SDL_ShaderCross_Blob *result;
+    char *error;
 
-            unsigned int binding_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding);
+    struct JobWorker *worker; /* The worker whose queue the job was put in */
+    struct SDL_ShaderCross_Job *prev; /* Worker queue links */
+    struct SDL_ShaderCross_Job *next;
+};
 
-            binding.stage = executionModel;
-            binding.desc_set = descriptor_set_index;
-            binding.binding = binding_index;
-            binding.msl_buffer = num_buffers + binding_index;
-            spvc_compiler_msl_add_resource_binding(compiler, &binding);
-            if (result < 0) {
-                SPVC_ERROR(spvc_compiler_msl_add_resource_binding);
-                spvc_context_destroy(context);
-                return NULL;
-            }
-        }
-        num_buffers += num_uniform_buffers;
+typedef struct JobWorker
+{
+    SDL_Thread *thread;
+    SDL_Mutex *lock;
+    SDL_ShaderCross_Job *front;
+    SDL_ShaderCross_Job *back;
+} JobWorker;
+
+static SDL_Mutex *jobPoolLock = NULL;
+static JobWorker *jobWorkers = NULL;
+static int numJobWorkers = 0;
+static int requestedJobWorkers = 0;
+static SDL_Semaphore *jobsQueued = NULL;
+static SDL_AtomicInt nextJobWorker;
+static SDL_AtomicInt jobPoolQuitting;
+
+static void SDL_ShaderCross_INTERNAL_ReleaseJob(SDL_ShaderCross_Job *job)
+{
+    if (SDL_AddAtomicInt(&job->refcount, -1) != 1) {
+        return;
     }
 
-    result = spvc_compiler_install_compiler_options(compiler, options);
-    if (result < 0) {
-        SPVC_ERROR(spvc_compiler_install_compiler_options);
-        spvc_context_destroy(context);
-        return NULL;
+    SDL_ShaderCross_ReleaseBlob(job->result);
+    SDL_free(job->error);
+
+    SDL_free((void *)job->hlslInfo.source);
+    SDL_free((void *)job->hlslInfo.entrypoint);
+    SDL_free((void *)job->hlslInfo.include_dir);
+    SDL_free((void *)job->hlslInfo.name);
+    SDL_DestroyProperties(job->hlslInfo.props);
+    if (job->defines != NULL) {
+        for (SDL_ShaderCross_HLSL_Define *define = job->defines; define->name != NULL; define += 1) {
+            SDL_free(define->name);
+            SDL_free(define->value);
+        }
+        SDL_free(job->defines);
     }
-
-    /* Compile to the target shader language */
-    result = spvc_compiler_compile(compiler, &translated_source);
-    if (result < 0) {
-        SPVC_ERROR(spvc_compiler_compile);
-        spvc_context_destroy(context);
-        return NULL;
+    if (job->includeDirs != NULL) {
+        for (char **includeDir = job->includeDirs; *includeDir != NULL; includeDir += 1) {
+            SDL_free(*includeDir);
+        }
+        SDL_free(job->includeDirs);
     }
 
-    if (backend == SPVC_BACKEND_MSL) {
-        // Metal doesn't allow a "main" entrypoint, so determine the "cleansed" entrypoint name (e.g. main -> main0 on MSL)
-        cleansed_entrypoint = spvc_compiler_get_cleansed_entry_point_name(
-            compiler,
-            entrypoint,
-            spvc_compiler_get_execution_model(compiler));
-    } else {
-        cleansed_entrypoint = entrypoint;
-    }
+    SDL_free((void *)job->spirvInfo.bytecode);
+    SDL_free((void *)job->spirvInfo.entrypoint);
+    SDL_free((void *)job->spirvInfo.name);
+    SDL_DestroyProperties(job->spirvInfo.props);
 
-    transpileContext = SDL_malloc(sizeof(SPIRVTranspileContext));
-    transpileContext->context = context;
-    transpileContext->cleansed_entrypoint = cleansed_entrypoint;
-    transpileContext->translated_source = translated_source;
-    return transpileContext;
+    SDL_DestroyCondition(job->finished);
+    SDL_DestroyMutex(job->lock);
+    SDL_free(job);
 }
 
-// Acquire metadata from SPIRV bytecode.
-// TODO: validate descriptor sets
-bool SDL_ShaderCross_ReflectGraphicsSPIRV(
-    const Uint8 *code,
-    size_t codeSize,
-    SDL_ShaderCross_GraphicsShaderMetadata *metadata // filled in with reflected data
-) {
-    spvc_result result;
-    spvc_context context = NULL;
-    spvc_parsed_ir ir = NULL;
-    spvc_compiler compiler = NULL;
-    size_t num_texture_samplers = 0;
-    size_t num_storage_textures = 0;
-    size_t num_storage_buffers = 0;
-    size_t num_uniform_buffers = 0;
-    size_t num_separate_samplers = 0; // HLSL edge case
-    size_t num_separate_images = 0; // HLSL edge case
+static char *SDL_ShaderCross_INTERNAL_CopyString(const char *str, bool *failed)
+{
+    if (str == NULL) {
+        return NULL;
+    }
+    char *copy = SDL_strdup(str);
+    if (copy == NULL) {
+        *failed = true;
+    }
+    return copy;
+}
 
-    /* Create the SPIRV-Cross context */
-    result = spvc_context_create(&context);
-    if (result < 0) {
-        SDL_SetError("spvc_context_create failed: %X", result);
-        return false;
+static SDL_PropertiesID SDL_ShaderCross_INTERNAL_CopyJobProperties(SDL_PropertiesID props, bool *failed)
+{
+    if (props == 0) {
+        return 0;
     }
+    SDL_PropertiesID copy = SDL_CreateProperties();
+    if (copy == 0 || !SDL_CopyProperties(props, copy)) {
+        *failed = true;
+    }
+    return copy;
+}
 
-    /* Parse the SPIR-V into IR */
-    result = spvc_context_parse_spirv(context, (const SpvId *)code, codeSize / sizeof(SpvId), &ir);
-    if (result < 0) {
-        SPVC_ERROR(spvc_context_parse_spirv);
-        spvc_context_destroy(context);
-        return false;
+static SDL_ShaderCross_Job *SDL_ShaderCross_INTERNAL_CreateJob(
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata)
+{
+    if (jobPoolLock == NULL) {
+        SDL_SetError("%s", "SDL_ShaderCross_Init must be called before starting async jobs!");
+        return NULL;
     }
 
-    /* Create a reflection-only compiler */
-    result = spvc_context_create_compiler(context, SPVC_BACKEND_NONE, ir, SPVC_CAPTURE_MODE_TAKE_OWNERSHIP, &compiler);
-    if (result < 0) {
-        SPVC_ERROR(spvc_context_create_compiler);
-        spvc_context_destroy(context);
-        return false;
+    SDL_ShaderCross_Job *job = SDL_calloc(1, sizeof(SDL_ShaderCross_Job));
+    if (job == NULL) {
+        return NULL;
+    }
+    SDL_SetAtomicInt(&job->refcount, 1);
+    job->callback = callback;
+    job->userdata = userdata;
+    job->lock = SDL_CreateMutex();
+    job->finished = SDL_CreateCondition();
+    if (job->lock == NULL || job->finished == NULL) {
+        SDL_ShaderCross_INTERNAL_ReleaseJob(job);
+        return NULL;
     }
+    return job;
+}
 
-    spvc_resources resources;
-    spvc_reflected_resource *reflected_resources;
+static bool SDL_ShaderCross_INTERNAL_CopyHLSLInfo(SDL_ShaderCross_Job *job, const SDL_ShaderCross_HLSL_Info *info)
+{
+    size_t sourceSize = SDL_ShaderCross_INTERNAL_GetHLSLSourceSize(info);
+    bool failed = false;
 
-    result = spvc_compiler_create_shader_resources(compiler, &resources);
-    if (result < 0) {
-        SPVC_ERROR(spvc_compiler_create_shader_resources);
-        spvc_context_destroy(context);
+    // NUL-terminated as well, in case the source size is not given as a property
+    char *source = SDL_malloc(sourceSize + 1);
+    if (source == NULL) {
         return false;
     }
+    SDL_memcpy(source, info->source, sourceSize);
+    source[sourceSize] = '\0';
 
-    // Combined texture-samplers
-    result = spvc_resources_get_resource_list_for_type(
-        resources,
-        SPVC_RESOURCE_TYPE_SAMPLED_IMAGE,
-        (const spvc_reflected_resource **)&reflected_resources,
-        &num_texture_samplers);
-    if (result < 0) {
-        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-        spvc_context_destroy(context);
-        return false;
-    }
+    job->hlslInfo = *info;
+    job->hlslInfo.source = source;
+    job->hlslInfo.entrypoint = SDL_ShaderCross_INTERNAL_CopyString(info->entrypoint, &failed);
+    job->hlslInfo.include_dir = SDL_ShaderCross_INTERNAL_CopyString(info->include_dir, &failed);
+    job->hlslInfo.name = SDL_ShaderCross_INTERNAL_CopyString(info->name, &failed);
+    job->hlslInfo.defines = NULL;
+    job->hlslInfo.props = SDL_ShaderCross_INTERNAL_CopyJobProperties(info->props, &failed);
 
-    // If source is HLSL, we might have separate images and samplers
-    if (num_texture_samplers == 0) {
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_SEPARATE_SAMPLERS,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_separate_samplers);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
+    if (info->defines != NULL) {
+        Uint32 numDefines = 0;
+        while (numDefines < MAX_DEFINES && info->defines[numDefines].name != NULL) {
+            numDefines += 1;
+        }
+        job->defines = SDL_calloc(numDefines + 1, sizeof(SDL_ShaderCross_HLSL_Define));
+        if (job->defines == NULL) {
             return false;
         }
-        num_texture_samplers = num_separate_samplers;
+        for (Uint32 i = 0; i < numDefines; i += 1) {
+            job->defines[i].name = SDL_ShaderCross_INTERNAL_CopyString(info->defines[i].name, &failed);
+            job->defines[i].value = SDL_ShaderCross_INTERNAL_CopyString(info->defines[i].value, &failed);
+        }
+        job->hlslInfo.defines = job->defines;
     }
 
-    // Storage textures
-    result = spvc_resources_get_resource_list_for_type(
-        resources,
-        SPVC_RESOURCE_TYPE_STORAGE_IMAGE,
-        (const spvc_reflected_resource **)&reflected_resources,
-        &num_storage_textures);
-    if (result < 0) {
-        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-        spvc_context_destroy(context);
-        return false;
+    // The include directory list is a pointer into the caller's memory, so it needs a copy of its own
+    const char **includeDirs = (const char **)SDL_GetPointerProperty(info->props, SDL_SHADERCROSS_PROP_HLSL_INCLUDE_DIRS_POINTER, NULL);
+    if (includeDirs != NULL) {
+        Uint32 numIncludeDirs = 0;
+        while (numIncludeDirs < MAX_INCLUDE_DIRS && includeDirs[numIncludeDirs] != NULL) {
+            numIncludeDirs += 1;
+        }
+        job->includeDirs = SDL_calloc(numIncludeDirs + 1, sizeof(char *));
+        if (job->includeDirs == NULL) {
+            return false;
+        }
+        for (Uint32 i = 0; i < numIncludeDirs; i += 1) {
+            job->includeDirs[i] = SDL_ShaderCross_INTERNAL_CopyString(includeDirs[i], &failed);
+        }
+        SDL_SetPointerProperty(job->hlslInfo.props, SDL_SHADERCROSS_PROP_HLSL_INCLUDE_DIRS_POINTER, job->includeDirs);
     }
 
-    // If source is HLSL, storage images might be marked as separate images
-    result = spvc_resources_get_resource_list_for_type(
-        resources,
-        SPVC_RESOURCE_TYPE_SEPARATE_IMAGE,
-        (const spvc_reflected_resource **)&reflected_resources,
-        &num_separate_images);
-    if (result < 0) {
-        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-        spvc_context_destroy(context);
-        return false;
-    }
-    // The number of storage textures is the number of separate images minus the number of samplers.
-    num_storage_textures += (num_separate_images - num_separate_samplers);
+    return !failed;
+}
 
-    // Storage buffers
-    result = spvc_resources_get_resource_list_for_type(
-        resources,
-        SPVC_RESOURCE_TYPE_STORAGE_BUFFER,
-        (const spvc_reflected_resource **)&reflected_resources,
-        &num_storage_buffers);
-    if (result < 0) {
-        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-        spvc_context_destroy(context);
+static bool SDL_ShaderCross_INTERNAL_CopySPIRVInfo(SDL_ShaderCross_Job *job, const SDL_ShaderCross_SPIRV_Info *info)
+{
+    bool failed = false;
+
+    void *bytecode = SDL_malloc(info->bytecode_size > 0 ? info->bytecode_size : 1);
+    if (bytecode == NULL) {
         return false;
     }
+    SDL_memcpy(bytecode, info->bytecode, info->bytecode_size);
 
-    // Uniform buffers
-    result = spvc_resources_get_resource_list_for_type(
-        resources,
-        SPVC_RESOURCE_TYPE_UNIFORM_BUFFER,
-        (const spvc_reflected_resource **)&reflected_resources,
-        &num_uniform_buffers);
-    if (result < 0) {
-        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-        spvc_context_destroy(context);
-        return false;
+    job->spirvInfo = *info;
+    job->spirvInfo.bytecode = bytecode;
+    job->spirvInfo.entrypoint = SDL_ShaderCross_INTERNAL_CopyString(info->entrypoint, &failed);
+    job->spirvInfo.name = SDL_ShaderCross_INTERNAL_CopyString(info->name, &failed);
+    job->spirvInfo.props = SDL_ShaderCross_INTERNAL_CopyJobProperties(info->props, &failed);
+
+    return !failed;
+}
+
+static void SDL_ShaderCross_INTERNAL_RunJob(SDL_ShaderCross_Job *job)
+{
+    SDL_ShaderCross_Blob *result = NULL;
+    if (job->task != NULL) {
+        // Workers outlive the task, so they go back to their own scope afterwards
+        CompileScope outer;
+        SDL_ShaderCross_INTERNAL_GetScope(&outer);
+        SDL_ShaderCross_INTERNAL_SetScope(&job->scope);
+        job->task(job->taskData);
+        SDL_ShaderCross_INTERNAL_SetScope(&outer);
+    } else if (job->compileHLSL != NULL) {
+        result = job->compileHLSL(&job->hlslInfo);
+    } else {
+        result = job->compileSPIRV(&job->spirvInfo);
     }
 
-    spvc_context_destroy(context);
+    SDL_LockMutex(job->lock);
+    job->result = result;
+    if (result == NULL && job->task == NULL) {
+        // The error string is thread-local, so capture it for the caller
+        job->error = SDL_strdup(SDL_GetError());
+    }
+    SDL_SetAtomicInt(&job->done, 1);
+    SDL_BroadcastCondition(job->finished);
+    SDL_UnlockMutex(job->lock);
 
-    metadata->num_samplers = num_texture_samplers;
-    metadata->num_storage_textures = num_storage_textures;
-    metadata->num_storage_buffers = num_storage_buffers;
-    metadata->num_uniform_buffers = num_uniform_buffers;
-    return true;
+    if (job->callback != NULL) {
+        job->callback(job->userdata, job);
+    }
+    SDL_ShaderCross_INTERNAL_ReleaseJob(job);
 }
 
-bool SDL_ShaderCross_ReflectComputeSPIRV(
-    const Uint8 *bytecode,
-    size_t bytecodeSize,
-    SDL_ShaderCross_ComputePipelineMetadata *metadata // filled in with reflected data
-) {
-    spvc_result result;
-    spvc_context context = NULL;
-    spvc_parsed_ir ir = NULL;
-    spvc_compiler compiler = NULL;
-    size_t num_texture_samplers = 0;
-    size_t num_readonly_storage_textures = 0;
-    size_t num_readonly_storage_buffers = 0;
-    size_t num_readwrite_storage_textures = 0;
-    size_t num_readwrite_storage_buffers = 0;
-    size_t num_uniform_buffers = 0;
+static SDL_ShaderCross_Job *SDL_ShaderCross_INTERNAL_TakeJob(JobWorker *worker, bool steal)
+{
+    SDL_LockMutex(worker->lock);
+    SDL_ShaderCross_Job *job = steal ? worker->back : worker->front;
+    if (job != NULL) {
+        if (job->prev != NULL) {
+            job->prev->next = job->next;
+        } else {
+            worker->front = job->next;
+        }
+        if (job->next != NULL) {
+            job->next->prev = job->prev;
+        } else {
+            worker->back = job->prev;
+        }
+        job->prev = NULL;
+        job->next = NULL;
+    }
+    SDL_UnlockMutex(worker->lock);
+    return job;
+}
 
-    size_t num_storage_textures = 0;
-    size_t num_storage_buffers = 0;
-    size_t num_separate_samplers = 0; // HLSL edge case
-    size_t num_separate_images = 0; // HLSL edge case
+static int SDLCALL SDL_ShaderCross_INTERNAL_JobWorkerThread(void *data)
+{
+    int index = (int)(intptr_t)data;
 
-    /* Create the SPIRV-Cross context */
-    result = spvc_context_create(&context);
-    if (result < 0) {
-        SDL_SetError("spvc_context_create failed: %X", result);
-        return false;
+    for (;;) {
+        SDL_WaitSemaphore(jobsQueued);
+
+        // Our own queue first, then the other workers' in turn
+        SDL_ShaderCross_Job *job = NULL;
+        for (int i = 0; job == NULL && i < numJobWorkers; i += 1) {
+            job = SDL_ShaderCross_INTERNAL_TakeJob(&jobWorkers[(index + i) % numJobWorkers], i > 0);
+        }
+
+        if (job != NULL) {
+            SDL_ShaderCross_INTERNAL_RunJob(job);
+        } else if (SDL_GetAtomicInt(&jobPoolQuitting)) {
+            break;
+        } else {
+            // Another worker took the job we were woken for between its signal and our scan, so look again
+            SDL_SignalSemaphore(jobsQueued);
+        }
     }
 
-    /* Parse the SPIR-V into IR */
-    result = spvc_context_parse_spirv(context, (const SpvId *)bytecode, bytecodeSize / sizeof(SpvId), &ir);
-    if (result < 0) {
-        SPVC_ERROR(spvc_context_parse_spirv);
-        spvc_context_destroy(context);
-        return false;
+    return 0;
+}
+
+// Must be called with the pool locked.
+static bool SDL_ShaderCross_INTERNAL_StartJobWorkers(void)
+{
+    int count = requestedJobWorkers;
+    if (count <= 0) {
+        count = SDL_max(SDL_GetNumLogicalCPUCores() - 1, 1);
     }
 
-    /* Create a reflection-only compiler */
-    result = spvc_context_create_compiler(context, SPVC_BACKEND_NONE, ir, SPVC_CAPTURE_MODE_TAKE_OWNERSHIP, &compiler);
-    if (result < 0) {
-        SPVC_ERROR(spvc_context_create_compiler);
-        spvc_context_destroy(context);
+    jobsQueued = SDL_CreateSemaphore(0);
+    jobWorkers = SDL_calloc(count, sizeof(JobWorker));
+    if (jobsQueued == NULL || jobWorkers == NULL) {
+        SDL_DestroySemaphore(jobsQueued);
+        SDL_free(jobWorkers);
+        jobsQueued = NULL;
+        jobWorkers = NULL;
         return false;
     }
 
-    spvc_resources resources;
-    spvc_reflected_resource *reflected_resources;
+    for (int i = 0; i < count; i += 1) {
+        jobWorkers[i].lock = SDL_CreateMutex();
+        if (jobWorkers[i].lock == NULL) {
+            break;
+        }
+        numJobWorkers += 1;
+    }
 
-    result = spvc_compiler_create_shader_resources(compiler, &resources);
-    if (result < 0) {
-        SPVC_ERROR(spvc_compiler_create_shader_resources);
-        spvc_context_destroy(context);
-        return false;
+    // Workers only read numJobWorkers, so it has to be final before the first one starts
+    bool started = false;
+    for (int i = 0; i < numJobWorkers; i += 1) {
+        jobWorkers[i].thread = SDL_CreateThread(SDL_ShaderCross_INTERNAL_JobWorkerThread, "ShaderCrossJob", (void *)(intptr_t)i);
+        if (jobWorkers[i].thread != NULL) {
+            started = true;
+        }
+    }
+    if (started) {
+        return true;
     }
 
-    // Combined texture-samplers
-    result = spvc_resources_get_resource_list_for_type(
-        resources,
-        SPVC_RESOURCE_TYPE_SAMPLED_IMAGE,
-        (const spvc_reflected_resource **)&reflected_resources,
-        &num_texture_samplers);
-    if (result < 0) {
-        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-        spvc_context_destroy(context);
-        return false;
+    // Nothing is running, so leave the pool as it was for the next job to try again
+    for (int i = 0; i < numJobWorkers; i += 1) {
+        SDL_DestroyMutex(jobWorkers[i].lock);
     }
+    SDL_free(jobWorkers);
+    jobWorkers = NULL;
+    numJobWorkers = 0;
+    SDL_DestroySemaphore(jobsQueued);
+    jobsQueued = NULL;
+    return SDL_SetError("%s", "Could not start any job worker threads!");
+}
 
-    // If source is HLSL, we might have separate images and samplers
-    if (num_texture_samplers == 0) {
-        result = spvc_resources_get_resource_list_for_type(
-            resources,
-            SPVC_RESOURCE_TYPE_SEPARATE_SAMPLERS,
-            (const spvc_reflected_resource **)&reflected_resources,
-            &num_separate_samplers);
-        if (result < 0) {
-            SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-            spvc_context_destroy(context);
-            return false;
-        }
-        num_texture_samplers = num_separate_samplers;
+static void SDL_ShaderCross_INTERNAL_StopJobWorkers(void)
+{
+    if (jobPoolLock == NULL) {
+        return;
     }
 
-    // Storage textures
-    result = spvc_resources_get_resource_list_for_type(
-        resources,
-        SPVC_RESOURCE_TYPE_STORAGE_IMAGE,
-        (const spvc_reflected_resource **)&reflected_resources,
-        &num_storage_textures);
-    if (result < 0) {
-        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-        spvc_context_destroy(context);
-        return false;
+    // Queued jobs are finished first, so that nobody waits on a job forever
+    SDL_SetAtomicInt(&jobPoolQuitting, 1);
+    for (int i = 0; i < numJobWorkers; i += 1) {
+        SDL_SignalSemaphore(jobsQueued);
+    }
+    for (int i = 0; i < numJobWorkers; i += 1) {
+        SDL_WaitThread(jobWorkers[i].thread, NULL);
+        SDL_DestroyMutex(jobWorkers[i].lock);
     }
 
-    for (size_t i = 0; i < num_storage_textures; i += 1) {
-        if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-            SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-            spvc_context_destroy(context);
-            return false;
-        }
+    SDL_free(jobWorkers);
+    jobWorkers = NULL;
+    numJobWorkers = 0;
+    SDL_DestroySemaphore(jobsQueued);
+    jobsQueued = NULL;
+    SDL_SetAtomicInt(&jobPoolQuitting, 0);
 
-        unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+    SDL_DestroyMutex(jobPoolLock);
+    jobPoolLock = NULL;
+}
 
-        if (descriptor_set_index == 0) {
-            num_readonly_storage_textures += 1;
-        } else if (descriptor_set_index == 1) {
-            num_readwrite_storage_textures += 1;
-        } else {
-            SDL_SetError("%s", "Descriptor set index for compute storage texture must be 0 or 1!");
-            spvc_context_destroy(context);
-            return false;
-        }
+static SDL_ShaderCross_Job *SDL_ShaderCross_INTERNAL_SubmitJob(SDL_ShaderCross_Job *job, bool copied)
+{
+    if (!copied) {
+        SDL_ShaderCross_INTERNAL_ReleaseJob(job);
+        return NULL;
     }
 
-    // If source is HLSL, readonly storage images might be marked as separate images
-    result = spvc_resources_get_resource_list_for_type(
-        resources,
-        SPVC_RESOURCE_TYPE_SEPARATE_IMAGE,
-        (const spvc_reflected_resource **)&reflected_resources,
-        &num_separate_images);
-    if (result < 0) {
-        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-        spvc_context_destroy(context);
-        return false;
+    if (jobPoolLock == NULL) {
+        SDL_ShaderCross_INTERNAL_ReleaseJob(job);
+        SDL_SetError("%s", "SDL_ShaderCross_Init must be called before starting async jobs!");
+        return NULL;
     }
 
-    // The number of storage textures is the number of separate images minus the number of samplers.
-    num_storage_textures += (num_separate_images - num_separate_samplers);
+    SDL_LockMutex(jobPoolLock);
+    bool started = jobWorkers != NULL || SDL_ShaderCross_INTERNAL_StartJobWorkers();
+    SDL_UnlockMutex(jobPoolLock);
+    if (!started) {
+        SDL_ShaderCross_INTERNAL_ReleaseJob(job);
+        return NULL;
+    }
 
-    for (size_t i = num_separate_samplers; i < num_separate_images; i += 1) {
-        if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-            SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-            spvc_context_destroy(context);
-            return false;
-        }
+    // Skip workers whose thread failed to start, at least one of them is running
+    JobWorker *worker;
+    do {
+        worker = &jobWorkers[(Uint32)SDL_AddAtomicInt(&nextJobWorker, 1) % (Uint32)numJobWorkers];
+    } while (worker->thread == NULL);
 
-        unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
+    SDL_AddAtomicInt(&job->refcount, 1);
 
-        if (descriptor_set_index == 0) {
-            num_readonly_storage_textures += 1;
-        } else if (descriptor_set_index == 1) {
-            num_readwrite_storage_textures += 1;
-        } else {
-            SDL_SetError("%s", "Descriptor set index for compute storage texture must be 0 or 1!");
-            spvc_context_destroy(context);
-            return false;
-        }
+    SDL_LockMutex(worker->lock);
+    job->worker = worker;
+    job->prev = worker->back;
+    if (worker->back != NULL) {
+        worker->back->next = job;
+    } else {
+        worker->front = job;
     }
+    worker->back = job;
+    SDL_UnlockMutex(worker->lock);
 
-    // Storage buffers
-    result = spvc_resources_get_resource_list_for_type(
-        resources,
-        SPVC_RESOURCE_TYPE_STORAGE_BUFFER,
-        (const spvc_reflected_resource **)&reflected_resources,
-        &num_storage_buffers);
-    if (result < 0) {
-        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-        spvc_context_destroy(context);
-        return false;
+    SDL_SignalSemaphore(jobsQueued);
+    return job;
+}
+
+/* Queues a task to run on the pool, for work that a call splits across
+ * threads. Returns NULL if it can't be, for the caller to run it instead.
+ */
+static SDL_ShaderCross_Job *SDL_ShaderCross_INTERNAL_StartTask(void (*task)(void *data), void *data)
+{
+    // Without SDL_ShaderCross_Init there is no pool, and that is not an error
+    if (jobPoolLock == NULL) {
+        return NULL;
     }
 
-    // Readonly storage buffers
-    for (size_t i = 0; i < num_storage_buffers; i += 1) {
-        if (!spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet) || !spvc_compiler_has_decoration(compiler, reflected_resources[i].id, SpvDecorationBinding)) {
-            SDL_SetError("%s", "Shader resources must have descriptor set and binding index!");
-            spvc_context_destroy(context);
-            return false;
-        }
+    SDL_ShaderCross_Job *job = SDL_ShaderCross_INTERNAL_CreateJob(NULL, NULL);
+    if (job == NULL) {
+        return NULL;
+    }
+    job->task = task;
+    job->taskData = data;
+    SDL_ShaderCross_INTERNAL_GetScope(&job->scope);
+    return SDL_ShaderCross_INTERNAL_SubmitJob(job, true);
+}
 
-        unsigned int descriptor_set_index = spvc_compiler_get_decoration(compiler, reflected_resources[i].id, SpvDecorationDescriptorSet);
-        if (!(descriptor_set_index == 0 || descriptor_set_index == 1)) {
-            SDL_SetError("%s", "Descriptor set index for compute storage buffer must be 0 or 1!");
-            spvc_context_destroy(context);
-            return false;
-        }
+/* Waits for a task and releases it. A task that no worker has started yet
+ * is taken back and run on the calling thread instead, so that a caller
+ * that is itself a worker never waits on a queue nobody is draining.
+ */
+static void SDL_ShaderCross_INTERNAL_FinishTask(SDL_ShaderCross_Job *job)
+{
+    JobWorker *worker = job->worker;
 
-        if (descriptor_set_index == 0) {
-            num_readonly_storage_buffers += 1;
-        } else if (descriptor_set_index == 1) {
-            num_readwrite_storage_buffers += 1;
+    SDL_LockMutex(worker->lock);
+    bool queued = worker->front == job || job->prev != NULL;
+    if (queued) {
+        if (job->prev != NULL) {
+            job->prev->next = job->next;
         } else {
-            SDL_SetError("%s", "Descriptor set index for compute storage buffer must be 0 or 1!");
-            spvc_context_destroy(context);
-            return false;
+            worker->front = job->next;
         }
+        if (job->next != NULL) {
+            job->next->prev = job->prev;
+        } else {
+            worker->back = job->prev;
+        }
+        job->prev = NULL;
+        job->next = NULL;
     }
+    SDL_UnlockMutex(worker->lock);
 
-    // Uniform buffers
-    result = spvc_resources_get_resource_list_for_type(
-        resources,
-        SPVC_RESOURCE_TYPE_UNIFORM_BUFFER,
-        (const spvc_reflected_resource **)&reflected_resources,
-        &num_uniform_buffers);
-    if (result < 0) {
-        SPVC_ERROR(spvc_resources_get_resource_list_for_type);
-        spvc_context_destroy(context);
-        return false;
+    if (queued) {
+        // Take back the count of the job too. If a worker holds it, it finds nothing and gives it back.
+        SDL_WaitSemaphore(jobsQueued);
+        SDL_ShaderCross_INTERNAL_RunJob(job);
+    } else {
+        SDL_ShaderCross_WaitJob(job);
     }
+    SDL_ShaderCross_INTERNAL_ReleaseJob(job);
+}
 
-    // Threadcount
-    metadata->threadcount_x = spvc_compiler_get_execution_mode_argument_by_index(compiler, SpvExecutionModeLocalSize, 0);
-    metadata->threadcount_y = spvc_compiler_get_execution_mode_argument_by_index(compiler, SpvExecutionModeLocalSize, 1);
-    metadata->threadcount_z = spvc_compiler_get_execution_mode_argument_by_index(compiler, SpvExecutionModeLocalSize, 2);
-
-    spvc_context_destroy(context);
+static SDL_ShaderCross_Job *SDL_ShaderCross_INTERNAL_StartHLSLJob(
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_ShaderCross_Blob *(SDLCALL *compile)(const SDL_ShaderCross_HLSL_Info *info),
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata)
+{
+    if (info == NULL) {
+        SDL_InvalidParamError("info");
+        return NULL;
+    }
 
-    metadata->num_samplers = num_texture_samplers;
-    metadata->num_readonly_storage_textures = num_readonly_storage_textures;
-    metadata->num_readonly_storage_buffers = num_readonly_storage_buffers;
-    metadata->num_readwrite_storage_textures = num_readwrite_storage_textures;
-    metadata->num_readwrite_storage_buffers = num_readwrite_storage_buffers;
-    metadata->num_uniform_buffers = num_uniform_buffers;
-    return true;
+    SDL_ShaderCross_Job *job = SDL_ShaderCross_INTERNAL_CreateJob(callback, userdata);
+    if (job == NULL) {
+        return NULL;
+    }
+    job->compileHLSL = compile;
+    return SDL_ShaderCross_INTERNAL_SubmitJob(job, SDL_ShaderCross_INTERNAL_CopyHLSLInfo(job, info));
 }
 
-static void *SDL_ShaderCross_INTERNAL_CompileFromSPIRV(
-    SDL_GPUDevice *device,
+static SDL_ShaderCross_Job *SDL_ShaderCross_INTERNAL_StartSPIRVJob(
     const SDL_ShaderCross_SPIRV_Info *info,
-    SDL_GPUShaderFormat targetFormat,
-    void *metadata
-) {
-    spvc_backend backend;
-    unsigned shadermodel = 0;
-
-    if (targetFormat == SDL_GPU_SHADERFORMAT_DXBC) {
-        backend = SPVC_BACKEND_HLSL;
-        shadermodel = 51;
-    } else if (targetFormat == SDL_GPU_SHADERFORMAT_DXIL) {
-        backend = SPVC_BACKEND_HLSL;
-        shadermodel = 60;
-    } else if (targetFormat == SDL_GPU_SHADERFORMAT_MSL) {
-        backend = SPVC_BACKEND_MSL;
-    } else {
-        SDL_SetError("SDL_ShaderCross_INTERNAL_CompileFromSPIRV: Unexpected SDL_GPUBackend");
+    SDL_ShaderCross_Blob *(SDLCALL *compile)(const SDL_ShaderCross_SPIRV_Info *info),
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata)
+{
+    if (info == NULL) {
+        SDL_InvalidParamError("info");
         return NULL;
     }
 
-    SPIRVTranspileContext *transpileContext = SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
-        backend,
-        shadermodel,
-        info->shader_stage,
-        info->bytecode,
-        info->bytecode_size,
-        info->entrypoint);
-
-    if (transpileContext == NULL) {
+    SDL_ShaderCross_Job *job = SDL_ShaderCross_INTERNAL_CreateJob(callback, userdata);
+    if (job == NULL) {
         return NULL;
     }
+    job->compileSPIRV = compile;
+    return SDL_ShaderCross_INTERNAL_SubmitJob(job, SDL_ShaderCross_INTERNAL_CopySPIRVInfo(job, info));
+}
 
-    void *shaderObject = NULL;
+SDL_ShaderCross_Job *SDL_ShaderCross_CompileDXBCFromHLSLAsync(
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata)
+{
+    return SDL_ShaderCross_INTERNAL_StartHLSLJob(info, SDL_ShaderCross_CompileDXBCFromHLSLToBlob, callback, userdata);
+}
 
-    if (info->shader_stage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
-        SDL_GPUComputePipelineCreateInfo createInfo;
-        SDL_ShaderCross_ComputePipelineMetadata *pipelineInfo = (SDL_ShaderCross_ComputePipelineMetadata *)metadata;
-        SDL_ShaderCross_ReflectComputeSPIRV(
-            info->bytecode,
-            info->bytecode_size,
-            pipelineInfo);
-        createInfo.entrypoint = transpileContext->cleansed_entrypoint;
-        createInfo.format = targetFormat;
-        createInfo.props = 0;
-        createInfo.num_samplers = pipelineInfo->num_samplers;
-        createInfo.num_readonly_storage_textures = pipelineInfo->num_readonly_storage_textures;
-        createInfo.num_readonly_storage_buffers = pipelineInfo->num_readonly_storage_buffers;
-        createInfo.num_readwrite_storage_textures = pipelineInfo->num_readwrite_storage_textures;
-        createInfo.num_readwrite_storage_buffers = pipelineInfo->num_readwrite_storage_buffers;
-        createInfo.num_uniform_buffers = pipelineInfo->num_uniform_buffers;
-        createInfo.threadcount_x = pipelineInfo->threadcount_x;
-        createInfo.threadcount_y = pipelineInfo->threadcount_y;
-        createInfo.threadcount_z = pipelineInfo->threadcount_z;
+SDL_ShaderCross_Job *SDL_ShaderCross_CompileDXILFromHLSLAsync(
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata)
+{
+    return SDL_ShaderCross_INTERNAL_StartHLSLJob(info, SDL_ShaderCross_CompileDXILFromHLSLToBlob, callback, userdata);
+}
 
-        SDL_ShaderCross_HLSL_Info hlslInfo;
-        hlslInfo.source = transpileContext->translated_source;
-        hlslInfo.entrypoint = transpileContext->cleansed_entrypoint;
-        hlslInfo.include_dir = NULL;
-        hlslInfo.defines = NULL;
-        hlslInfo.enable_debug = info->enable_debug;
-        hlslInfo.shader_stage = SDL_SHADERCROSS_SHADERSTAGE_COMPUTE;
-        hlslInfo.name = info->name;
-        hlslInfo.props = 0;
+SDL_ShaderCross_Job *SDL_ShaderCross_CompileSPIRVFromHLSLAsync(
+    const SDL_ShaderCross_HLSL_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata)
+{
+    return SDL_ShaderCross_INTERNAL_StartHLSLJob(info, SDL_ShaderCross_CompileSPIRVFromHLSLToBlob, callback, userdata);
+}
 
-        if (targetFormat == SDL_GPU_SHADERFORMAT_DXBC) {
-            createInfo.code = SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSL(
-                &hlslInfo,
-                false,
-                &createInfo.code_size);
-        } else if (targetFormat == SDL_GPU_SHADERFORMAT_DXIL) {
-            createInfo.code = SDL_ShaderCross_CompileDXILFromHLSL(
-                &hlslInfo,
-                &createInfo.code_size);
-        } else { // MSL
-            createInfo.code = (const Uint8 *)transpileContext->translated_source;
-            createInfo.code_size = SDL_strlen(transpileContext->translated_source) + 1;
-        }
+SDL_ShaderCross_Job *SDL_ShaderCross_TranspileMSLFromSPIRVAsync(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata)
+{
+    return SDL_ShaderCross_INTERNAL_StartSPIRVJob(info, SDL_ShaderCross_TranspileMSLFromSPIRVToBlob, callback, userdata);
+}
 
-        shaderObject = SDL_CreateGPUComputePipeline(device, &createInfo);
-    } else {
-        SDL_GPUShaderCreateInfo createInfo;
-        SDL_ShaderCross_GraphicsShaderMetadata *shaderInfo = (SDL_ShaderCross_GraphicsShaderMetadata *)metadata;
-        SDL_ShaderCross_ReflectGraphicsSPIRV(
-            info->bytecode,
-            info->bytecode_size,
-            shaderInfo);
-        createInfo.entrypoint = transpileContext->cleansed_entrypoint;
-        createInfo.format = targetFormat;
-        createInfo.stage = (SDL_GPUShaderStage)info->shader_stage;
-        createInfo.props = 0;
-        createInfo.num_samplers = shaderInfo->num_samplers;
-        createInfo.num_storage_textures = shaderInfo->num_storage_textures;
-        createInfo.num_storage_buffers = shaderInfo->num_storage_buffers;
-        createInfo.num_uniform_buffers = shaderInfo->num_uniform_buffers;
+SDL_ShaderCross_Job *SDL_ShaderCross_TranspileHLSLFromSPIRVAsync(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata)
+{
+    return SDL_ShaderCross_INTERNAL_StartSPIRVJob(info, SDL_ShaderCross_TranspileHLSLFromSPIRVToBlob, callback, userdata);
+}
 
-        SDL_ShaderCross_HLSL_Info hlslInfo;
-        hlslInfo.source = transpileContext->translated_source;
-        hlslInfo.entrypoint = transpileContext->cleansed_entrypoint;
-        hlslInfo.include_dir = NULL;
-        hlslInfo.defines = NULL;
-        hlslInfo.enable_debug = info->enable_debug;
-        hlslInfo.shader_stage = info->shader_stage;
-        hlslInfo.name = info->name;
-        hlslInfo.props = 0;
+SDL_ShaderCross_Job *SDL_ShaderCross_CompileDXBCFromSPIRVAsync(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata)
+{
+    return SDL_ShaderCross_INTERNAL_StartSPIRVJob(info, SDL_ShaderCross_CompileDXBCFromSPIRVToBlob, callback, userdata);
+}
 
-        if (targetFormat == SDL_GPU_SHADERFORMAT_DXBC) {
-            createInfo.code = SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSL(
-                &hlslInfo,
-                false,
-                &createInfo.code_size);
-        } else if (targetFormat == SDL_GPU_SHADERFORMAT_DXIL) {
-            createInfo.code = SDL_ShaderCross_CompileDXILFromHLSL(
-                &hlslInfo,
-                &createInfo.code_size);
-        } else { // MSL
-            createInfo.code = (const Uint8 *)transpileContext->translated_source;
-            createInfo.code_size = SDL_strlen(transpileContext->translated_source) + 1;
-        }
+SDL_ShaderCross_Job *SDL_ShaderCross_CompileDXILFromSPIRVAsync(
+    const SDL_ShaderCross_SPIRV_Info *info,
+    SDL_ShaderCross_JobCallback callback,
+    void *userdata)
+{
+    return SDL_ShaderCross_INTERNAL_StartSPIRVJob(info, SDL_ShaderCross_CompileDXILFromSPIRVToBlob, callback, userdata);
+}
 
-        shaderObject = SDL_CreateGPUShader(device, &createInfo);
+bool SDL_ShaderCross_IsJobDone(SDL_ShaderCross_Job *job)
+{
+    if (job == NULL) {
+        SDL_InvalidParamError("job");
+        return false;
     }
-
-    SDL_ShaderCross_INTERNAL_DestroyTranspileContext(transpileContext);
-    return shaderObject;
+    return SDL_GetAtomicInt(&job->done) != 0;
 }
 
-void *SDL_ShaderCross_TranspileMSLFromSPIRV(
-    const SDL_ShaderCross_SPIRV_Info *info)
+void SDL_ShaderCross_WaitJob(SDL_ShaderCross_Job *job)
 {
-    SPIRVTranspileContext *context = SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
-        SPVC_BACKEND_MSL,
-        0,
-        info->shader_stage,
-        info->bytecode,
-        info->bytecode_size,
-        info->entrypoint
-    );
+    if (job == NULL) {
+        return;
+    }
+    SDL_LockMutex(job->lock);
+    while (!SDL_GetAtomicInt(&job->done)) {
+        SDL_WaitCondition(job->finished, job->lock);
+    }
+    SDL_UnlockMutex(job->lock);
+}
 
-    if (context == NULL) {
+SDL_ShaderCross_Blob *SDL_ShaderCross_GetJobResult(SDL_ShaderCross_Job *job)
+{
+    if (job == NULL) {
+        SDL_InvalidParamError("job");
         return NULL;
     }
 
-    size_t length = SDL_strlen(context->translated_source) + 1;
-    char *result = SDL_malloc(length);
-    SDL_strlcpy(result, context->translated_source, length);
+    SDL_ShaderCross_WaitJob(job);
 
-    SDL_ShaderCross_INTERNAL_DestroyTranspileContext(context);
+    SDL_LockMutex(job->lock);
+    SDL_ShaderCross_Blob *result = job->result;
+    job->result = NULL;
+    if (result == NULL) {
+        SDL_SetError("%s", job->error != NULL ? job->error : "The job result was already taken");
+    }
+    SDL_UnlockMutex(job->lock);
     return result;
 }
 
-void *SDL_ShaderCross_TranspileHLSLFromSPIRV(
-    const SDL_ShaderCross_SPIRV_Info *info)
+const char *SDL_ShaderCross_GetJobError(SDL_ShaderCross_Job *job)
 {
-    SPIRVTranspileContext *context = SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
-        SPVC_BACKEND_HLSL,
-        60,
-        info->shader_stage,
-        info->bytecode,
-        info->bytecode_size,
-        info->entrypoint
-    );
-
-    if (context == NULL) {
+    if (job == NULL) {
+        SDL_InvalidParamError("job");
         return NULL;
     }
 
-    size_t length = SDL_strlen(context->translated_source) + 1;
-    char *result = SDL_malloc(length);
-    SDL_strlcpy(result, context->translated_source, length);
+    SDL_ShaderCross_WaitJob(job);
+    return job->error;
+}
 
-    SDL_ShaderCross_INTERNAL_DestroyTranspileContext(context);
-    return result;
+void SDL_ShaderCross_ReleaseJob(SDL_ShaderCross_Job *job)
+{
+    if (job == NULL) {
+        return;
+    }
+    SDL_ShaderCross_INTERNAL_ReleaseJob(job);
 }
 
-void *SDL_ShaderCross_CompileDXBCFromSPIRV(
-    const SDL_ShaderCross_SPIRV_Info *info,
-    size_t *size)
+/* Capture Replay
+ *
+ * Captured calls are read back one record at a time and run again through
+ * the same public functions, in the order they finished, on the calling
+ * thread. The captured includes are registered as virtual files for the
+ * duration of the replay so that the compiles resolve them as they did when
+ * they were captured.
+ */
+
+typedef struct ReplayCall
 {
-    SPIRVTranspileContext *context = SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
-        SPVC_BACKEND_HLSL,
-        51,
-        info->shader_stage,
-        info->bytecode,
-        info->bytecode_size,
-        info->entrypoint);
+    Uint32 function;
+    Uint64 threadID;
+    Uint64 start;
+    Uint64 duration;
+    Uint8 success;
+    Uint8 cacheHit;
+    Uint64 outputSize;
+    char *name;
+    char *entrypoint;
+    char *includeDir;
+    Uint32 shaderStage;
+    Uint8 enableDebug;
+    Uint8 *code; /* The HLSL source or the SPIR-V, NUL-terminated */
+    Uint64 codeSize;
+    SDL_ShaderCross_HLSL_Define *defines;
+    char **includeDirs;
+    SDL_PropertiesID props;
+    Uint32 format;
+    Uint32 numDefineSets;
+    SDL_ShaderCross_HLSL_Define **defineSets;
+} ReplayCall;
+
+static bool SDL_ShaderCross_INTERNAL_ReadCaptureString(SDL_IOStream *stream, char **str)
+{
+    Uint32 length;
+    *str = NULL;
+    if (!SDL_ReadU32LE(stream, &length)) {
+        return false;
+    }
+    if (length == CAPTURE_NULL_STRING) {
+        return true;
+    }
+    *str = SDL_malloc((size_t)length + 1);
+    if (*str == NULL || SDL_ReadIO(stream, *str, length) != length) {
+        return false;
+    }
+    (*str)[length] = '\0';
+    return true;
+}
 
-    if (context == NULL) {
-        return NULL;
+static bool SDL_ShaderCross_INTERNAL_ReadCaptureBytes(SDL_IOStream *stream, Uint8 **data, Uint64 *size)
+{
+    *data = NULL;
+    if (!SDL_ReadU64LE(stream, size) || *size >= SDL_SIZE_MAX) {
+        return false;
     }
+    *data = SDL_malloc((size_t)*size + 1);
+    if (*data == NULL || SDL_ReadIO(stream, *data, (size_t)*size) != *size) {
+        return false;
+    }
+    (*data)[*size] = '\0';
+    return true;
+}
 
-    SDL_ShaderCross_HLSL_Info hlslInfo;
-    hlslInfo.source = context->translated_source;
-    hlslInfo.entrypoint = context->cleansed_entrypoint;
-    hlslInfo.include_dir = NULL;
-    hlslInfo.defines = NULL;
-    hlslInfo.shader_stage = info->shader_stage;
-    hlslInfo.enable_debug = info->enable_debug;
-    hlslInfo.name = info->name;
-    hlslInfo.props = 0;
+static void SDL_ShaderCross_INTERNAL_FreeCaptureDefines(SDL_ShaderCross_HLSL_Define *defines)
+{
+    for (SDL_ShaderCross_HLSL_Define *define = defines; define != NULL && define->name != NULL; define += 1) {
+        SDL_free(define->name);
+        SDL_free(define->value);
+    }
+    SDL_free(defines);
+}
 
-    void *result = SDL_ShaderCross_INTERNAL_CompileDXBCFromHLSL(
-        &hlslInfo,
-        false,
-        size);
+static bool SDL_ShaderCross_INTERNAL_ReadCaptureDefines(SDL_IOStream *stream, SDL_ShaderCross_HLSL_Define **defines)
+{
+    Uint32 count;
+    *defines = NULL;
+    if (!SDL_ReadU32LE(stream, &count)) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
 
-    SDL_ShaderCross_INTERNAL_DestroyTranspileContext(context);
-    return result;
+    // Zeroed, so the array stays terminated however much of it is read
+    *defines = SDL_calloc((size_t)count + 1, sizeof(SDL_ShaderCross_HLSL_Define));
+    if (*defines == NULL) {
+        return false;
+    }
+    for (Uint32 i = 0; i < count; i += 1) {
+        char *name = NULL;
+        char *value = NULL;
+        bool success = SDL_ShaderCross_INTERNAL_ReadCaptureString(stream, &name) &&
+            SDL_ShaderCross_INTERNAL_ReadCaptureString(stream, &value) &&
+            name != NULL;
+        if (!success) {
+            SDL_free(name);
+            SDL_free(value);
+            return false;
+        }
+        (*defines)[i].name = name;
+        (*defines)[i].value = value;
+    }
+    return true;
 }
 
-void *SDL_ShaderCross_CompileDXILFromSPIRV(
-    const SDL_ShaderCross_SPIRV_Info *info,
-    size_t *size)
+static bool SDL_ShaderCross_INTERNAL_ReadCaptureProperties(SDL_IOStream *stream, ReplayCall *call)
 {
-#ifndef SDL_SHADERCROSS_DXC
-    SDL_SetError("%s", "Shadercross was not compiled with DXC support, cannot compile to SPIR-V!");
-    return NULL;
-#endif
+    Uint32 count;
+    if (!SDL_ReadU32LE(stream, &count)) {
+        return false;
+    }
 
-    SPIRVTranspileContext *context = SDL_ShaderCross_INTERNAL_TranspileFromSPIRV(
-        SPVC_BACKEND_HLSL,
-        60,
-        info->shader_stage,
-        info->bytecode,
-        info->bytecode_size,
-        info->entrypoint);
+    call->props = SDL_CreateProperties();
+    if (call->props == 0) {
+        return false;
+    }
 
-    if (context == NULL) {
-        return NULL;
+    for (Uint32 i = 0; i < count; i += 1) {
+        char *name;
+        Uint32 type;
+        bool success = SDL_ShaderCross_INTERNAL_ReadCaptureString(stream, &name) &&
+            name != NULL &&
+            SDL_ReadU32LE(stream, &type);
+
+        if (success && type == SDL_PROPERTY_TYPE_STRING) {
+            char *value;
+            success = SDL_ShaderCross_INTERNAL_ReadCaptureString(stream, &value) &&
+                SDL_SetStringProperty(call->props, name, value);
+            SDL_free(value);
+        } else if (success && type == SDL_PROPERTY_TYPE_NUMBER) {
+            Sint64 value;
+            success = SDL_ReadS64LE(stream, &value) &&
+                SDL_SetNumberProperty(call->props, name, value);
+        } else if (success && type == SDL_PROPERTY_TYPE_FLOAT) {
+            union { float f; Uint32 u; } value;
+            success = SDL_ReadU32LE(stream, &value.u) &&
+                SDL_SetFloatProperty(call->props, name, value.f);
+        } else if (success && type == SDL_PROPERTY_TYPE_BOOLEAN) {
+            Uint8 value;
+            success = SDL_ReadU8(stream, &value) &&
+                SDL_SetBooleanProperty(call->props, name, value != 0);
+        } else {
+            success = false;
+        }
+        SDL_free(name);
+        if (!success) {
+            return false;
+        }
     }
 
-    SDL_ShaderCross_HLSL_Info hlslInfo;
-    hlslInfo.source = context->translated_source;
-    hlslInfo.entrypoint = context->cleansed_entrypoint;
-    hlslInfo.include_dir = NULL;
-    hlslInfo.defines = NULL;
-    hlslInfo.shader_stage = info->shader_stage;
-    hlslInfo.enable_debug = info->enable_debug;
-    hlslInfo.name = info->name;
-    hlslInfo.props = 0;
+    Uint32 numIncludeDirs;
+    if (!SDL_ReadU32LE(stream, &numIncludeDirs)) {
+        return false;
+    }
+    if (numIncludeDirs > 0) {
+        call->includeDirs = SDL_calloc((size_t)numIncludeDirs + 1, sizeof(char *));
+        if (call->includeDirs == NULL) {
+            return false;
+        }
+        for (Uint32 i = 0; i < numIncludeDirs; i += 1) {
+            if (!SDL_ShaderCross_INTERNAL_ReadCaptureString(stream, &call->includeDirs[i]) || call->includeDirs[i] == NULL) {
+                return false;
+            }
+        }
+        SDL_SetPointerProperty(call->props, SDL_SHADERCROSS_PROP_HLSL_INCLUDE_DIRS_POINTER, call->includeDirs);
+    }
+    return true;
+}
 
-    void *result = SDL_ShaderCross_CompileDXILFromHLSL(
-        &hlslInfo,
-        size);
+static void SDL_ShaderCross_INTERNAL_DestroyReplayCall(ReplayCall *call)
+{
+    SDL_free(call->name);
+    SDL_free(call->entrypoint);
+    SDL_free(call->includeDir);
+    SDL_free(call->code);
+    SDL_ShaderCross_INTERNAL_FreeCaptureDefines(call->defines);
+    if (call->includeDirs != NULL) {
+        for (char **dir = call->includeDirs; *dir != NULL; dir += 1) {
+            SDL_free(*dir);
+        }
+        SDL_free(call->includeDirs);
+    }
+    SDL_DestroyProperties(call->props);
+    if (call->defineSets != NULL) {
+        for (Uint32 i = 0; i < call->numDefineSets; i += 1) {
+            SDL_ShaderCross_INTERNAL_FreeCaptureDefines(call->defineSets[i]);
+        }
+        SDL_free(call->defineSets);
+    }
+    SDL_zerop(call);
+}
 
-    SDL_ShaderCross_INTERNAL_DestroyTranspileContext(context);
-    return result;
+static bool SDL_ShaderCross_INTERNAL_ReadReplayCall(SDL_IOStream *stream, ReplayCall *call)
+{
+    bool success = SDL_ReadU32LE(stream, &call->function) &&
+        call->function < CAPTURE_FUNCTION_COUNT &&
+        SDL_ReadU64LE(stream, &call->threadID) &&
+        SDL_ReadU64LE(stream, &call->start) &&
+        SDL_ReadU64LE(stream, &call->duration) &&
+        SDL_ReadU8(stream, &call->success) &&
+        SDL_ReadU8(stream, &call->cacheHit) &&
+        SDL_ReadU64LE(stream, &call->outputSize) &&
+        SDL_ShaderCross_INTERNAL_ReadCaptureString(stream, &call->name) &&
+        SDL_ShaderCross_INTERNAL_ReadCaptureString(stream, &call->entrypoint);
+
+    if (call->function <= CAPTURE_COMPILE_PERMUTATIONS_FROM_HLSL || call->function == CAPTURE_COMPILE_HLSL_SHADER_FOR_DEVICE) {
+        success = success &&
+            SDL_ShaderCross_INTERNAL_ReadCaptureString(stream, &call->includeDir) &&
+            SDL_ReadU32LE(stream, &call->shaderStage) &&
+            SDL_ReadU8(stream, &call->enableDebug) &&
+            SDL_ShaderCross_INTERNAL_ReadCaptureBytes(stream, &call->code, &call->codeSize) &&
+            SDL_ShaderCross_INTERNAL_ReadCaptureDefines(stream, &call->defines);
+    } else {
+        success = success &&
+            SDL_ReadU32LE(stream, &call->shaderStage) &&
+            SDL_ReadU8(stream, &call->enableDebug) &&
+            SDL_ShaderCross_INTERNAL_ReadCaptureBytes(stream, &call->code, &call->codeSize);
+    }
+
+    // Replays measure compiles, so they bypass both caches
+    success = success &&
+        SDL_ShaderCross_INTERNAL_ReadCaptureProperties(stream, call) &&
+        SDL_SetStringProperty(call->props, SDL_SHADERCROSS_PROP_CACHE_DIRECTORY_STRING, "") &&
+        SDL_SetBooleanProperty(call->props, SDL_SHADERCROSS_INTERNAL_PROP_NO_MEMORY_CACHE_BOOLEAN, true) &&
+        SDL_ReadU32LE(stream, &call->format) &&
+        SDL_ReadU32LE(stream, &call->numDefineSets);
+
+    if (success && call->numDefineSets > 0) {
+        call->defineSets = SDL_calloc(call->numDefineSets, sizeof(SDL_ShaderCross_HLSL_Define *));
+        success = call->defineSets != NULL;
+        for (Uint32 i = 0; success && i < call->numDefineSets; i += 1) {
+            success = SDL_ShaderCross_INTERNAL_ReadCaptureDefines(stream, &call->defineSets[i]);
+        }
+    }
+    return success;
 }
 
-static void *SDL_ShaderCross_INTERNAL_CreateShaderFromSPIRV(
-    SDL_GPUDevice *device,
-    const SDL_ShaderCross_SPIRV_Info *info,
-    void *metadata)
+// Runs the call as it was captured, returning whether it succeeded
+static bool SDL_ShaderCross_INTERNAL_RunReplayCall(const ReplayCall *call, Uint64 *outputSize)
 {
-    SDL_GPUShaderFormat format;
+    SDL_ShaderCross_HLSL_Info hlslInfo;
+    hlslInfo.source = (const char *)call->code;
+    hlslInfo.entrypoint = call->entrypoint;
+    hlslInfo.include_dir = call->includeDir;
+    hlslInfo.defines = call->defines;
+    hlslInfo.shader_stage = (SDL_ShaderCross_ShaderStage)call->shaderStage;
+    hlslInfo.enable_debug = call->enableDebug != 0;
+    hlslInfo.name = call->name;
+    hlslInfo.props = call->props;
 
-    SDL_GPUShaderFormat shader_formats = SDL_GetGPUShaderFormats(device);
+    SDL_ShaderCross_SPIRV_Info spirvInfo;
+    spirvInfo.bytecode = call->code;
+    spirvInfo.bytecode_size = (size_t)call->codeSize;
+    spirvInfo.entrypoint = call->entrypoint;
+    spirvInfo.shader_stage = (SDL_ShaderCross_ShaderStage)call->shaderStage;
+    spirvInfo.enable_debug = call->enableDebug != 0;
+    spirvInfo.name = call->name;
+    spirvInfo.props = call->props;
+
+    SDL_ShaderCross_Blob *blob = NULL;
+    bool success = false;
+    *outputSize = 0;
+
+    switch (call->function) {
+    case CAPTURE_COMPILE_SPIRV_FROM_HLSL:
+        blob = SDL_ShaderCross_CompileSPIRVFromHLSLToBlob(&hlslInfo);
+        break;
+    case CAPTURE_COMPILE_DXIL_FROM_HLSL:
+        blob = SDL_ShaderCross_CompileDXILFromHLSLToBlob(&hlslInfo);
+        break;
+    case CAPTURE_COMPILE_DXBC_FROM_HLSL:
+        blob = SDL_ShaderCross_CompileDXBCFromHLSLToBlob(&hlslInfo);
+        break;
+    case CAPTURE_COMPILE_PERMUTATIONS_FROM_HLSL:
+    {
+        SDL_ShaderCross_PermutationResult *results = SDL_ShaderCross_CompilePermutationsFromHLSL(
+            &hlslInfo,
+            (const SDL_ShaderCross_HLSL_Define *const *)call->defineSets,
+            (int)call->numDefineSets,
+            call->format);
+        *outputSize = SDL_ShaderCross_INTERNAL_GetPermutationsOutputSize(results, (int)call->numDefineSets, &success);
+        SDL_ShaderCross_ReleasePermutationResults(results, (int)call->numDefineSets);
+        return success;
+    }
+    case CAPTURE_TRANSPILE_MSL_FROM_SPIRV:
+        blob = SDL_ShaderCross_TranspileMSLFromSPIRVToBlob(&spirvInfo);
+        break;
+    case CAPTURE_TRANSPILE_HLSL_FROM_SPIRV:
+        blob = SDL_ShaderCross_TranspileHLSLFromSPIRVToBlob(&spirvInfo);
+        break;
+    case CAPTURE_COMPILE_DXBC_FROM_SPIRV:
+        blob = SDL_ShaderCross_CompileDXBCFromSPIRVToBlob(&spirvInfo);
+        break;
+    case CAPTURE_COMPILE_DXIL_FROM_SPIRV:
+        blob = SDL_ShaderCross_CompileDXILFromSPIRVToBlob(&spirvInfo);
+        break;
+    case CAPTURE_COMPILE_MULTI_TARGET_FROM_SPIRV:
+    {
+        SDL_ShaderCross_MultiTargetResult results;
+        SDL_zero(results);
+        success = SDL_ShaderCross_CompileMultiTargetFromSPIRV(&spirvInfo, call->format, &results);
+        *outputSize = SDL_ShaderCross_INTERNAL_GetMultiTargetOutputSize(&results);
+        SDL_ShaderCross_ReleaseMultiTargetResult(&results);
+        return success;
+    }
+    case CAPTURE_REFLECT_GRAPHICS_SPIRV:
+    {
+        SDL_ShaderCross_GraphicsShaderMetadata metadata;
+        success = SDL_ShaderCross_ReflectGraphicsSPIRV(spirvInfo.bytecode, spirvInfo.bytecode_size, &metadata);
+        *outputSize = success ? sizeof(metadata) : 0;
+        return success;
+    }
+    case CAPTURE_REFLECT_COMPUTE_SPIRV:
+    {
+        SDL_ShaderCross_ComputePipelineMetadata metadata;
+        success = SDL_ShaderCross_ReflectComputeSPIRV(spirvInfo.bytecode, spirvInfo.bytecode_size, &metadata);
+        *outputSize = success ? sizeof(metadata) : 0;
+        return success;
+    }
+    case CAPTURE_COMPILE_SHADER_FOR_DEVICE:
+        // No device is needed to compile what would have been handed to it
+        blob = SDL_ShaderCross_INTERNAL_CompileShaderForDeviceCached(&spirvInfo, call->format);
+        break;
+    case CAPTURE_COMPILE_HLSL_SHADER_FOR_DEVICE:
+        blob = SDL_ShaderCross_INTERNAL_CompileHLSLShaderForDevice(&hlslInfo, call->format);
+        break;
+    default:
+        SDL_SetError("%s", "Unknown function in capture!");
+        return false;
+    }
 
-    if (shader_formats & SDL_GPU_SHADERFORMAT_SPIRV) {
-        if (info->shader_stage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
-            SDL_GPUComputePipelineCreateInfo createInfo;
-            SDL_ShaderCross_ComputePipelineMetadata *pipelineMetadata = (SDL_ShaderCross_ComputePipelineMetadata *)metadata;
-            SDL_ShaderCross_ReflectComputeSPIRV(
-                info->bytecode,
-                info->bytecode_size,
-                pipelineMetadata);
-            createInfo.code = info->bytecode;
-            createInfo.code_size = info->bytecode_size;
-            createInfo.entrypoint = info->entrypoint;
-            createInfo.format = SDL_GPU_SHADERFORMAT_SPIRV;
-            createInfo.props = 0;
-            createInfo.num_samplers = pipelineMetadata->num_samplers;
-            createInfo.num_readonly_storage_textures = pipelineMetadata->num_readonly_storage_textures;
-            createInfo.num_readonly_storage_buffers = pipelineMetadata->num_readonly_storage_buffers;
-            createInfo.num_readwrite_storage_textures = pipelineMetadata->num_readwrite_storage_textures;
-            createInfo.num_readwrite_storage_buffers = pipelineMetadata->num_readwrite_storage_buffers;
-            createInfo.num_uniform_buffers = pipelineMetadata->num_uniform_buffers;
-            createInfo.threadcount_x = pipelineMetadata->threadcount_x;
-            createInfo.threadcount_y = pipelineMetadata->threadcount_y;
-            createInfo.threadcount_z = pipelineMetadata->threadcount_z;
-            return SDL_CreateGPUComputePipeline(device, &createInfo);
-        } else {
-            SDL_GPUShaderCreateInfo createInfo;
-            SDL_ShaderCross_GraphicsShaderMetadata *shaderMetadata = (SDL_ShaderCross_GraphicsShaderMetadata *)metadata;
-            SDL_ShaderCross_ReflectGraphicsSPIRV(
-                info->bytecode,
-                info->bytecode_size,
-                shaderMetadata);
-            createInfo.code = info->bytecode;
-            createInfo.code_size = info->bytecode_size;
-            createInfo.entrypoint = info->entrypoint;
-            createInfo.format = SDL_GPU_SHADERFORMAT_SPIRV;
-            createInfo.stage = (SDL_GPUShaderStage)info->shader_stage;
-            createInfo.props = 0;
-            createInfo.num_samplers = shaderMetadata->num_samplers;
-            createInfo.num_storage_textures = shaderMetadata->num_storage_textures;
-            createInfo.num_storage_buffers = shaderMetadata->num_storage_buffers;
-            createInfo.num_uniform_buffers = shaderMetadata->num_uniform_buffers;
-            return SDL_CreateGPUShader(device, &createInfo);
-        }
-    } else if (shader_formats & SDL_GPU_SHADERFORMAT_MSL) {
-        format = SDL_GPU_SHADERFORMAT_MSL;
-    } else {
-        if ((shader_formats & SDL_GPU_SHADERFORMAT_DXBC) && SDL_D3DCompile != NULL) {
-            format = SDL_GPU_SHADERFORMAT_DXBC;
+    success = blob != NULL;
+    *outputSize = success ? blob->size : 0;
+    SDL_ShaderCross_ReleaseBlob(blob);
+    return success;
+}
+
+bool SDL_ShaderCross_ReplayCapture(
+    SDL_IOStream *stream,
+    bool closeio,
+    SDL_ShaderCross_ReplayCallback callback,
+    void *userdata)
+{
+    if (stream == NULL) {
+        return SDL_InvalidParamError("stream");
+    }
+    if (includeCacheLock == NULL) {
+        if (closeio) {
+            SDL_CloseIO(stream);
         }
-#ifdef SDL_SHADERCROSS_DXC
-        else if (shader_formats & SDL_GPU_SHADERFORMAT_DXIL) {
-            format = SDL_GPU_SHADERFORMAT_DXIL;
+        return SDL_SetError("%s", "SDL_ShaderCross_Init has not been called!");
+    }
+
+    char magic[CAPTURE_MAGIC_SIZE];
+    Uint32 version = 0;
+    char *compilerVersions = NULL;
+    bool success = SDL_ReadIO(stream, magic, sizeof(magic)) == sizeof(magic) &&
+        SDL_memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) == 0 &&
+        SDL_ReadU32LE(stream, &version) &&
+        version == CAPTURE_VERSION &&
+        SDL_ShaderCross_INTERNAL_ReadCaptureString(stream, &compilerVersions);
+    if (!success) {
+        SDL_free(compilerVersions);
+        if (closeio) {
+            SDL_CloseIO(stream);
         }
-#endif
-        else {
-            SDL_SetError("SDL_ShaderCross_INTERNAL_CreateShaderFromSPIRV: Unexpected SDL_GPUBackend");
-            return NULL;
+        return SDL_SetError("%s", "Not a capture, or one from an incompatible version!");
+    }
+
+    char **includePaths = NULL;
+    size_t numIncludePaths = 0;
+    size_t includePathsCapacity = 0;
+
+    // A capture cut short by a crash ends partway through a record, which simply ends the replay
+    Uint32 tag;
+    while (success && SDL_ReadU32LE(stream, &tag)) {
+        if (tag == CAPTURE_RECORD_INCLUDE) {
+            char *path = NULL;
+            Uint8 *data = NULL;
+            Uint64 size = 0;
+            if (!SDL_ShaderCross_INTERNAL_ReadCaptureString(stream, &path) ||
+                path == NULL ||
+                !SDL_ShaderCross_INTERNAL_ReadCaptureBytes(stream, &data, &size)) {
+                SDL_free(path);
+                SDL_free(data);
+                break;
+            }
+
+            if (numIncludePaths == includePathsCapacity) {
+                size_t capacity = includePathsCapacity > 0 ? includePathsCapacity * 2 : 16;
+                char **paths = SDL_realloc(includePaths, capacity * sizeof(char *));
+                if (paths != NULL) {
+                    includePaths = paths;
+                    includePathsCapacity = capacity;
+                }
+            }
+            success = numIncludePaths < includePathsCapacity &&
+                SDL_ShaderCross_RegisterVirtualFile(path, data, (size_t)size);
+            if (success) {
+                includePaths[numIncludePaths++] = path;
+            } else {
+                SDL_free(path);
+            }
+            SDL_free(data);
+        } else if (tag == CAPTURE_RECORD_CALL) {
+            ReplayCall call;
+            SDL_zero(call);
+            if (!SDL_ShaderCross_INTERNAL_ReadReplayCall(stream, &call)) {
+                SDL_ShaderCross_INTERNAL_DestroyReplayCall(&call);
+                break;
+            }
+
+            SDL_ShaderCross_ReplayEvent event;
+            event.function = captureFunctionNames[call.function];
+            if (call.function == CAPTURE_COMPILE_SHADER_FOR_DEVICE && call.shaderStage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+                event.function = "SDL_ShaderCross_CompileComputePipelineFromSPIRV";
+            } else if (call.function == CAPTURE_COMPILE_HLSL_SHADER_FOR_DEVICE && call.shaderStage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+                event.function = "SDL_ShaderCross_CompileComputePipelineFromHLSL";
+            }
+            event.name = call.name;
+            event.captured_versions = compilerVersions;
+            event.thread_id = (SDL_ThreadID)call.threadID;
+            event.captured_start_ns = call.start;
+            event.captured_ns = call.duration;
+            event.captured_success = call.success != 0;
+            event.captured_cache_hit = call.cacheHit != 0;
+            event.captured_output_size = call.outputSize;
+
+            Uint64 start = SDL_GetTicksNS();
+            event.replayed_success = SDL_ShaderCross_INTERNAL_RunReplayCall(&call, &event.replayed_output_size);
+            event.replayed_ns = SDL_GetTicksNS() - start;
+            event.error = event.replayed_success ? NULL : SDL_GetError();
+
+            if (callback != NULL) {
+                callback(userdata, &event);
+            }
+            SDL_ShaderCross_INTERNAL_DestroyReplayCall(&call);
+        } else {
+            success = SDL_SetError("%s", "Invalid record in capture!");
         }
     }
 
-    return SDL_ShaderCross_INTERNAL_CompileFromSPIRV(
-        device,
-        info,
-        format,
-        metadata);
+    for (size_t i = 0; i < numIncludePaths; i += 1) {
+        SDL_ShaderCross_UnregisterVirtualFile(includePaths[i]);
+        SDL_free(includePaths[i]);
+    }
+    SDL_free(includePaths);
+    SDL_free(compilerVersions);
+    if (closeio) {
+        SDL_CloseIO(stream);
+    }
+    return success;
 }
 
-SDL_GPUShader *SDL_ShaderCross_CompileGraphicsShaderFromSPIRV(
-    SDL_GPUDevice *device,
-    const SDL_ShaderCross_SPIRV_Info *info,
-    SDL_ShaderCross_GraphicsShaderMetadata *metadata)
+// Every compiler that can contribute to an output is part of the disk cache key
+static char *SDL_ShaderCross_INTERNAL_QueryCompilerVersions(void)
 {
-    return (SDL_GPUShader *)SDL_ShaderCross_INTERNAL_CreateShaderFromSPIRV(
-        device,
-        info,
-        metadata);
+    unsigned int spvcMajor, spvcMinor, spvcPatch;
+    Uint32 dxcMajor = 0, dxcMinor = 0, dxcFlags = 0;
+    char *versions = NULL;
+
+    spvc_get_version(&spvcMajor, &spvcMinor, &spvcPatch);
+
+#ifdef SDL_SHADERCROSS_DXC
+    if (!SDL_ShaderCross_INTERNAL_GetDXCVersion(&dxcMajor, &dxcMinor, &dxcFlags)) {
+        return NULL;
+    }
+#endif
+
+    if (SDL_asprintf(
+            &versions,
+            "SDL_shadercross %d.%d.%d; SPIRV-Cross %u.%u.%u %s; DXC %" SDL_PRIu32 ".%" SDL_PRIu32 " %" SDL_PRIu32 "; FXC %s",
+            SDL_SHADERCROSS_MAJOR_VERSION,
+            SDL_SHADERCROSS_MINOR_VERSION,
+            SDL_SHADERCROSS_MICRO_VERSION,
+            spvcMajor,
+            spvcMinor,
+            spvcPatch,
+            spvc_get_commit_revision_and_timestamp(),
+            dxcMajor,
+            dxcMinor,
+            dxcFlags,
+            d3dcompiler_dll != NULL ? D3DCOMPILER_DLL : "none") < 0) {
+        return NULL;
+    }
+    return versions;
 }
 
-SDL_GPUComputePipeline *SDL_ShaderCross_CompileComputePipelineFromSPIRV(
-    SDL_GPUDevice *device,
-    const SDL_ShaderCross_SPIRV_Info *info,
-    SDL_ShaderCross_ComputePipelineMetadata *metadata)
+static SDL_AtomicInt initCount;
+
+bool SDL_ShaderCross_Init(void)
 {
-    return (SDL_GPUComputePipeline *)SDL_ShaderCross_INTERNAL_CreateShaderFromSPIRV(
-        device,
-        info,
-        metadata);
+    return SDL_ShaderCross_InitWithProperties(0);
 }
 
-bool SDL_ShaderCross_Init(void)
+bool SDL_ShaderCross_InitWithProperties(SDL_PropertiesID props)
 {
+    // Nested calls only count, so that every SDL_ShaderCross_Quit but the last is a no-op
+    if (SDL_AtomicIncRef(&initCount) > 0) {
+        return true;
+    }
+
+    includeCacheLock = SDL_CreateMutex();
+    cacheLock = SDL_CreateMutex();
+#ifdef SDL_SHADERCROSS_DXC
+    if (!SDL_ShaderCross_INTERNAL_CreateDXCPool()) {
+        SDL_ShaderCross_Quit();
+        return false;
+    }
+#endif
+    jobPoolLock = SDL_CreateMutex();
+    captureLock = SDL_CreateMutex();
+    if (includeCacheLock == NULL || cacheLock == NULL || jobPoolLock == NULL || captureLock == NULL) {
+        SDL_ShaderCross_Quit();
+        return false;
+    }
+
+    // The workers themselves are started by the first async job
+    Sint64 workerThreads = SDL_GetNumberProperty(props, SDL_SHADERCROSS_PROP_WORKER_THREADS_NUMBER, 0);
+    requestedJobWorkers = (int)SDL_clamp(workerThreads, 0, 256);
+
+    Sint64 memoryCacheBudget = SDL_GetNumberProperty(props, SDL_SHADERCROSS_PROP_MEMORY_CACHE_BUDGET_NUMBER, 0);
+    if (!SDL_ShaderCross_INTERNAL_CreateMemoryCache(memoryCacheBudget > 0 ? (Uint64)memoryCacheBudget : 0)) {
+        SDL_ShaderCross_Quit();
+        return false;
+    }
+
+    const char *cacheDirectory = SDL_GetStringProperty(props, SDL_SHADERCROSS_PROP_CACHE_DIRECTORY_STRING, NULL);
+    if (cacheDirectory != NULL && *cacheDirectory != '\0') {
+        diskCacheDirectory = SDL_strdup(cacheDirectory);
+        if (diskCacheDirectory == NULL) {
+            SDL_ShaderCross_Quit();
+            return false;
+        }
+    }
+
     d3dcompiler_dll = SDL_LoadObject(D3DCOMPILER_DLL);
 
     if (d3dcompiler_dll != NULL) {
@@ -2288,11 +7981,65 @@ bool SDL_ShaderCross_Init(void)
         }
     }
 
+    // Started last, so that the capture records the compilers that were found
+    const char *captureFile = SDL_GetStringProperty(props, SDL_SHADERCROSS_PROP_CAPTURE_FILE_STRING, NULL);
+    if (captureFile != NULL && *captureFile != '\0') {
+        SDL_IOStream *captureIO = SDL_IOFromFile(captureFile, "wb");
+        if (captureIO == NULL || !SDL_ShaderCross_StartCapture(captureIO, true)) {
+            SDL_ShaderCross_Quit();
+            return false;
+        }
+    }
+
     return true;
 }
 
 void SDL_ShaderCross_Quit(void)
 {
+    // Only the last call tears everything down, and a call without SDL_ShaderCross_Init does nothing
+    int count;
+    do {
+        count = SDL_GetAtomicInt(&initCount);
+        if (count <= 0) {
+            return;
+        }
+    } while (!SDL_CompareAndSwapAtomicInt(&initCount, count, count - 1));
+    if (count > 1) {
+        return;
+    }
+
+    // Jobs may still be using everything below
+    SDL_ShaderCross_INTERNAL_StopJobWorkers();
+    SDL_ShaderCross_INTERNAL_ReleasePendingOutputs();
+
+    if (captureLock != NULL) {
+        if (captureStream != NULL) {
+            SDL_ShaderCross_StopCapture();
+        }
+        SDL_DestroyMutex(captureLock);
+        captureLock = NULL;
+    }
+
+#ifdef SDL_SHADERCROSS_DXC
+    SDL_ShaderCross_INTERNAL_DestroyDXCPool();
+#endif
+
+    if (includeCacheLock != NULL) {
+        SDL_ShaderCross_INTERNAL_ClearIncludeCache(false);
+        SDL_DestroyMutex(includeCacheLock);
+        includeCacheLock = NULL;
+    }
+
+    if (cacheLock != NULL) {
+        SDL_ShaderCross_INTERNAL_DestroyMemoryCache();
+        SDL_DestroyMutex(cacheLock);
+        cacheLock = NULL;
+    }
+    SDL_free(diskCacheDirectory);
+    diskCacheDirectory = NULL;
+    SDL_free(cacheCompilerVersions);
+    cacheCompilerVersions = NULL;
+
     if (d3dcompiler_dll != NULL) {
         SDL_UnloadObject(d3dcompiler_dll);
         d3dcompiler_dll = NULL;
@@ -19,9 +19,31 @@
   3. This notice may not be removed or altered from any source distribution.
 */
 
+// For fdopen and friends in a strict C99 build, they are always visible on Apple platforms
+#if !defined(_WIN32) && !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <SDL3_shadercross/SDL_shadercross.h>
 #include <SDL3/SDL_log.h>
 #include <SDL3/SDL_iostream.h>
+#include <stdio.h>
+
+#ifndef SDL_PLATFORM_WINDOWS
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#define SHADERCROSS_SOCKETS
+#else
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#endif
 
 // We can emit HLSL and JSON as a destination, so let's redefine the shader format enum.
 typedef enum ShaderCross_DestinationFormat {
@@ -34,22 +56,66 @@ typedef enum ShaderCross_DestinationFormat {
     SHADERFORMAT_JSON
 } ShaderCross_ShaderFormat;
 
+#define MAX_OUTPUTS 16
+
 void print_help(void)
 {
     int column_width = 32;
     SDL_Log("Usage: shadercross <input> [options]");
+    SDL_Log("       shadercross --batch <manifest> [-j <jobs>] [options]");
+    SDL_Log("       shadercross --server [--socket <path>] [-j <jobs>] [options]");
+    SDL_Log("       shadercross --client --socket <path> <input> [options]");
+    SDL_Log("       shadercross --replay <capture> [options]");
     SDL_Log("Required options:\n");
     SDL_Log("  %-*s %s", column_width, "-s | --source <value>", "Source language format. May be inferred from the filename. Values: [SPIRV, HLSL]");
     SDL_Log("  %-*s %s", column_width, "-d | --dest <value>", "Destination format. May be inferred from the filename. Values: [DXBC, DXIL, MSL, SPIRV, HLSL, JSON]");
+    SDL_Log("  %-*s %s", column_width, "", "A comma-separated list produces one output per format, e.g. DXIL,MSL,JSON.");
     SDL_Log("  %-*s %s", column_width, "-t | --stage <value>", "Shader stage. May be inferred from the filename. Values: [vertex, fragment, compute]");
     SDL_Log("  %-*s %s", column_width, "-e | --entrypoint <value>", "Entrypoint function name. Default: \"main\".");
-    SDL_Log("  %-*s %s", column_width, "-o | --output <value>", "Output file.");
+    SDL_Log("  %-*s %s", column_width, "-o | --output <value>", "Output file. Repeat once per destination format, in the same order.");
     SDL_Log("\n");
     SDL_Log("Optional options:\n");
-    SDL_Log("  %-*s %s", column_width, "-I | --include <value>", "HLSL include directory. Only used with HLSL source.");
+    SDL_Log("  %-*s %s", column_width, "-I | --include <value>", "HLSL include directory. May be repeated. Only used with HLSL source.");
     SDL_Log("  %-*s %s", column_width, "-D<name>[=<value>]", "HLSL define. Only used with HLSL source. Can be repeated.");
     SDL_Log("  %-*s %s", column_width, "", "If =<value> is omitted the define will be treated as equal to 1.");
     SDL_Log("  %-*s %s", column_width, "-g | --debug", "Generate debug information when possible.");
+    SDL_Log("  %-*s %s", column_width, "--shadermodel <value>", "HLSL shader model to target, e.g. 6.2. Default: 6.0 for DXIL/SPIRV, 5.1 for DXBC.");
+    SDL_Log("  %-*s %s", column_width, "-O0 | -O1 | -O2 | -O3", "Optimization level. Default: the compiler's default.");
+    SDL_Log("  %-*s %s", column_width, "--skip-validation", "Skip validation of the compiled shader.");
+    SDL_Log("  %-*s %s", column_width, "--all-resources-bound", "Assume all resources are bound when the shader runs.");
+    SDL_Log("  %-*s %s", column_width, "--avoid-flow-control", "Avoid flow control constructs where possible.");
+    SDL_Log("  %-*s %s", column_width, "--direct-dxil", "Compile HLSL to DXIL without the SPIR-V roundtrip when its bindings already match SDL_GPU's.");
+    SDL_Log("  %-*s %s", column_width, "--cache-dir <value>", "Directory in which to cache compile results across runs.");
+    SDL_Log("  %-*s %s", column_width, "--cwd <value>", "Resolve relative input, output, include, depfile and stats paths against this directory.");
+    SDL_Log("  %-*s %s", column_width, "-MD", "Write a Make/Ninja depfile listing the files the input includes, to <output>.d.");
+    SDL_Log("  %-*s %s", column_width, "-MF <value>", "Write the depfile to the given path instead. Implies -MD.");
+    SDL_Log("  %-*s %s", column_width, "--incremental", "Skip the compile if the input, options and includes are unchanged since the last one.");
+    SDL_Log("  %-*s %s", column_width, "", "The hashes are kept in <output>.sxstamp.");
+    SDL_Log("  %-*s %s", column_width, "--time", "Print the time spent in each stage of the compile, the input and output sizes and peak memory.");
+    SDL_Log("  %-*s %s", column_width, "--stats <value>", "Write the same as JSON to the given file. With --batch, both cover the whole batch");
+    SDL_Log("  %-*s %s", column_width, "", "and list the slowest items.");
+    SDL_Log("  %-*s %s", column_width, "--trace <value>", "Write a Chrome trace of every compile this process runs, for chrome://tracing or Perfetto.");
+    SDL_Log("  %-*s %s", column_width, "--capture <value>", "Capture every compile this process runs, with all of its inputs, for --replay.");
+    SDL_Log("\n");
+    SDL_Log("Batch options:\n");
+    SDL_Log("  %-*s %s", column_width, "--batch <value>", "Compile every item listed in a manifest file, in a single process.");
+    SDL_Log("  %-*s %s", column_width, "", "Each line holds the arguments for one compile, e.g. \"a.frag.hlsl -o a.frag.dxil -DX=1\".");
+    SDL_Log("  %-*s %s", column_width, "", "Blank lines and lines starting with # are skipped. Other options apply to every line.");
+    SDL_Log("  %-*s %s", column_width, "-j | --jobs <value>", "Number of items to compile in parallel. Default: 1, or the number of CPU cores for --server.");
+    SDL_Log("\n");
+    SDL_Log("Server options:\n");
+    SDL_Log("  %-*s %s", column_width, "--server", "Keep running and serve compiles, one batch line per request, on stdin/stdout or --socket.");
+    SDL_Log("  %-*s %s", column_width, "", "Other options apply to every request. Relative paths are resolved against the server's directory.");
+    SDL_Log("  %-*s %s", column_width, "", "Messages go back to the client, except compiler warnings from work the library runs on its");
+    SDL_Log("  %-*s %s", column_width, "", "thread pool, such as several targets at once, which go to the server's log.");
+    SDL_Log("  %-*s %s", column_width, "--client", "Forward this compile to the server listening on --socket, with this directory as --cwd.");
+    SDL_Log("  %-*s %s", column_width, "", "Compiles locally if no server is listening.");
+    SDL_Log("  %-*s %s", column_width, "--socket <value>", "Path of the local socket the server listens on. Not available on Windows.");
+    SDL_Log("\n");
+    SDL_Log("Replay options:\n");
+    SDL_Log("  %-*s %s", column_width, "--replay <value>", "Run the compiles in a capture again and compare their times with the captured ones.");
+    SDL_Log("  %-*s %s", column_width, "", "The capture can come from --capture or any program using SDL_SHADERCROSS_PROP_CAPTURE_FILE_STRING.");
+    SDL_Log("  %-*s %s", column_width, "", "Replayed calls bypass the caches. --stats writes the comparison as JSON and --time adds peak memory.");
 }
 
 void write_graphics_reflect_json(SDL_IOStream *outputIO, SDL_ShaderCross_GraphicsShaderMetadata *info)
@@ -81,137 +147,227 @@ void write_compute_reflect_json(SDL_IOStream *outputIO, SDL_ShaderCross_ComputeP
     );
 }
 
-int main(int argc, char *argv[])
+typedef struct CompileOptions
 {
-    bool sourceValid = false;
-    bool destinationValid = false;
-    bool stageValid = false;
+    bool sourceValid;
+    bool stageValid;
 
-    bool spirvSource = false;
-    ShaderCross_ShaderFormat destinationFormat = SHADERFORMAT_INVALID;
-    SDL_ShaderCross_ShaderStage shaderStage = SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
-    char *outputFilename = NULL;
-    char *entrypointName = "main";
-    char *includeDir = NULL;
+    bool spirvSource;
+    ShaderCross_ShaderFormat destinationFormats[MAX_OUTPUTS];
+    size_t numDestinationFormats;
+    SDL_ShaderCross_ShaderStage shaderStage;
+    char *filename;
+    char *outputFilenames[MAX_OUTPUTS];
+    size_t numOutputFilenames;
+    char *entrypointName;
+    char *includeDir;
+    const char **extraIncludeDirs;
+    size_t numExtraIncludeDirs;
+    SDL_ShaderCross_HLSL_Define *defines;
+    size_t numDefines;
+    int shaderModel;
+    int optimizationLevel;
+    bool skipValidation;
+    bool allResourcesBound;
+    bool avoidFlowControl;
+    bool enableDebug;
+    bool directDxil;
+    bool writeDepfile;
+    char *depfilePath;
+    bool incremental;
+    bool printTimes;
+    char *statsPath;
+    char *cwd;
+    char **resolvedPaths; // Paths made absolute against cwd, owned by the options
+    int numResolvedPaths;
 
-    char *filename = NULL;
-    size_t fileSize = 0;
-    void *fileData = NULL;
-    bool accept_optionals = true;
+    // These apply to the whole process rather than to a single compile
+    bool showHelp;
+    char *cacheDir;
+    char *batchFilename;
+    int numJobs; // 0 when not given
+    bool server;
+    bool client;
+    char *socketPath;
+    char *tracePath;
+    char *capturePath;
+    char *replayPath;
+} CompileOptions;
+
+void init_options(CompileOptions *options)
+{
+    SDL_zerop(options);
+    options->shaderStage = SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
+    options->entrypointName = "main";
+    options->optimizationLevel = -1;
+}
+
+void free_options(CompileOptions *options)
+{
+    for (size_t i = 0; i < options->numDefines; i += 1) {
+        SDL_free(options->defines[i].name);
+    }
+    SDL_free(options->defines);
+    SDL_free(options->extraIncludeDirs);
+    for (int i = 0; i < options->numResolvedPaths; i += 1) {
+        SDL_free(options->resolvedPaths[i]);
+    }
+    SDL_free(options->resolvedPaths);
+    init_options(options);
+}
+
+ShaderCross_ShaderFormat parse_destination_format(const char *name, size_t len)
+{
+    static const struct {
+        const char *name;
+        ShaderCross_ShaderFormat format;
+    } formats[] = {
+        { "DXBC", SHADERFORMAT_DXBC },
+        { "DXIL", SHADERFORMAT_DXIL },
+        { "MSL", SHADERFORMAT_MSL },
+        { "SPIRV", SHADERFORMAT_SPIRV },
+        { "HLSL", SHADERFORMAT_HLSL },
+        { "JSON", SHADERFORMAT_JSON }
+    };
 
-    SDL_ShaderCross_HLSL_Define *defines = NULL;
-    size_t numDefines = 0;
+    for (size_t i = 0; i < SDL_arraysize(formats); i += 1) {
+        if (SDL_strlen(formats[i].name) == len && SDL_strncasecmp(name, formats[i].name, len) == 0) {
+            return formats[i].format;
+        }
+    }
+    return SHADERFORMAT_INVALID;
+}
 
-    bool enableDebug = false;
+// Parses argv[1] onwards. The options point into argv, so it has to outlive them.
+bool parse_args(int argc, char *argv[], CompileOptions *options)
+{
+    bool accept_optionals = true;
 
     for (int i = 1; i < argc; i += 1) {
         char *arg = argv[i];
 
         if (accept_optionals && arg[0] == '-') {
             if (SDL_strcmp(arg, "-h") == 0 || SDL_strcmp(arg, "--help") == 0) {
-                print_help();
-                return 0;
+                options->showHelp = true;
             } else if (SDL_strcmp(arg, "-s") == 0 || SDL_strcmp(arg, "--source") == 0) {
                 if (i + 1 >= argc) {
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
-                    print_help();
-                    return 1;
+                    return false;
                 }
                 i += 1;
                 if (SDL_strcasecmp(argv[i], "spirv") == 0) {
-                    spirvSource = true;
-                    sourceValid = true;
+                    options->spirvSource = true;
+                    options->sourceValid = true;
                 } else if (SDL_strcasecmp(argv[i], "hlsl") == 0) {
-                    spirvSource = false;
-                    sourceValid = true;
+                    options->spirvSource = false;
+                    options->sourceValid = true;
                 } else {
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unrecognized source input %s, source must be SPIRV or HLSL!", argv[i]);
-                    print_help();
-                    return 1;
+                    return false;
                 }
             } else if (SDL_strcmp(arg, "-d") == 0 || SDL_strcmp(arg, "--dest") == 0) {
                 if (i + 1 >= argc) {
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
-                    print_help();
-                    return 1;
+                    return false;
                 }
                 i += 1;
-                if (SDL_strcasecmp(argv[i], "DXBC") == 0) {
-                    destinationFormat = SHADERFORMAT_DXBC;
-                    destinationValid = true;
-                } else if (SDL_strcasecmp(argv[i], "DXIL") == 0) {
-                    destinationFormat = SHADERFORMAT_DXIL;
-                    destinationValid = true;
-                } else if (SDL_strcasecmp(argv[i], "MSL") == 0) {
-                    destinationFormat = SHADERFORMAT_MSL;
-                    destinationValid = true;
-                } else if (SDL_strcasecmp(argv[i], "SPIRV") == 0) {
-                    destinationFormat = SHADERFORMAT_SPIRV;
-                    destinationValid = true;
-                } else if (SDL_strcasecmp(argv[i], "HLSL") == 0) {
-                    destinationFormat = SHADERFORMAT_HLSL;
-                    destinationValid = true;
-                } else if (SDL_strcasecmp(argv[i], "JSON") == 0) {
-                    destinationFormat = SHADERFORMAT_JSON;
-                    destinationValid = true;
-                } else {
-                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unrecognized destination input %s, destination must be DXBC, DXIL, MSL or SPIRV!", argv[i]);
-                    print_help();
-                    return 1;
+                // A later --dest replaces the earlier ones
+                options->numDestinationFormats = 0;
+                char *formats = argv[i];
+                for (;;) {
+                    char *comma = SDL_strchr(formats, ',');
+                    size_t len = comma != NULL ? (size_t)(comma - formats) : SDL_strlen(formats);
+                    ShaderCross_ShaderFormat format = parse_destination_format(formats, len);
+                    if (format == SHADERFORMAT_INVALID) {
+                        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unrecognized destination input %s, destination must be DXBC, DXIL, MSL, SPIRV, HLSL or JSON!", argv[i]);
+                        return false;
+                    }
+                    if (options->numDestinationFormats == MAX_OUTPUTS) {
+                        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Too many destination formats, at most %d are allowed!", MAX_OUTPUTS);
+                        return false;
+                    }
+                    options->destinationFormats[options->numDestinationFormats++] = format;
+                    if (comma == NULL) {
+                        break;
+                    }
+                    formats = comma + 1;
                 }
             } else if (SDL_strcmp(arg, "-t") == 0 || SDL_strcmp(arg, "--stage") == 0) {
                 if (i + 1 >= argc) {
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
-                    print_help();
-                    return 1;
+                    return false;
                 }
                 i += 1;
                 if (SDL_strcasecmp(argv[i], "vertex") == 0) {
-                    shaderStage = SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
-                    stageValid = true;
+                    options->shaderStage = SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
+                    options->stageValid = true;
                 } else if (SDL_strcasecmp(argv[i], "fragment") == 0) {
-                    shaderStage = SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
-                    stageValid = true;
+                    options->shaderStage = SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+                    options->stageValid = true;
                 } else if (SDL_strcasecmp(argv[i], "compute") == 0) {
-                    shaderStage = SDL_SHADERCROSS_SHADERSTAGE_COMPUTE;
-                    stageValid = true;
+                    options->shaderStage = SDL_SHADERCROSS_SHADERSTAGE_COMPUTE;
+                    options->stageValid = true;
                 } else {
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unrecognized shader stage input %s, must be vertex, fragment, or compute.", argv[i]);
-                    print_help();
-                    return 1;
+                    return false;
                 }
             } else if (SDL_strcmp(arg, "-e") == 0 || SDL_strcmp(arg, "--entrypoint") == 0) {
                 if (i + 1 >= argc) {
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
-                    print_help();
-                    return 1;
+                    return false;
                 }
                 i += 1;
-                entrypointName = argv[i];
+                options->entrypointName = argv[i];
             } else if (SDL_strcmp(arg, "-I") == 0 || SDL_strcmp(arg, "--include") == 0) {
-                if (includeDir) {
-                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "'%s' can only be used once", arg);
-                    print_help();
-                    return 1;
-                }
                 if (i + 1 >= argc) {
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
-                    print_help();
-                    return 1;
+                    return false;
                 }
                 i += 1;
-                includeDir = argv[i];
+                if (options->includeDir == NULL) {
+                    options->includeDir = argv[i];
+                } else {
+                    // Keep the array NULL-terminated for SDL_SHADERCROSS_PROP_HLSL_INCLUDE_DIRS_POINTER
+                    options->extraIncludeDirs = SDL_realloc(options->extraIncludeDirs, sizeof(const char *) * (options->numExtraIncludeDirs + 2));
+                    options->extraIncludeDirs[options->numExtraIncludeDirs++] = argv[i];
+                    options->extraIncludeDirs[options->numExtraIncludeDirs] = NULL;
+                }
             } else if (SDL_strcmp(arg, "-o") == 0 || SDL_strcmp(arg, "--output") == 0) {
                 if (i + 1 >= argc) {
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
-                    print_help();
-                    return 1;
+                    return false;
+                }
+                i += 1;
+                if (options->numOutputFilenames == MAX_OUTPUTS) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Too many outputs, at most %d are allowed!", MAX_OUTPUTS);
+                    return false;
+                }
+                options->outputFilenames[options->numOutputFilenames++] = argv[i];
+            } else if (SDL_strcmp(arg, "--incremental") == 0) {
+                options->incremental = true;
+            } else if (SDL_strcmp(arg, "--time") == 0) {
+                options->printTimes = true;
+            } else if (SDL_strcmp(arg, "--stats") == 0) {
+                if (i + 1 >= argc) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
+                    return false;
+                }
+                i += 1;
+                options->statsPath = argv[i];
+            } else if (SDL_strcmp(arg, "-MD") == 0) {
+                options->writeDepfile = true;
+            } else if (SDL_strcmp(arg, "-MF") == 0) {
+                if (i + 1 >= argc) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
+                    return false;
                 }
                 i += 1;
-                outputFilename = argv[i];
+                options->writeDepfile = true;
+                options->depfilePath = argv[i];
             } else if (SDL_strncmp(argv[i], "-D", SDL_strlen("-D")) == 0) {
-                numDefines += 1;
-                defines = SDL_realloc(defines, sizeof(SDL_ShaderCross_HLSL_Define) * numDefines);
+                // Keep the array NULL-terminated for SDL_ShaderCross_HLSL_Info
+                size_t numDefines = options->numDefines += 1;
+                SDL_ShaderCross_HLSL_Define *defines = options->defines = SDL_realloc(options->defines, sizeof(SDL_ShaderCross_HLSL_Define) * (numDefines + 1));
                 char *equalSign = SDL_strchr(argv[i], '=');
                 if (equalSign != NULL) {
                     defines[numDefines - 1].value = equalSign + 1;
@@ -224,145 +380,689 @@ int main(int argc, char *argv[])
                     defines[numDefines - 1].name = SDL_malloc(len);
                     SDL_utf8strlcpy(defines[numDefines - 1].name, (const char *)argv[i] + 2, len);
                 }
+                defines[numDefines].name = NULL;
+                defines[numDefines].value = NULL;
             } else if (SDL_strcmp(argv[i], "-g") == 0 || SDL_strcmp(arg, "--debug") == 0) {
-                enableDebug = true;
+                options->enableDebug = true;
+            } else if (SDL_strcmp(arg, "--shadermodel") == 0) {
+                if (i + 1 >= argc) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
+                    return false;
+                }
+                i += 1;
+                // Accept "6.2", "6_2" and "62"
+                int major = 0, minor = 0;
+                if (SDL_sscanf(argv[i], "%d.%d", &major, &minor) == 2 || SDL_sscanf(argv[i], "%d_%d", &major, &minor) == 2) {
+                    options->shaderModel = major * 10 + minor;
+                } else {
+                    options->shaderModel = SDL_atoi(argv[i]);
+                }
+                if (options->shaderModel < 50 || options->shaderModel > 69 || minor > 9) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unrecognized shader model %s!", argv[i]);
+                    return false;
+                }
+            } else if (SDL_strcmp(arg, "-O0") == 0 || SDL_strcmp(arg, "-O1") == 0 || SDL_strcmp(arg, "-O2") == 0 || SDL_strcmp(arg, "-O3") == 0) {
+                options->optimizationLevel = arg[2] - '0';
+            } else if (SDL_strcmp(arg, "--skip-validation") == 0) {
+                options->skipValidation = true;
+            } else if (SDL_strcmp(arg, "--all-resources-bound") == 0) {
+                options->allResourcesBound = true;
+            } else if (SDL_strcmp(arg, "--avoid-flow-control") == 0) {
+                options->avoidFlowControl = true;
+            } else if (SDL_strcmp(arg, "--direct-dxil") == 0) {
+                options->directDxil = true;
+            } else if (SDL_strcmp(arg, "--cache-dir") == 0) {
+                if (i + 1 >= argc) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
+                    return false;
+                }
+                i += 1;
+                options->cacheDir = argv[i];
+            } else if (SDL_strcmp(arg, "--trace") == 0) {
+                if (i + 1 >= argc) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
+                    return false;
+                }
+                i += 1;
+                options->tracePath = argv[i];
+            } else if (SDL_strcmp(arg, "--capture") == 0) {
+                if (i + 1 >= argc) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
+                    return false;
+                }
+                i += 1;
+                options->capturePath = argv[i];
+            } else if (SDL_strcmp(arg, "--replay") == 0) {
+                if (i + 1 >= argc) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
+                    return false;
+                }
+                i += 1;
+                options->replayPath = argv[i];
+            } else if (SDL_strcmp(arg, "--batch") == 0) {
+                if (i + 1 >= argc) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
+                    return false;
+                }
+                i += 1;
+                options->batchFilename = argv[i];
+            } else if (SDL_strcmp(arg, "-j") == 0 || SDL_strcmp(arg, "--jobs") == 0) {
+                if (i + 1 >= argc) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
+                    return false;
+                }
+                i += 1;
+                options->numJobs = SDL_atoi(argv[i]);
+                if (options->numJobs < 1) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Invalid number of jobs %s!", argv[i]);
+                    return false;
+                }
+            } else if (SDL_strcmp(arg, "--server") == 0) {
+                options->server = true;
+            } else if (SDL_strcmp(arg, "--client") == 0) {
+                options->client = true;
+            } else if (SDL_strcmp(arg, "--socket") == 0) {
+                if (i + 1 >= argc) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
+                    return false;
+                }
+                i += 1;
+                options->socketPath = argv[i];
+            } else if (SDL_strcmp(arg, "--cwd") == 0) {
+                if (i + 1 >= argc) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s requires an argument", arg);
+                    return false;
+                }
+                i += 1;
+                options->cwd = argv[i];
             } else if (SDL_strcmp(arg, "--") == 0) {
                 accept_optionals = false;
             } else {
                 SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: Unknown argument: %s", argv[0], arg);
-                print_help();
-                return 1;
+                return false;
             }
-        } else if (!filename) {
-            filename = arg;
+        } else if (!options->filename) {
+            options->filename = arg;
         } else {
             SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: Unknown argument: %s", argv[0], arg);
-            print_help();
-            return 1;
+            return false;
         }
     }
-    if (!filename) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: missing input path", argv[0]);
-        print_help();
-        return 1;
+
+    return true;
+}
+
+bool is_absolute_path(const char *path)
+{
+    return path[0] == '/' || path[0] == '\\' || (SDL_isalpha(path[0]) && path[1] == ':');
+}
+
+// Returns the path as is if it is absolute or there is no --cwd
+char *resolve_path(CompileOptions *options, char *path)
+{
+    if (options->cwd == NULL || path == NULL || is_absolute_path(path)) {
+        return path;
     }
-    if (!outputFilename) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: missing output path", argv[0]);
-        print_help();
-        return 1;
+
+    size_t cwdLength = SDL_strlen(options->cwd);
+    bool separated = cwdLength > 0 && (options->cwd[cwdLength - 1] == '/' || options->cwd[cwdLength - 1] == '\\');
+    char *resolved = NULL;
+    if (SDL_asprintf(&resolved, "%s%s%s", options->cwd, separated ? "" : "/", path) < 0) {
+        return path;
     }
-    fileData = SDL_LoadFile(filename, &fileSize);
-    if (fileData == NULL) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Invalid file (%s)", SDL_GetError());
-        return 1;
+    options->resolvedPaths = SDL_realloc(options->resolvedPaths, sizeof(char *) * (options->numResolvedPaths + 1));
+    options->resolvedPaths[options->numResolvedPaths++] = resolved;
+    return resolved;
+}
+
+/* The inverse of resolve_path, for paths written to depfiles, so that they
+ * name the same targets and prerequisites as a compile run in --cwd would.
+ */
+const char *get_relative_path(const CompileOptions *options, const char *path)
+{
+    if (options->cwd == NULL) {
+        return path;
+    }
+    size_t cwdLength = SDL_strlen(options->cwd);
+    while (cwdLength > 0 && (options->cwd[cwdLength - 1] == '/' || options->cwd[cwdLength - 1] == '\\')) {
+        cwdLength -= 1;
+    }
+    if (SDL_strncmp(path, options->cwd, cwdLength) == 0 && (path[cwdLength] == '/' || path[cwdLength] == '\\')) {
+        return path + cwdLength + 1;
+    }
+    return path;
+}
+
+// Makes every path of a compile absolute, for a server compiling on behalf of a client in another directory
+void resolve_paths(CompileOptions *options)
+{
+    if (options->cwd == NULL) {
+        return;
     }
 
-    if (!SDL_ShaderCross_Init())
-    {
-        SDL_LogError(SDL_LOG_CATEGORY_GPU, "%s", "Failed to initialize shadercross!");
-        return 1;
+    options->filename = resolve_path(options, options->filename);
+    for (size_t i = 0; i < options->numOutputFilenames; i += 1) {
+        options->outputFilenames[i] = resolve_path(options, options->outputFilenames[i]);
+    }
+    // Without -I, includes are searched for in the current directory
+    options->includeDir = options->includeDir != NULL ? resolve_path(options, options->includeDir) : options->cwd;
+    for (size_t i = 0; i < options->numExtraIncludeDirs; i += 1) {
+        options->extraIncludeDirs[i] = resolve_path(options, (char *)options->extraIncludeDirs[i]);
+    }
+    options->depfilePath = resolve_path(options, options->depfilePath);
+    options->statsPath = resolve_path(options, options->statsPath);
+}
+
+// Checks that a single compile is fully described, inferring what was left out from the filenames.
+bool finish_options(const char *program, CompileOptions *options)
+{
+    if (!options->filename) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: missing input path", program);
+        return false;
+    }
+    if (options->numOutputFilenames == 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: missing output path", program);
+        return false;
     }
 
-    if (!sourceValid) {
-        if (SDL_strstr(filename, ".spv")) {
-            spirvSource = true;
-        } else if (SDL_strstr(filename, ".hlsl")) {
-            spirvSource = false;
+    if (!options->sourceValid) {
+        if (SDL_strstr(options->filename, ".spv")) {
+            options->spirvSource = true;
+        } else if (SDL_strstr(options->filename, ".hlsl")) {
+            options->spirvSource = false;
         } else {
             SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", "Could not infer source format!");
-            print_help();
-            return 1;
+            return false;
         }
     }
 
-    if (!destinationValid) {
-        if (SDL_strstr(outputFilename, ".dxbc")) {
-            destinationFormat = SHADERFORMAT_DXBC;
-        } else if (SDL_strstr(outputFilename, ".dxil")) {
-            destinationFormat = SHADERFORMAT_DXIL;
-        } else if (SDL_strstr(outputFilename, ".msl")) {
-            destinationFormat = SHADERFORMAT_MSL;
-        } else if (SDL_strstr(outputFilename, ".spv")) {
-            destinationFormat = SHADERFORMAT_SPIRV;
-        } else if (SDL_strstr(outputFilename, ".hlsl")) {
-            destinationFormat = SHADERFORMAT_HLSL;
-        } else if (SDL_strstr(outputFilename, ".json")) {
-            destinationFormat = SHADERFORMAT_JSON;
-        } else {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", "Could not infer destination format!");
-            print_help();
-            return 1;
+    if (options->numDestinationFormats == 0) {
+        for (size_t i = 0; i < options->numOutputFilenames; i += 1) {
+            const char *outputFilename = options->outputFilenames[i];
+            ShaderCross_ShaderFormat format;
+            if (SDL_strstr(outputFilename, ".dxbc")) {
+                format = SHADERFORMAT_DXBC;
+            } else if (SDL_strstr(outputFilename, ".dxil")) {
+                format = SHADERFORMAT_DXIL;
+            } else if (SDL_strstr(outputFilename, ".msl")) {
+                format = SHADERFORMAT_MSL;
+            } else if (SDL_strstr(outputFilename, ".spv")) {
+                format = SHADERFORMAT_SPIRV;
+            } else if (SDL_strstr(outputFilename, ".hlsl")) {
+                format = SHADERFORMAT_HLSL;
+            } else if (SDL_strstr(outputFilename, ".json")) {
+                format = SHADERFORMAT_JSON;
+            } else {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", "Could not infer destination format!");
+                return false;
+            }
+            options->destinationFormats[i] = format;
         }
+        options->numDestinationFormats = options->numOutputFilenames;
+    } else if (options->numDestinationFormats != options->numOutputFilenames) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: %d destination formats were given for %d outputs", program, (int)options->numDestinationFormats, (int)options->numOutputFilenames);
+        return false;
     }
 
-    if (!stageValid) {
-        if (SDL_strcasestr(filename, ".vert")) {
-            shaderStage = SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
-        } else if (SDL_strcasestr(filename, ".frag")) {
-            shaderStage = SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
-        } else if (SDL_strcasestr(filename, ".comp")) {
-            shaderStage = SDL_SHADERCROSS_SHADERSTAGE_COMPUTE;
+    if (!options->stageValid) {
+        if (SDL_strcasestr(options->filename, ".vert")) {
+            options->shaderStage = SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
+        } else if (SDL_strcasestr(options->filename, ".frag")) {
+            options->shaderStage = SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+        } else if (SDL_strcasestr(options->filename, ".comp")) {
+            options->shaderStage = SDL_SHADERCROSS_SHADERSTAGE_COMPUTE;
         } else {
             SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not infer shader stage from filename!");
-            print_help();
-            return 1;
+            return false;
         }
     }
 
-    SDL_IOStream *outputIO = SDL_IOFromFile(outputFilename, "w");
+    resolve_paths(options);
+    return true;
+}
+
+SDL_PropertiesID create_compile_props(const CompileOptions *options, size_t fileSize)
+{
+    SDL_PropertiesID props = SDL_CreateProperties();
+    if (options->extraIncludeDirs != NULL) {
+        SDL_SetPointerProperty(props, SDL_SHADERCROSS_PROP_HLSL_INCLUDE_DIRS_POINTER, (void *)options->extraIncludeDirs);
+    }
+    SDL_SetBooleanProperty(props, SDL_SHADERCROSS_PROP_HLSL_DXIL_DIRECT_BOOLEAN, options->directDxil);
+    if (options->shaderModel != 0) {
+        SDL_SetNumberProperty(props, SDL_SHADERCROSS_PROP_SHADER_MODEL_NUMBER, options->shaderModel);
+    }
+    if (options->optimizationLevel >= 0) {
+        SDL_SetNumberProperty(props, SDL_SHADERCROSS_PROP_OPTIMIZATION_LEVEL_NUMBER, options->optimizationLevel);
+    }
+    SDL_SetBooleanProperty(props, SDL_SHADERCROSS_PROP_SKIP_VALIDATION_BOOLEAN, options->skipValidation);
+    SDL_SetBooleanProperty(props, SDL_SHADERCROSS_PROP_ALL_RESOURCES_BOUND_BOOLEAN, options->allResourcesBound);
+    SDL_SetBooleanProperty(props, SDL_SHADERCROSS_PROP_AVOID_FLOW_CONTROL_BOOLEAN, options->avoidFlowControl);
+    if (!options->spirvSource) {
+        SDL_SetNumberProperty(props, SDL_SHADERCROSS_PROP_HLSL_SOURCE_SIZE_NUMBER, (Sint64)fileSize);
+    }
+    return props;
+}
+
+/* Timing
+ *
+ * The stages between loading the input and writing the outputs are timed by
+ * the library, and follow the order of SDL_ShaderCross_CompilePhase.
+ */
+
+#define STAGE_LOAD 0
+#define STAGE_WRITE (SDL_SHADERCROSS_PHASE_COUNT + 1)
+#define NUM_STAGES (SDL_SHADERCROSS_PHASE_COUNT + 2)
+#define NUM_SLOWEST_ITEMS 10
+
+static const struct {
+    const char *label;
+    const char *key;
+} stages[NUM_STAGES] = {
+    { "file load", "file_load" },
+    { "DXC front end", "dxc_frontend" },
+    { "SPIR-V parse", "spirv_parse" },
+    { "reflection", "reflection" },
+    { "SPIRV-Cross codegen", "codegen" },
+    { "DXC back end", "dxc_backend" },
+    { "FXC", "fxc" },
+    { "GPU object creation", "gpu_object" },
+    { "write", "write" }
+};
+
+typedef struct ItemStats
+{
+    Uint64 stageNS[NUM_STAGES];
+    Uint32 stageCount[NUM_STAGES]; // Only counted for the library's stages
+    Uint32 cacheHits;
+    Uint64 totalNS;
+    Uint64 inputSize;
+    Uint64 outputSize;
+    bool upToDate;
+} ItemStats;
+
+Uint64 begin_stage(const ItemStats *stats)
+{
+    return stats != NULL ? SDL_GetTicksNS() : 0;
+}
+
+void end_stage(ItemStats *stats, int stage, Uint64 start)
+{
+    if (stats != NULL) {
+        stats->stageNS[stage] += SDL_GetTicksNS() - start;
+    }
+}
+
+// Reflection for JSON output is not part of a compile the library can time, so it is timed here
+void end_reflection(ItemStats *stats, Uint64 start)
+{
+    if (stats != NULL) {
+        stats->stageNS[1 + SDL_SHADERCROSS_PHASE_REFLECTION] += SDL_GetTicksNS() - start;
+        stats->stageCount[1 + SDL_SHADERCROSS_PHASE_REFLECTION] += 1;
+    }
+}
+
+// Returns 0 where it cannot be measured
+Uint64 get_peak_memory(void)
+{
+#ifdef SDL_PLATFORM_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef SDL_PLATFORM_APPLE
+    return (Uint64)usage.ru_maxrss;
+#else
+    return (Uint64)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+double to_ms(Uint64 ns)
+{
+    return (double)ns / SDL_NS_PER_MS;
+}
+
+void add_stats(ItemStats *total, const ItemStats *stats)
+{
+    for (int i = 0; i < NUM_STAGES; i += 1) {
+        total->stageNS[i] += stats->stageNS[i];
+        total->stageCount[i] += stats->stageCount[i];
+    }
+    total->cacheHits += stats->cacheHits;
+    total->totalNS += stats->totalNS;
+    total->inputSize += stats->inputSize;
+    total->outputSize += stats->outputSize;
+}
+
+void log_stats(const char *name, const ItemStats *stats)
+{
+    int column_width = 20;
+    SDL_Log("%s: %.3f ms%s", name, to_ms(stats->totalNS), stats->upToDate ? " (up to date)" : "");
+    for (int i = 0; i < NUM_STAGES; i += 1) {
+        if (stats->stageNS[i] == 0 && stats->stageCount[i] == 0) {
+            continue;
+        }
+        if (i == STAGE_LOAD || i == STAGE_WRITE) {
+            SDL_Log("  %-*s %10.3f ms", column_width, stages[i].label, to_ms(stats->stageNS[i]));
+        } else {
+            SDL_Log("  %-*s %10.3f ms  x%u", column_width, stages[i].label, to_ms(stats->stageNS[i]), stats->stageCount[i]);
+        }
+    }
+    if (stats->cacheHits > 0) {
+        SDL_Log("  %-*s %10u", column_width, "cache hits", stats->cacheHits);
+    }
+    SDL_Log("  %-*s %10" SDL_PRIu64 " bytes", column_width, "input", stats->inputSize);
+    SDL_Log("  %-*s %10" SDL_PRIu64 " bytes", column_width, "output", stats->outputSize);
+}
+
+void log_peak_memory(void)
+{
+    Uint64 peakMemory = get_peak_memory();
+    if (peakMemory != 0) {
+        SDL_Log("peak memory: %.1f MiB", (double)peakMemory / (1024.0 * 1024.0));
+    }
+}
+
+void write_json_string(SDL_IOStream *io, const char *str)
+{
+    if (str == NULL) {
+        SDL_IOprintf(io, "null");
+        return;
+    }
+    SDL_IOprintf(io, "\"");
+    for (const char *c = str; *c != '\0'; c += 1) {
+        if (*c == '"' || *c == '\\') {
+            SDL_IOprintf(io, "\\%c", *c);
+        } else if ((unsigned char)*c < 0x20) {
+            SDL_IOprintf(io, "\\u%04x", (unsigned char)*c);
+        } else {
+            SDL_IOprintf(io, "%c", *c);
+        }
+    }
+    SDL_IOprintf(io, "\"");
+}
+
+// Writes the fields of a JSON object, leaving the last line open for the caller to finish
+void write_stats_json(SDL_IOStream *io, const ItemStats *stats, const char *indent)
+{
+    SDL_IOprintf(io, "%s\"total_ms\": %.3f,\n", indent, to_ms(stats->totalNS));
+    SDL_IOprintf(io, "%s\"stages\": {\n", indent);
+    for (int i = 0; i < NUM_STAGES; i += 1) {
+        const char *separator = i + 1 < NUM_STAGES ? "," : "";
+        if (i == STAGE_LOAD || i == STAGE_WRITE) {
+            SDL_IOprintf(io, "%s  \"%s\": { \"ms\": %.3f }%s\n", indent, stages[i].key, to_ms(stats->stageNS[i]), separator);
+        } else {
+            SDL_IOprintf(io, "%s  \"%s\": { \"ms\": %.3f, \"count\": %u }%s\n", indent, stages[i].key, to_ms(stats->stageNS[i]), stats->stageCount[i], separator);
+        }
+    }
+    SDL_IOprintf(io, "%s},\n", indent);
+    SDL_IOprintf(io, "%s\"cache_hits\": %u,\n", indent, stats->cacheHits);
+    SDL_IOprintf(io, "%s\"input_bytes\": %" SDL_PRIu64 ",\n", indent, stats->inputSize);
+    SDL_IOprintf(io, "%s\"output_bytes\": %" SDL_PRIu64, indent, stats->outputSize);
+}
 
+// Prints and writes what --time and --stats ask for about a single compile
+bool report_item_stats(const CompileOptions *options, const ItemStats *stats)
+{
+    if (options->printTimes) {
+        log_stats(options->filename, stats);
+        log_peak_memory();
+    }
+    if (options->statsPath == NULL) {
+        return true;
+    }
+
+    SDL_IOStream *io = SDL_IOFromFile(options->statsPath, "w");
+    if (io == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return false;
+    }
+    SDL_IOprintf(io, "{\n  \"input\": ");
+    write_json_string(io, options->filename);
+    SDL_IOprintf(io, ",\n  \"up_to_date\": %s,\n", stats->upToDate ? "true" : "false");
+    write_stats_json(io, stats, "  ");
+    SDL_IOprintf(io, ",\n  \"peak_memory_bytes\": %" SDL_PRIu64 "\n}\n", get_peak_memory());
+    return SDL_CloseIO(io);
+}
+
+void write_data(SDL_IOStream *io, const void *data, size_t size, ItemStats *stats)
+{
+    Uint64 start = begin_stage(stats);
+    SDL_WriteIO(io, data, size);
+    end_stage(stats, STAGE_WRITE, start);
+}
+
+bool write_output(const char *outputFilename, const void *data, size_t size, ItemStats *stats)
+{
+    Uint64 start = begin_stage(stats);
+    SDL_IOStream *outputIO = SDL_IOFromFile(outputFilename, "w");
     if (outputIO == NULL) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
-        return 1;
+        return false;
     }
+    SDL_WriteIO(outputIO, data, size);
+    bool result = SDL_CloseIO(outputIO);
+    end_stage(stats, STAGE_WRITE, start);
+    return result;
+}
 
-    size_t bytecodeSize;
+/* Produces several outputs from one input. HLSL is compiled to SPIR-V once,
+ * and the SPIR-V is parsed once for every other format.
+ */
+int compile_multiple(const CompileOptions *options, void *fileData, size_t fileSize, SDL_PropertiesID props, ItemStats *stats)
+{
+    SDL_ShaderCross_Blob *spirv = NULL;
+    SDL_ShaderCross_Blob *directDxil = NULL;
+    SDL_ShaderCross_Blob *hlsl = NULL;
+    SDL_ShaderCross_MultiTargetResult results;
+    SDL_GPUShaderFormat targets = 0;
     int result = 0;
 
-    // null-terminate the defines array
-    if (defines != NULL) {
-        defines = SDL_realloc(defines, sizeof(SDL_ShaderCross_HLSL_Define) * (numDefines + 1));
-        defines[numDefines].name = NULL;
-        defines[numDefines].value = NULL;
+    SDL_zero(results);
+
+    for (size_t i = 0; i < options->numOutputFilenames; i += 1) {
+        switch (options->destinationFormats[i]) {
+            case SHADERFORMAT_DXBC:
+                targets |= SDL_GPU_SHADERFORMAT_DXBC;
+                break;
+            case SHADERFORMAT_DXIL:
+                // Direct DXIL skips SPIR-V entirely, so it cannot share the front end
+                if (options->spirvSource || !options->directDxil) {
+                    targets |= SDL_GPU_SHADERFORMAT_DXIL;
+                }
+                break;
+            case SHADERFORMAT_MSL:
+                targets |= SDL_GPU_SHADERFORMAT_MSL;
+                break;
+            case SHADERFORMAT_SPIRV:
+                if (options->spirvSource) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Input and output are both SPIRV. Did you mean to do that?");
+                    return 1;
+                }
+                break;
+            default:
+                break;
+        }
     }
 
-    if (spirvSource) {
-        SDL_ShaderCross_SPIRV_Info spirvInfo;
+    SDL_ShaderCross_SPIRV_Info spirvInfo;
+    spirvInfo.entrypoint = options->entrypointName;
+    spirvInfo.shader_stage = options->shaderStage;
+    spirvInfo.enable_debug = options->enableDebug;
+    spirvInfo.name = options->filename;
+    spirvInfo.props = props;
+
+    if (options->spirvSource) {
         spirvInfo.bytecode = fileData;
         spirvInfo.bytecode_size = fileSize;
-        spirvInfo.entrypoint = entrypointName;
-        spirvInfo.shader_stage = shaderStage;
-        spirvInfo.enable_debug = enableDebug;
-        spirvInfo.name = filename;
-        spirvInfo.props = 0;
-
-        switch (destinationFormat) {
-            case SHADERFORMAT_DXBC: {
-                Uint8 *buffer = SDL_ShaderCross_CompileDXBCFromSPIRV(
-                    &spirvInfo,
-                    &bytecodeSize);
-                if (buffer == NULL) {
-                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compile DXBC from SPIR-V: %s", SDL_GetError());
-                    result = 1;
-                } else {
-                    SDL_WriteIO(outputIO, buffer, bytecodeSize);
-                    SDL_free(buffer);
-                }
-                break;
-            }
+    } else {
+        SDL_ShaderCross_HLSL_Info hlslInfo;
+        hlslInfo.source = fileData;
+        hlslInfo.entrypoint = options->entrypointName;
+        hlslInfo.include_dir = options->includeDir;
+        hlslInfo.defines = options->defines;
+        hlslInfo.shader_stage = options->shaderStage;
+        hlslInfo.enable_debug = options->enableDebug;
+        hlslInfo.name = options->filename;
+        hlslInfo.props = props;
 
-            case SHADERFORMAT_DXIL: {
-                Uint8 *buffer = SDL_ShaderCross_CompileDXILFromSPIRV(
-                    &spirvInfo,
-                    &bytecodeSize);
-                if (buffer == NULL) {
-                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compile DXIL from SPIR-V: %s", SDL_GetError());
-                    result = 1;
-                } else {
-                    SDL_WriteIO(outputIO, buffer, bytecodeSize);
-                    SDL_free(buffer);
+        if (options->directDxil) {
+            for (size_t i = 0; i < options->numOutputFilenames; i += 1) {
+                if (options->destinationFormats[i] == SHADERFORMAT_DXIL) {
+                    directDxil = SDL_ShaderCross_CompileDXILFromHLSLToBlob(&hlslInfo);
+                    if (directDxil == NULL) {
+                        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compile DXIL from HLSL: %s", SDL_GetError());
+                        result = 1;
+                    }
+                    break;
                 }
-                break;
+            }
+        }
+
+        spirv = SDL_ShaderCross_CompileSPIRVFromHLSLToBlob(&hlslInfo);
+        if (spirv == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compile HLSL to SPIRV: %s", SDL_GetError());
+            SDL_ShaderCross_ReleaseBlob(directDxil);
+            return 1;
+        }
+        spirvInfo.bytecode = SDL_ShaderCross_GetBlobData(spirv);
+        spirvInfo.bytecode_size = SDL_ShaderCross_GetBlobSize(spirv);
+    }
+
+    // Reflection for JSON comes along with the other targets. It has succeeded if only a target failed.
+    bool reflected = true;
+    if (!SDL_ShaderCross_CompileMultiTargetFromSPIRV(&spirvInfo, targets, &results)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compile %s: %s", options->filename, SDL_GetError());
+        reflected = results.error != NULL;
+        result = 1;
+    }
+
+    for (size_t i = 0; i < options->numOutputFilenames; i += 1) {
+        const char *outputFilename = options->outputFilenames[i];
+        SDL_ShaderCross_Blob *output = NULL;
+
+        switch (options->destinationFormats[i]) {
+            case SHADERFORMAT_DXBC:
+                output = results.dxbc;
+                break;
+            case SHADERFORMAT_DXIL:
+                output = directDxil != NULL ? directDxil : results.dxil;
+                break;
+            case SHADERFORMAT_MSL:
+                output = results.msl;
+                break;
+            case SHADERFORMAT_SPIRV:
+                output = spirv;
+                break;
+            case SHADERFORMAT_HLSL:
+                // Only the DXIL target produces HLSL on the way
+                if (hlsl == NULL) {
+                    hlsl = results.hlsl != NULL ? results.hlsl : SDL_ShaderCross_TranspileHLSLFromSPIRVToBlob(&spirvInfo);
+                    if (hlsl == NULL) {
+                        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to transpile HLSL from SPIRV: %s", SDL_GetError());
+                        result = 1;
+                    }
+                }
+                output = hlsl;
+                break;
+            case SHADERFORMAT_JSON: {
+                if (!reflected) {
+                    break;
+                }
+                Uint64 start = begin_stage(stats);
+                SDL_IOStream *outputIO = SDL_IOFromFile(outputFilename, "w");
+                if (outputIO == NULL) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+                    result = 1;
+                    break;
+                }
+                if (options->shaderStage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
+                    write_compute_reflect_json(outputIO, &results.compute_metadata);
+                } else {
+                    write_graphics_reflect_json(outputIO, &results.graphics_metadata);
+                }
+                SDL_CloseIO(outputIO);
+                end_stage(stats, STAGE_WRITE, start);
+                continue;
+            }
+            case SHADERFORMAT_INVALID:
+                break;
+        }
+
+        // Failures were logged above, only the outputs that exist are written
+        if (output != NULL && !write_output(outputFilename, SDL_ShaderCross_GetBlobData(output), SDL_ShaderCross_GetBlobSize(output), stats)) {
+            result = 1;
+        }
+    }
+
+    if (hlsl != results.hlsl) {
+        SDL_ShaderCross_ReleaseBlob(hlsl);
+    }
+    SDL_ShaderCross_ReleaseMultiTargetResult(&results);
+    SDL_ShaderCross_ReleaseBlob(directDxil);
+    SDL_ShaderCross_ReleaseBlob(spirv);
+    return result;
+}
+
+int compile_single(const CompileOptions *options, void *fileData, size_t fileSize, SDL_PropertiesID props, ItemStats *stats)
+{
+    const char *filename = options->filename;
+    const char *entrypointName = options->entrypointName;
+    SDL_ShaderCross_ShaderStage shaderStage = options->shaderStage;
+    bool enableDebug = options->enableDebug;
+    SDL_IOStream *outputIO = SDL_IOFromFile(options->outputFilenames[0], "w");
+
+    if (outputIO == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return 1;
+    }
+
+    size_t bytecodeSize;
+    int result = 0;
+
+    if (options->spirvSource) {
+        SDL_ShaderCross_SPIRV_Info spirvInfo;
+        spirvInfo.bytecode = fileData;
+        spirvInfo.bytecode_size = fileSize;
+        spirvInfo.entrypoint = entrypointName;
+        spirvInfo.shader_stage = shaderStage;
+        spirvInfo.enable_debug = enableDebug;
+        spirvInfo.name = filename;
+        spirvInfo.props = props;
+
+        switch (options->destinationFormats[0]) {
+            case SHADERFORMAT_DXBC: {
+                Uint8 *buffer = SDL_ShaderCross_CompileDXBCFromSPIRV(
+                    &spirvInfo,
+                    &bytecodeSize);
+                if (buffer == NULL) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compile DXBC from SPIR-V: %s", SDL_GetError());
+                    result = 1;
+                } else {
+                    write_data(outputIO, buffer, bytecodeSize, stats);
+                    SDL_free(buffer);
+                }
+                break;
+            }
+
+            case SHADERFORMAT_DXIL: {
+                Uint8 *buffer = SDL_ShaderCross_CompileDXILFromSPIRV(
+                    &spirvInfo,
+                    &bytecodeSize);
+                if (buffer == NULL) {
+                    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compile DXIL from SPIR-V: %s", SDL_GetError());
+                    result = 1;
+                } else {
+                    write_data(outputIO, buffer, bytecodeSize, stats);
+                    SDL_free(buffer);
+                }
+                break;
             }
 
             case SHADERFORMAT_MSL: {
@@ -372,7 +1072,7 @@ int main(int argc, char *argv[])
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to transpile MSL from SPIR-V: %s", SDL_GetError());
                     result = 1;
                 } else {
-                    SDL_IOprintf(outputIO, "%s", buffer);
+                    write_data(outputIO, buffer, SDL_strlen(buffer), stats);
                     SDL_free(buffer);
                 }
                 break;
@@ -385,7 +1085,7 @@ int main(int argc, char *argv[])
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to transpile HLSL from SPIRV: %s", SDL_GetError());
                     result = 1;
                 } else {
-                    SDL_IOprintf(outputIO, "%s", buffer);
+                    write_data(outputIO, buffer, SDL_strlen(buffer), stats);
                     SDL_free(buffer);
                 }
                 break;
@@ -400,22 +1100,32 @@ int main(int argc, char *argv[])
             case SHADERFORMAT_JSON: {
                 if (shaderStage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
                     SDL_ShaderCross_ComputePipelineMetadata info;
-                    if (SDL_ShaderCross_ReflectComputeSPIRV(
+                    Uint64 reflectStart = begin_stage(stats);
+                    bool reflected = SDL_ShaderCross_ReflectComputeSPIRV(
                         fileData,
                         fileSize,
-                        &info)) {
+                        &info);
+                    end_reflection(stats, reflectStart);
+                    if (reflected) {
+                        Uint64 start = begin_stage(stats);
                         write_compute_reflect_json(outputIO, &info);
+                        end_stage(stats, STAGE_WRITE, start);
                     } else {
                         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to reflect SPIRV: %s", SDL_GetError());
                         result = 1;
                     }
                 } else {
                     SDL_ShaderCross_GraphicsShaderMetadata info;
-                    if (SDL_ShaderCross_ReflectGraphicsSPIRV(
+                    Uint64 reflectStart = begin_stage(stats);
+                    bool reflected = SDL_ShaderCross_ReflectGraphicsSPIRV(
                         fileData,
                         fileSize,
-                        &info)) {
+                        &info);
+                    end_reflection(stats, reflectStart);
+                    if (reflected) {
+                        Uint64 start = begin_stage(stats);
                         write_graphics_reflect_json(outputIO, &info);
+                        end_stage(stats, STAGE_WRITE, start);
                     } else {
                         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to reflect SPIRV: %s", SDL_GetError());
                         result = 1;
@@ -434,14 +1144,14 @@ int main(int argc, char *argv[])
         SDL_ShaderCross_HLSL_Info hlslInfo;
         hlslInfo.source = fileData;
         hlslInfo.entrypoint = entrypointName;
-        hlslInfo.include_dir = includeDir;
-        hlslInfo.defines = defines;
+        hlslInfo.include_dir = options->includeDir;
+        hlslInfo.defines = options->defines;
         hlslInfo.shader_stage = shaderStage;
         hlslInfo.enable_debug = enableDebug;
         hlslInfo.name = filename;
-        hlslInfo.props = 0;
+        hlslInfo.props = props;
 
-        switch (destinationFormat) {
+        switch (options->destinationFormats[0]) {
             case SHADERFORMAT_DXBC: {
                 Uint8 *buffer = SDL_ShaderCross_CompileDXBCFromHLSL(
                     &hlslInfo,
@@ -450,7 +1160,7 @@ int main(int argc, char *argv[])
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compile DXBC from HLSL: %s", SDL_GetError());
                     result = 1;
                 } else {
-                    SDL_WriteIO(outputIO, buffer, bytecodeSize);
+                    write_data(outputIO, buffer, bytecodeSize, stats);
                     SDL_free(buffer);
                 }
                 break;
@@ -464,7 +1174,7 @@ int main(int argc, char *argv[])
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compile DXIL from HLSL: %s", SDL_GetError());
                     result = 1;
                 } else {
-                    SDL_WriteIO(outputIO, buffer, bytecodeSize);
+                    write_data(outputIO, buffer, bytecodeSize, stats);
                     SDL_free(buffer);
                 }
                 break;
@@ -485,17 +1195,18 @@ int main(int argc, char *argv[])
                     spirvInfo.entrypoint = entrypointName;
                     spirvInfo.shader_stage = shaderStage;
                     spirvInfo.enable_debug = enableDebug;
-                    spirvInfo.props = 0;
+                    spirvInfo.name = filename;
+                    spirvInfo.props = props;
                     char *buffer = SDL_ShaderCross_TranspileMSLFromSPIRV(
                         &spirvInfo);
                     if (buffer == NULL) {
                         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to transpile MSL from HLSL: %s", SDL_GetError());
                         result = 1;
                     } else {
-                        SDL_IOprintf(outputIO, "%s", buffer);
-                        SDL_free(spirv);
+                        write_data(outputIO, buffer, SDL_strlen(buffer), stats);
                         SDL_free(buffer);
                     }
+                    SDL_free(spirv);
                 }
                 break;
             }
@@ -508,7 +1219,7 @@ int main(int argc, char *argv[])
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to compile SPIR-V From HLSL: %s", SDL_GetError());
                     result = 1;
                 } else {
-                    SDL_WriteIO(outputIO, buffer, bytecodeSize);
+                    write_data(outputIO, buffer, bytecodeSize, stats);
                     SDL_free(buffer);
                 }
                 break;
@@ -531,10 +1242,12 @@ int main(int argc, char *argv[])
                 spirvInfo.entrypoint = entrypointName;
                 spirvInfo.shader_stage = shaderStage;
                 spirvInfo.enable_debug = enableDebug;
-                spirvInfo.props = 0;
+                spirvInfo.name = filename;
+                spirvInfo.props = props;
 
                 char *buffer = SDL_ShaderCross_TranspileHLSLFromSPIRV(
                     &spirvInfo);
+                SDL_free(spirv);
 
                 if (buffer == NULL) {
                     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to transpile HLSL from SPIRV: %s", SDL_GetError());
@@ -542,8 +1255,7 @@ int main(int argc, char *argv[])
                     break;
                 }
 
-                SDL_IOprintf(outputIO, "%s", buffer);
-                SDL_free(spirv);
+                write_data(outputIO, buffer, SDL_strlen(buffer), stats);
                 SDL_free(buffer);
                 break;
             }
@@ -561,28 +1273,36 @@ int main(int argc, char *argv[])
 
                 if (shaderStage == SDL_SHADERCROSS_SHADERSTAGE_COMPUTE) {
                     SDL_ShaderCross_ComputePipelineMetadata info;
-                    bool result = SDL_ShaderCross_ReflectComputeSPIRV(
+                    Uint64 reflectStart = begin_stage(stats);
+                    bool reflected = SDL_ShaderCross_ReflectComputeSPIRV(
                         spirv,
                         bytecodeSize,
                         &info);
+                    end_reflection(stats, reflectStart);
                     SDL_free(spirv);
 
-                    if (result) {
+                    if (reflected) {
+                        Uint64 start = begin_stage(stats);
                         write_compute_reflect_json(outputIO, &info);
+                        end_stage(stats, STAGE_WRITE, start);
                     } else {
                         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to reflect SPIRV: %s", SDL_GetError());
                         result = 1;
                     }
                 } else {
                     SDL_ShaderCross_GraphicsShaderMetadata info;
-                    bool result = SDL_ShaderCross_ReflectGraphicsSPIRV(
+                    Uint64 reflectStart = begin_stage(stats);
+                    bool reflected = SDL_ShaderCross_ReflectGraphicsSPIRV(
                         spirv,
                         bytecodeSize,
                         &info);
+                    end_reflection(stats, reflectStart);
                     SDL_free(spirv);
 
-                    if (result) {
+                    if (reflected) {
+                        Uint64 start = begin_stage(stats);
                         write_graphics_reflect_json(outputIO, &info);
+                        end_stage(stats, STAGE_WRITE, start);
                     } else {
                         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to reflect SPIRV: %s", SDL_GetError());
                         result = 1;
@@ -600,12 +1320,1390 @@ int main(int argc, char *argv[])
         }
     }
 
+    Uint64 closeStart = begin_stage(stats);
     SDL_CloseIO(outputIO);
+    end_stage(stats, STAGE_WRITE, closeStart);
+    return result;
+}
+
+typedef struct DependencyList
+{
+    char **paths;
+    int count;
+} DependencyList;
+
+void SDLCALL record_dependency(void *userdata, const char *path)
+{
+    DependencyList *dependencies = (DependencyList *)userdata;
+    for (int i = 0; i < dependencies->count; i += 1) {
+        if (SDL_strcmp(dependencies->paths[i], path) == 0) {
+            return;
+        }
+    }
+    dependencies->paths = SDL_realloc(dependencies->paths, sizeof(char *) * (dependencies->count + 1));
+    dependencies->paths[dependencies->count++] = SDL_strdup(path);
+}
+
+// Escapes a path for Make and Ninja, which split on spaces and expand $
+void write_depfile_path(SDL_IOStream *io, const char *path)
+{
+    for (const char *c = path; *c != '\0'; c += 1) {
+        if (*c == ' ' || *c == '#') {
+            SDL_IOprintf(io, "\\%c", *c);
+        } else if (*c == '$') {
+            SDL_IOprintf(io, "$$");
+        } else {
+            SDL_IOprintf(io, "%c", *c);
+        }
+    }
+}
+
+char *get_depfile_path(const CompileOptions *options)
+{
+    char *path = NULL;
+    if (options->depfilePath != NULL) {
+        return SDL_strdup(options->depfilePath);
+    }
+    if (SDL_asprintf(&path, "%s.d", options->outputFilenames[0]) < 0) {
+        return NULL;
+    }
+    return path;
+}
+
+bool write_depfile(const CompileOptions *options, const DependencyList *dependencies)
+{
+    char *path = get_depfile_path(options);
+    SDL_IOStream *io = path != NULL ? SDL_IOFromFile(path, "w") : NULL;
+    SDL_free(path);
+    if (io == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+        return false;
+    }
+
+    for (size_t i = 0; i < options->numOutputFilenames; i += 1) {
+        write_depfile_path(io, get_relative_path(options, options->outputFilenames[i]));
+        SDL_IOprintf(io, i + 1 < options->numOutputFilenames ? " " : ":");
+    }
+    SDL_IOprintf(io, " ");
+    write_depfile_path(io, get_relative_path(options, options->filename));
+    for (int i = 0; i < dependencies->count; i += 1) {
+        SDL_IOprintf(io, " \\\n  ");
+        write_depfile_path(io, get_relative_path(options, dependencies->paths[i]));
+    }
+    SDL_IOprintf(io, "\n");
+
+    return SDL_CloseIO(io);
+}
+
+// A growing NUL-terminated string
+typedef struct TextBuffer
+{
+    char *text;
+    size_t length;
+    size_t capacity;
+} TextBuffer;
+
+void append_text(TextBuffer *buffer, const char *text, size_t length)
+{
+    // Doubling keeps building a line a byte at a time linear
+    if (buffer->length + length + 1 > buffer->capacity) {
+        size_t capacity = SDL_max(buffer->capacity * 2, 64);
+        while (capacity < buffer->length + length + 1) {
+            capacity *= 2;
+        }
+        buffer->text = SDL_realloc(buffer->text, capacity);
+        buffer->capacity = capacity;
+    }
+    SDL_memcpy(buffer->text + buffer->length, text, length);
+    buffer->length += length;
+    buffer->text[buffer->length] = '\0';
+}
+
+/* Incremental builds
+ *
+ * After a successful compile, a stamp file next to the first output records
+ * a SHA-256 digest of the input, the options and the compiler versions, and
+ * one of the contents of every include. A later run with --incremental
+ * skips the compile while the outputs exist and all of these still hash the
+ * same, so upgrading the library or one of its compilers recompiles
+ * everything.
+ */
+
+#define STAMP_MAGIC "SDLSXSTAMP2"
+#define STAMP_DIGEST_LENGTH (SDL_SHADERCROSS_DIGEST_SIZE * 2)
+
+void add_key_data(TextBuffer *key, const void *data, size_t size)
+{
+    append_text(key, (const char *)data, size);
+}
+
+void add_key_number(TextBuffer *key, Sint64 value)
+{
+    add_key_data(key, &value, sizeof(value));
+}
+
+// The terminator keeps consecutive strings apart, and NULL hashes differently from ""
+void add_key_string(TextBuffer *key, const char *str)
+{
+    if (str == NULL) {
+        add_key_number(key, -1);
+    } else {
+        add_key_data(key, str, SDL_strlen(str) + 1);
+    }
+}
+
+// Hashes data to a NUL-terminated hex digest
+bool hash_data(const void *data, size_t size, char result[STAMP_DIGEST_LENGTH + 1])
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    Uint8 digest[SDL_SHADERCROSS_DIGEST_SIZE];
+    if (!SDL_ShaderCross_ComputeDigest(data, size, digest)) {
+        return false;
+    }
+    for (int i = 0; i < SDL_SHADERCROSS_DIGEST_SIZE; i += 1) {
+        result[i * 2] = hexDigits[digest[i] >> 4];
+        result[i * 2 + 1] = hexDigits[digest[i] & 0xF];
+    }
+    result[STAMP_DIGEST_LENGTH] = '\0';
+    return true;
+}
+
+// Returns false if there is no key, in which case the compile always runs
+bool hash_options(const CompileOptions *options, const void *fileData, size_t fileSize, char result[STAMP_DIGEST_LENGTH + 1])
+{
+    const char *compilerVersions = SDL_ShaderCross_GetCompilerVersions();
+    if (compilerVersions == NULL) {
+        return false;
+    }
+
+    TextBuffer key;
+    SDL_zero(key);
+    add_key_string(&key, compilerVersions);
+    add_key_number(&key, fileSize);
+    add_key_data(&key, fileData, fileSize);
+    add_key_string(&key, options->filename);
+    add_key_number(&key, options->spirvSource);
+    add_key_number(&key, options->numOutputFilenames);
+    for (size_t i = 0; i < options->numOutputFilenames; i += 1) {
+        add_key_number(&key, options->destinationFormats[i]);
+        add_key_string(&key, options->outputFilenames[i]);
+    }
+    add_key_number(&key, options->shaderStage);
+    add_key_string(&key, options->entrypointName);
+    add_key_string(&key, options->includeDir);
+    for (size_t i = 0; i < options->numExtraIncludeDirs; i += 1) {
+        add_key_string(&key, options->extraIncludeDirs[i]);
+    }
+    add_key_number(&key, options->numDefines);
+    for (size_t i = 0; i < options->numDefines; i += 1) {
+        add_key_string(&key, options->defines[i].name);
+        add_key_string(&key, options->defines[i].value);
+    }
+    add_key_number(&key, options->shaderModel);
+    add_key_number(&key, options->optimizationLevel);
+    add_key_number(&key, options->skipValidation);
+    add_key_number(&key, options->allResourcesBound);
+    add_key_number(&key, options->avoidFlowControl);
+    add_key_number(&key, options->enableDebug);
+    add_key_number(&key, options->directDxil);
+
+    bool hashed = hash_data(key.text, key.length, result);
+    SDL_free(key.text);
+    return hashed;
+}
+
+// Returns false if the file cannot be read
+bool hash_file(const char *path, char result[STAMP_DIGEST_LENGTH + 1])
+{
+    size_t size;
+    void *data = SDL_LoadFile(path, &size);
+    if (data == NULL) {
+        return false;
+    }
+    bool hashed = hash_data(data, size, result);
+    SDL_free(data);
+    return hashed;
+}
+
+char *get_stamp_path(const CompileOptions *options)
+{
+    char *path = NULL;
+    if (SDL_asprintf(&path, "%s.sxstamp", options->outputFilenames[0]) < 0) {
+        return NULL;
+    }
+    return path;
+}
+
+bool file_exists(const char *path)
+{
+    SDL_PathInfo info;
+    return SDL_GetPathInfo(path, &info) && info.type == SDL_PATHTYPE_FILE;
+}
+
+bool is_up_to_date(const CompileOptions *options, const char *key)
+{
+    for (size_t i = 0; i < options->numOutputFilenames; i += 1) {
+        if (!file_exists(options->outputFilenames[i])) {
+            return false;
+        }
+    }
+    if (options->writeDepfile) {
+        char *depfilePath = get_depfile_path(options);
+        bool depfileExists = depfilePath != NULL && file_exists(depfilePath);
+        SDL_free(depfilePath);
+        if (!depfileExists) {
+            return false;
+        }
+    }
+
+    char *stampPath = get_stamp_path(options);
+    char *stamp = stampPath != NULL ? SDL_LoadFile(stampPath, NULL) : NULL;
+    SDL_free(stampPath);
+    if (stamp == NULL) {
+        return false;
+    }
+
+    // The first line holds the key, every other one an include as "<digest> <path>"
+    bool upToDate = false;
+    char *line = stamp;
+    char *next = SDL_strchr(line, '\n');
+    if (next != NULL) {
+        *next = '\0';
+        upToDate = SDL_strncmp(line, STAMP_MAGIC " ", sizeof(STAMP_MAGIC)) == 0 &&
+            SDL_strcmp(line + sizeof(STAMP_MAGIC), key) == 0;
+        for (line = next + 1; upToDate && *line != '\0'; line = next + 1) {
+            next = SDL_strchr(line, '\n');
+            if (next == NULL) {
+                upToDate = false;
+                break;
+            }
+            *next = '\0';
+
+            char currentHash[STAMP_DIGEST_LENGTH + 1];
+            char *space = SDL_strchr(line, ' ');
+            upToDate = space != NULL && space - line == STAMP_DIGEST_LENGTH &&
+                hash_file(space + 1, currentHash) &&
+                SDL_strncmp(line, currentHash, STAMP_DIGEST_LENGTH) == 0;
+        }
+    }
+
+    SDL_free(stamp);
+    return upToDate;
+}
+
+// A stamp that cannot be written only costs a compile next time, so it is not an error
+void write_stamp(const CompileOptions *options, const char *key, const DependencyList *dependencies)
+{
+    char *stampPath = get_stamp_path(options);
+    SDL_IOStream *io = stampPath != NULL ? SDL_IOFromFile(stampPath, "w") : NULL;
+    if (io == NULL) {
+        SDL_free(stampPath);
+        return;
+    }
+
+    bool complete = true;
+    SDL_IOprintf(io, STAMP_MAGIC " %s\n", key);
+    for (int i = 0; i < dependencies->count; i += 1) {
+        char hash[STAMP_DIGEST_LENGTH + 1];
+        if (!hash_file(dependencies->paths[i], hash)) {
+            complete = false;
+            break;
+        }
+        SDL_IOprintf(io, "%s %s\n", hash, dependencies->paths[i]);
+    }
+
+    if (!SDL_CloseIO(io) || !complete) {
+        SDL_RemovePath(stampPath);
+    }
+    SDL_free(stampPath);
+}
+
+// Returns the process exit code for one input. stats may be NULL.
+int compile_input(const CompileOptions *options, ItemStats *stats)
+{
+    size_t fileSize = 0;
+    Uint64 loadStart = begin_stage(stats);
+    void *fileData = SDL_LoadFile(options->filename, &fileSize);
+    end_stage(stats, STAGE_LOAD, loadStart);
+    if (fileData == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Invalid file (%s)", SDL_GetError());
+        return 1;
+    }
+    if (stats != NULL) {
+        stats->inputSize = fileSize;
+    }
+
+    char key[STAMP_DIGEST_LENGTH + 1];
+    bool haveKey = false;
+    if (options->incremental) {
+        haveKey = hash_options(options, fileData, fileSize, key);
+        if (haveKey && is_up_to_date(options, key)) {
+            if (stats != NULL) {
+                stats->upToDate = true;
+            }
+            SDL_free(fileData);
+            return 0;
+        }
+
+        // The outputs are about to be overwritten, so the stamp must not outlive a failed compile
+        char *stampPath = get_stamp_path(options);
+        if (stampPath != NULL) {
+            SDL_RemovePath(stampPath);
+            SDL_free(stampPath);
+        }
+    }
+
+    SDL_PropertiesID props = create_compile_props(options, fileSize);
+
+    // Every include the compiles open is reported, including for results that come from the cache
+    DependencyList dependencies;
+    SDL_zero(dependencies);
+    SDL_ShaderCross_DependencyReporter reporter;
+    reporter.callback = record_dependency;
+    reporter.userdata = &dependencies;
+    if (options->writeDepfile || options->incremental) {
+        SDL_SetPointerProperty(props, SDL_SHADERCROSS_PROP_HLSL_DEPENDENCY_REPORTER_POINTER, &reporter);
+    }
+
+    SDL_ShaderCross_CompileStats compileStats;
+    SDL_zero(compileStats);
+    if (stats != NULL) {
+        SDL_SetPointerProperty(props, SDL_SHADERCROSS_PROP_COMPILE_STATS_POINTER, &compileStats);
+    }
+
+    int result;
+    if (options->numOutputFilenames > 1) {
+        result = compile_multiple(options, fileData, fileSize, props, stats);
+    } else {
+        result = compile_single(options, fileData, fileSize, props, stats);
+    }
+
+    if (stats != NULL) {
+        for (int i = 0; i < SDL_SHADERCROSS_PHASE_COUNT; i += 1) {
+            stats->stageNS[1 + i] += compileStats.phase_ns[i];
+            stats->stageCount[1 + i] += compileStats.phase_count[i];
+        }
+        stats->cacheHits = compileStats.cache_hits;
+    }
+
+    if (result == 0 && options->writeDepfile && !write_depfile(options, &dependencies)) {
+        result = 1;
+    }
+    if (result == 0 && haveKey) {
+        write_stamp(options, key, &dependencies);
+    }
+
+    for (int i = 0; i < dependencies.count; i += 1) {
+        SDL_free(dependencies.paths[i]);
+    }
+    SDL_free(dependencies.paths);
+    SDL_DestroyProperties(props);
     SDL_free(fileData);
-    for (Uint32 i = 0; i < numDefines; i += 1) {
-        SDL_free(defines[i].name);
+    return result;
+}
+
+// Compiles one input to its outputs. Returns the process exit code for it.
+int compile_item(const CompileOptions *options, ItemStats *stats)
+{
+    ItemStats localStats;
+    bool report = options->printTimes || options->statsPath != NULL;
+    if (stats == NULL && report) {
+        stats = &localStats;
+    }
+    if (stats != NULL) {
+        SDL_zerop(stats);
+    }
+
+    Uint64 start = begin_stage(stats);
+    int result = compile_input(options, stats);
+    if (stats != NULL) {
+        stats->totalNS = SDL_GetTicksNS() - start;
+        for (size_t i = 0; i < options->numOutputFilenames; i += 1) {
+            SDL_PathInfo info;
+            if (SDL_GetPathInfo(options->outputFilenames[i], &info)) {
+                stats->outputSize += info.size;
+            }
+        }
+    }
+
+    if (report && !report_item_stats(options, stats)) {
+        result = 1;
+    }
+    return result;
+}
+
+/* Batch mode
+ *
+ * A manifest lists one compile per line, written as the arguments for a
+ * single shadercross run, e.g.
+ *
+ *     shaders/blit.frag.hlsl -o out/blit.frag.dxil -e BlitMain -DSRGB=1
+ *
+ * Arguments are separated by whitespace, and can be quoted with " or '.
+ * Blank lines and lines starting with # are skipped. The options given on
+ * the command line besides --batch and -j apply to every line, before the
+ * line's own.
+ */
+
+typedef struct BatchItem
+{
+    int line;
+    int argc;
+    char **argv;
+    CompileOptions options;
+    int result;
+    ItemStats stats;
+} BatchItem;
+
+typedef struct Batch
+{
+    const char *filename;
+    BatchItem *items;
+    int numItems;
+    SDL_AtomicInt nextItem;
+    SDL_AtomicInt numFailed;
+    bool collectStats;
+} Batch;
+
+// Splits a line into arguments in place. The arguments point into the line.
+char **split_line(char *line, int *count)
+{
+    char **args = NULL;
+    int numArgs = 0;
+    char *src = line;
+
+    for (;;) {
+        while (*src == ' ' || *src == '\t' || *src == '\r' || *src == '\n') {
+            src += 1;
+        }
+        if (*src == '\0') {
+            break;
+        }
+
+        char *arg = src;
+        char *dst = src;
+        char quote = '\0';
+        while (*src != '\0' && (quote != '\0' || (*src != ' ' && *src != '\t' && *src != '\r' && *src != '\n'))) {
+            if (quote == '\0' && (*src == '"' || *src == '\'')) {
+                quote = *src;
+            } else if (*src == quote) {
+                quote = '\0';
+            } else {
+                *dst++ = *src;
+            }
+            src += 1;
+        }
+        if (*src != '\0') {
+            src += 1;
+        }
+        *dst = '\0';
+
+        args = SDL_realloc(args, sizeof(char *) * (numArgs + 1));
+        args[numArgs++] = arg;
+    }
+
+    *count = numArgs;
+    return args;
+}
+
+// The options that only make sense once per process are not passed on to each compile
+char **make_base_args(int argc, char *argv[], int *count)
+{
+    char **baseArgs = SDL_malloc(sizeof(char *) * argc);
+    int numBaseArgs = 0;
+    for (int i = 0; i < argc; i += 1) {
+        if (SDL_strcmp(argv[i], "--batch") == 0 || SDL_strcmp(argv[i], "-j") == 0 || SDL_strcmp(argv[i], "--jobs") == 0 || SDL_strcmp(argv[i], "--socket") == 0) {
+            i += 1;
+        } else if (SDL_strcmp(argv[i], "--server") != 0 && SDL_strcmp(argv[i], "--client") != 0) {
+            baseArgs[numBaseArgs++] = argv[i];
+        }
     }
-    SDL_free(defines);
+    *count = numBaseArgs;
+    return baseArgs;
+}
+
+// Returns false for blank and comment lines. A line that does not parse is an item that failed.
+bool prepare_item(BatchItem *item, const char *program, char **baseArgs, int numBaseArgs, char *line)
+{
+    int numLineArgs;
+    char **lineArgs = split_line(line, &numLineArgs);
+    if (numLineArgs == 0 || lineArgs[0][0] == '#') {
+        SDL_free(lineArgs);
+        return false;
+    }
+
+    item->argc = numBaseArgs + numLineArgs;
+    item->argv = SDL_malloc(sizeof(char *) * item->argc);
+    SDL_memcpy(item->argv, baseArgs, sizeof(char *) * numBaseArgs);
+    SDL_memcpy(item->argv + numBaseArgs, lineArgs, sizeof(char *) * numLineArgs);
+    SDL_free(lineArgs);
+    item->result = 0;
+    SDL_zero(item->stats);
+
+    init_options(&item->options);
+    if (!parse_args(item->argc, item->argv, &item->options) ||
+        !finish_options(program, &item->options)) {
+        item->result = 1;
+    } else if (item->options.batchFilename != NULL || item->options.server || item->options.client) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", "Batch files and servers cannot be nested!");
+        item->result = 1;
+    }
+    return true;
+}
+
+void free_item(BatchItem *item)
+{
+    free_options(&item->options);
+    SDL_free(item->argv);
+}
+
+int SDLCALL batch_worker(void *data)
+{
+    Batch *batch = (Batch *)data;
+
+    for (;;) {
+        int index = SDL_AddAtomicInt(&batch->nextItem, 1);
+        if (index >= batch->numItems) {
+            break;
+        }
+
+        BatchItem *item = &batch->items[index];
+        if (item->result == 0) {
+            item->result = compile_item(&item->options, batch->collectStats ? &item->stats : NULL);
+        }
+        if (item->result != 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s:%d: %s failed", batch->filename, item->line, item->options.filename ? item->options.filename : "item");
+            SDL_AddAtomicInt(&batch->numFailed, 1);
+        }
+    }
+
+    return 0;
+}
+
+int SDLCALL compare_item_times(const void *a, const void *b)
+{
+    const BatchItem *itemA = *(const BatchItem *const *)a;
+    const BatchItem *itemB = *(const BatchItem *const *)b;
+    if (itemA->stats.totalNS != itemB->stats.totalNS) {
+        return itemA->stats.totalNS > itemB->stats.totalNS ? -1 : 1;
+    }
+    return itemA->line - itemB->line;
+}
+
+// Prints and writes what --time and --stats ask for about the whole batch
+bool report_batch_stats(const CompileOptions *options, Batch *batch, Uint64 wallNS)
+{
+    ItemStats total;
+    SDL_zero(total);
+    int numUpToDate = 0;
+    BatchItem **slowest = SDL_malloc(sizeof(BatchItem *) * SDL_max(batch->numItems, 1));
+    for (int i = 0; i < batch->numItems; i += 1) {
+        add_stats(&total, &batch->items[i].stats);
+        numUpToDate += batch->items[i].stats.upToDate;
+        slowest[i] = &batch->items[i];
+    }
+    SDL_qsort(slowest, batch->numItems, sizeof(BatchItem *), compare_item_times);
+    int numSlowest = SDL_min(batch->numItems, NUM_SLOWEST_ITEMS);
+    int numFailed = SDL_GetAtomicInt(&batch->numFailed);
+
+    if (options->printTimes) {
+        SDL_Log("%d items, %d failed, %d up to date, in %.3f ms", batch->numItems, numFailed, numUpToDate, to_ms(wallNS));
+        log_stats("all items", &total);
+        log_peak_memory();
+        if (numSlowest > 0) {
+            SDL_Log("slowest items:");
+        }
+        for (int i = 0; i < numSlowest; i += 1) {
+            const BatchItem *item = slowest[i];
+            SDL_Log("  %10.3f ms  %s:%d: %s", to_ms(item->stats.totalNS), batch->filename, item->line, item->options.filename ? item->options.filename : "item");
+        }
+    }
+
+    bool result = true;
+    if (options->statsPath != NULL) {
+        SDL_IOStream *io = SDL_IOFromFile(options->statsPath, "w");
+        if (io == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+            SDL_free(slowest);
+            return false;
+        }
+        SDL_IOprintf(io, "{\n  \"items\": %d,\n  \"failed\": %d,\n  \"up_to_date\": %d,\n", batch->numItems, numFailed, numUpToDate);
+        SDL_IOprintf(io, "  \"wall_ms\": %.3f,\n", to_ms(wallNS));
+        SDL_IOprintf(io, "  \"peak_memory_bytes\": %" SDL_PRIu64 ",\n", get_peak_memory());
+        SDL_IOprintf(io, "  \"totals\": {\n");
+        write_stats_json(io, &total, "    ");
+        SDL_IOprintf(io, "\n  },\n  \"slowest\": [");
+        for (int i = 0; i < numSlowest; i += 1) {
+            const BatchItem *item = slowest[i];
+            SDL_IOprintf(io, "%s\n    {\n      \"line\": %d,\n      \"input\": ", i > 0 ? "," : "", item->line);
+            write_json_string(io, item->options.filename);
+            SDL_IOprintf(io, ",\n      \"failed\": %s,\n", item->result != 0 ? "true" : "false");
+            SDL_IOprintf(io, "      \"up_to_date\": %s,\n", item->stats.upToDate ? "true" : "false");
+            write_stats_json(io, &item->stats, "      ");
+            SDL_IOprintf(io, "\n    }");
+        }
+        SDL_IOprintf(io, "%s]\n}\n", numSlowest > 0 ? "\n  " : "");
+        result = SDL_CloseIO(io);
+    }
+
+    SDL_free(slowest);
+    return result;
+}
+
+int run_batch(int argc, char *argv[], const CompileOptions *options)
+{
+    size_t manifestSize = 0;
+    char *manifest = SDL_LoadFile(options->batchFilename, &manifestSize);
+    if (manifest == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Invalid batch file (%s)", SDL_GetError());
+        return 1;
+    }
+
+    int numBaseArgs;
+    char **baseArgs = make_base_args(argc, argv, &numBaseArgs);
+
+    Batch batch;
+    SDL_zero(batch);
+    batch.filename = options->batchFilename;
+    batch.collectStats = options->printTimes || options->statsPath != NULL;
+
+    int lineNumber = 0;
+    char *line = manifest;
+    while (line != NULL) {
+        char *next = SDL_strchr(line, '\n');
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        lineNumber += 1;
+
+        // Bad lines are reported with the compile failures, and do not stop the rest
+        batch.items = SDL_realloc(batch.items, sizeof(BatchItem) * (batch.numItems + 1));
+        BatchItem *item = &batch.items[batch.numItems];
+        if (prepare_item(item, argv[0], baseArgs, numBaseArgs, line)) {
+            // --time and --stats describe the whole batch rather than every item
+            item->options.printTimes = false;
+            item->options.statsPath = NULL;
+            item->line = lineNumber;
+            batch.numItems += 1;
+        }
+
+        line = next;
+    }
+
+    Uint64 start = SDL_GetTicksNS();
+    int numThreads = SDL_min(SDL_max(options->numJobs, 1), batch.numItems) - 1;
+    SDL_Thread **threads = NULL;
+    if (numThreads > 0) {
+        threads = SDL_calloc(numThreads, sizeof(SDL_Thread *));
+        for (int i = 0; i < numThreads; i += 1) {
+            threads[i] = SDL_CreateThread(batch_worker, "shadercross", &batch);
+        }
+    }
+
+    // The main thread works through the batch too, so it finishes even if no thread could start
+    batch_worker(&batch);
+
+    for (int i = 0; i < numThreads; i += 1) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    SDL_free(threads);
+
+    Uint64 wallNS = SDL_GetTicksNS() - start;
+
+    int numFailed = SDL_GetAtomicInt(&batch.numFailed);
+    if (numFailed > 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%d of %d items failed", numFailed, batch.numItems);
+    }
+    int result = numFailed > 0 ? 1 : 0;
+    if (batch.collectStats && !report_batch_stats(options, &batch, wallNS)) {
+        result = 1;
+    }
+
+    for (int i = 0; i < batch.numItems; i += 1) {
+        free_item(&batch.items[i]);
+    }
+    SDL_free(batch.items);
+    SDL_free(baseArgs);
+    SDL_free(manifest);
+    return result;
+}
+
+/* Server mode
+ *
+ * A server is one long-lived process that keeps the compilers loaded and
+ * the caches warm. It serves compiles to clients over stdin/stdout or a
+ * local socket. Requests and responses are lines of text:
+ *
+ *     request:   the arguments for one compile, as on a batch manifest line
+ *     response:  "E <message>" for every message logged while compiling,
+ *                with backslashes and newlines escaped, then "= <exit code>"
+ *
+ * Requests on stdin are served one at a time. Every socket connection is
+ * served by its own thread, and -j compiles run at once. The server's
+ * directory is shared by all of them, so --client starts its requests with
+ * --cwd, which makes the paths in them absolute.
+ */
+
+static SDL_TLSID logCaptureTLS;
+static SDL_LogOutputFunction defaultLogOutput;
+static void *defaultLogOutputUserdata;
+
+// Messages logged on a thread serving a request are sent back to the client.
+// The capture is per thread, so messages from the library's job pool threads
+// reach the server's own log instead.
+void SDLCALL capture_log(void *userdata, int category, SDL_LogPriority priority, const char *message)
+{
+    (void)userdata;
+    TextBuffer *capture = (TextBuffer *)SDL_GetTLS(&logCaptureTLS);
+    if (capture == NULL) {
+        defaultLogOutput(defaultLogOutputUserdata, category, priority, message);
+        return;
+    }
+
+    append_text(capture, "E ", 2);
+    for (const char *c = message; *c != '\0'; c += 1) {
+        if (*c == '\\') {
+            append_text(capture, "\\\\", 2);
+        } else if (*c == '\n') {
+            append_text(capture, "\\n", 2);
+        } else if (*c != '\r') {
+            append_text(capture, c, 1);
+        }
+    }
+    append_text(capture, "\n", 1);
+}
+
+// Returns NULL at the end of the stream. The line must be freed.
+char *read_line(FILE *stream)
+{
+    TextBuffer line;
+    SDL_zero(line);
+
+    int c;
+    while ((c = fgetc(stream)) != EOF && c != '\n') {
+        char ch = (char)c;
+        append_text(&line, &ch, 1);
+    }
+    if (c == EOF && line.text == NULL) {
+        return NULL;
+    }
+    return line.text != NULL ? line.text : SDL_strdup("");
+}
+
+typedef struct Server
+{
+    const char *program;
+    char **baseArgs;
+    int numBaseArgs;
+    SDL_Semaphore *compileSlots;
+} Server;
+
+void serve_request(Server *server, char *line, FILE *output)
+{
+    TextBuffer capture;
+    SDL_zero(capture);
+    SDL_SetTLS(&logCaptureTLS, &capture, NULL);
+
+    BatchItem item;
+    int result = 1;
+    if (prepare_item(&item, server->program, server->baseArgs, server->numBaseArgs, line)) {
+        if (item.result == 0) {
+            SDL_WaitSemaphore(server->compileSlots);
+            item.result = compile_item(&item.options, NULL);
+            SDL_SignalSemaphore(server->compileSlots);
+        }
+        result = item.result;
+        free_item(&item);
+    } else {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", "Empty request!");
+    }
+
+    SDL_SetTLS(&logCaptureTLS, NULL, NULL);
+    fprintf(output, "%s= %d\n", capture.text != NULL ? capture.text : "", result);
+    fflush(output);
+    SDL_free(capture.text);
+}
+
+void serve_stream(Server *server, FILE *input, FILE *output)
+{
+    char *line;
+    while ((line = read_line(input)) != NULL) {
+        serve_request(server, line, output);
+        SDL_free(line);
+    }
+}
+
+#ifdef SHADERCROSS_SOCKETS
+typedef struct Connection
+{
+    Server *server;
+    int fd;
+} Connection;
+
+int SDLCALL serve_connection(void *data)
+{
+    Connection *connection = (Connection *)data;
+    FILE *input = fdopen(connection->fd, "r");
+    FILE *output = fdopen(dup(connection->fd), "w");
+    if (input != NULL && output != NULL) {
+        serve_stream(connection->server, input, output);
+    }
+    if (output != NULL) {
+        fclose(output);
+    }
+    if (input != NULL) {
+        fclose(input);
+    } else {
+        close(connection->fd);
+    }
+    SDL_free(connection);
+    return 0;
+}
+
+bool make_socket_address(const char *path, struct sockaddr_un *address)
+{
+    SDL_zerop(address);
+    address->sun_family = AF_UNIX;
+    if (SDL_strlen(path) >= sizeof(address->sun_path)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Socket path %s is too long!", path);
+        return false;
+    }
+    SDL_strlcpy(address->sun_path, path, sizeof(address->sun_path));
+    return true;
+}
+
+// Removes a socket left behind by a server that did not exit cleanly, which
+// would fail the bind. Anything else at the path is left alone.
+bool remove_stale_socket(const char *path, const struct sockaddr_un *address)
+{
+    struct stat info;
+    if (lstat(path, &info) < 0) {
+        if (errno == ENOENT) {
+            return true;
+        }
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not check %s: %s", path, strerror(errno));
+        return false;
+    }
+    if (!S_ISSOCK(info.st_mode)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s exists and is not a socket!", path);
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not create socket: %s", strerror(errno));
+        return false;
+    }
+    int result = connect(fd, (const struct sockaddr *)address, sizeof(*address));
+    int error = errno;
+    close(fd);
+    if (result == 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "A server is already listening on %s!", path);
+        return false;
+    }
+    if (error != ECONNREFUSED) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not check %s: %s", path, strerror(error));
+        return false;
+    }
+    if (unlink(path) < 0 && errno != ENOENT) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not remove %s: %s", path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+int serve_socket(Server *server, const char *path)
+{
+    struct sockaddr_un address;
+    if (!make_socket_address(path, &address) || !remove_stale_socket(path, &address)) {
+        return 1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not create socket: %s", strerror(errno));
+        return 1;
+    }
+
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(fd, 64) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not listen on %s: %s", path, strerror(errno));
+        close(fd);
+        return 1;
+    }
+
+    // Remembered so that shutting down only removes the socket this server made
+    struct stat bound;
+    bool haveBound = lstat(path, &bound) == 0;
+
+    // A client hanging up early must not take the server down with it
+    signal(SIGPIPE, SIG_IGN);
+
+    for (;;) {
+        int clientFd = accept(fd, NULL, NULL);
+        if (clientFd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not accept a connection: %s", strerror(errno));
+            break;
+        }
+
+        Connection *connection = SDL_malloc(sizeof(Connection));
+        connection->server = server;
+        connection->fd = clientFd;
+        SDL_Thread *thread = SDL_CreateThread(serve_connection, "shadercross", connection);
+        if (thread == NULL) {
+            serve_connection(connection);
+        } else {
+            SDL_DetachThread(thread);
+        }
+    }
+
+    close(fd);
+    struct stat current;
+    if (haveBound && lstat(path, &current) == 0 && current.st_dev == bound.st_dev && current.st_ino == bound.st_ino) {
+        unlink(path);
+    }
+    return 1;
+}
+#endif
+
+int run_server(int argc, char *argv[], const CompileOptions *options)
+{
+    Server server;
+    server.program = argv[0];
+    server.baseArgs = make_base_args(argc, argv, &server.numBaseArgs);
+    server.compileSlots = SDL_CreateSemaphore(options->numJobs > 0 ? options->numJobs : SDL_GetNumLogicalCPUCores());
+
+    SDL_GetLogOutputFunction(&defaultLogOutput, &defaultLogOutputUserdata);
+    SDL_SetLogOutputFunction(capture_log, NULL);
+
+    int result = 0;
+    if (options->socketPath != NULL) {
+#ifdef SHADERCROSS_SOCKETS
+        result = serve_socket(&server, options->socketPath);
+#else
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", "--socket is not supported on this platform!");
+        result = 1;
+#endif
+    } else {
+        serve_stream(&server, stdin, stdout);
+    }
+
+    SDL_SetLogOutputFunction(defaultLogOutput, defaultLogOutputUserdata);
+    SDL_DestroySemaphore(server.compileSlots);
+    SDL_free(server.baseArgs);
+    return result;
+}
+
+#ifdef SHADERCROSS_SOCKETS
+// Appends an argument and a space to a request, or returns false if it can't be quoted
+bool append_request_arg(TextBuffer *request, const char *arg)
+{
+    if (SDL_strchr(arg, '"') != NULL && SDL_strchr(arg, '\'') != NULL) {
+        return false;
+    }
+    const char *quote = SDL_strchr(arg, '"') != NULL ? "'" : "\"";
+    append_text(request, quote, 1);
+    append_text(request, arg, SDL_strlen(arg));
+    append_text(request, quote, 1);
+    append_text(request, " ", 1);
+    return true;
+}
+#endif
+
+// Returns -1 if the request could not be forwarded and should be compiled locally
+int run_client(int argc, char *argv[], const CompileOptions *options)
+{
+#ifdef SHADERCROSS_SOCKETS
+    struct sockaddr_un address;
+    if (options->socketPath == NULL || !make_socket_address(options->socketPath, &address)) {
+        return -1;
+    }
+
+    // The server adds its own program name and options, and resolves our relative paths against --cwd
+    char *cwd = SDL_GetCurrentDirectory();
+    if (cwd == NULL) {
+        return -1;
+    }
+    int numArgs;
+    char **args = make_base_args(argc, argv, &numArgs);
+    TextBuffer request;
+    SDL_zero(request);
+    bool quoted = append_request_arg(&request, "--cwd") && append_request_arg(&request, cwd);
+    for (int i = 1; quoted && i < numArgs; i += 1) {
+        quoted = append_request_arg(&request, args[i]);
+    }
+    SDL_free(args);
+    SDL_free(cwd);
+    if (!quoted) {
+        SDL_free(request.text);
+        return -1;
+    }
+    request.text[request.length - 1] = '\n';
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        SDL_free(request.text);
+        return -1;
+    }
+
+    FILE *stream = fdopen(fd, "r+");
+    if (stream == NULL) {
+        close(fd);
+        SDL_free(request.text);
+        return -1;
+    }
+    fputs(request.text, stream);
+    fflush(stream);
+    SDL_free(request.text);
+
+    // Anything short of a complete response means the server went away
+    int result = -1;
+    char *line;
+    while ((line = read_line(stream)) != NULL) {
+        if (line[0] == '=' && line[1] == ' ') {
+            result = SDL_atoi(line + 2);
+            SDL_free(line);
+            break;
+        }
+        if (line[0] == 'E' && line[1] == ' ') {
+            char *dst = line;
+            for (const char *src = line + 2; *src != '\0'; src += 1) {
+                if (*src == '\\' && src[1] != '\0') {
+                    src += 1;
+                    *dst++ = *src == 'n' ? '\n' : *src;
+                } else {
+                    *dst++ = *src;
+                }
+            }
+            *dst = '\0';
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", line);
+        }
+        SDL_free(line);
+    }
+
+    fclose(stream);
+    if (result < 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Lost the connection to the server, compiling locally");
+    }
+    return result;
+#else
+    return -1;
+#endif
+}
+
+/* Replay mode
+ *
+ * Runs the compiles in a capture taken with --capture, or by any program
+ * using SDL_SHADERCROSS_PROP_CAPTURE_FILE_STRING, and compares the time each
+ * one takes now with the time it took when it was captured.
+ */
+
+typedef struct ReplayedCall
+{
+    char *function;
+    char *name;
+    Uint64 capturedNS;
+    Uint64 replayedNS;
+    bool capturedCacheHit;
+} ReplayedCall;
+
+typedef struct ReplayFunction
+{
+    char *function;
+    int numCalls;
+    Uint64 capturedNS;
+    Uint64 replayedNS;
+} ReplayFunction;
+
+typedef struct Replay
+{
+    char *capturedVersions;
+    ReplayedCall *calls;
+    int numCalls;
+    ReplayFunction *functions;
+    int numFunctions;
+    int numFailed;  // Failed when replayed but not when captured
+    int numChanged; // Succeeded or failed differently, or with a different output size
+    int numCacheHits; // Served from a cache when captured, so not comparable
+    Uint64 capturedNS;
+    Uint64 replayedNS;
+} Replay;
+
+void SDLCALL record_replayed_call(void *userdata, const SDL_ShaderCross_ReplayEvent *event)
+{
+    Replay *replay = (Replay *)userdata;
+
+    if (replay->capturedVersions == NULL && event->captured_versions != NULL) {
+        replay->capturedVersions = SDL_strdup(event->captured_versions);
+    }
+    if (!event->replayed_success && event->captured_success) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s(%s) failed: %s", event->function, event->name ? event->name : "", event->error);
+        replay->numFailed += 1;
+    }
+    if (event->replayed_success != event->captured_success || event->replayed_output_size != event->captured_output_size) {
+        replay->numChanged += 1;
+    }
+    if (event->captured_cache_hit) {
+        replay->numCacheHits += 1;
+    }
+    replay->capturedNS += event->captured_ns;
+    replay->replayedNS += event->replayed_ns;
+
+    replay->calls = SDL_realloc(replay->calls, sizeof(ReplayedCall) * (replay->numCalls + 1));
+    ReplayedCall *call = &replay->calls[replay->numCalls++];
+    call->function = SDL_strdup(event->function);
+    call->name = event->name != NULL ? SDL_strdup(event->name) : NULL;
+    call->capturedNS = event->captured_ns;
+    call->replayedNS = event->replayed_ns;
+    call->capturedCacheHit = event->captured_cache_hit;
+
+    ReplayFunction *function = NULL;
+    for (int i = 0; i < replay->numFunctions; i += 1) {
+        if (SDL_strcmp(replay->functions[i].function, event->function) == 0) {
+            function = &replay->functions[i];
+            break;
+        }
+    }
+    if (function == NULL) {
+        replay->functions = SDL_realloc(replay->functions, sizeof(ReplayFunction) * (replay->numFunctions + 1));
+        function = &replay->functions[replay->numFunctions++];
+        SDL_zerop(function);
+        function->function = SDL_strdup(event->function);
+    }
+    function->numCalls += 1;
+    function->capturedNS += event->captured_ns;
+    function->replayedNS += event->replayed_ns;
+}
+
+// Slowest to fastest, compared with the capture
+int SDLCALL compare_call_regressions(const void *a, const void *b)
+{
+    const ReplayedCall *callA = *(const ReplayedCall *const *)a;
+    const ReplayedCall *callB = *(const ReplayedCall *const *)b;
+    Sint64 regressionA = (Sint64)(callA->replayedNS - callA->capturedNS);
+    Sint64 regressionB = (Sint64)(callB->replayedNS - callB->capturedNS);
+    if (regressionA != regressionB) {
+        return regressionA > regressionB ? -1 : 1;
+    }
+    return callA < callB ? -1 : 1;
+}
+
+double to_ratio(Uint64 replayedNS, Uint64 capturedNS)
+{
+    return capturedNS > 0 ? (double)replayedNS / (double)capturedNS : 0.0;
+}
+
+bool report_replay(const CompileOptions *options, const Replay *replay)
+{
+    int column_width = 48;
+    // Calls that hit a cache when captured would all look like regressions
+    ReplayedCall **regressions = SDL_malloc(sizeof(ReplayedCall *) * SDL_max(replay->numCalls, 1));
+    int numCompared = 0;
+    for (int i = 0; i < replay->numCalls; i += 1) {
+        if (!replay->calls[i].capturedCacheHit) {
+            regressions[numCompared++] = &replay->calls[i];
+        }
+    }
+    SDL_qsort(regressions, numCompared, sizeof(ReplayedCall *), compare_call_regressions);
+    int numRegressions = 0;
+    while (numRegressions < SDL_min(numCompared, NUM_SLOWEST_ITEMS) &&
+           regressions[numRegressions]->replayedNS > regressions[numRegressions]->capturedNS) {
+        numRegressions += 1;
+    }
+
+    SDL_Log("%d calls, %d failed, %d with different results, %d served from a cache when captured", replay->numCalls, replay->numFailed, replay->numChanged, replay->numCacheHits);
+    if (replay->capturedVersions != NULL) {
+        SDL_Log("captured with %s", replay->capturedVersions);
+    }
+    SDL_Log("  %-*s %10s %12s %12s %7s", column_width, "function", "calls", "captured", "replayed", "ratio");
+    for (int i = 0; i < replay->numFunctions; i += 1) {
+        const ReplayFunction *function = &replay->functions[i];
+        SDL_Log("  %-*s %10d %9.3f ms %9.3f ms %6.2fx", column_width, function->function, function->numCalls, to_ms(function->capturedNS), to_ms(function->replayedNS), to_ratio(function->replayedNS, function->capturedNS));
+    }
+    SDL_Log("  %-*s %10d %9.3f ms %9.3f ms %6.2fx", column_width, "all calls", replay->numCalls, to_ms(replay->capturedNS), to_ms(replay->replayedNS), to_ratio(replay->replayedNS, replay->capturedNS));
+    if (options->printTimes) {
+        log_peak_memory();
+    }
+    if (numRegressions > 0) {
+        SDL_Log("largest regressions:");
+    }
+    for (int i = 0; i < numRegressions; i += 1) {
+        const ReplayedCall *call = regressions[i];
+        SDL_Log("  %+10.3f ms  %9.3f -> %9.3f ms  %s %s", to_ms(call->replayedNS - call->capturedNS), to_ms(call->capturedNS), to_ms(call->replayedNS), call->function, call->name ? call->name : "");
+    }
+
+    bool result = true;
+    if (options->statsPath != NULL) {
+        SDL_IOStream *io = SDL_IOFromFile(options->statsPath, "w");
+        if (io == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s", SDL_GetError());
+            SDL_free(regressions);
+            return false;
+        }
+        SDL_IOprintf(io, "{\n  \"capture\": ");
+        write_json_string(io, options->replayPath);
+        SDL_IOprintf(io, ",\n  \"captured_versions\": ");
+        write_json_string(io, replay->capturedVersions);
+        SDL_IOprintf(io, ",\n  \"calls\": %d,\n  \"failed\": %d,\n  \"changed\": %d,\n  \"captured_cache_hits\": %d,\n", replay->numCalls, replay->numFailed, replay->numChanged, replay->numCacheHits);
+        SDL_IOprintf(io, "  \"captured_ms\": %.3f,\n  \"replayed_ms\": %.3f,\n", to_ms(replay->capturedNS), to_ms(replay->replayedNS));
+        SDL_IOprintf(io, "  \"peak_memory_bytes\": %" SDL_PRIu64 ",\n  \"functions\": [", get_peak_memory());
+        for (int i = 0; i < replay->numFunctions; i += 1) {
+            const ReplayFunction *function = &replay->functions[i];
+            SDL_IOprintf(io, "%s\n    { \"function\": ", i > 0 ? "," : "");
+            write_json_string(io, function->function);
+            SDL_IOprintf(io, ", \"calls\": %d, \"captured_ms\": %.3f, \"replayed_ms\": %.3f }", function->numCalls, to_ms(function->capturedNS), to_ms(function->replayedNS));
+        }
+        SDL_IOprintf(io, "%s],\n  \"regressions\": [", replay->numFunctions > 0 ? "\n  " : "");
+        for (int i = 0; i < numRegressions; i += 1) {
+            const ReplayedCall *call = regressions[i];
+            SDL_IOprintf(io, "%s\n    { \"function\": ", i > 0 ? "," : "");
+            write_json_string(io, call->function);
+            SDL_IOprintf(io, ", \"name\": ");
+            write_json_string(io, call->name);
+            SDL_IOprintf(io, ", \"captured_ms\": %.3f, \"replayed_ms\": %.3f }", to_ms(call->capturedNS), to_ms(call->replayedNS));
+        }
+        SDL_IOprintf(io, "%s]\n}\n", numRegressions > 0 ? "\n  " : "");
+        result = SDL_CloseIO(io);
+    }
+
+    SDL_free(regressions);
+    return result;
+}
+
+int run_replay(const CompileOptions *options)
+{
+    SDL_IOStream *io = SDL_IOFromFile(options->replayPath, "rb");
+    if (io == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Invalid capture file (%s)", SDL_GetError());
+        return 1;
+    }
+
+    Replay replay;
+    SDL_zero(replay);
+    int result = 0;
+    if (!SDL_ShaderCross_ReplayCapture(io, true, record_replayed_call, &replay)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to replay %s (%s)", options->replayPath, SDL_GetError());
+        result = 1;
+    } else {
+        if (replay.numFailed > 0) {
+            result = 1;
+        }
+        if (!report_replay(options, &replay)) {
+            result = 1;
+        }
+    }
+
+    for (int i = 0; i < replay.numCalls; i += 1) {
+        SDL_free(replay.calls[i].function);
+        SDL_free(replay.calls[i].name);
+    }
+    SDL_free(replay.calls);
+    for (int i = 0; i < replay.numFunctions; i += 1) {
+        SDL_free(replay.functions[i].function);
+    }
+    SDL_free(replay.functions);
+    SDL_free(replay.capturedVersions);
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    CompileOptions options;
+    init_options(&options);
+
+    if (!parse_args(argc, argv, &options)) {
+        print_help();
+        free_options(&options);
+        return 1;
+    }
+    if (options.showHelp) {
+        print_help();
+        free_options(&options);
+        return 0;
+    }
+    if ((options.batchFilename != NULL) + options.server + options.client + (options.replayPath != NULL) > 1) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: only one of --batch, --server, --client and --replay can be used", argv[0]);
+        print_help();
+        free_options(&options);
+        return 1;
+    }
+    if ((options.batchFilename != NULL || options.server || options.replayPath != NULL) && options.filename != NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: an input path cannot be combined with --batch, --server or --replay", argv[0]);
+        print_help();
+        free_options(&options);
+        return 1;
+    }
+    if (options.client && options.socketPath == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: --client requires --socket", argv[0]);
+        print_help();
+        free_options(&options);
+        return 1;
+    }
+    if (options.batchFilename == NULL && !options.server && options.replayPath == NULL && !finish_options(argv[0], &options)) {
+        print_help();
+        free_options(&options);
+        return 1;
+    }
+
+    // Only fall through to initializing and compiling here if no server answered
+    if (options.client) {
+        int result = run_client(argc, argv, &options);
+        if (result >= 0) {
+            free_options(&options);
+            return result;
+        }
+    }
+
+    SDL_PropertiesID initProps = SDL_CreateProperties();
+    SDL_SetStringProperty(initProps, SDL_SHADERCROSS_PROP_CACHE_DIRECTORY_STRING, options.cacheDir);
+    SDL_SetStringProperty(initProps, SDL_SHADERCROSS_PROP_CAPTURE_FILE_STRING, options.capturePath);
+    bool initialized = SDL_ShaderCross_InitWithProperties(initProps);
+    SDL_DestroyProperties(initProps);
+    if (!initialized)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_GPU, "%s", "Failed to initialize shadercross!");
+        free_options(&options);
+        return 1;
+    }
+
+    SDL_ShaderCross_ChromeTrace *trace = NULL;
+    if (options.tracePath != NULL) {
+        SDL_IOStream *traceIO = SDL_IOFromFile(options.tracePath, "w");
+        trace = traceIO != NULL ? SDL_ShaderCross_CreateChromeTrace(traceIO, true) : NULL;
+        if (trace == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start the trace (%s)", SDL_GetError());
+            free_options(&options);
+            SDL_ShaderCross_Quit();
+            return 1;
+        }
+        SDL_ShaderCross_SetTraceCallback(SDL_ShaderCross_WriteChromeTraceEvent, trace);
+    }
+
+    int result;
+    if (options.batchFilename != NULL) {
+        result = run_batch(argc, argv, &options);
+    } else if (options.server) {
+        result = run_server(argc, argv, &options);
+    } else if (options.replayPath != NULL) {
+        result = run_replay(&options);
+    } else {
+        result = compile_item(&options, NULL);
+    }
+
+    if (trace != NULL) {
+        SDL_ShaderCross_SetTraceCallback(NULL, NULL);
+        if (!SDL_ShaderCross_CloseChromeTrace(trace)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write the trace (%s)", SDL_GetError());
+            result = 1;
+        }
+    }
+
+    free_options(&options);
     SDL_ShaderCross_Quit();
     return result;
 }